@@ -1,4 +1,8 @@
 #include "BME280.h"
+#include "BME280_Kernels.h"
+
+#include <string.h>
+#include <time.h>
 
 // Internal helpers
 static int bme280_write_u8(bme280_t *dev, uint8_t reg, uint8_t val) {
@@ -15,13 +19,59 @@ static int bme280_read_buf(bme280_t *dev, uint8_t reg, uint8_t *buf, size_t len)
     return dev->bus.read(dev->bus.user, reg, buf, len);
 }
 
-static int bme280_update_bits(bme280_t *dev, uint8_t reg, uint8_t mask, uint8_t value) {
-    uint8_t cur;
-    int rc = bme280_read_u8(dev, reg, &cur);
-    if (rc != BME280_OK) return rc;
-    uint8_t newv = (cur & ~mask) | (value & mask);
-    if (newv == cur) return BME280_OK;
-    return bme280_write_u8(dev, reg, newv);
+// Write n registers in one bus transaction. The BME280 has no auto-increment
+// for writes on either bus; a multi-byte write is a sequence of
+// register/value pairs, so the payload after regs[0] is
+// vals[0], regs[1], vals[1], ...
+#define BME280_MAX_PAIR_WRITES 4
+
+static int bme280_write_pairs(bme280_t *dev, const uint8_t *regs, const uint8_t *vals, size_t n) {
+    if (!dev || !dev->bus.write) return BME280_E_NULL_PTR;
+    if (n == 0) return BME280_OK;
+    if (n > BME280_MAX_PAIR_WRITES) return BME280_E_INVALID_ARG;
+    uint8_t buf[2 * BME280_MAX_PAIR_WRITES - 1];
+    size_t len = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (i) buf[len++] = regs[i];
+        buf[len++] = vals[i];
+    }
+    return dev->bus.write(dev->bus.user, regs[0], buf, len);
+}
+
+// Register images for settings (datasheet section 5.4)
+static uint8_t bme280_ctrl_hum_bits(bme280_oversampling_t osr_h) {
+    return (uint8_t)(osr_h & 0x07);
+}
+
+static uint8_t bme280_ctrl_meas_bits(bme280_oversampling_t osr_t, bme280_oversampling_t osr_p, bme280_mode_t mode) {
+    return (uint8_t)(((osr_t & 0x07) << 5) | ((osr_p & 0x07) << 2) | (mode & 0x03));
+}
+
+static uint8_t bme280_config_bits(bme280_standby_t standby, bme280_filter_t filter) {
+    return (uint8_t)(((standby & 0x07) << 5) | ((filter & 0x07) << 2));
+}
+
+// Register fields back to settings; the datasheet maps the unused codes to x16 / coefficient 16
+static bme280_oversampling_t bme280_osr_from_bits(uint8_t bits) {
+    bits &= 0x07;
+    return bits > BME280_OSRS_X16 ? BME280_OSRS_X16 : (bme280_oversampling_t)bits;
+}
+
+static bme280_filter_t bme280_filter_from_bits(uint8_t bits) {
+    bits &= 0x07;
+    return bits > BME280_FILTER_16 ? BME280_FILTER_16 : (bme280_filter_t)bits;
+}
+
+static bool bme280_settings_valid(const bme280_settings_t *s) {
+    return s->osr_t <= BME280_OSRS_X16 && s->osr_p <= BME280_OSRS_X16 && s->osr_h <= BME280_OSRS_X16 &&
+           s->filter <= BME280_FILTER_16 && s->standby <= BME280_STANDBY_20_MS &&
+           (s->mode == BME280_SLEEP_MODE || s->mode == BME280_FORCED_MODE || s->mode == BME280_NORMAL_MODE);
+}
+
+static uint64_t bme280_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
 }
 
 static void bme280_delay(bme280_t *dev, uint32_t ms) {
@@ -37,6 +87,10 @@ int bme280_soft_reset(bme280_t *dev) {
     if (!dev) return BME280_E_NULL_PTR;
     int rc = bme280_write_u8(dev, BME280_REG_RESET, BME280_SOFT_RESET);
     if (rc != BME280_OK) return rc;
+    // Power-on/reset values of the shadowed registers (datasheet table 18)
+    dev->reg_ctrl_hum = 0x00;
+    dev->reg_ctrl_meas = 0x00;
+    dev->reg_config = 0x00;
     // Wait for NVM copy, datasheet suggests 2 ms; we'll poll STATUS[0] (im_update)
     for (int i = 0; i < 20; ++i) {
         uint8_t st = 0;
@@ -51,43 +105,47 @@ int bme280_soft_reset(bme280_t *dev) {
 static uint16_t u16_le(const uint8_t *p) { return (uint16_t)p[0] | ((uint16_t)p[1] << 8); }
 static int16_t s16_le(const uint8_t *p) { return (int16_t)((uint16_t)p[0] | ((uint16_t)p[1] << 8)); }
 
-int bme280_read_calibration(bme280_t *dev) {
-    if (!dev) return BME280_E_NULL_PTR;
-    uint8_t buf1[26]; // 0x88 .. 0xA1 (26 bytes)
-    int rc = bme280_read_buf(dev, BME280_CALIB00_START, buf1, sizeof(buf1));
-    if (rc != BME280_OK) return rc;
-
-    dev->calib.dig_T1 = u16_le(&buf1[0]);
-    dev->calib.dig_T2 = s16_le(&buf1[2]);
-    dev->calib.dig_T3 = s16_le(&buf1[4]);
-
-    dev->calib.dig_P1 = u16_le(&buf1[6]);
-    dev->calib.dig_P2 = s16_le(&buf1[8]);
-    dev->calib.dig_P3 = s16_le(&buf1[10]);
-    dev->calib.dig_P4 = s16_le(&buf1[12]);
-    dev->calib.dig_P5 = s16_le(&buf1[14]);
-    dev->calib.dig_P6 = s16_le(&buf1[16]);
-    dev->calib.dig_P7 = s16_le(&buf1[18]);
-    dev->calib.dig_P8 = s16_le(&buf1[20]);
-    dev->calib.dig_P9 = s16_le(&buf1[22]);
-
-    dev->calib.dig_H1 = buf1[24]; // 0xA1
-
-    uint8_t buf2[7]; // 0xE1 .. 0xE7
-    rc = bme280_read_buf(dev, BME280_CALIB26_START, buf2, sizeof(buf2));
-    if (rc != BME280_OK) return rc;
-
-    dev->calib.dig_H2 = s16_le(&buf2[0]);
-    dev->calib.dig_H3 = buf2[2];
+void bme280_parse_calibration(const uint8_t raw[BME280_CALIB_RAW_LEN], bme280_calib_t *calib) {
+    if (!raw || !calib) return;
+    const uint8_t *buf1 = raw;                      // 0x88 .. 0xA1
+    const uint8_t *buf2 = raw + BME280_CALIB00_LEN; // 0xE1 .. 0xE7
+
+    calib->dig_T1 = u16_le(&buf1[0]);
+    calib->dig_T2 = s16_le(&buf1[2]);
+    calib->dig_T3 = s16_le(&buf1[4]);
+
+    calib->dig_P1 = u16_le(&buf1[6]);
+    calib->dig_P2 = s16_le(&buf1[8]);
+    calib->dig_P3 = s16_le(&buf1[10]);
+    calib->dig_P4 = s16_le(&buf1[12]);
+    calib->dig_P5 = s16_le(&buf1[14]);
+    calib->dig_P6 = s16_le(&buf1[16]);
+    calib->dig_P7 = s16_le(&buf1[18]);
+    calib->dig_P8 = s16_le(&buf1[20]);
+    calib->dig_P9 = s16_le(&buf1[22]);
+
+    calib->dig_H1 = buf1[24]; // 0xA1
+
+    calib->dig_H2 = s16_le(&buf2[0]);
+    calib->dig_H3 = buf2[2];
     // H4/H5 are packed 12-bit signed values; perform proper sign extension
     uint16_t h4_raw = ((uint16_t)buf2[3] << 4) | (buf2[4] & 0x0F);
     uint16_t h5_raw = ((uint16_t)buf2[5] << 4) | (buf2[4] >> 4);
     int16_t h4 = (h4_raw & 0x0800) ? (int16_t)(h4_raw | 0xF000) : (int16_t)h4_raw;
     int16_t h5 = (h5_raw & 0x0800) ? (int16_t)(h5_raw | 0xF000) : (int16_t)h5_raw;
-    dev->calib.dig_H4 = h4;
-    dev->calib.dig_H5 = h5;
-    dev->calib.dig_H6 = (int8_t)buf2[6];
+    calib->dig_H4 = h4;
+    calib->dig_H5 = h5;
+    calib->dig_H6 = (int8_t)buf2[6];
+}
 
+int bme280_read_calibration(bme280_t *dev) {
+    if (!dev) return BME280_E_NULL_PTR;
+    int rc = bme280_read_buf(dev, BME280_CALIB00_START, dev->calib_raw, BME280_CALIB00_LEN);
+    if (rc != BME280_OK) return rc;
+    rc = bme280_read_buf(dev, BME280_CALIB26_START, dev->calib_raw + BME280_CALIB00_LEN, BME280_CALIB26_LEN);
+    if (rc != BME280_OK) return rc;
+
+    bme280_parse_calibration(dev->calib_raw, &dev->calib);
     dev->calib_loaded = true;
     return BME280_OK;
 }
@@ -98,6 +156,7 @@ int bme280_init(bme280_t *dev, const bme280_bus_t *bus, uint8_t i2c_addr) {
     dev->i2c_addr = i2c_addr;
     dev->t_fine = 0;
     dev->calib_loaded = false;
+    dev->meas_seq = 0;
 
     uint8_t id = 0;
     int rc = bme280_read_chip_id(dev, &id);
@@ -110,76 +169,140 @@ int bme280_init(bme280_t *dev, const bme280_bus_t *bus, uint8_t i2c_addr) {
     rc = bme280_read_calibration(dev);
     if (rc != BME280_OK) return rc;
 
-    // Default settings: osrs T/P/H = x1, filter off, standby 1000ms, sleep
-    dev->settings.osr_t = BME280_OSRS_X1;
-    dev->settings.osr_p = BME280_OSRS_X1;
-    dev->settings.osr_h = BME280_OSRS_X1;
-    dev->settings.filter = BME280_FILTER_OFF;
-    dev->settings.standby = BME280_STANDBY_1000_MS;
-    dev->settings.mode = BME280_SLEEP_MODE;
+    // Default settings: osrs T/P/H = x1, filter off, standby 1000ms, sleep.
+    // The shadows hold the reset values, so this is a single paired write.
+    const bme280_settings_t defaults = {
+        .osr_t = BME280_OSRS_X1, .osr_p = BME280_OSRS_X1, .osr_h = BME280_OSRS_X1,
+        .filter = BME280_FILTER_OFF, .standby = BME280_STANDBY_1000_MS, .mode = BME280_SLEEP_MODE,
+    };
+    return bme280_apply_settings(dev, &defaults);
+}
 
-    rc = bme280_set_oversampling(dev, dev->settings.osr_t, dev->settings.osr_p, dev->settings.osr_h);
+int bme280_attach(bme280_t *dev, const bme280_bus_t *bus, uint8_t i2c_addr,
+                  const uint8_t calib_raw[BME280_CALIB_RAW_LEN]) {
+    if (!dev || !bus || !calib_raw) return BME280_E_NULL_PTR;
+    dev->bus = *bus;
+    dev->i2c_addr = i2c_addr;
+    dev->t_fine = 0;
+    dev->calib_loaded = false;
+    dev->meas_seq = 0;
+
+    uint8_t id = 0;
+    int rc = bme280_read_chip_id(dev, &id);
     if (rc != BME280_OK) return rc;
-    rc = bme280_set_filter(dev, dev->settings.filter);
+    if (id != BME280_CHIP_ID) return BME280_E_CHIP_ID_MISMATCH;
+
+    // Spot check: a different part behind the same address fails here
+    uint8_t spot[BME280_CALIB_SPOT_LEN];
+    rc = bme280_read_buf(dev, BME280_CALIB00_START, spot, sizeof(spot));
     if (rc != BME280_OK) return rc;
-    rc = bme280_set_standby(dev, dev->settings.standby);
+    for (size_t i = 0; i < sizeof(spot); ++i) {
+        if (spot[i] != calib_raw[i]) return BME280_E_CALIB_MISMATCH;
+    }
+
+    // CTRL_HUM, STATUS, CTRL_MEAS, CONFIG in one burst
+    uint8_t ctrl[4];
+    rc = bme280_read_buf(dev, BME280_REG_CTRL_HUM, ctrl, sizeof(ctrl));
     if (rc != BME280_OK) return rc;
-    rc = bme280_set_mode(dev, BME280_SLEEP_MODE);
-    return rc;
+    dev->reg_ctrl_hum = (uint8_t)(ctrl[0] & 0x07);
+    dev->reg_ctrl_meas = ctrl[2];
+    dev->reg_config = (uint8_t)(ctrl[3] & 0xFC);
+    if ((dev->reg_ctrl_meas & 0x03) == BME280_FORCED_MODE) {
+        dev->reg_ctrl_meas &= (uint8_t)~0x03; // a pending one-shot ends in sleep
+    }
+
+    bme280_settings_t *st = &dev->settings;
+    st->osr_h   = bme280_osr_from_bits(dev->reg_ctrl_hum);
+    st->osr_t   = bme280_osr_from_bits((uint8_t)(dev->reg_ctrl_meas >> 5));
+    st->osr_p   = bme280_osr_from_bits((uint8_t)(dev->reg_ctrl_meas >> 2));
+    st->mode    = (dev->reg_ctrl_meas & 0x03) == BME280_NORMAL_MODE ? BME280_NORMAL_MODE : BME280_SLEEP_MODE;
+    st->filter  = bme280_filter_from_bits((uint8_t)(dev->reg_config >> 2));
+    st->standby = (bme280_standby_t)(dev->reg_config >> 5);
+
+    memcpy(dev->calib_raw, calib_raw, BME280_CALIB_RAW_LEN);
+    bme280_parse_calibration(dev->calib_raw, &dev->calib);
+    dev->calib_loaded = true;
+    return BME280_OK;
 }
 
-int bme280_set_oversampling(bme280_t *dev, bme280_oversampling_t osr_t, bme280_oversampling_t osr_p, bme280_oversampling_t osr_h) {
-    if (!dev) return BME280_E_NULL_PTR;
-    if (osr_t > BME280_OSRS_X16 || osr_p > BME280_OSRS_X16 || osr_h > BME280_OSRS_X16) return BME280_E_INVALID_ARG;
+int bme280_apply_settings(bme280_t *dev, const bme280_settings_t *settings) {
+    if (!dev || !settings) return BME280_E_NULL_PTR;
+    if (!bme280_settings_valid(settings)) return BME280_E_INVALID_ARG;
 
-    int rc = bme280_update_bits(dev, BME280_REG_CTRL_HUM, 0x07, (uint8_t)osr_h);
-    if (rc != BME280_OK) return rc;
+    uint8_t hum  = bme280_ctrl_hum_bits(settings->osr_h);
+    uint8_t meas = bme280_ctrl_meas_bits(settings->osr_t, settings->osr_p, settings->mode);
+    uint8_t cfg  = bme280_config_bits(settings->standby, settings->filter);
 
-    // ctrl_meas: osrs_t[7:5], osrs_p[4:2], mode[1:0]
-    uint8_t ctrl_meas;
-    rc = bme280_read_u8(dev, BME280_REG_CTRL_MEAS, &ctrl_meas);
-    if (rc != BME280_OK) return rc;
-    ctrl_meas = (uint8_t)((ctrl_meas & 0x03) | ((osr_t & 0x07) << 5) | ((osr_p & 0x07) << 2));
-    rc = bme280_write_u8(dev, BME280_REG_CTRL_MEAS, ctrl_meas);
+    uint8_t regs[BME280_MAX_PAIR_WRITES], vals[BME280_MAX_PAIR_WRITES];
+    size_t n = 0;
+    bool hum_changed = hum != dev->reg_ctrl_hum;
+    bool cfg_changed = cfg != dev->reg_config;
+
+    if (cfg_changed && (dev->reg_ctrl_meas & 0x03) == BME280_NORMAL_MODE) {
+        regs[n] = BME280_REG_CTRL_MEAS; vals[n++] = (uint8_t)(dev->reg_ctrl_meas & ~0x03);
+    }
+    if (hum_changed) { regs[n] = BME280_REG_CTRL_HUM; vals[n++] = hum; }
+    if (cfg_changed) { regs[n] = BME280_REG_CONFIG; vals[n++] = cfg; }
+    // CTRL_HUM only takes effect after a CTRL_MEAS write; FORCED always triggers
+    if (n || meas != dev->reg_ctrl_meas || settings->mode == BME280_FORCED_MODE) {
+        regs[n] = BME280_REG_CTRL_MEAS; vals[n++] = meas;
+    }
+
+    int rc = bme280_write_pairs(dev, regs, vals, n);
     if (rc != BME280_OK) return rc;
 
-    // Writing to ctrl_meas is required after ctrl_hum for changes to take effect
-    dev->settings.osr_t = osr_t;
-    dev->settings.osr_p = osr_p;
-    dev->settings.osr_h = osr_h;
+    dev->reg_ctrl_hum = hum;
+    dev->reg_config = cfg;
+    dev->reg_ctrl_meas = settings->mode == BME280_FORCED_MODE ? (uint8_t)(meas & ~0x03) : meas;
+    dev->settings = *settings;
     return BME280_OK;
 }
 
+// The single-field setters go through bme280_apply_settings, so they only
+// touch the bus when the register image actually changes. A device configured
+// for FORCED mode stays configured that way, but reconfiguring it does not
+// start a conversion.
+static int bme280_apply_keep_mode(bme280_t *dev, bme280_settings_t *s) {
+    bme280_mode_t mode = s->mode;
+    if (mode == BME280_FORCED_MODE) s->mode = BME280_SLEEP_MODE;
+    int rc = bme280_apply_settings(dev, s);
+    if (rc == BME280_OK) dev->settings.mode = mode;
+    return rc;
+}
+
+int bme280_set_oversampling(bme280_t *dev, bme280_oversampling_t osr_t, bme280_oversampling_t osr_p, bme280_oversampling_t osr_h) {
+    if (!dev) return BME280_E_NULL_PTR;
+    bme280_settings_t s = dev->settings;
+    s.osr_t = osr_t;
+    s.osr_p = osr_p;
+    s.osr_h = osr_h;
+    return bme280_apply_keep_mode(dev, &s);
+}
+
 int bme280_set_filter(bme280_t *dev, bme280_filter_t filter) {
     if (!dev) return BME280_E_NULL_PTR;
-    if (filter > BME280_FILTER_16) return BME280_E_INVALID_ARG;
-    int rc = bme280_update_bits(dev, BME280_REG_CONFIG, 0x1C, (uint8_t)(filter << 2)); // filter[4:2]
-    if (rc == BME280_OK) dev->settings.filter = filter;
-    return rc;
+    bme280_settings_t s = dev->settings;
+    s.filter = filter;
+    return bme280_apply_keep_mode(dev, &s);
 }
 
 int bme280_set_standby(bme280_t *dev, bme280_standby_t standby) {
     if (!dev) return BME280_E_NULL_PTR;
-    if (standby > BME280_STANDBY_20_MS) return BME280_E_INVALID_ARG;
-    int rc = bme280_update_bits(dev, BME280_REG_CONFIG, 0xE0, (uint8_t)(standby << 5)); // t_sb[7:5]
-    if (rc == BME280_OK) dev->settings.standby = standby;
-    return rc;
+    bme280_settings_t s = dev->settings;
+    s.standby = standby;
+    return bme280_apply_keep_mode(dev, &s);
 }
 
+// FORCED always writes CTRL_MEAS (one write-only transaction per trigger)
 int bme280_set_mode(bme280_t *dev, bme280_mode_t mode) {
     if (!dev) return BME280_E_NULL_PTR;
-    if (!(mode == BME280_SLEEP_MODE || mode == BME280_FORCED_MODE || mode == BME280_NORMAL_MODE)) return BME280_E_INVALID_ARG;
-    int rc = bme280_update_bits(dev, BME280_REG_CTRL_MEAS, 0x03, (uint8_t)mode);
-    if (rc == BME280_OK) dev->settings.mode = mode;
-    return rc;
+    bme280_settings_t s = dev->settings;
+    s.mode = mode;
+    return bme280_apply_settings(dev, &s);
 }
 
-int bme280_read_raw(bme280_t *dev, int32_t *adc_T, int32_t *adc_P, int32_t *adc_H) {
-    if (!dev) return BME280_E_NULL_PTR;
-    uint8_t buf[8];
-    int rc = bme280_read_buf(dev, BME280_REG_PRESS_MSB, buf, sizeof(buf));
-    if (rc != BME280_OK) return rc;
-
+void bme280_parse_raw(const uint8_t buf[BME280_MEAS_BURST_LEN], int32_t *adc_T, int32_t *adc_P, int32_t *adc_H) {
+    if (!buf) return;
     int32_t p = ((int32_t)buf[0] << 12) | ((int32_t)buf[1] << 4) | ((int32_t)buf[2] >> 4);
     int32_t t = ((int32_t)buf[3] << 12) | ((int32_t)buf[4] << 4) | ((int32_t)buf[5] >> 4);
     int32_t h = ((int32_t)buf[6] << 8) | buf[7];
@@ -187,77 +310,188 @@ int bme280_read_raw(bme280_t *dev, int32_t *adc_T, int32_t *adc_P, int32_t *adc_
     if (adc_P) *adc_P = p;
     if (adc_T) *adc_T = t;
     if (adc_H) *adc_H = h;
+}
+
+int bme280_read_raw(bme280_t *dev, int32_t *adc_T, int32_t *adc_P, int32_t *adc_H) {
+    if (!dev) return BME280_E_NULL_PTR;
+    uint8_t buf[BME280_MEAS_BURST_LEN];
+    int rc = bme280_read_buf(dev, BME280_REG_PRESS_MSB, buf, sizeof(buf));
+    if (rc != BME280_OK) return rc;
+    bme280_parse_raw(buf, adc_T, adc_P, adc_H);
     return BME280_OK;
 }
 
+// ===== Compensation =====
+// The kernels (BME280_Kernels.h) are pure functions of the calibration data.
+// The float API below and the batch API share them, so both produce the same
+// values; only the batch API is free of the dev->t_fine side channel.
+
 float bme280_compensate_temperature(bme280_t *dev, int32_t adc_T) {
     if (!dev || !dev->calib_loaded) return 0.0f;
     // Bosch datasheet compensation formula
-    int32_t var1 = ((((adc_T >> 3) - ((int32_t)dev->calib.dig_T1 << 1))) * ((int32_t)dev->calib.dig_T2)) >> 11;
-    int32_t var2 = (((((adc_T >> 4) - ((int32_t)dev->calib.dig_T1)) * ((adc_T >> 4) - ((int32_t)dev->calib.dig_T1))) >> 12) * ((int32_t)dev->calib.dig_T3)) >> 14;
-    dev->t_fine = var1 + var2;
+    dev->t_fine = bme280__t_fine(&dev->calib, adc_T);
     float T = (dev->t_fine * 5 + 128) / 256.0f; // in 0.01 C -> C
     return T / 100.0f;
 }
 
 float bme280_compensate_pressure(bme280_t *dev, int32_t adc_P) {
     if (!dev || !dev->calib_loaded) return 0.0f;
-    int64_t var1 = (int64_t)dev->t_fine - 128000;
-    int64_t var2 = var1 * var1 * (int64_t)dev->calib.dig_P6;
-    var2 = var2 + ((var1 * (int64_t)dev->calib.dig_P5) << 17);
-    var2 = var2 + (((int64_t)dev->calib.dig_P4) << 35);
-    var1 = ((var1 * var1 * (int64_t)dev->calib.dig_P3) >> 8) + ((var1 * (int64_t)dev->calib.dig_P2) << 12);
-    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)dev->calib.dig_P1) >> 33;
-
-    if (var1 == 0) {
-        return 0.0f; // avoid division by zero
-    }
-    int64_t p = 1048576 - adc_P;
-    p = (((p << 31) - var2) * 3125) / var1;
-    var1 = (((int64_t)dev->calib.dig_P9) * (p >> 13) * (p >> 13)) >> 25;
-    var2 = (((int64_t)dev->calib.dig_P8) * p) >> 19;
-    p = ((p + var1 + var2) >> 8) + (((int64_t)dev->calib.dig_P7) << 4);
-    return (float)p / 256.0f; // Pa
+    return (float)bme280__pressure_q24_8(&dev->calib, dev->t_fine, adc_P) / 256.0f; // Pa
 }
 
 float bme280_compensate_humidity(bme280_t *dev, int32_t adc_H) {
     if (!dev || !dev->calib_loaded) return 0.0f;
-    int32_t v_x1_u32r = dev->t_fine - ((int32_t)76800);
-    v_x1_u32r = (((((adc_H << 14) - (((int32_t)dev->calib.dig_H4) << 20) - (((int32_t)dev->calib.dig_H5) * v_x1_u32r)) + ((int32_t)16384)) >> 15) *
-                 (((((((v_x1_u32r * ((int32_t)dev->calib.dig_H6)) >> 10) * (((v_x1_u32r * ((int32_t)dev->calib.dig_H3)) >> 11) + ((int32_t)32768))) >> 10) +
-                     ((int32_t)2097152)) * ((int32_t)dev->calib.dig_H2) + 8192) >> 14));
-    v_x1_u32r = v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * ((int32_t)dev->calib.dig_H1)) >> 4);
-    v_x1_u32r = (v_x1_u32r < 0 ? 0 : v_x1_u32r);
-    v_x1_u32r = (v_x1_u32r > 419430400 ? 419430400 : v_x1_u32r);
-    float h = (v_x1_u32r >> 12) / 1024.0f; // %RH
-    if (h < 0.0f) h = 0.0f;
+    float h = bme280__humidity_q22_10(&dev->calib, dev->t_fine, adc_H) / 1024.0f; // %RH
     if (h > 100.0f) h = 100.0f;
     return h;
 }
 
+// ===== Batch compensation =====
+// Samples are processed in blocks: a branch-free 32-bit pass computes t_fine
+// (and temperature), a second 32-bit pass does humidity, and the 64-bit
+// pressure pass (with its division) runs last. The two 32-bit passes are
+// written so -O3 vectorizes them; on x86_64 GCC additionally emits an AVX2
+// clone selected at load time, so the binary still runs on SSE2-only CPUs.
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__) && !defined(BME280_NO_TARGET_CLONES)
+#define BME280_VECTOR_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define BME280_VECTOR_CLONES
+#endif
+
+#define BME280_BATCH_BLOCK 64
+
+BME280_VECTOR_CLONES
+static void bme280__batch_t_fine(const bme280_calib_t *c, const int32_t *restrict adc_T, size_t n,
+                                 int32_t *restrict t_fine, int32_t *restrict temp_c100) {
+    for (size_t i = 0; i < n; ++i) t_fine[i] = bme280__t_fine(c, adc_T[i]);
+    if (temp_c100) {
+        for (size_t i = 0; i < n; ++i) temp_c100[i] = (t_fine[i] * 5 + 128) >> 8;
+    }
+}
+
+BME280_VECTOR_CLONES
+static void bme280__batch_humidity(const bme280_calib_t *c, const int32_t *restrict t_fine, const int32_t *restrict adc_H,
+                                   size_t n, uint32_t *restrict hum_q22_10) {
+    for (size_t i = 0; i < n; ++i) hum_q22_10[i] = bme280__humidity_q22_10(c, t_fine[i], adc_H[i]);
+}
+
+static void bme280__batch_pressure(const bme280_calib_t *c, const int32_t *t_fine, const int32_t *adc_P,
+                                   size_t n, uint32_t *press_q24_8) {
+    for (size_t i = 0; i < n; ++i) press_q24_8[i] = bme280__pressure_q24_8(c, t_fine[i], adc_P[i]);
+}
+
+int bme280_compensate_batch_fixed(const bme280_calib_t *calib,
+                                  const int32_t *adc_T, const int32_t *adc_P, const int32_t *adc_H, size_t n,
+                                  int32_t *temp_c100, uint32_t *press_q24_8, uint32_t *hum_q22_10) {
+    if (!calib || !adc_T) return BME280_E_NULL_PTR;
+    if ((adc_P && !press_q24_8) || (adc_H && !hum_q22_10)) return BME280_E_NULL_PTR;
+
+    int32_t t_fine[BME280_BATCH_BLOCK];
+    for (size_t off = 0; off < n; off += BME280_BATCH_BLOCK) {
+        size_t m = n - off < BME280_BATCH_BLOCK ? n - off : BME280_BATCH_BLOCK;
+        bme280__batch_t_fine(calib, adc_T + off, m, t_fine, temp_c100 ? temp_c100 + off : NULL);
+        if (adc_H) bme280__batch_humidity(calib, t_fine, adc_H + off, m, hum_q22_10 + off);
+        if (adc_P) bme280__batch_pressure(calib, t_fine, adc_P + off, m, press_q24_8 + off);
+    }
+    return BME280_OK;
+}
+
+int bme280_compensate_batch(const bme280_calib_t *calib,
+                            const int32_t *adc_T, const int32_t *adc_P, const int32_t *adc_H, size_t n,
+                            bme280_reading_t *out) {
+    if (!calib || !adc_T || !out) return BME280_E_NULL_PTR;
+
+    int32_t t_fine[BME280_BATCH_BLOCK];
+    uint32_t press[BME280_BATCH_BLOCK];
+    uint32_t hum[BME280_BATCH_BLOCK];
+    for (size_t off = 0; off < n; off += BME280_BATCH_BLOCK) {
+        size_t m = n - off < BME280_BATCH_BLOCK ? n - off : BME280_BATCH_BLOCK;
+        bme280__batch_t_fine(calib, adc_T + off, m, t_fine, NULL);
+        if (adc_H) bme280__batch_humidity(calib, t_fine, adc_H + off, m, hum);
+        if (adc_P) bme280__batch_pressure(calib, t_fine, adc_P + off, m, press);
+        for (size_t i = 0; i < m; ++i) {
+            bme280_reading_t *r = &out[off + i];
+            r->temperature_c = (t_fine[i] * 5 + 128) / 256.0f / 100.0f;
+            r->pressure_pa   = adc_P ? (float)press[i] / 256.0f : 0.0f;
+            r->humidity_rh   = adc_H ? hum[i] / 1024.0f : 0.0f;
+            if (r->humidity_rh > 100.0f) r->humidity_rh = 100.0f;
+        }
+    }
+    return BME280_OK;
+}
+
+// Oversampling factor for an OSRS register value (SKIP -> 0, X1..X16 -> 1..16)
+static uint32_t bme280_osr_factor(bme280_oversampling_t osr) {
+    return osr == BME280_OSRS_SKIP ? 0u : (1u << (osr - 1));
+}
+
+uint32_t bme280_measurement_time_us(const bme280_settings_t *settings) {
+    if (!settings) return 0;
+    uint32_t t = bme280_osr_factor(settings->osr_t);
+    uint32_t p = bme280_osr_factor(settings->osr_p);
+    uint32_t h = bme280_osr_factor(settings->osr_h);
+    uint32_t us = 1250u + 2300u * t;
+    if (p) us += 2300u * p + 575u;
+    if (h) us += 2300u * h + 575u;
+    return us;
+}
+
+int bme280_trigger_measurement(bme280_t *dev, uint32_t *wait_us) {
+    if (!dev) return BME280_E_NULL_PTR;
+    if (wait_us) *wait_us = 0;
+    if (dev->settings.mode != BME280_FORCED_MODE) return BME280_OK;
+    int rc = bme280_set_mode(dev, BME280_FORCED_MODE); // trigger one-shot
+    if (rc != BME280_OK) return rc;
+    if (wait_us) *wait_us = bme280_measurement_time_us(&dev->settings);
+    return BME280_OK;
+}
+
+int bme280_fetch_measurement(bme280_t *dev, bme280_reading_t *out) {
+    if (!dev || !out) return BME280_E_NULL_PTR;
+    uint8_t buf[BME280_MEAS_BURST_LEN];
+    int rc = bme280_read_buf(dev, BME280_REG_PRESS_MSB, buf, sizeof(buf));
+    if (rc != BME280_OK) return rc;
+    return bme280_decode_measurement(dev, buf, out);
+}
+
 int bme280_read_measurement(bme280_t *dev, bme280_reading_t *out) {
     if (!dev || !out) return BME280_E_NULL_PTR;
 
-    if (dev->settings.mode == BME280_FORCED_MODE) {
-        int rc = bme280_set_mode(dev, BME280_FORCED_MODE); // trigger one-shot
-        if (rc != BME280_OK) return rc;
-        // Wait until measuring bit clears
-        for (int i = 0; i < 50; ++i) {
-            uint8_t st = 0;
+    uint32_t wait_us = 0;
+    int rc = bme280_trigger_measurement(dev, &wait_us);
+    if (rc != BME280_OK) return rc;
+    if (wait_us && dev->bus.delay_ms) {
+        // One sleep for the datasheet maximum instead of polling STATUS_MEASURING
+        bme280_delay(dev, (wait_us + 999u) / 1000u);
+    } else if (wait_us) {
+        // No way to sleep: poll. Every poll is a bus read of well over 1 us, so
+        // wait_us polls outlast the datasheet maximum.
+        uint8_t st = BME280_STATUS_MEASURING;
+        for (uint32_t i = 0; i < wait_us && (st & BME280_STATUS_MEASURING); ++i) {
             rc = bme280_read_u8(dev, BME280_REG_STATUS, &st);
             if (rc != BME280_OK) return rc;
-            if ((st & BME280_STATUS_MEASURING) == 0) break;
-            bme280_delay(dev, 5);
         }
+        if (st & BME280_STATUS_MEASURING) return BME280_E_TIMEOUT;
     }
+    return bme280_fetch_measurement(dev, out);
+}
 
+int bme280_decode_measurement(bme280_t *dev, const uint8_t buf[BME280_MEAS_BURST_LEN], bme280_reading_t *out) {
+    if (!dev || !buf || !out) return BME280_E_NULL_PTR;
     int32_t adc_T = 0, adc_P = 0, adc_H = 0;
-    int rc = bme280_read_raw(dev, &adc_T, &adc_P, &adc_H);
-    if (rc != BME280_OK) return rc;
+    bme280_parse_raw(buf, &adc_T, &adc_P, &adc_H);
 
     out->temperature_c = bme280_compensate_temperature(dev, adc_T);
     out->pressure_pa   = bme280_compensate_pressure(dev, adc_P);
     out->humidity_rh   = bme280_compensate_humidity(dev, adc_H);
+
+    dev->last = *out;
+    dev->last_adc_T = adc_T;
+    dev->last_adc_P = adc_P;
+    dev->last_adc_H = adc_H;
+    if (++dev->meas_seq == 0) dev->meas_seq = 1; // 0 is reserved for "no measurement"
+    dev->last_ms = bme280_now_ms();
     return BME280_OK;
 }
 
@@ -265,19 +499,57 @@ int bme280_read_measurement(bme280_t *dev, bme280_reading_t *out) {
 
 // Reuse the public wrapper context type to avoid duplicate definitions
 
-static bool bme280__get_event_temp(void *ctx, sensors_event_t *event) {
-    if (!ctx || !event) return false;
-    bme280_sensor_wrapper_t *c = (bme280_sensor_wrapper_t *)ctx;
-    bme280_reading_t r;
-    if (bme280_read_measurement(c->dev, &r) != BME280_OK) return false;
+// One measurement per sampling epoch: serve the cached reading unless this
+// wrapper already reported it or it is older than the wrapper's max age.
+static int bme280__shared_reading(bme280_sensor_wrapper_t *c, bme280_reading_t *r) {
+    bme280_t *dev = c->dev;
+    if (!dev) return BME280_E_NULL_PTR;
+    if (dev->meas_seq == 0 || c->seen_seq == dev->meas_seq || bme280_now_ms() - dev->last_ms > c->max_age_ms) {
+        int rc = bme280_read_measurement(dev, r);
+        if (rc != BME280_OK) return rc;
+    } else {
+        *r = dev->last;
+    }
+    c->seen_seq = dev->meas_seq;
+    return BME280_OK;
+}
+
+static void bme280__fill_event(const bme280_sensor_wrapper_t *c, int type, const bme280_reading_t *r, sensors_event_t *event) {
     event->version = sizeof(*event);
     event->sensor_id = c->sensor_id;
-    event->type = SENSOR_TYPE_AMBIENT_TEMPERATURE;
+    event->type = type;
     event->timestamp = 0; // caller may fill
-    event->value.temperature = r.temperature_c;
+    switch (type) {
+    case SENSOR_TYPE_AMBIENT_TEMPERATURE: event->value.temperature = r->temperature_c; break;
+    case SENSOR_TYPE_PRESSURE:            event->value.pressure = r->pressure_pa / 100.0f; break; // hPa
+    case SENSOR_TYPE_RELATIVE_HUMIDITY:   event->value.relative_humidity = r->humidity_rh; break;
+    default: break;
+    }
+}
+
+static bool bme280__get_event(void *ctx, sensors_event_t *event) {
+    if (!ctx || !event) return false;
+    bme280_sensor_wrapper_t *c = (bme280_sensor_wrapper_t *)ctx;
+    bme280_reading_t r;
+    if (bme280__shared_reading(c, &r) != BME280_OK) return false;
+    bme280__fill_event(c, c->type, &r, event);
     return true;
 }
 
+static size_t bme280__get_events(void *ctx, sensors_event_t *out, size_t n) {
+    if (!ctx || !out || n == 0) return 0;
+    bme280_sensor_wrapper_t *c = (bme280_sensor_wrapper_t *)ctx;
+    if (!c->dev) return 0;
+    bme280_reading_t r;
+    if (bme280_read_measurement(c->dev, &r) != BME280_OK) return 0;
+    c->seen_seq = c->dev->meas_seq;
+
+    static const int order[] = { SENSOR_TYPE_AMBIENT_TEMPERATURE, SENSOR_TYPE_PRESSURE, SENSOR_TYPE_RELATIVE_HUMIDITY };
+    size_t count = n < 3 ? n : 3;
+    for (size_t i = 0; i < count; ++i) bme280__fill_event(c, order[i], &r, &out[i]);
+    return count;
+}
+
 static void bme280__get_sensor_temp(void *ctx, sensor_t *sensor) {
     if (!ctx || !sensor) return;
     bme280_sensor_wrapper_t *c = (bme280_sensor_wrapper_t *)ctx;
@@ -292,19 +564,6 @@ static void bme280__get_sensor_temp(void *ctx, sensor_t *sensor) {
     sensor->init_delay = 2;
 }
 
-static bool bme280__get_event_pressure(void *ctx, sensors_event_t *event) {
-    if (!ctx || !event) return false;
-    bme280_sensor_wrapper_t *c = (bme280_sensor_wrapper_t *)ctx;
-    bme280_reading_t r;
-    if (bme280_read_measurement(c->dev, &r) != BME280_OK) return false;
-    event->version = sizeof(*event);
-    event->sensor_id = c->sensor_id;
-    event->type = SENSOR_TYPE_PRESSURE;
-    event->timestamp = 0;
-    event->value.pressure = r.pressure_pa / 100.0f; // hPa
-    return true;
-}
-
 static void bme280__get_sensor_pressure(void *ctx, sensor_t *sensor) {
     if (!ctx || !sensor) return;
     bme280_sensor_wrapper_t *c = (bme280_sensor_wrapper_t *)ctx;
@@ -319,19 +578,6 @@ static void bme280__get_sensor_pressure(void *ctx, sensor_t *sensor) {
     sensor->init_delay = 2;
 }
 
-static bool bme280__get_event_humidity(void *ctx, sensors_event_t *event) {
-    if (!ctx || !event) return false;
-    bme280_sensor_wrapper_t *c = (bme280_sensor_wrapper_t *)ctx;
-    bme280_reading_t r;
-    if (bme280_read_measurement(c->dev, &r) != BME280_OK) return false;
-    event->version = sizeof(*event);
-    event->sensor_id = c->sensor_id;
-    event->type = SENSOR_TYPE_RELATIVE_HUMIDITY;
-    event->timestamp = 0;
-    event->value.relative_humidity = r.humidity_rh;
-    return true;
-}
-
 static void bme280__get_sensor_humidity(void *ctx, sensor_t *sensor) {
     if (!ctx || !sensor) return;
     bme280_sensor_wrapper_t *c = (bme280_sensor_wrapper_t *)ctx;
@@ -351,9 +597,12 @@ void bme280_make_temperature_sensor(bme280_sensor_wrapper_t *ctx, bme280_t *dev,
     if (!ctx || !iface) return;
     ctx->dev = dev;
     ctx->sensor_id = sensor_id;
+    ctx->seen_seq = 0;
+    ctx->max_age_ms = BME280_SHARED_MAX_AGE_MS;
     ctx->type = SENSOR_TYPE_AMBIENT_TEMPERATURE;
     iface->context = ctx;
-    iface->get_event = bme280__get_event_temp;
+    iface->get_event = bme280__get_event;
+    iface->get_events = bme280__get_events;
     iface->get_sensor = bme280__get_sensor_temp;
 }
 
@@ -361,9 +610,12 @@ void bme280_make_pressure_sensor(bme280_sensor_wrapper_t *ctx, bme280_t *dev, se
     if (!ctx || !iface) return;
     ctx->dev = dev;
     ctx->sensor_id = sensor_id;
+    ctx->seen_seq = 0;
+    ctx->max_age_ms = BME280_SHARED_MAX_AGE_MS;
     ctx->type = SENSOR_TYPE_PRESSURE;
     iface->context = ctx;
-    iface->get_event = bme280__get_event_pressure;
+    iface->get_event = bme280__get_event;
+    iface->get_events = bme280__get_events;
     iface->get_sensor = bme280__get_sensor_pressure;
 }
 
@@ -371,8 +623,11 @@ void bme280_make_humidity_sensor(bme280_sensor_wrapper_t *ctx, bme280_t *dev, se
     if (!ctx || !iface) return;
     ctx->dev = dev;
     ctx->sensor_id = sensor_id;
+    ctx->seen_seq = 0;
+    ctx->max_age_ms = BME280_SHARED_MAX_AGE_MS;
     ctx->type = SENSOR_TYPE_RELATIVE_HUMIDITY;
     iface->context = ctx;
-    iface->get_event = bme280__get_event_humidity;
+    iface->get_event = bme280__get_event;
+    iface->get_events = bme280__get_events;
     iface->get_sensor = bme280__get_sensor_humidity;
 }
@@ -32,11 +32,18 @@ extern "C" {
 #define BME280_REG_HUM_MSB        0xFD
 #define BME280_REG_HUM_LSB        0xFE
 
+// Burst length of one measurement (PRESS_MSB..HUM_LSB)
+#define BME280_MEAS_BURST_LEN     8
+
 // Calibration register ranges
 #define BME280_CALIB00_START      0x88  // 0x88..0xA1
 #define BME280_CALIB00_END        0xA1
 #define BME280_CALIB26_START      0xE1  // 0xE1..0xE7
 #define BME280_CALIB26_END        0xE7
+#define BME280_CALIB00_LEN        26    // 0x88..0xA1
+#define BME280_CALIB26_LEN        7     // 0xE1..0xE7
+#define BME280_CALIB_RAW_LEN      (BME280_CALIB00_LEN + BME280_CALIB26_LEN)
+#define BME280_CALIB_SPOT_LEN     6     // dig_T1..dig_T3, compared on fast attach
 
 // Reset value
 #define BME280_SOFT_RESET         0xB6
@@ -92,6 +99,8 @@ typedef enum {
 #define BME280_E_COMM             -2
 #define BME280_E_INVALID_ARG      -3
 #define BME280_E_CHIP_ID_MISMATCH -4
+#define BME280_E_CALIB_MISMATCH   -5  // fast attach: device NVM differs from the cached copy
+#define BME280_E_TIMEOUT          -6  // forced conversion still running after polling STATUS
 
 // Bus callback signatures
 // Return 0 on success, negative error on failure.
@@ -124,57 +133,150 @@ typedef struct {
     bme280_mode_t         mode;   // current power mode
 } bme280_settings_t;
 
+// A single compensated reading (SI units)
+typedef struct {
+    float temperature_c; // degrees Celsius
+    float pressure_pa;   // Pascals
+    float humidity_rh;   // % relative humidity (0..100)
+} bme280_reading_t;
+
 // Device context
 typedef struct {
     bme280_bus_t       bus;
     uint8_t            i2c_addr;        // Only used for I2C implementations (bus callbacks may ignore)
     bme280_calib_t     calib;
+    uint8_t            calib_raw[BME280_CALIB_RAW_LEN]; // NVM bytes calib was parsed from (CALIB00 then CALIB26)
     bme280_settings_t  settings;
     int32_t            t_fine;          // for compensation
     bool               calib_loaded;
+    // Most recent measurement; the Sensor.h wrappers serve from it so one bus
+    // read / compensation pass feeds all three quantities of a sampling epoch.
+    bme280_reading_t   last;
+    int32_t            last_adc_T, last_adc_P, last_adc_H;
+    uint32_t           meas_seq;        // bumped on every decoded measurement (0 = none yet)
+    uint64_t           last_ms;         // CLOCK_MONOTONIC of the last decode, for the wrappers' max age
+    // Write-through shadows of the configuration registers, so setters and
+    // forced-mode triggers are write-only. The mode bits of reg_ctrl_meas are
+    // kept as SLEEP after a FORCED trigger (the device returns to sleep itself).
+    uint8_t            reg_ctrl_hum;
+    uint8_t            reg_ctrl_meas;
+    uint8_t            reg_config;
 } bme280_t;
 
-// A single compensated reading (SI units)
-typedef struct {
-    float temperature_c; // degrees Celsius
-    float pressure_pa;   // Pascals
-    float humidity_rh;   // % relative humidity (0..100)
-} bme280_reading_t;
-
 // API
 int bme280_init(bme280_t *dev, const bme280_bus_t *bus, uint8_t i2c_addr);
 int bme280_soft_reset(bme280_t *dev);
 int bme280_read_chip_id(bme280_t *dev, uint8_t *chip_id);
 int bme280_read_calibration(bme280_t *dev);
 
+// Parse raw NVM bytes (CALIB00 block followed by CALIB26 block) into calib.
+void bme280_parse_calibration(const uint8_t raw[BME280_CALIB_RAW_LEN], bme280_calib_t *calib);
+
+// Fast attach to a device that is already powered and configured, using
+// calibration bytes saved earlier (e.g. BME280_CalibCache.h). Skips the soft
+// reset and the calibration read: checks the chip ID, compares the first
+// BME280_CALIB_SPOT_LEN calibration bytes with the cached copy, and reads
+// CTRL_HUM..CONFIG back to seed the register shadows and dev->settings.
+// Returns BME280_E_CALIB_MISMATCH if the spot check fails; fall back to
+// bme280_init() in that case.
+int bme280_attach(bme280_t *dev, const bme280_bus_t *bus, uint8_t i2c_addr,
+                  const uint8_t calib_raw[BME280_CALIB_RAW_LEN]);
+
 // Configuration helpers
 int bme280_set_oversampling(bme280_t *dev, bme280_oversampling_t osr_t, bme280_oversampling_t osr_p, bme280_oversampling_t osr_h);
 int bme280_set_filter(bme280_t *dev, bme280_filter_t filter);
 int bme280_set_standby(bme280_t *dev, bme280_standby_t standby);
 int bme280_set_mode(bme280_t *dev, bme280_mode_t mode);
 
+// Apply oversampling, filter, standby and mode together. Only registers whose
+// shadow differs are written, as one multi-register write transaction
+// (register/value pairs). If CONFIG changes while the device is in NORMAL
+// mode, the transaction first puts it to sleep (CONFIG writes may be ignored
+// in normal mode) and restores the requested mode last. A FORCED mode
+// request always writes CTRL_MEAS and so starts a conversion.
+int bme280_apply_settings(bme280_t *dev, const bme280_settings_t *settings);
+
 // Read raw ADC values (20-bit pressure/temperature, 16-bit humidity)
 int bme280_read_raw(bme280_t *dev, int32_t *adc_T, int32_t *adc_P, int32_t *adc_H);
 
+// Split an 8-byte burst read from BME280_REG_PRESS_MSB into raw ADC values.
+// Useful when the burst was fetched outside of the bus callbacks (e.g. batched reads).
+void bme280_parse_raw(const uint8_t buf[BME280_MEAS_BURST_LEN], int32_t *adc_T, int32_t *adc_P, int32_t *adc_H);
+
+// Parse and compensate an 8-byte burst read from BME280_REG_PRESS_MSB.
+// The result is also stored in dev->last and dev->meas_seq is advanced.
+int bme280_decode_measurement(bme280_t *dev, const uint8_t buf[BME280_MEAS_BURST_LEN], bme280_reading_t *out);
+
 // Compensate raw values to SI units
 float bme280_compensate_temperature(bme280_t *dev, int32_t adc_T);
 float bme280_compensate_pressure(bme280_t *dev, int32_t adc_P);
 float bme280_compensate_humidity(bme280_t *dev, int32_t adc_H);
 
+// Stateless batch compensation of n raw samples (e.g. replaying logged data).
+// Only reads the calibration, so several threads may share one bme280_calib_t.
+// adc_T is required (temperature feeds the P/H formulas); adc_P / adc_H may be
+// NULL to skip that channel, in which case the matching output is untouched.
+//
+// Integer outputs (Bosch reference formats):
+//   temp_c100   : 0.01 degC          (2345 -> 23.45 degC), may be NULL
+//   press_q24_8 : Q24.8 Pa           (24674867 -> 96386.2 Pa)
+//   hum_q22_10  : Q22.10 %RH         (47445 -> 46.333 %RH)
+int bme280_compensate_batch_fixed(const bme280_calib_t *calib,
+                                  const int32_t *adc_T, const int32_t *adc_P, const int32_t *adc_H, size_t n,
+                                  int32_t *temp_c100, uint32_t *press_q24_8, uint32_t *hum_q22_10);
+
+// Same as above with SI float output; skipped channels read as 0.
+int bme280_compensate_batch(const bme280_calib_t *calib,
+                            const int32_t *adc_T, const int32_t *adc_P, const int32_t *adc_H, size_t n,
+                            bme280_reading_t *out);
+
+// Maximum conversion time in microseconds for the given oversampling settings
+// (datasheet appendix B: 1.25 ms + 2.3 ms * osr_t + [2.3 ms * osr_p + 0.575 ms]
+// + [2.3 ms * osr_h + 0.575 ms], bracketed terms only for enabled channels).
+uint32_t bme280_measurement_time_us(const bme280_settings_t *settings);
+
+// Split forced-mode sampling.
+// bme280_trigger_measurement() starts a one-shot conversion when the device is
+// configured for FORCED mode and reports in *wait_us how long the conversion
+// takes (0 in SLEEP/NORMAL mode, where nothing is written). The caller may
+// trigger several sensors, sleep once for the longest wait, and then complete
+// each one with bme280_fetch_measurement(), which burst-reads and compensates
+// without polling STATUS.
+int bme280_trigger_measurement(bme280_t *dev, uint32_t *wait_us);
+int bme280_fetch_measurement(bme280_t *dev, bme280_reading_t *out);
+
 // Convenience: take one measurement according to current settings
-// If in FORCED mode, this function will trigger a measurement and wait for completion.
+// If in FORCED mode, this function triggers a measurement, sleeps for the
+// computed conversion time and then fetches the result. A bus without
+// delay_ms polls STATUS_MEASURING instead and returns BME280_E_TIMEOUT if the
+// conversion does not finish.
 int bme280_read_measurement(bme280_t *dev, bme280_reading_t *out);
 
 // Optional: Adafruit Unified Sensor-style wrappers
 // These helpers build sensor_interface_t wrappers for each quantity.
 #include "Sensor.h"
 
+#ifndef BME280_SHARED_MAX_AGE_MS
+#define BME280_SHARED_MAX_AGE_MS 1000u
+#endif
+
 typedef struct {
     bme280_t *dev;
     int32_t sensor_id;
     int type; // sensors_type_t
+    uint32_t seen_seq; // dev->meas_seq this wrapper last reported
+    uint32_t max_age_ms; // oldest dev->last get_event() serves (default BME280_SHARED_MAX_AGE_MS)
 } bme280_sensor_wrapper_t;
 
+// get_event() reuses dev->last while this wrapper has not reported it yet and
+// it is at most max_age_ms old, and only triggers a new bus read otherwise.
+// Polling temperature, pressure and humidity back to back therefore costs a
+// single measurement, while a wrapper polled after a long pause never reports
+// another wrapper's stale reading.
+// get_events() always takes a fresh measurement and fills up to three events
+// in the order temperature, pressure, humidity (all tagged with the wrapper's
+// sensor_id; use event->type to tell them apart).
+
 void bme280_make_temperature_sensor(bme280_sensor_wrapper_t *ctx, bme280_t *dev, sensor_interface_t *iface, int32_t sensor_id);
 void bme280_make_pressure_sensor(bme280_sensor_wrapper_t *ctx, bme280_t *dev, sensor_interface_t *iface, int32_t sensor_id);
 void bme280_make_humidity_sensor(bme280_sensor_wrapper_t *ctx, bme280_t *dev, sensor_interface_t *iface, int32_t sensor_id);
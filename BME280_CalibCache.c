@@ -0,0 +1,162 @@
+#include "BME280_CalibCache.h"
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* CRC-32 (IEEE 802.3, reflected), bitwise: entries are tiny and rarely checked */
+static uint32_t bme280_cache_crc32(uint32_t crc, const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+static uint32_t bme280_cache_entry_crc(const bme280_calib_cache_entry_t *e) {
+    uint32_t crc = bme280_cache_crc32(0, e->bus, sizeof(e->bus));
+    crc = bme280_cache_crc32(crc, &e->addr, 1);
+    return bme280_cache_crc32(crc, e->raw, sizeof(e->raw));
+}
+
+static bool bme280_cache_key_matches(const bme280_calib_cache_entry_t *e, const char *bus, uint8_t addr) {
+    return e->used && e->addr == addr && strncmp(e->bus, bus, sizeof(e->bus)) == 0;
+}
+
+int bme280_calib_cache_open(bme280_calib_cache_t *cache, const char *path) {
+    if (!cache) { errno = EINVAL; return -1; }
+    cache->fd = -1;
+    cache->map = NULL;
+    if (!path || !path[0]) { errno = EINVAL; return -1; }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+
+    const size_t size = sizeof(bme280_calib_cache_file_t);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || ((size_t)st.st_size != size && ftruncate(fd, (off_t)size) != 0)) {
+        int e = errno; close(fd); errno = e;
+        return -1;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        int e = errno; close(fd); errno = e;
+        return -1;
+    }
+
+    bme280_calib_cache_file_t *f = (bme280_calib_cache_file_t *)map;
+    if (f->magic != BME280_CALIB_CACHE_MAGIC || f->version != BME280_CALIB_CACHE_VERSION ||
+        f->entry_size != sizeof(bme280_calib_cache_entry_t) || f->entries != BME280_CALIB_CACHE_ENTRIES) {
+        /* New file, older layout or different build: start empty */
+        memset(f, 0, size);
+        f->magic = BME280_CALIB_CACHE_MAGIC;
+        f->version = BME280_CALIB_CACHE_VERSION;
+        f->entry_size = sizeof(bme280_calib_cache_entry_t);
+        f->entries = BME280_CALIB_CACHE_ENTRIES;
+        msync(f, size, MS_ASYNC);
+    }
+    cache->fd = fd;
+    cache->map = f;
+    return 0;
+}
+
+void bme280_calib_cache_close(bme280_calib_cache_t *cache) {
+    if (!cache) return;
+    if (cache->map) munmap(cache->map, sizeof(bme280_calib_cache_file_t));
+    if (cache->fd >= 0) close(cache->fd);
+    cache->map = NULL;
+    cache->fd = -1;
+}
+
+const uint8_t *bme280_calib_cache_lookup(const bme280_calib_cache_t *cache, const char *bus, uint8_t addr) {
+    if (!cache || !cache->map || !bus) return NULL;
+    for (size_t i = 0; i < BME280_CALIB_CACHE_ENTRIES; ++i) {
+        const bme280_calib_cache_entry_t *e = &cache->map->entry[i];
+        if (!bme280_cache_key_matches(e, bus, addr)) continue;
+        return bme280_cache_entry_crc(e) == e->crc ? e->raw : NULL;
+    }
+    return NULL;
+}
+
+int bme280_calib_cache_store(bme280_calib_cache_t *cache, const char *bus, uint8_t addr,
+                             const uint8_t raw[BME280_CALIB_RAW_LEN]) {
+    if (!cache || !cache->map || !bus || !raw) { errno = EINVAL; return -1; }
+    if (strlen(bus) >= BME280_CALIB_CACHE_PATH_MAX) { errno = ENAMETOOLONG; return -1; }
+
+    /* Same key first, then a free slot, then recycle slot 0.. in order (the
+     * cursor lives in the file, so the order carries over restarts) */
+    bme280_calib_cache_entry_t *slot = NULL;
+    for (size_t i = 0; i < BME280_CALIB_CACHE_ENTRIES && !slot; ++i) {
+        if (bme280_cache_key_matches(&cache->map->entry[i], bus, addr)) slot = &cache->map->entry[i];
+    }
+    for (size_t i = 0; i < BME280_CALIB_CACHE_ENTRIES && !slot; ++i) {
+        if (!cache->map->entry[i].used) slot = &cache->map->entry[i];
+    }
+    if (!slot) {
+        uint32_t next = cache->map->next_evict % BME280_CALIB_CACHE_ENTRIES;
+        slot = &cache->map->entry[next];
+        cache->map->next_evict = (next + 1u) % BME280_CALIB_CACHE_ENTRIES;
+    }
+
+    bme280_calib_cache_entry_t e;
+    memset(&e, 0, sizeof(e));
+    strncpy(e.bus, bus, sizeof(e.bus) - 1);
+    e.addr = addr;
+    e.used = 1;
+    memcpy(e.raw, raw, sizeof(e.raw));
+    e.crc = bme280_cache_entry_crc(&e);
+    *slot = e;
+    return msync(cache->map, sizeof(*cache->map), MS_ASYNC);
+}
+
+void bme280_calib_cache_invalidate(bme280_calib_cache_t *cache, const char *bus, uint8_t addr) {
+    if (!cache || !cache->map || !bus) return;
+    for (size_t i = 0; i < BME280_CALIB_CACHE_ENTRIES; ++i) {
+        bme280_calib_cache_entry_t *e = &cache->map->entry[i];
+        if (bme280_cache_key_matches(e, bus, addr)) memset(e, 0, sizeof(*e));
+    }
+}
+
+int bme280_init_cached(bme280_t *dev, const bme280_bus_t *bus, uint8_t i2c_addr,
+                       bme280_calib_cache_t *cache, const char *bus_path, int *fast) {
+    if (fast) *fast = 0;
+    if (!dev || !bus) return BME280_E_NULL_PTR;
+
+    pthread_mutex_t *lock = cache ? cache->lock : NULL;
+    uint8_t raw[BME280_CALIB_RAW_LEN];
+    const uint8_t *cached = NULL;
+    if (bus_path) {
+        if (lock) pthread_mutex_lock(lock);
+        cached = bme280_calib_cache_lookup(cache, bus_path, i2c_addr);
+        if (cached) memcpy(raw, cached, sizeof(raw));
+        if (lock) pthread_mutex_unlock(lock);
+    }
+    if (cached) {
+        int rc = bme280_attach(dev, bus, i2c_addr, raw);
+        if (rc == BME280_OK) {
+            if (fast) *fast = 1;
+            return BME280_OK;
+        }
+        if (rc != BME280_E_CALIB_MISMATCH) return rc; /* no device / bus error: nothing to retry */
+        if (lock) pthread_mutex_lock(lock);
+        bme280_calib_cache_invalidate(cache, bus_path, i2c_addr);
+        if (lock) pthread_mutex_unlock(lock);
+    }
+
+    int rc = bme280_init(dev, bus, i2c_addr);
+    if (rc == BME280_OK && bus_path) {
+        if (lock) pthread_mutex_lock(lock);
+        bme280_calib_cache_store(cache, bus_path, i2c_addr, dev->calib_raw);
+        if (lock) pthread_mutex_unlock(lock);
+    }
+    return rc;
+}
+
+#endif /* __linux__ */
@@ -0,0 +1,91 @@
+#ifndef BME280_CALIBCACHE_H
+#define BME280_CALIBCACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Persistent BME280 calibration cache.
+ * A small fixed-size binary file, mmap'ed shared, holding the raw NVM
+ * calibration bytes of previously seen sensors keyed by bus path and address.
+ * Each entry carries a CRC32 over key and bytes, so a torn or stale entry is
+ * treated as a miss. With a valid entry, bme280_init_cached() attaches through
+ * bme280_attach() (chip ID + 6-byte spot check + control readback) instead of
+ * soft reset, IM_UPDATE polling and both calibration reads.
+ *
+ * The file layout is host-endian and versioned; a header mismatch makes the
+ * cache start empty. Build only on Linux targets.
+ */
+
+#include "BME280.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <stdint.h>
+
+#define BME280_CALIB_CACHE_MAGIC    0x4C414342u /* "BCAL" */
+#define BME280_CALIB_CACHE_VERSION  2u
+#ifndef BME280_CALIB_CACHE_ENTRIES
+#define BME280_CALIB_CACHE_ENTRIES  32
+#endif
+#define BME280_CALIB_CACHE_PATH_MAX 48
+
+typedef struct {
+    char     bus[BME280_CALIB_CACHE_PATH_MAX]; /* NUL-terminated, e.g. "/dev/i2c-1" */
+    uint8_t  addr;                             /* I2C address, 0 for SPI */
+    uint8_t  used;
+    uint8_t  raw[BME280_CALIB_RAW_LEN];        /* CALIB00 then CALIB26 */
+    uint8_t  pad[1];
+    uint32_t crc;                              /* CRC32 of bus, addr and raw */
+} bme280_calib_cache_entry_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entry_size;
+    uint32_t entries;
+    uint32_t next_evict; /* entry a store recycles when none is free, round-robin */
+    bme280_calib_cache_entry_t entry[BME280_CALIB_CACHE_ENTRIES];
+} bme280_calib_cache_file_t;
+
+typedef struct {
+    int fd;
+    bme280_calib_cache_file_t *map;
+    pthread_mutex_t *lock;  /* NULL or set by the caller (open/close leave it);
+                               bme280_init_cached() holds it around cache
+                               accesses only, never across bus I/O */
+} bme280_calib_cache_t;
+
+/* Open (creating if needed) and map the cache file.
+ * Returns 0 on success, -1 on error with errno set; the handle is then
+ * unusable but safe to pass to the other functions (they become no-ops). */
+int bme280_calib_cache_open(bme280_calib_cache_t *cache, const char *path);
+void bme280_calib_cache_close(bme280_calib_cache_t *cache);
+
+/* Cached raw calibration for (bus, addr), or NULL if absent or invalid. */
+const uint8_t *bme280_calib_cache_lookup(const bme280_calib_cache_t *cache, const char *bus, uint8_t addr);
+
+/* Insert or replace the entry for (bus, addr). Returns 0 or -1. */
+int bme280_calib_cache_store(bme280_calib_cache_t *cache, const char *bus, uint8_t addr,
+                             const uint8_t raw[BME280_CALIB_RAW_LEN]);
+
+/* Drop the entry for (bus, addr), e.g. after a spot-check mismatch. */
+void bme280_calib_cache_invalidate(bme280_calib_cache_t *cache, const char *bus, uint8_t addr);
+
+/* bme280_attach() when the cache has a valid entry, otherwise (or if the spot
+ * check fails) bme280_init() followed by storing the calibration.
+ * cache may be NULL. *fast (optional) reports whether the fast path was used.
+ * With cache->lock set, several threads may share one cache: the entry is
+ * copied out under the lock, so a slow or hung bus never holds it. */
+int bme280_init_cached(bme280_t *dev, const bme280_bus_t *bus, uint8_t i2c_addr,
+                       bme280_calib_cache_t *cache, const char *bus_path, int *fast);
+
+#else
+#warning "BME280_CalibCache.h included on non-Linux target; no declarations emitted."
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BME280_CALIBCACHE_H */
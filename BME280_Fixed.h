@@ -0,0 +1,288 @@
+#ifndef BME280_FIXED_H
+#define BME280_FIXED_H
+
+// Build-time specialized BME280 driver (header-only, Linux).
+//
+// For single-sensor appliances whose bus, I2C address and sensor settings
+// never change. Compared with bme280_t there are no bus callbacks, no
+// settings or calibration-loaded checks and no register shadows: the
+// transport is an ioctl on the device fd, every register image is a
+// compile-time constant, and channels configured as skipped are neither
+// read nor compensated. bme280_fixed_read() is straight-line code: one
+// trigger, one sleep of a constant length, one burst read and the kernels.
+//
+// Selected with `make BME280_FIXED=i2c` or `make BME280_FIXED=spi`; the
+// sensor registry then drives every device through this variant. Settings
+// (integers, as in the datasheet register fields):
+//
+//   BME280_FIXED_ADDR      I2C address                     default 0x76
+//   BME280_FIXED_SPI_HZ    SPI clock (mode 0)              default 8 MHz
+//   BME280_FIXED_OSR_T/_P/_H  0 = skip, 1..5 = x1..x16     default 1
+//   BME280_FIXED_FILTER    0 = off, 1..4 = 2..16           default 0
+//   BME280_FIXED_MODE      1 = forced, 3 = normal          default 1
+//   BME280_FIXED_STANDBY   normal mode standby code        default 5 (1 s)
+//
+// e.g. make BME280_FIXED=i2c CFLAGS+="-DBME280_FIXED_OSR_H=0 -DBME280_FIXED_OSR_P=3"
+//
+// Readings of skipped channels are NaN. Functions return BME280_OK or a
+// BME280_E_* code; the device pointer is never checked.
+
+#include "BME280.h"
+#include "BME280_Kernels.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#define BME280_FIXED_BUS_I2C 1
+#define BME280_FIXED_BUS_SPI 2
+
+// bme280_mode_t values, usable in #if
+#define BME280_FIXED_FORCED  1
+#define BME280_FIXED_NORMAL  3
+
+#ifndef BME280_FIXED_BUS
+#define BME280_FIXED_BUS BME280_FIXED_BUS_I2C
+#endif
+#ifndef BME280_FIXED_ADDR
+#define BME280_FIXED_ADDR BME280_I2C_ADDR_SDO_LOW
+#endif
+#ifndef BME280_FIXED_SPI_HZ
+#define BME280_FIXED_SPI_HZ 8000000u
+#endif
+#ifndef BME280_FIXED_OSR_T
+#define BME280_FIXED_OSR_T 1
+#endif
+#ifndef BME280_FIXED_OSR_P
+#define BME280_FIXED_OSR_P 1
+#endif
+#ifndef BME280_FIXED_OSR_H
+#define BME280_FIXED_OSR_H 1
+#endif
+#ifndef BME280_FIXED_FILTER
+#define BME280_FIXED_FILTER 0
+#endif
+#ifndef BME280_FIXED_MODE
+#define BME280_FIXED_MODE 1
+#endif
+#ifndef BME280_FIXED_STANDBY
+#define BME280_FIXED_STANDBY 5
+#endif
+
+#if BME280_FIXED_OSR_T < 1 || BME280_FIXED_OSR_T > 5
+#error "BME280_FIXED_OSR_T must be 1..5: pressure and humidity need t_fine"
+#endif
+#if BME280_FIXED_OSR_P < 0 || BME280_FIXED_OSR_P > 5 || BME280_FIXED_OSR_H < 0 || BME280_FIXED_OSR_H > 5
+#error "BME280_FIXED_OSR_P/_H must be 0..5"
+#endif
+#if BME280_FIXED_MODE != BME280_FIXED_FORCED && BME280_FIXED_MODE != BME280_FIXED_NORMAL
+#error "BME280_FIXED_MODE must be 1 (forced) or 3 (normal)"
+#endif
+
+#if BME280_FIXED_BUS == BME280_FIXED_BUS_I2C
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#elif BME280_FIXED_BUS == BME280_FIXED_BUS_SPI
+#include <linux/spi/spidev.h>
+#else
+#error "BME280_FIXED_BUS must be BME280_FIXED_BUS_I2C or BME280_FIXED_BUS_SPI"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Register images
+#define BME280_FIXED_CTRL_HUM   BME280_FIXED_OSR_H
+#define BME280_FIXED_CTRL_MEAS  ((BME280_FIXED_OSR_T << 5) | (BME280_FIXED_OSR_P << 2) | BME280_FIXED_MODE)
+#define BME280_FIXED_CONFIG     ((BME280_FIXED_STANDBY << 5) | (BME280_FIXED_FILTER << 2))
+
+// Datasheet maximum conversion time (same formula as bme280_measurement_time_us)
+#define BME280_FIXED_OSR_N(o)   ((o) ? (1u << ((o) - 1)) : 0u)
+#define BME280_FIXED_WAIT_US    (1250u + 2300u * BME280_FIXED_OSR_N(BME280_FIXED_OSR_T) \
+                                 + (BME280_FIXED_OSR_P ? 2300u * BME280_FIXED_OSR_N(BME280_FIXED_OSR_P) + 575u : 0u) \
+                                 + (BME280_FIXED_OSR_H ? 2300u * BME280_FIXED_OSR_N(BME280_FIXED_OSR_H) + 575u : 0u))
+
+// Burst window: only the enabled channels (P at F7..F9, T at FA..FC, H at FD..FE)
+#define BME280_FIXED_BURST_REG  (BME280_FIXED_OSR_P ? BME280_REG_PRESS_MSB : BME280_REG_TEMP_MSB)
+#define BME280_FIXED_BURST_END  (BME280_FIXED_OSR_H ? BME280_REG_HUM_LSB : BME280_REG_TEMP_XLSB)
+#define BME280_FIXED_BURST_LEN  (BME280_FIXED_BURST_END - BME280_FIXED_BURST_REG + 1)
+#define BME280_FIXED_OFF_T      (BME280_REG_TEMP_MSB - BME280_FIXED_BURST_REG)
+
+// SPI keeps trigger, wait and burst in one SPI_IOC_MESSAGE while the wait
+// fits the 16-bit delay_usecs field
+#if BME280_FIXED_BUS == BME280_FIXED_BUS_SPI && BME280_FIXED_WAIT_US <= 65535u
+#define BME280_FIXED_SPI_ONE_IOCTL 1
+#else
+#define BME280_FIXED_SPI_ONE_IOCTL 0
+#endif
+
+typedef struct {
+    int            fd;
+    bme280_calib_t calib;
+    uint8_t        calib_raw[BME280_CALIB_RAW_LEN]; // CALIB00 then CALIB26
+    int32_t        last_adc_T, last_adc_P, last_adc_H;
+} bme280_fixed_t;
+
+// ===== Transport =====
+
+#if BME280_FIXED_BUS == BME280_FIXED_BUS_I2C
+
+static inline int bme280_fixed_read_regs(bme280_fixed_t *dev, uint8_t reg, uint8_t *buf, uint16_t len) {
+    struct i2c_msg msgs[2] = {
+        { .addr = BME280_FIXED_ADDR, .flags = 0, .len = 1, .buf = &reg },
+        { .addr = BME280_FIXED_ADDR, .flags = I2C_M_RD, .len = len, .buf = buf },
+    };
+    struct i2c_rdwr_ioctl_data rdwr = { msgs, 2 };
+    return ioctl(dev->fd, I2C_RDWR, &rdwr) == 2 ? BME280_OK : BME280_E_COMM;
+}
+
+// buf holds register/value pairs; on I2C the pairs go out as one write
+static inline int bme280_fixed_write_pairs(bme280_fixed_t *dev, uint8_t *buf, uint16_t len) {
+    struct i2c_msg msg = { .addr = BME280_FIXED_ADDR, .flags = 0, .len = len, .buf = buf };
+    struct i2c_rdwr_ioctl_data rdwr = { &msg, 1 };
+    return ioctl(dev->fd, I2C_RDWR, &rdwr) == 1 ? BME280_OK : BME280_E_COMM;
+}
+
+#else
+
+static inline int bme280_fixed_read_regs(bme280_fixed_t *dev, uint8_t reg, uint8_t *buf, uint16_t len) {
+    uint8_t tx[1 + 32] = { (uint8_t)(reg | 0x80) }, rx[1 + 32];
+    if (len > 32) return BME280_E_INVALID_ARG;
+    struct spi_ioc_transfer x = {
+        .tx_buf = (uintptr_t)tx, .rx_buf = (uintptr_t)rx, .len = 1u + len,
+        .speed_hz = BME280_FIXED_SPI_HZ, .bits_per_word = 8,
+    };
+    if (ioctl(dev->fd, SPI_IOC_MESSAGE(1), &x) < 0) return BME280_E_COMM;
+    memcpy(buf, rx + 1, len);
+    return BME280_OK;
+}
+
+// SPI writes clear bit 7 of every register byte in the pairs
+static inline int bme280_fixed_write_pairs(bme280_fixed_t *dev, uint8_t *buf, uint16_t len) {
+    for (uint16_t i = 0; i < len; i += 2) buf[i] &= 0x7F;
+    struct spi_ioc_transfer x = {
+        .tx_buf = (uintptr_t)buf, .len = len, .speed_hz = BME280_FIXED_SPI_HZ, .bits_per_word = 8,
+    };
+    return ioctl(dev->fd, SPI_IOC_MESSAGE(1), &x) < 0 ? BME280_E_COMM : BME280_OK;
+}
+
+#endif
+
+static inline void bme280_fixed_sleep_us(uint32_t us) {
+    struct timespec ts = { (time_t)(us / 1000000u), (long)(us % 1000000u) * 1000L };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+}
+
+// ===== Init =====
+
+static inline void bme280_fixed_close(bme280_fixed_t *dev) {
+    if (dev->fd >= 0) close(dev->fd);
+    dev->fd = -1;
+}
+
+// Open the bus node, check the chip ID, soft reset, read the calibration and
+// write the constant configuration (only taken in sleep mode, so CTRL_MEAS
+// goes last).
+static inline int bme280_fixed_open(bme280_fixed_t *dev, const char *path) {
+    memset(dev, 0, sizeof(*dev));
+    dev->last_adc_P = 0x80000; // what the chip reports for skipped channels
+    dev->last_adc_H = 0x8000;
+    dev->fd = open(path, O_RDWR | O_CLOEXEC);
+    if (dev->fd < 0) return BME280_E_COMM;
+#if BME280_FIXED_BUS == BME280_FIXED_BUS_SPI
+    uint8_t mode = SPI_MODE_0, bits = 8;
+    uint32_t hz = BME280_FIXED_SPI_HZ;
+    if (ioctl(dev->fd, SPI_IOC_WR_MODE, &mode) < 0 || ioctl(dev->fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+        ioctl(dev->fd, SPI_IOC_WR_MAX_SPEED_HZ, &hz) < 0) {
+        bme280_fixed_close(dev);
+        return BME280_E_COMM;
+    }
+#endif
+    uint8_t id = 0;
+    int rc = bme280_fixed_read_regs(dev, BME280_REG_ID, &id, 1);
+    if (rc == BME280_OK && id != BME280_CHIP_ID) rc = BME280_E_CHIP_ID_MISMATCH;
+    if (rc == BME280_OK) {
+        uint8_t reset[2] = { BME280_REG_RESET, 0xB6 };
+        rc = bme280_fixed_write_pairs(dev, reset, sizeof(reset));
+    }
+    if (rc == BME280_OK) {
+        // NVM copy after reset: 2 ms startup, then IM_UPDATE clears
+        bme280_fixed_sleep_us(2000);
+        uint8_t status = BME280_STATUS_IM_UPDATE;
+        for (int i = 0; i < 10 && rc == BME280_OK && (status & BME280_STATUS_IM_UPDATE); ++i) {
+            rc = bme280_fixed_read_regs(dev, BME280_REG_STATUS, &status, 1);
+            if (status & BME280_STATUS_IM_UPDATE) bme280_fixed_sleep_us(1000);
+        }
+    }
+    if (rc == BME280_OK) rc = bme280_fixed_read_regs(dev, BME280_CALIB00_START, dev->calib_raw, BME280_CALIB00_LEN);
+    if (rc == BME280_OK) rc = bme280_fixed_read_regs(dev, BME280_CALIB26_START, dev->calib_raw + BME280_CALIB00_LEN, BME280_CALIB26_LEN);
+    if (rc == BME280_OK) {
+        bme280_parse_calibration(dev->calib_raw, &dev->calib);
+        // Forced mode: configure in sleep; each read triggers its own conversion
+        uint8_t cfg[6] = {
+            BME280_REG_CTRL_HUM, BME280_FIXED_CTRL_HUM,
+            BME280_REG_CONFIG, BME280_FIXED_CONFIG,
+            BME280_REG_CTRL_MEAS, (uint8_t)(BME280_FIXED_MODE == BME280_FIXED_FORCED ? BME280_FIXED_CTRL_MEAS & ~0x03 : BME280_FIXED_CTRL_MEAS),
+        };
+        rc = bme280_fixed_write_pairs(dev, cfg, sizeof(cfg));
+    }
+    if (rc != BME280_OK) bme280_fixed_close(dev);
+    return rc;
+}
+
+// ===== Hot path =====
+
+// Forced mode: trigger, wait BME280_FIXED_WAIT_US, read the enabled channels.
+// Normal mode: read the latest conversion.
+static inline int bme280_fixed_read(bme280_fixed_t *dev, bme280_reading_t *out) {
+    uint8_t raw[BME280_FIXED_BURST_LEN];
+#if BME280_FIXED_MODE == BME280_FIXED_FORCED && BME280_FIXED_SPI_ONE_IOCTL
+    uint8_t trig[2] = { BME280_REG_CTRL_MEAS & 0x7F, BME280_FIXED_CTRL_MEAS };
+    uint8_t tx[1 + BME280_FIXED_BURST_LEN] = { BME280_FIXED_BURST_REG | 0x80 }, rx[1 + BME280_FIXED_BURST_LEN];
+    struct spi_ioc_transfer x[2] = {
+        { .tx_buf = (uintptr_t)trig, .len = 2, .speed_hz = BME280_FIXED_SPI_HZ, .bits_per_word = 8,
+          .delay_usecs = (uint16_t)BME280_FIXED_WAIT_US, .cs_change = 1 },
+        { .tx_buf = (uintptr_t)tx, .rx_buf = (uintptr_t)rx, .len = sizeof(tx),
+          .speed_hz = BME280_FIXED_SPI_HZ, .bits_per_word = 8 },
+    };
+    if (ioctl(dev->fd, SPI_IOC_MESSAGE(2), x) < 0) return BME280_E_COMM;
+    memcpy(raw, rx + 1, sizeof(raw));
+#else
+#if BME280_FIXED_MODE == BME280_FIXED_FORCED
+    uint8_t trig[2] = { BME280_REG_CTRL_MEAS, BME280_FIXED_CTRL_MEAS };
+    if (bme280_fixed_write_pairs(dev, trig, sizeof(trig)) != BME280_OK) return BME280_E_COMM;
+    bme280_fixed_sleep_us(BME280_FIXED_WAIT_US);
+#endif
+    if (bme280_fixed_read_regs(dev, BME280_FIXED_BURST_REG, raw, sizeof(raw)) != BME280_OK) return BME280_E_COMM;
+#endif
+
+    const uint8_t *t = raw + BME280_FIXED_OFF_T;
+    dev->last_adc_T = ((int32_t)t[0] << 12) | ((int32_t)t[1] << 4) | ((int32_t)t[2] >> 4);
+    int32_t t_fine = bme280__t_fine(&dev->calib, dev->last_adc_T);
+    out->temperature_c = (t_fine * 5 + 128) / 256.0f / 100.0f;
+#if BME280_FIXED_OSR_P
+    dev->last_adc_P = ((int32_t)raw[0] << 12) | ((int32_t)raw[1] << 4) | ((int32_t)raw[2] >> 4);
+    out->pressure_pa = (float)bme280__pressure_q24_8(&dev->calib, t_fine, dev->last_adc_P) / 256.0f;
+#else
+    out->pressure_pa = NAN;
+#endif
+#if BME280_FIXED_OSR_H
+    const uint8_t *h = t + 3;
+    dev->last_adc_H = ((int32_t)h[0] << 8) | h[1];
+    out->humidity_rh = fminf((float)bme280__humidity_q22_10(&dev->calib, t_fine, dev->last_adc_H) / 1024.0f, 100.0f);
+#else
+    out->humidity_rh = NAN;
+#endif
+    return BME280_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BME280_FIXED_H
@@ -2,6 +2,7 @@
 
 #if defined(__linux__)
 
+#include <string.h>
 #include <time.h>
 
 static int bme280_i2c_read(void *user, uint8_t reg, uint8_t *buf, size_t len) {
@@ -40,4 +41,146 @@ int bme280_init_i2c_linux(bme280_t *bme, I2CDevice *i2c, uint8_t i2c_addr) {
     return bme280_init(bme, &bus, i2c_addr);
 }
 
+/* ===== Multi-device sampling ===== */
+
+void bme280_i2c_batch_init(bme280_i2c_batch_t *batch) {
+    if (!batch) return;
+    memset(batch, 0, sizeof(*batch));
+}
+
+int bme280_i2c_batch_add(bme280_i2c_batch_t *batch, bme280_t *bme, I2CDevice *i2c) {
+    if (!batch || !bme || !i2c) return BME280_E_NULL_PTR;
+    if (batch->count >= BME280_I2C_BATCH_MAX || !i2c_device_is_open(i2c)) return BME280_E_INVALID_ARG;
+    bme280_i2c_batch_entry_t *e = &batch->entries[batch->count];
+    memset(e, 0, sizeof(*e));
+    e->dev = bme;
+    e->i2c = i2c;
+    e->reg = BME280_REG_PRESS_MSB;
+    e->status = BME280_E_COMM;
+    return (int)batch->count++;
+}
+
+/* Entries on the same adapter share one transaction; entry i is the group leader
+ * when no earlier entry uses the same device path. */
+static bool bme280_i2c_batch_same_bus(const bme280_i2c_batch_entry_t *a, const bme280_i2c_batch_entry_t *b) {
+    return strncmp(a->i2c->path, b->i2c->path, I2C_DEVICE_PATH_MAX) == 0;
+}
+
+static bool bme280_i2c_batch_is_leader(const bme280_i2c_batch_t *batch, size_t i) {
+    for (size_t j = 0; j < i; ++j) {
+        if (bme280_i2c_batch_same_bus(&batch->entries[j], &batch->entries[i])) return false;
+    }
+    return true;
+}
+
+static uint16_t bme280_i2c_msg_flags(const I2CDevice *i2c) {
+    return i2c->tenbit ? I2C_M_TEN : 0;
+}
+
+int bme280_i2c_batch_trigger(bme280_i2c_batch_t *batch) {
+    if (!batch) return BME280_E_NULL_PTR;
+    batch->ioctls = 0;
+    batch->wait_us = 0;
+
+    /* Two-byte [reg, value] payload per device; kept alive until the ioctl returns */
+    uint8_t payload[BME280_I2C_BATCH_MAX][2];
+    struct i2c_msg msgs[I2C_RDWR_IOCTL_MAX_MSGS];
+    int first_err = BME280_OK;
+
+    for (size_t i = 0; i < batch->count; ++i) {
+        if (!bme280_i2c_batch_is_leader(batch, i)) continue;
+        size_t n = 0;
+        for (size_t j = i; j < batch->count; ++j) {
+            bme280_i2c_batch_entry_t *e = &batch->entries[j];
+            if (!bme280_i2c_batch_same_bus(&batch->entries[i], e)) continue;
+            if (e->dev->settings.mode != BME280_FORCED_MODE) continue;
+            uint32_t wait_us = bme280_measurement_time_us(&e->dev->settings);
+            if (wait_us > batch->wait_us) batch->wait_us = wait_us;
+            /* From the shadow: oversampling bits as last applied, mode = FORCED */
+            payload[j][0] = BME280_REG_CTRL_MEAS;
+            payload[j][1] = (uint8_t)((e->dev->reg_ctrl_meas & ~0x03) | BME280_FORCED_MODE);
+            msgs[n].addr  = e->i2c->addr;
+            msgs[n].flags = bme280_i2c_msg_flags(e->i2c);
+            msgs[n].len   = 2;
+            msgs[n].buf   = payload[j];
+            if (++n == I2C_RDWR_IOCTL_MAX_MSGS) {
+                batch->ioctls++;
+                if (i2c_device_rdwr(batch->entries[i].i2c, msgs, n) != 0 && first_err == BME280_OK) first_err = BME280_E_COMM;
+                n = 0;
+            }
+        }
+        if (n) {
+            batch->ioctls++;
+            if (i2c_device_rdwr(batch->entries[i].i2c, msgs, n) != 0 && first_err == BME280_OK) first_err = BME280_E_COMM;
+        }
+    }
+    return first_err;
+}
+
+static void bme280_i2c_batch_finish(bme280_i2c_batch_entry_t *e) {
+    e->status = bme280_decode_measurement(e->dev, e->buf, &e->reading);
+}
+
+/* Fallback when a combined transaction fails: isolate the bad device(s). */
+static void bme280_i2c_batch_read_single(bme280_i2c_batch_t *batch, bme280_i2c_batch_entry_t *e) {
+    batch->ioctls++;
+    if (i2c_device_read_reg(e->i2c, e->reg, e->buf, sizeof(e->buf), 1) != 0) {
+        e->status = BME280_E_COMM;
+        return;
+    }
+    bme280_i2c_batch_finish(e);
+}
+
+static void bme280_i2c_batch_submit(bme280_i2c_batch_t *batch, const I2CDevice *bus,
+                                    struct i2c_msg *msgs, bme280_i2c_batch_entry_t **group, size_t n) {
+    if (n == 0) return;
+    batch->ioctls++;
+    if (i2c_device_rdwr(bus, msgs, n * 2) == 0) {
+        for (size_t k = 0; k < n; ++k) bme280_i2c_batch_finish(group[k]);
+        return;
+    }
+    for (size_t k = 0; k < n; ++k) bme280_i2c_batch_read_single(batch, group[k]);
+}
+
+int bme280_i2c_batch_read(bme280_i2c_batch_t *batch) {
+    if (!batch) return BME280_E_NULL_PTR;
+    batch->ioctls = 0;
+
+    /* Two messages per device: register write + 8-byte read with repeated start */
+    enum { PER_CALL = I2C_RDWR_IOCTL_MAX_MSGS / 2 };
+    struct i2c_msg msgs[PER_CALL * 2];
+    bme280_i2c_batch_entry_t *group[PER_CALL];
+
+    for (size_t i = 0; i < batch->count; ++i) {
+        if (!bme280_i2c_batch_is_leader(batch, i)) continue;
+        size_t n = 0;
+        for (size_t j = i; j < batch->count; ++j) {
+            bme280_i2c_batch_entry_t *e = &batch->entries[j];
+            if (!bme280_i2c_batch_same_bus(&batch->entries[i], e)) continue;
+            e->status = BME280_E_COMM;
+            uint16_t flags = bme280_i2c_msg_flags(e->i2c);
+            msgs[2 * n].addr      = e->i2c->addr;
+            msgs[2 * n].flags     = flags;
+            msgs[2 * n].len       = 1;
+            msgs[2 * n].buf       = &e->reg;
+            msgs[2 * n + 1].addr  = e->i2c->addr;
+            msgs[2 * n + 1].flags = flags | I2C_M_RD;
+            msgs[2 * n + 1].len   = sizeof(e->buf);
+            msgs[2 * n + 1].buf   = e->buf;
+            group[n] = e;
+            if (++n == PER_CALL) {
+                bme280_i2c_batch_submit(batch, batch->entries[i].i2c, msgs, group, n);
+                n = 0;
+            }
+        }
+        bme280_i2c_batch_submit(batch, batch->entries[i].i2c, msgs, group, n);
+    }
+
+    int ok = 0;
+    for (size_t i = 0; i < batch->count; ++i) {
+        if (batch->entries[i].status == BME280_OK) ok++;
+    }
+    return ok;
+}
+
 #endif /* __linux__ */
@@ -21,6 +21,52 @@ void bme280_bus_from_i2c_device(bme280_bus_t *out, I2CDevice *dev);
 /* Convenience initializer: wraps bus setup + bme280_init */
 int bme280_init_i2c_linux(bme280_t *bme, I2CDevice *i2c, uint8_t i2c_addr);
 
+/* Multi-device sampling.
+ * Collects the BME280_REG_PRESS_MSB burst reads of several sensors and submits
+ * them as one I2C_RDWR transaction per adapter (grouped by I2CDevice path, so
+ * sensors at 0x76/0x77 and on each muxed segment are handled in one call per
+ * /dev/i2c-* node). Every device keeps its own bme280_t for calibration.
+ */
+#ifndef BME280_I2C_BATCH_MAX
+#define BME280_I2C_BATCH_MAX 16
+#endif
+
+typedef struct {
+    bme280_t        *dev;
+    I2CDevice       *i2c;
+    uint8_t          reg;                          /* register byte sent before the read */
+    uint8_t          buf[BME280_MEAS_BURST_LEN];   /* raw burst from the last round */
+    int              status;                       /* BME280_OK or error of the last round */
+    bme280_reading_t reading;                      /* compensated values of the last round */
+} bme280_i2c_batch_entry_t;
+
+typedef struct {
+    bme280_i2c_batch_entry_t entries[BME280_I2C_BATCH_MAX];
+    size_t   count;
+    uint32_t ioctls;  /* I2C_RDWR calls issued by the last trigger/read round */
+    uint32_t wait_us; /* longest conversion time started by the last trigger */
+} bme280_i2c_batch_t;
+
+void bme280_i2c_batch_init(bme280_i2c_batch_t *batch);
+
+/* Register an initialized sensor. Returns the entry index or a negative BME280_E_* code. */
+int bme280_i2c_batch_add(bme280_i2c_batch_t *batch, bme280_t *bme, I2CDevice *i2c);
+
+/* Start a conversion on every entry configured for BME280_FORCED_MODE
+ * (one CTRL_MEAS write per device, one ioctl per adapter). Entries in
+ * NORMAL mode are left untouched. batch->wait_us receives the longest
+ * datasheet conversion time among the triggered sensors; sleep that long
+ * once, then call bme280_i2c_batch_read. Returns BME280_OK or the first error.
+ */
+int bme280_i2c_batch_trigger(bme280_i2c_batch_t *batch);
+
+/* Burst-read and compensate all entries. If the combined transaction fails
+ * (e.g. one device NACKs), the affected adapter group is retried device by
+ * device so a single bad sensor does not invalidate the round.
+ * Returns the number of entries with status == BME280_OK.
+ */
+int bme280_i2c_batch_read(bme280_i2c_batch_t *batch);
+
 #else
 /* Stubs for non-Linux to avoid including Linux-only headers */
 #warning "BME280_I2CDevice.h included on non-Linux target; no declarations emitted."
@@ -0,0 +1,50 @@
+#ifndef BME280_KERNELS_H
+#define BME280_KERNELS_H
+
+// BME280 compensation kernels (Bosch reference integer formulas), shared by
+// the runtime driver (BME280.c) and the build-time specialized variant
+// (BME280_Fixed.h). Pure functions of the calibration data; no argument
+// checks, callers guarantee a parsed calibration.
+
+#include <stdint.h>
+#include "BME280.h"
+
+static inline int32_t bme280__t_fine(const bme280_calib_t *c, int32_t adc_T) {
+    int32_t var1 = ((((adc_T >> 3) - ((int32_t)c->dig_T1 << 1))) * ((int32_t)c->dig_T2)) >> 11;
+    int32_t var2 = (((((adc_T >> 4) - ((int32_t)c->dig_T1)) * ((adc_T >> 4) - ((int32_t)c->dig_T1))) >> 12) * ((int32_t)c->dig_T3)) >> 14;
+    return var1 + var2;
+}
+
+// Pressure in Q24.8 Pa (0 if the calibration would divide by zero)
+static inline uint32_t bme280__pressure_q24_8(const bme280_calib_t *c, int32_t t_fine, int32_t adc_P) {
+    int64_t var1 = (int64_t)t_fine - 128000;
+    int64_t var2 = var1 * var1 * (int64_t)c->dig_P6;
+    var2 = var2 + ((var1 * (int64_t)c->dig_P5) << 17);
+    var2 = var2 + (((int64_t)c->dig_P4) << 35);
+    var1 = ((var1 * var1 * (int64_t)c->dig_P3) >> 8) + ((var1 * (int64_t)c->dig_P2) << 12);
+    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)c->dig_P1) >> 33;
+
+    if (var1 == 0) {
+        return 0; // avoid division by zero
+    }
+    int64_t p = 1048576 - adc_P;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)c->dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)c->dig_P8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)c->dig_P7) << 4);
+    return (uint32_t)p;
+}
+
+// Humidity in Q22.10 %RH, clamped to 0..100 %RH
+static inline uint32_t bme280__humidity_q22_10(const bme280_calib_t *c, int32_t t_fine, int32_t adc_H) {
+    int32_t v_x1_u32r = t_fine - ((int32_t)76800);
+    v_x1_u32r = (((((adc_H << 14) - (((int32_t)c->dig_H4) << 20) - (((int32_t)c->dig_H5) * v_x1_u32r)) + ((int32_t)16384)) >> 15) *
+                 (((((((v_x1_u32r * ((int32_t)c->dig_H6)) >> 10) * (((v_x1_u32r * ((int32_t)c->dig_H3)) >> 11) + ((int32_t)32768))) >> 10) +
+                     ((int32_t)2097152)) * ((int32_t)c->dig_H2) + 8192) >> 14));
+    v_x1_u32r = v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * ((int32_t)c->dig_H1)) >> 4);
+    v_x1_u32r = (v_x1_u32r < 0 ? 0 : v_x1_u32r);
+    v_x1_u32r = (v_x1_u32r > 419430400 ? 419430400 : v_x1_u32r);
+    return (uint32_t)(v_x1_u32r >> 12);
+}
+
+#endif // BME280_KERNELS_H
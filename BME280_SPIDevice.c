@@ -4,7 +4,6 @@
 
 #include <string.h>
 #include <time.h>
-#include <stdlib.h>
 
 static int bme280_spi_read(void *user, uint8_t reg, uint8_t *buf, size_t len) {
     SPIDevice *dev = (SPIDevice *)user;
@@ -15,20 +14,23 @@ static int bme280_spi_read(void *user, uint8_t reg, uint8_t *buf, size_t len) {
 
 static int bme280_spi_write(void *user, uint8_t reg, const uint8_t *buf, size_t len) {
     SPIDevice *dev = (SPIDevice *)user;
-    uint8_t stack[1 + 32];
-    uint8_t *w = stack;
-    size_t wlen = 1 + len;
-    uint8_t *alloc = NULL;
-    if (wlen > sizeof(stack)) {
-        alloc = (uint8_t*)malloc(wlen);
-        if (!alloc) return BME280_E_COMM;
-        w = alloc;
+    // Multi-byte writes are register/value pairs (no auto-increment on writes):
+    // every register byte of the sequence needs its RW bit cleared too, so the
+    // payload is copied. Each [reg, value] pair stands alone, so anything
+    // beyond the stack buffer goes out in further frames at pair boundaries.
+    uint8_t w[1 + 2 * 16 - 1];
+    size_t off = 0;
+    uint8_t r = reg;
+    for (;;) {
+        size_t n = len - off < sizeof(w) - 1 ? len - off : sizeof(w) - 1;
+        w[0] = r & 0x7F; // MSB=0 for write
+        if (n && buf) memcpy(&w[1], buf + off, n);
+        for (size_t i = 2; i < 1 + n; i += 2) w[i] &= 0x7F;
+        if (spi_device_write(dev, w, 1 + n) != 0) return BME280_E_COMM;
+        off += n;
+        if (off >= len || !buf) return BME280_OK;
+        r = buf[off++]; // next pair starts with a register byte
     }
-    w[0] = reg & 0x7F; // MSB=0 for write
-    if (len && buf) memcpy(&w[1], buf, len);
-    int rc = spi_device_write(dev, w, wlen);
-    if (alloc) free(alloc);
-    return (rc == 0) ? BME280_OK : BME280_E_COMM;
 }
 
 static void bme280_spi_delay(void *user, uint32_t ms) {
@@ -54,4 +56,28 @@ int bme280_init_spi_linux(bme280_t *bme, SPIDevice *spi) {
     return bme280_init(bme, &bus, 0);
 }
 
+int bme280_spi_read_measurement(bme280_t *bme, SPIQueue *q, bme280_reading_t *out, uint32_t *wait_us) {
+    if (!bme || !q || !out) return BME280_E_NULL_PTR;
+    uint32_t wait = 0;
+    spi_queue_reset(q);
+    if (bme->settings.mode == BME280_FORCED_MODE) {
+        // Trigger from the shadow (oversampling as last applied, mode = FORCED),
+        // end the frame, then hold the bus for the conversion time
+        uint8_t *trig = spi_queue_add_tx(q, 2);
+        if (trig) {
+            trig[0] = BME280_REG_CTRL_MEAS & 0x7F;
+            trig[1] = (uint8_t)((bme->reg_ctrl_meas & ~0x03) | BME280_FORCED_MODE);
+        }
+        wait = bme280_measurement_time_us(&bme->settings);
+        spi_queue_cs_change(q);
+        spi_queue_delay_us(q, wait);
+    }
+    uint8_t *cmd = spi_queue_add_tx(q, 1);
+    if (cmd) cmd[0] = BME280_REG_PRESS_MSB | 0x80;
+    uint8_t *raw = spi_queue_add_rx(q, BME280_MEAS_BURST_LEN);
+    if (wait_us) *wait_us = wait;
+    if (!raw || spi_queue_submit(q) != 0) return BME280_E_COMM;
+    return bme280_decode_measurement(bme, raw, out);
+}
+
 #endif /* __linux__ */
@@ -23,6 +23,14 @@ void bme280_bus_from_spi_device(bme280_bus_t *out, SPIDevice *dev);
 /* Convenience initializer: wraps bus setup + bme280_init (i2c_addr ignored on SPI) */
 int bme280_init_spi_linux(bme280_t *bme, SPIDevice *spi);
 
+/* One measurement in a single SPI_IOC_MESSAGE on q's device: FORCED mode
+ * queues the CTRL_MEAS trigger, the datasheet conversion time as a segment
+ * delay and the 8-byte burst read; other modes queue the burst read alone.
+ * The controller stays busy for the delay, so other chip selects on the same
+ * controller wait as well. *wait_us (optional) receives the queued delay.
+ * Returns BME280_OK or BME280_E_COMM. */
+int bme280_spi_read_measurement(bme280_t *bme, SPIQueue *q, bme280_reading_t *out, uint32_t *wait_us);
+
 #else
 #warning "BME280_SPIDevice.h included on non-Linux target; no declarations emitted."
 #endif
@@ -17,6 +17,7 @@ extern "C" {
 #include <stdlib.h>
 
 #if defined(__linux__)
+#include <linux/i2c.h>
 #include <linux/i2c-dev.h>
 #include <sys/ioctl.h>
 #include <fcntl.h>
@@ -29,12 +30,26 @@ extern "C" {
 #define I2C_DEVICE_PATH_MAX 64
 #endif
 
+// Largest register write payload that is copied into a stack buffer when the
+// adapter cannot continue a message without a new start (I2C_FUNC_NOSTART);
+// larger writes fail with EMSGSIZE on such adapters, nothing is allocated.
+#ifndef I2C_DEVICE_WRITE_STACK_MAX
+#define I2C_DEVICE_WRITE_STACK_MAX 256
+#endif
+
+// Stand-in for the adapter's I2C_RDWR ioctl (same messages, all with a start
+// of their own unless I2C_M_NOSTART). Returns 0, or -1 with errno set.
+typedef int (*i2c_device_transfer_f)(void *user, struct i2c_msg *msgs, size_t nmsgs);
+
 // Represents an open I2C device on Linux.
 typedef struct {
     int fd;                 // File descriptor for /dev/i2c-X
     uint16_t addr;          // Device address (7-bit or 10-bit)
     int tenbit;             // Non-zero if using 10-bit addressing
     char path[I2C_DEVICE_PATH_MAX]; // Path to the device (e.g., "/dev/i2c-1")
+    unsigned long funcs;    // Adapter functionality (I2C_FUNCS), 0 if unknown
+    i2c_device_transfer_f transfer; // NULL: the fd; else every transfer goes here (simulated adapter)
+    void *transfer_user;
 } I2CDevice;
 
 static inline void i2c_device_clear(I2CDevice *dev) {
@@ -43,6 +58,43 @@ static inline void i2c_device_clear(I2CDevice *dev) {
     dev->addr = 0;
     dev->tenbit = 0;
     dev->path[0] = '\0';
+    dev->funcs = 0;
+    dev->transfer = NULL;
+    dev->transfer_user = NULL;
+}
+
+// True when transfers can be issued: an open fd or a transfer function.
+static inline bool i2c_device_is_open(const I2CDevice *dev) {
+    return dev && (dev->fd >= 0 || dev->transfer);
+}
+
+// Set up dev on a simulated adapter: nothing is opened, every transfer is
+// handed to fn as I2C_RDWR messages, and the adapter reports plain I2C.
+// path names the adapter (devices with the same path share transactions, see
+// i2c_device_rdwr). Returns 0, or -1 with errno set.
+static inline int i2c_device_open_transfer(I2CDevice *dev, const char *path, uint16_t addr,
+                                           i2c_device_transfer_f fn, void *user) {
+    if (!dev || !path || !fn) { errno = EINVAL; return -1; }
+    i2c_device_clear(dev);
+    dev->addr = addr;
+    dev->tenbit = (addr > 0x7F) ? 1 : 0;
+    dev->funcs = I2C_FUNC_I2C;
+    dev->transfer = fn;
+    dev->transfer_user = user;
+    size_t n = strlen(path);
+    if (n > I2C_DEVICE_PATH_MAX - 1) n = I2C_DEVICE_PATH_MAX - 1;
+    memcpy(dev->path, path, n);
+    dev->path[n] = '\0';
+    return 0;
+}
+
+// One combined transaction through the fd or the transfer function.
+static inline int i2c_device__xfer(const I2CDevice *dev, struct i2c_msg *msgs, size_t nmsgs) {
+    if (dev->transfer) return dev->transfer(dev->transfer_user, msgs, nmsgs);
+    struct i2c_rdwr_ioctl_data rdwr;
+    rdwr.msgs  = msgs;
+    rdwr.nmsgs = (uint32_t)nmsgs;
+    return ioctl(dev->fd, I2C_RDWR, &rdwr) < 0 ? -1 : 0;
 }
 
 // Open and configure an I2C device at the given path and address.
@@ -73,12 +125,23 @@ static inline int i2c_device_open(I2CDevice *dev, const char *path, uint16_t add
         return -1;
     }
 
+    // Functionality is only a hint for picking the transfer type; an adapter
+    // that does not report it is treated as plain I2C
+    unsigned long funcs = 0;
+    if (ioctl(fd, I2C_FUNCS, &funcs) == 0) dev->funcs = funcs;
+
     size_t n = strnlen(path, I2C_DEVICE_PATH_MAX - 1);
     memcpy(dev->path, path, n);
     dev->path[n] = '\0';
     return 0;
 }
 
+// True when the adapter has no raw I2C transfers but supports the given
+// SMBus functionality, i.e. register access must go through I2C_SMBUS.
+static inline bool i2c_device_smbus_only(const I2CDevice *dev, unsigned long func) {
+    return dev->funcs && !(dev->funcs & I2C_FUNC_I2C) && (dev->funcs & func) == func;
+}
+
 // Close the I2C device. Returns 0 on success, -1 on error with errno set.
 static inline int i2c_device_close(I2CDevice *dev) {
     if (!dev) { errno = EINVAL; return -1; }
@@ -92,13 +155,23 @@ static inline int i2c_device_close(I2CDevice *dev) {
 
 // Write raw bytes to the device. Returns number of bytes written or -1 on error.
 static inline ssize_t i2c_device_write(const I2CDevice *dev, const void *data, size_t len) {
-    if (!dev || dev->fd < 0 || (!data && len)) { errno = EINVAL; return -1; }
+    if (!i2c_device_is_open(dev) || (!data && len)) { errno = EINVAL; return -1; }
+    if (dev->transfer) {
+        if (len > 0xFFFF) { errno = EINVAL; return -1; }
+        struct i2c_msg m = { dev->addr, (uint16_t)(dev->tenbit ? I2C_M_TEN : 0), (uint16_t)len, (uint8_t *)data };
+        return i2c_device__xfer(dev, &m, 1) == 0 ? (ssize_t)len : -1;
+    }
     return write(dev->fd, data, len);
 }
 
 // Read raw bytes from the device. Returns number of bytes read or -1 on error.
 static inline ssize_t i2c_device_read(const I2CDevice *dev, void *data, size_t len) {
-    if (!dev || dev->fd < 0 || (!data && len)) { errno = EINVAL; return -1; }
+    if (!i2c_device_is_open(dev) || (!data && len)) { errno = EINVAL; return -1; }
+    if (dev->transfer) {
+        if (len > 0xFFFF) { errno = EINVAL; return -1; }
+        struct i2c_msg m = { dev->addr, (uint16_t)((dev->tenbit ? I2C_M_TEN : 0) | I2C_M_RD), (uint16_t)len, (uint8_t *)data };
+        return i2c_device__xfer(dev, &m, 1) == 0 ? (ssize_t)len : -1;
+    }
     return read(dev->fd, data, len);
 }
 
@@ -107,10 +180,9 @@ static inline ssize_t i2c_device_read(const I2CDevice *dev, void *data, size_t l
 static inline int i2c_device_write_read(const I2CDevice *dev,
                                         const void *wbuf, size_t wlen,
                                         void *rbuf, size_t rlen) {
-    if (!dev || dev->fd < 0) { errno = EINVAL; return -1; }
+    if (!i2c_device_is_open(dev)) { errno = EINVAL; return -1; }
     if (wlen == 0 && rlen == 0) return 0;
 
-    struct i2c_rdwr_ioctl_data rdwr;
     struct i2c_msg msgs[2];
     int nmsgs = 0;
 
@@ -129,22 +201,173 @@ static inline int i2c_device_write_read(const I2CDevice *dev,
         nmsgs++;
     }
 
-    rdwr.msgs  = msgs;
-    rdwr.nmsgs = nmsgs;
+    return i2c_device__xfer(dev, msgs, (size_t)nmsgs);
+}
+
+// Submit caller-built messages as one combined I2C_RDWR transaction.
+// Each message carries its own address, so any fd opened on the same adapter
+// may be used to address several devices. nmsgs must not exceed
+// I2C_RDWR_IOCTL_MAX_MSGS. Returns 0 on success, -1 on error with errno set.
+static inline int i2c_device_rdwr(const I2CDevice *dev, struct i2c_msg *msgs, size_t nmsgs) {
+    if (!i2c_device_is_open(dev) || (!msgs && nmsgs)) { errno = EINVAL; return -1; }
+    if (nmsgs == 0) return 0;
+    if (nmsgs > I2C_RDWR_IOCTL_MAX_MSGS) { errno = EINVAL; return -1; }
+    return i2c_device__xfer(dev, msgs, nmsgs);
+}
 
-    if (ioctl(dev->fd, I2C_RDWR, &rdwr) < 0) return -1;
+// SMBus I2C-block transfers (I2C_SMBUS ioctl, up to I2C_SMBUS_BLOCK_MAX bytes,
+// 8-bit register). For SMBus-only controllers, and for adapters whose SMBus
+// path is cheaper than a combined I2C_RDWR transaction.
+// Returns 0 on success, -1 on error with errno set.
+static inline int i2c_device_smbus_read_block(const I2CDevice *dev, uint8_t reg, void *buf, size_t len) {
+    if (!dev || dev->fd < 0 || (!buf && len) || len > I2C_SMBUS_BLOCK_MAX) { errno = EINVAL; return -1; }
+    if (len == 0) return 0;
+    union i2c_smbus_data data;
+    data.block[0] = (uint8_t)len;
+    struct i2c_smbus_ioctl_data args = { I2C_SMBUS_READ, reg, I2C_SMBUS_I2C_BLOCK_DATA, &data };
+    if (ioctl(dev->fd, I2C_SMBUS, &args) < 0) return -1;
+    if (data.block[0] < len) { errno = EIO; return -1; }
+    memcpy(buf, &data.block[1], len);
     return 0;
 }
 
+static inline int i2c_device_smbus_write_block(const I2CDevice *dev, uint8_t reg, const void *buf, size_t len) {
+    if (!dev || dev->fd < 0 || (!buf && len) || len > I2C_SMBUS_BLOCK_MAX) { errno = EINVAL; return -1; }
+    union i2c_smbus_data data;
+    data.block[0] = (uint8_t)len;
+    if (len) memcpy(&data.block[1], buf, len);
+    struct i2c_smbus_ioctl_data args = { I2C_SMBUS_WRITE, reg, I2C_SMBUS_I2C_BLOCK_DATA, &data };
+    return ioctl(dev->fd, I2C_SMBUS, &args) < 0 ? -1 : 0;
+}
+
+// Scatter/gather transaction builder.
+// Collects i2c_msg segments pointing at caller buffers (nothing is copied or
+// allocated) and submits them as one I2C_RDWR ioctl. Each read or write starts
+// with a (repeated) start; i2c_txn_write_more() continues the previous write
+// without one (I2C_M_NOSTART), so a register address and a payload held in
+// separate buffers go out as one bus write. Messages target the device's
+// address and addressing mode (dev->tenbit) unless i2c_txn_addr() switches
+// them; every address must sit on the device's adapter. Buffers must stay valid until i2c_txn_submit() returns.
+#ifndef I2C_TXN_MAX_MSGS
+#define I2C_TXN_MAX_MSGS 16
+#endif
+
+typedef struct {
+    const I2CDevice *dev;
+    struct i2c_msg msgs[I2C_TXN_MAX_MSGS];
+    uint8_t regs[I2C_TXN_MAX_MSGS][2];  // register bytes queued by i2c_txn_write_reg/read_reg
+    size_t count;
+    size_t nregs;
+    uint16_t addr;                      // target of the next message
+    int tenbit;                         // addr is a 10-bit address (I2C_M_TEN)
+    int error;                          // errno of the first failed add, reported by submit
+} I2CTransaction;
+
+static inline void i2c_txn_init(I2CTransaction *t, const I2CDevice *dev) {
+    if (!t) return;
+    t->dev = dev;
+    t->count = 0;
+    t->nregs = 0;
+    t->addr = dev ? dev->addr : 0;
+    t->tenbit = dev ? dev->tenbit : 0;
+    t->error = 0;
+}
+
+// Target later messages at addr; tenbit selects 10-bit addressing, which
+// is a property of the device and cannot be told from the address value.
+static inline int i2c_txn_addr(I2CTransaction *t, uint16_t addr, int tenbit) {
+    if (!t || addr > (tenbit ? 0x3FF : 0x7F)) { errno = EINVAL; return -1; }
+    t->addr = addr;
+    t->tenbit = tenbit != 0;
+    return 0;
+}
+
+static inline int i2c_txn__push(I2CTransaction *t, uint16_t flags, void *buf, size_t len) {
+    if (!t) { errno = EINVAL; return -1; }
+    int err = 0;
+    if (t->count >= I2C_TXN_MAX_MSGS) err = ENOSPC;
+    else if (len > 0xFFFF || (!buf && len)) err = EINVAL;
+    else if ((flags & I2C_M_NOSTART) && t->dev && !(t->dev->funcs & I2C_FUNC_NOSTART)) err = EOPNOTSUPP;
+    if (err) {
+        if (!t->error) t->error = err;
+        errno = err;
+        return -1;
+    }
+    struct i2c_msg *m = &t->msgs[t->count++];
+    m->addr  = t->addr;
+    m->flags = (uint16_t)(flags | (t->tenbit ? I2C_M_TEN : 0));
+    m->len   = (uint16_t)len;
+    m->buf   = (uint8_t *)buf;
+    return 0;
+}
+
+static inline int i2c_txn_write(I2CTransaction *t, const void *buf, size_t len) {
+    return i2c_txn__push(t, 0, (void *)buf, len);
+}
+
+// Needs I2C_FUNC_NOSTART; fails with EOPNOTSUPP on other adapters.
+static inline int i2c_txn_write_more(I2CTransaction *t, const void *buf, size_t len) {
+    if (t && t->count == 0) { errno = EINVAL; return -1; }
+    return i2c_txn__push(t, I2C_M_NOSTART, (void *)buf, len);
+}
+
+static inline int i2c_txn_read(I2CTransaction *t, void *buf, size_t len) {
+    return i2c_txn__push(t, I2C_M_RD, buf, len);
+}
+
+// Queue the register address (1 or 2 bytes, MSB first) held in the
+// transaction itself.
+static inline int i2c_txn__reg(I2CTransaction *t, uint16_t reg, int reg_width_bytes) {
+    if (!t || (reg_width_bytes != 1 && reg_width_bytes != 2)) { errno = EINVAL; return -1; }
+    if (t->nregs >= I2C_TXN_MAX_MSGS) {
+        if (!t->error) t->error = ENOSPC;
+        errno = ENOSPC;
+        return -1;
+    }
+    uint8_t *r = t->regs[t->nregs++];
+    if (reg_width_bytes == 1) {
+        r[0] = (uint8_t)reg;
+    } else {
+        r[0] = (uint8_t)((reg >> 8) & 0xFF);
+        r[1] = (uint8_t)(reg & 0xFF);
+    }
+    return i2c_txn_write(t, r, (size_t)reg_width_bytes);
+}
+
+// Register read: address write, repeated start, read of len bytes.
+static inline int i2c_txn_read_reg(I2CTransaction *t, uint16_t reg, void *buf, size_t len, int reg_width_bytes) {
+    if (i2c_txn__reg(t, reg, reg_width_bytes) != 0) return -1;
+    return i2c_txn_read(t, buf, len);
+}
+
+// Register write: address and payload as one bus write (I2C_FUNC_NOSTART).
+static inline int i2c_txn_write_reg(I2CTransaction *t, uint16_t reg, const void *data, size_t len, int reg_width_bytes) {
+    if (i2c_txn__reg(t, reg, reg_width_bytes) != 0) return -1;
+    return len ? i2c_txn_write_more(t, data, len) : 0;
+}
+
+// Submit all queued messages in one I2C_RDWR ioctl.
+// Returns 0 on success, -1 on error with errno set.
+static inline int i2c_txn_submit(I2CTransaction *t) {
+    if (!t || !t->dev) { errno = EINVAL; return -1; }
+    if (t->error) { errno = t->error; return -1; }
+    return i2c_device_rdwr(t->dev, t->msgs, t->count);
+}
+
 // Read from a 1 or 2-byte register address using a repeated start.
 // reg_width_bytes must be 1 or 2. Register value is sent MSB first when 2 bytes.
 // Returns 0 on success, -1 on error with errno set.
 static inline int i2c_device_read_reg(const I2CDevice *dev,
                                       uint16_t reg, void *buf, size_t len,
                                       int reg_width_bytes) {
-    if (!dev || dev->fd < 0 || (!buf && len)) { errno = EINVAL; return -1; }
+    if (!i2c_device_is_open(dev) || (!buf && len)) { errno = EINVAL; return -1; }
     if (reg_width_bytes != 1 && reg_width_bytes != 2) { errno = EINVAL; return -1; }
 
+    if (reg_width_bytes == 1 && len <= I2C_SMBUS_BLOCK_MAX &&
+        i2c_device_smbus_only(dev, I2C_FUNC_SMBUS_READ_I2C_BLOCK)) {
+        return i2c_device_smbus_read_block(dev, (uint8_t)reg, buf, len);
+    }
+
     uint8_t rbuf[2];
     size_t wlen = (size_t)reg_width_bytes;
 
@@ -160,25 +383,32 @@ static inline int i2c_device_read_reg(const I2CDevice *dev,
 }
 
 // Write to a 1 or 2-byte register address (reg MSB first when 2 bytes).
+// With I2C_FUNC_NOSTART the payload is sent from the caller's buffer behind
+// the register bytes; SMBus-only adapters use an I2C block write; otherwise
+// register and payload are staged on the stack, up to
+// I2C_DEVICE_WRITE_STACK_MAX payload bytes (EMSGSIZE above). Never allocates.
 // Returns 0 on success, -1 on error with errno set.
 static inline int i2c_device_write_reg(const I2CDevice *dev,
                                        uint16_t reg, const void *data, size_t len,
                                        int reg_width_bytes) {
-    if (!dev || dev->fd < 0 || (!data && len)) { errno = EINVAL; return -1; }
+    if (!i2c_device_is_open(dev) || (!data && len)) { errno = EINVAL; return -1; }
     if (reg_width_bytes != 1 && reg_width_bytes != 2) { errno = EINVAL; return -1; }
 
-    size_t wlen = (size_t)reg_width_bytes + len;
-    uint8_t stackbuf[2 + 64];
-    uint8_t *wbuf = NULL;
-    bool use_stack = (wlen <= sizeof(stackbuf));
-
-    if (use_stack) {
-        wbuf = stackbuf;
-    } else {
-        wbuf = (uint8_t *)malloc(wlen);
-        if (!wbuf) { errno = ENOMEM; return -1; }
+    if (len && (dev->funcs & I2C_FUNC_NOSTART)) {
+        I2CTransaction t;
+        i2c_txn_init(&t, dev);
+        if (i2c_txn_write_reg(&t, reg, data, len, reg_width_bytes) != 0) return -1;
+        return i2c_txn_submit(&t);
+    }
+    if (reg_width_bytes == 1 && len <= I2C_SMBUS_BLOCK_MAX &&
+        i2c_device_smbus_only(dev, I2C_FUNC_SMBUS_WRITE_I2C_BLOCK)) {
+        return i2c_device_smbus_write_block(dev, (uint8_t)reg, data, len);
     }
 
+    if (len > I2C_DEVICE_WRITE_STACK_MAX) { errno = EMSGSIZE; return -1; }
+    size_t wlen = (size_t)reg_width_bytes + len;
+    uint8_t wbuf[2 + I2C_DEVICE_WRITE_STACK_MAX];
+
     if (reg_width_bytes == 1) {
         wbuf[0] = (uint8_t)reg;
     } else {
@@ -189,11 +419,8 @@ static inline int i2c_device_write_reg(const I2CDevice *dev,
     if (len) memcpy(wbuf + reg_width_bytes, data, len);
 
     ssize_t wr = i2c_device_write(dev, wbuf, wlen);
-    int saved_errno = errno;
-
-    if (!use_stack) free(wbuf);
-
-    if (wr < 0 || (size_t)wr != wlen) { errno = saved_errno ? saved_errno : EIO; return -1; }
+    if (wr < 0) return -1;
+    if ((size_t)wr != wlen) { errno = EIO; return -1; }
     return 0;
 }
 
@@ -15,13 +15,21 @@ extern "C" {
 
   Example:
     SPIDevice dev;
-    if (spi_device_open(&dev, "/dev/spidev0.0", 8000000u, 0 /* SPI_MODE_0 */, 8) == 0) {
+    if (spi_device_open(&dev, "/dev/spidev0.0", 8000000u, SPI_MODE_0, 8) == 0) {
       uint8_t tx[2] = { 0x0F, 0x00 };
       uint8_t rx[2];
       spi_device_write_then_read(&dev, tx, 1, rx, 1);
       spi_device_close(&dev);
     }
 
+  Transfer queue (one SPI_IOC_MESSAGE(n) for many segments):
+    SPIQueue q;
+    spi_queue_init(&q, &dev);
+    uint8_t *cmd = spi_queue_add_tx(&q, 1);   // buffers come from the queue arena
+    cmd[0] = 0xF7 | 0x80;
+    uint8_t *data = spi_queue_add_rx(&q, 8);
+    spi_queue_submit(&q);                     // data[] is valid until spi_queue_reset
+
   Notes:
     - This header targets Linux systems exposing /dev/spidevX.Y.
     - No Arduino types or headers are used.
@@ -29,6 +37,7 @@ extern "C" {
 
 #include <stdint.h>
 #include <stddef.h>
+#include <linux/spi/spidev.h>
 
 /* Forward declaration of the device struct */
 typedef struct SPIDevice {
@@ -54,7 +63,13 @@ int spi_device_set_mode(SPIDevice *dev, uint8_t mode);
 int spi_device_set_speed(SPIDevice *dev, uint32_t speed_hz);
 int spi_device_set_bits_per_word(SPIDevice *dev, uint8_t bits_per_word);
 
-/* Full-duplex transfer. If tx is NULL, zeros are sent. If rx is NULL, incoming bytes are discarded. */
+#ifndef SPI_DEVICE_ZERO_MAX
+#define SPI_DEVICE_ZERO_MAX 256  /* zero tx bytes available for reads without tx */
+#endif
+
+/* Full-duplex transfer. If tx is NULL, zeros are sent (from a static buffer; reads
+ * longer than SPI_DEVICE_ZERO_MAX shift out the controller's idle level, like
+ * SPIQueue rx segments). If rx is NULL, incoming bytes are discarded. Never allocates. */
 int spi_device_transfer(SPIDevice *dev, const uint8_t *tx, uint8_t *rx, size_t len);
 
 /* Convenience helpers */
@@ -64,6 +79,59 @@ int spi_device_write_then_read(SPIDevice *dev,
                                const uint8_t *tx, size_t txlen,
                                uint8_t *rx, size_t rxlen);
 
+/* ===== Transfer queue =====
+ * Collects spi_ioc_transfer segments and submits them in one
+ * SPI_IOC_MESSAGE(n) ioctl. Segments of one chip-select frame follow each
+ * other with CS held; spi_queue_cs_change() ends the frame after the last
+ * segment, so several register transactions (e.g. trigger, wait, burst read)
+ * cost one syscall. Segment buffers can come from the queue's fixed arena;
+ * nothing is allocated. One queue serves one SPIDevice: spidev cannot combine
+ * chip selects (device nodes) in one message.
+ */
+#ifndef SPI_QUEUE_MAX_XFERS
+#define SPI_QUEUE_MAX_XFERS 16
+#endif
+#ifndef SPI_QUEUE_ARENA_SIZE
+#define SPI_QUEUE_ARENA_SIZE 256
+#endif
+
+typedef struct SPIQueue {
+  SPIDevice *dev;
+  struct spi_ioc_transfer xfers[SPI_QUEUE_MAX_XFERS];
+  size_t count;           /* queued segments */
+  size_t used;            /* arena bytes handed out */
+  int error;              /* errno of the first failed add (reported by submit) */
+  uint8_t arena[SPI_QUEUE_ARENA_SIZE];
+} SPIQueue;
+
+/* Bind a queue to an open device and empty it. */
+void spi_queue_init(SPIQueue *q, SPIDevice *dev);
+
+/* Drop all segments and arena buffers (rx data of the last submit included). */
+void spi_queue_reset(SPIQueue *q);
+
+/* Queue a segment with caller buffers (either may be NULL; with tx NULL the
+ * controller shifts out its idle level, normally zeros). Buffers must stay valid until spi_queue_submit returns.
+ * Returns 0, or -1 with errno = ENOSPC when the queue is full. */
+int spi_queue_add(SPIQueue *q, const uint8_t *tx, uint8_t *rx, size_t len);
+
+/* Queue a write / read segment backed by the arena. Returns the buffer
+ * (fill tx before submit; rx holds data after submit), or NULL when the
+ * queue or arena is full. */
+uint8_t *spi_queue_add_tx(SPIQueue *q, size_t len);
+uint8_t *spi_queue_add_rx(SPIQueue *q, size_t len);
+
+/* Per-segment options, applied to the last queued segment. A delay longer
+ * than the 16-bit delay_usecs field is continued in empty segments. */
+int spi_queue_cs_change(SPIQueue *q);
+int spi_queue_delay_us(SPIQueue *q, uint32_t usecs);
+int spi_queue_speed(SPIQueue *q, uint32_t speed_hz);
+
+/* Submit every queued segment in one ioctl. Returns 0, or -1 with errno set
+ * (a failed add is reported here as well). The queue keeps its contents;
+ * call spi_queue_reset before building the next message. */
+int spi_queue_submit(SPIQueue *q);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -80,15 +148,12 @@ int spi_device_write_then_read(SPIDevice *dev,
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/ioctl.h>
-#include <linux/spi/spidev.h>
 #include <stdlib.h>
 
-/* Internal helper: clamp null pointers to a zero buffer when needed */
+/* Internal helper: zero tx bytes for reads without a tx buffer (NULL when longer) */
+static const uint8_t spi__zeros[SPI_DEVICE_ZERO_MAX];
 static inline const uint8_t *spi__zero_tx_buffer(size_t len) {
-  if (len == 0) return NULL;
-  /* Allocate a transient zero buffer; caller expects transfer to be synchronous */
-  uint8_t *buf = (uint8_t *)calloc(1, len);
-  return buf; /* Caller ensures freeing if allocated here */
+  return len <= sizeof(spi__zeros) ? spi__zeros : NULL;
 }
 
 int spi_device_open(SPIDevice *dev,
@@ -177,13 +242,7 @@ int spi_device_transfer(SPIDevice *dev, const uint8_t *tx, uint8_t *rx, size_t l
   if (!dev || dev->fd < 0) { errno = EINVAL; return -1; }
   if (len == 0) return 0;
 
-  const uint8_t *txbuf = tx;
-  uint8_t *alloc = NULL;
-  if (!txbuf) {
-    alloc = (uint8_t *)calloc(1, len);
-    if (!alloc) return -1;
-    txbuf = alloc;
-  }
+  const uint8_t *txbuf = tx ? tx : spi__zero_tx_buffer(len);
 
   struct spi_ioc_transfer tr;
   memset(&tr, 0, sizeof(tr));
@@ -196,8 +255,6 @@ int spi_device_transfer(SPIDevice *dev, const uint8_t *tx, uint8_t *rx, size_t l
 
   int rc = ioctl(dev->fd, SPI_IOC_MESSAGE(1), &tr);
 
-  if (alloc) free(alloc);
-
   return (rc < 1) ? -1 : 0;
 }
 
@@ -217,13 +274,7 @@ int spi_device_write_then_read(SPIDevice *dev,
   struct spi_ioc_transfer xfers[2];
   memset(&xfers, 0, sizeof(xfers));
 
-  const uint8_t *txbuf = tx;
-  uint8_t *alloc = NULL;
-  if (txlen && !txbuf) {
-    alloc = (uint8_t *)calloc(1, txlen);
-    if (!alloc) return -1;
-    txbuf = alloc;
-  }
+  const uint8_t *txbuf = (txlen && !tx) ? spi__zero_tx_buffer(txlen) : tx;
 
   /* First: write */
   xfers[0].tx_buf = (unsigned long) (uintptr_t) txbuf;
@@ -243,11 +294,112 @@ int spi_device_write_then_read(SPIDevice *dev,
 
   int rc = ioctl(dev->fd, SPI_IOC_MESSAGE(2), xfers);
 
-  if (alloc) free(alloc);
-
   return (rc < 1) ? -1 : 0;
 }
 
+/* ===== Transfer queue ===== */
+
+void spi_queue_init(SPIQueue *q, SPIDevice *dev) {
+  if (!q) return;
+  q->dev = dev;
+  spi_queue_reset(q);
+}
+
+void spi_queue_reset(SPIQueue *q) {
+  if (!q) return;
+  memset(q->xfers, 0, sizeof(q->xfers[0]) * q->count);
+  q->count = 0;
+  q->used = 0;
+  q->error = 0;
+}
+
+static inline struct spi_ioc_transfer *spi__queue_next(SPIQueue *q) {
+  if (q->count >= SPI_QUEUE_MAX_XFERS) {
+    if (!q->error) q->error = ENOSPC;
+    return NULL;
+  }
+  struct spi_ioc_transfer *tr = &q->xfers[q->count++];
+  memset(tr, 0, sizeof(*tr));
+  tr->speed_hz = q->dev ? q->dev->speed_hz : 0;
+  tr->bits_per_word = q->dev ? q->dev->bits_per_word : 0;
+  tr->delay_usecs = q->dev ? q->dev->delay_usecs : 0;
+  return tr;
+}
+
+static inline uint8_t *spi__queue_arena(SPIQueue *q, size_t len) {
+  if (len > SPI_QUEUE_ARENA_SIZE - q->used) {
+    if (!q->error) q->error = ENOSPC;
+    return NULL;
+  }
+  uint8_t *p = &q->arena[q->used];
+  q->used += len;
+  return p;
+}
+
+int spi_queue_add(SPIQueue *q, const uint8_t *tx, uint8_t *rx, size_t len) {
+  if (!q) { errno = EINVAL; return -1; }
+  struct spi_ioc_transfer *tr = spi__queue_next(q);
+  if (!tr) { errno = ENOSPC; return -1; }
+  tr->tx_buf = (unsigned long) (uintptr_t) tx;
+  tr->rx_buf = (unsigned long) (uintptr_t) rx;
+  tr->len = (uint32_t)len;
+  return 0;
+}
+
+uint8_t *spi_queue_add_tx(SPIQueue *q, size_t len) {
+  if (!q) return NULL;
+  uint8_t *buf = spi__queue_arena(q, len);
+  if (!buf || spi_queue_add(q, buf, NULL, len) != 0) return NULL;
+  return buf;
+}
+
+uint8_t *spi_queue_add_rx(SPIQueue *q, size_t len) {
+  if (!q) return NULL;
+  uint8_t *buf = spi__queue_arena(q, len);
+  if (!buf || spi_queue_add(q, NULL, buf, len) != 0) return NULL;
+  return buf;
+}
+
+int spi_queue_cs_change(SPIQueue *q) {
+  if (!q || q->count == 0) { errno = EINVAL; return -1; }
+  q->xfers[q->count - 1].cs_change = 1;
+  return 0;
+}
+
+int spi_queue_delay_us(SPIQueue *q, uint32_t usecs) {
+  if (!q || q->count == 0) { errno = EINVAL; return -1; }
+  struct spi_ioc_transfer *tr = &q->xfers[q->count - 1];
+  for (;;) {
+    uint32_t room = 0xFFFFu - tr->delay_usecs;
+    uint32_t add = usecs < room ? usecs : room;
+    tr->delay_usecs = (uint16_t)(tr->delay_usecs + add);
+    usecs -= add;
+    if (usecs == 0) return 0;
+    if (spi_queue_add(q, NULL, NULL, 0) != 0) return -1;
+    tr = &q->xfers[q->count - 1];
+    tr->delay_usecs = 0;
+  }
+}
+
+int spi_queue_speed(SPIQueue *q, uint32_t speed_hz) {
+  if (!q || q->count == 0) { errno = EINVAL; return -1; }
+  q->xfers[q->count - 1].speed_hz = speed_hz;
+  return 0;
+}
+
+int spi_queue_submit(SPIQueue *q) {
+  if (!q || !q->dev || q->dev->fd < 0) { errno = EINVAL; return -1; }
+  if (q->error) { errno = q->error; return -1; }
+  if (q->count == 0) return 0;
+  /* cs_change on the final segment would leave CS asserted after the message */
+  struct spi_ioc_transfer *last = &q->xfers[q->count - 1];
+  uint8_t keep = last->cs_change;
+  last->cs_change = 0;
+  int rc = ioctl(q->dev->fd, SPI_IOC_MESSAGE(q->count), q->xfers);
+  last->cs_change = keep;
+  return (rc < 0) ? -1 : 0;
+}
+
 #endif /* SPIDEVICE_IMPLEMENTATION */
 
 #endif /* SPIDEVICE_H */
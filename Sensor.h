@@ -19,6 +19,7 @@ extern "C" {
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 /* Common constants (match Adafruit values where appropriate) */
 #define SENSORS_GRAVITY_EARTH            (9.80665F)   /* m/s^2 */
@@ -117,6 +118,9 @@ typedef struct sensor_interface {
   void *context; /* user-provided context passed to callbacks (may be NULL) */
   bool (*get_event)(void *context, sensors_event_t *event);
   void (*get_sensor)(void *context, sensor_t *sensor);
+  /* Optional bulk read: fill up to n events taken from one sample and return
+     the number written. May be NULL; see sensor_get_events(). */
+  size_t (*get_events)(void *context, sensors_event_t *out, size_t n);
 } sensor_interface_t;
 
 /* Helper inline wrappers for convenience */
@@ -125,6 +129,15 @@ static inline bool sensor_get_event(const sensor_interface_t *iface, sensors_eve
   return iface->get_event(iface->context, event);
 }
 
+/* Read every quantity of one sample in a single call. Falls back to a single
+   get_event() when the sensor has no bulk entry point. */
+static inline size_t sensor_get_events(const sensor_interface_t *iface, sensors_event_t *out, size_t n) {
+  if (!iface || !out || n == 0) return 0;
+  if (iface->get_events) return iface->get_events(iface->context, out, n);
+  if (!iface->get_event) return 0;
+  return iface->get_event(iface->context, &out[0]) ? 1 : 0;
+}
+
 static inline void sensor_get_info(const sensor_interface_t *iface, sensor_t *sensor) {
   if (!iface || !iface->get_sensor) return;
   iface->get_sensor(iface->context, sensor);
@@ -0,0 +1,297 @@
+/*
+ * BME280 driver microbenchmarks on a simulated bus (mock_bus.h).
+ *
+ *   ./bme280_bench [--dump=FILE] [--iters=N] [--latency-us=N] [--jitter-us=N]
+ *                  [--sleep-delays] [--json]
+ *   ./bme280_bench --capture=/dev/i2c-1[:0x76] [--count=N] > my.dump
+ *
+ * Benchmarks:
+ *   read_measurement     forced-mode trigger + conversion wait + burst read +
+ *                        compensation through the mock bus (per-op p50/p99)
+ *   compensate_scalar    bme280_compensate_temperature/pressure/humidity per sample
+ *   compensate_batch     bme280_compensate_batch, float output, per sample
+ *   compensate_fixed     bme280_compensate_batch_fixed, integer output, per sample
+ *   i2c_write_reg_<n>    i2c_device_write_reg with an n-byte payload on an
+ *                        adapter without I2C_FUNC_NOSTART (stack copy + one
+ *                        write() to /dev/null); the last size is one byte over
+ *                        I2C_DEVICE_WRITE_STACK_MAX and times the EMSGSIZE
+ *                        rejection
+ *
+ * Results go to stdout, one row per benchmark, or one JSON object per line
+ * with --json, so runs from two releases can be diffed. The default dump is
+ * data/bme280_sample.dump next to the executable, so the benchmark runs from
+ * bench/ and from the repo root alike.
+ */
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "BME280.h"
+#include "BME280_I2CDevice.h"
+#include "I2CDevice.h"
+#include "mock_bus.h"
+
+#define BENCH_BATCH 4096
+
+static int g_json = 0;
+static volatile float g_sink_f;
+static volatile uint32_t g_sink_u;
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void report(const char *name, unsigned long iters, double ns_per_op, uint64_t p50, uint64_t p99) {
+    if (g_json) {
+        printf("{\"bench\":\"%s\",\"iters\":%lu,\"ns_per_op\":%.1f,\"p50_ns\":%llu,\"p99_ns\":%llu}\n",
+               name, iters, ns_per_op, (unsigned long long)p50, (unsigned long long)p99);
+    } else if (p99) {
+        printf("%-24s %10lu %12.1f %10llu %10llu\n", name, iters, ns_per_op,
+               (unsigned long long)p50, (unsigned long long)p99);
+    } else {
+        printf("%-24s %10lu %12.1f %10s %10s\n", name, iters, ns_per_op, "-", "-");
+    }
+}
+
+// ===== Benchmarks =====
+
+static int bench_read_measurement(const mock_dump_t *dump, unsigned long iters,
+                                  uint32_t latency_ns, uint32_t jitter_ns, int sleep_delays) {
+    mock_bus_t m;
+    mock_bus_init(&m, dump, latency_ns, jitter_ns);
+    m.sleep_delays = sleep_delays;
+    bme280_bus_t bus;
+    mock_bus_bind(&m, &bus);
+
+    bme280_t dev;
+    int rc = bme280_init(&dev, &bus, BME280_I2C_ADDR_SDO_LOW);
+    if (rc != BME280_OK) {
+        fprintf(stderr, "read_measurement: bme280_init failed: %d\n", rc);
+        return -1;
+    }
+    const bme280_settings_t forced = {
+        .osr_t = BME280_OSRS_X1, .osr_p = BME280_OSRS_X1, .osr_h = BME280_OSRS_X1,
+        .filter = BME280_FILTER_OFF, .standby = BME280_STANDBY_1000_MS, .mode = BME280_FORCED_MODE,
+    };
+    bme280_apply_settings(&dev, &forced);
+
+    uint64_t *lat = malloc(iters * sizeof(*lat));
+    if (!lat) return -1;
+    unsigned long reads0 = m.reads, writes0 = m.writes;
+    uint64_t total = 0;
+    bme280_reading_t r;
+    for (unsigned long i = 0; i < iters; ++i) {
+        uint64_t t0 = mock_now_ns();
+        rc = bme280_read_measurement(&dev, &r);
+        lat[i] = mock_now_ns() - t0;
+        total += lat[i];
+        if (rc != BME280_OK) {
+            fprintf(stderr, "read_measurement: failed: %d\n", rc);
+            free(lat);
+            return -1;
+        }
+    }
+    g_sink_f = r.temperature_c;
+    qsort(lat, iters, sizeof(*lat), cmp_u64);
+    report("read_measurement", iters, (double)total / (double)iters, lat[iters / 2], lat[iters * 99 / 100]);
+    if (!g_json) {
+        printf("  %.2f reads + %.2f writes and %.2f ms of conversion wait per measurement%s; "
+               "last: %.2f degC %.2f hPa %.2f %%RH\n",
+               (double)(m.reads - reads0) / (double)iters, (double)(m.writes - writes0) / (double)iters,
+               (double)m.delay_ms_total / (double)iters, sleep_delays ? "" : " (not slept)",
+               (double)r.temperature_c, (double)r.pressure_pa / 100.0, (double)r.humidity_rh);
+    }
+    free(lat);
+    return 0;
+}
+
+/* The dump's ADC tuples repeated into BENCH_BATCH-long channel arrays */
+typedef struct {
+    int32_t T[BENCH_BATCH], P[BENCH_BATCH], H[BENCH_BATCH];
+} bench_adc_t;
+
+static void bench_compensation(const mock_dump_t *dump, unsigned long iters) {
+    static bench_adc_t adc;
+    static bme280_reading_t out[BENCH_BATCH];
+    static int32_t t100[BENCH_BATCH];
+    static uint32_t pq[BENCH_BATCH], hq[BENCH_BATCH];
+    for (size_t i = 0; i < BENCH_BATCH; ++i) {
+        adc.T[i] = dump->adc[i % dump->count][0];
+        adc.P[i] = dump->adc[i % dump->count][1];
+        adc.H[i] = dump->adc[i % dump->count][2];
+    }
+    bme280_t dev;
+    memset(&dev, 0, sizeof(dev));
+    bme280_parse_calibration(dump->calib_raw, &dev.calib);
+    dev.calib_loaded = true;
+
+    unsigned long rounds = iters / BENCH_BATCH ? iters / BENCH_BATCH : 1;
+    unsigned long n = rounds * BENCH_BATCH;
+
+    uint64_t t0 = mock_now_ns();
+    float acc = 0.0f;
+    for (unsigned long r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < BENCH_BATCH; ++i) {
+            acc += bme280_compensate_temperature(&dev, adc.T[i]);
+            acc += bme280_compensate_pressure(&dev, adc.P[i]);
+            acc += bme280_compensate_humidity(&dev, adc.H[i]);
+        }
+    }
+    g_sink_f = acc;
+    report("compensate_scalar", n, (double)(mock_now_ns() - t0) / (double)n, 0, 0);
+
+    t0 = mock_now_ns();
+    for (unsigned long r = 0; r < rounds; ++r) {
+        bme280_compensate_batch(&dev.calib, adc.T, adc.P, adc.H, BENCH_BATCH, out);
+        g_sink_f = out[r % BENCH_BATCH].pressure_pa;
+    }
+    report("compensate_batch", n, (double)(mock_now_ns() - t0) / (double)n, 0, 0);
+
+    t0 = mock_now_ns();
+    for (unsigned long r = 0; r < rounds; ++r) {
+        bme280_compensate_batch_fixed(&dev.calib, adc.T, adc.P, adc.H, BENCH_BATCH, t100, pq, hq);
+        g_sink_u = pq[r % BENCH_BATCH];
+    }
+    report("compensate_fixed", n, (double)(mock_now_ns() - t0) / (double)n, 0, 0);
+}
+
+static int bench_i2c_write_reg(unsigned long iters) {
+    I2CDevice dev;
+    i2c_device_clear(&dev);
+    dev.fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (dev.fd < 0) {
+        perror("/dev/null");
+        return -1;
+    }
+    static const size_t lens[] = { 1, 8, 32, I2C_DEVICE_WRITE_STACK_MAX, I2C_DEVICE_WRITE_STACK_MAX + 1 };
+    static uint8_t payload[I2C_DEVICE_WRITE_STACK_MAX + 1];
+    for (size_t i = 0; i < sizeof(payload); ++i) payload[i] = (uint8_t)i;
+    for (size_t k = 0; k < sizeof(lens) / sizeof(lens[0]); ++k) {
+        int oversized = lens[k] > I2C_DEVICE_WRITE_STACK_MAX;
+        uint64_t t0 = mock_now_ns();
+        for (unsigned long i = 0; i < iters; ++i) {
+            int rc = i2c_device_write_reg(&dev, 0xF4, payload, lens[k], 1);
+            if (oversized ? rc != -1 || errno != EMSGSIZE : rc != 0) {
+                fprintf(stderr, "i2c_write_reg_%zu: %s\n", lens[k], rc ? strerror(errno) : "accepted");
+                close(dev.fd);
+                return -1;
+            }
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "i2c_write_reg_%zu", lens[k]);
+        report(name, iters, (double)(mock_now_ns() - t0) / (double)iters, 0, 0);
+    }
+    close(dev.fd);
+    return 0;
+}
+
+// ===== Capture =====
+
+/* Print a dump of a real sensor: its calibration and count forced-mode ADC tuples */
+static int capture(const char *spec, unsigned long count) {
+    char path[I2C_DEVICE_PATH_MAX];
+    snprintf(path, sizeof(path), "%s", spec);
+    uint8_t addr = BME280_I2C_ADDR_SDO_LOW;
+    char *colon = strchr(path, ':');
+    if (colon) {
+        *colon = '\0';
+        addr = (uint8_t)strtoul(colon + 1, NULL, 0);
+    }
+    I2CDevice i2c;
+    if (i2c_device_open(&i2c, path, addr) != 0) {
+        perror(path);
+        return -1;
+    }
+    bme280_t bme;
+    int rc = bme280_init_i2c_linux(&bme, &i2c, addr);
+    if (rc != BME280_OK) {
+        fprintf(stderr, "bme280_init failed: %d\n", rc);
+        i2c_device_close(&i2c);
+        return -1;
+    }
+    const bme280_settings_t forced = {
+        .osr_t = BME280_OSRS_X1, .osr_p = BME280_OSRS_X1, .osr_h = BME280_OSRS_X1,
+        .filter = BME280_FILTER_OFF, .standby = BME280_STANDBY_1000_MS, .mode = BME280_FORCED_MODE,
+    };
+    bme280_apply_settings(&bme, &forced);
+
+    printf("# captured from %s addr 0x%02X\ncalib", path, (unsigned)addr);
+    for (size_t i = 0; i < BME280_CALIB_RAW_LEN; ++i) printf(" %02x", bme.calib_raw[i]);
+    printf("\n");
+    bme280_reading_t r;
+    for (unsigned long i = 0; i < count; ++i) {
+        if (bme280_read_measurement(&bme, &r) != BME280_OK) continue;
+        printf("adc %ld %ld %ld\n", (long)bme.last_adc_T, (long)bme.last_adc_P, (long)bme.last_adc_H);
+    }
+    i2c_device_close(&i2c);
+    return 0;
+}
+
+/* BENCH_DUMP_DEFAULT in the directory of the executable; out must hold PATH_MAX */
+#define BENCH_DUMP_DEFAULT "data/bme280_sample.dump"
+
+static const char *default_dump_path(char *out, size_t len) {
+    ssize_t n = readlink("/proc/self/exe", out, len - 1);
+    if (n <= 0) return BENCH_DUMP_DEFAULT;
+    out[n] = '\0';
+    char *slash = strrchr(out, '/');
+    if (!slash || (size_t)(slash + 1 - out) + sizeof(BENCH_DUMP_DEFAULT) > len) return BENCH_DUMP_DEFAULT;
+    memcpy(slash + 1, BENCH_DUMP_DEFAULT, sizeof(BENCH_DUMP_DEFAULT));
+    return out;
+}
+
+int main(int argc, char **argv) {
+    char exe_dir_dump[4096];
+    const char *dump_path = default_dump_path(exe_dir_dump, sizeof(exe_dir_dump));
+    const char *capture_spec = NULL;
+    unsigned long iters = 100000, count = 256;
+    uint32_t latency_us = 0, jitter_us = 0;
+    int sleep_delays = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--dump=", 7) == 0) dump_path = argv[i] + 7;
+        else if (strncmp(argv[i], "--iters=", 8) == 0) iters = strtoul(argv[i] + 8, NULL, 10);
+        else if (strncmp(argv[i], "--latency-us=", 13) == 0) latency_us = (uint32_t)strtoul(argv[i] + 13, NULL, 10);
+        else if (strncmp(argv[i], "--jitter-us=", 12) == 0) jitter_us = (uint32_t)strtoul(argv[i] + 12, NULL, 10);
+        else if (strcmp(argv[i], "--sleep-delays") == 0) sleep_delays = 1;
+        else if (strcmp(argv[i], "--json") == 0) g_json = 1;
+        else if (strncmp(argv[i], "--capture=", 10) == 0) capture_spec = argv[i] + 10;
+        else if (strncmp(argv[i], "--count=", 8) == 0) count = strtoul(argv[i] + 8, NULL, 10);
+        else {
+            fprintf(stderr, "usage: %s [--dump=FILE] [--iters=N] [--latency-us=N] [--jitter-us=N] "
+                            "[--sleep-delays] [--json] | --capture=/dev/i2c-N[:addr] [--count=N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (capture_spec) return capture(capture_spec, count) == 0 ? 0 : 1;
+    if (iters == 0) iters = 1;
+
+    static mock_dump_t dump;
+    if (mock_dump_load(&dump, dump_path) != 0) return 1;
+
+    if (!g_json) {
+        printf("dump %s: %zu samples, bus latency %u us + jitter %u us\n",
+               dump_path, dump.count, (unsigned)latency_us, (unsigned)jitter_us);
+        printf("%-24s %10s %12s %10s %10s\n", "benchmark", "iters", "ns/op", "p50 ns", "p99 ns");
+    }
+    /* Bus latency makes each read_measurement cost tens of microseconds: fewer rounds */
+    unsigned long read_iters = latency_us || jitter_us || sleep_delays ? (iters / 100 ? iters / 100 : 1) : iters;
+    if (bench_read_measurement(&dump, read_iters, latency_us * 1000u, jitter_us * 1000u, sleep_delays) != 0) return 1;
+    bench_compensation(&dump, iters * 10);
+    if (bench_i2c_write_reg(iters) != 0) return 1;
+    return 0;
+}
+
+#else
+#include <stdio.h>
+int main(void) {
+    fprintf(stderr, "bme280_bench requires Linux.\n");
+    return 0;
+}
+#endif
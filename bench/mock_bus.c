@@ -0,0 +1,185 @@
+#include "mock_bus.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+uint64_t mock_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+int mock_dump_load(mock_dump_t *dump, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    memset(dump, 0, sizeof(*dump));
+    int have_calib = 0;
+    char line[512];
+    unsigned lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        char *p = line;
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p == '#' || *p == '\n' || *p == '\0') continue;
+        if (strncmp(p, "calib", 5) == 0) {
+            p += 5;
+            size_t n = 0;
+            char *end;
+            for (unsigned long v; n < BME280_CALIB_RAW_LEN && (v = strtoul(p, &end, 16), end != p); p = end) {
+                dump->calib_raw[n++] = (uint8_t)v;
+            }
+            if (n != BME280_CALIB_RAW_LEN) {
+                fprintf(stderr, "%s:%u: calib needs %d bytes\n", path, lineno, BME280_CALIB_RAW_LEN);
+                fclose(f);
+                return -1;
+            }
+            have_calib = 1;
+        } else if (strncmp(p, "adc", 3) == 0) {
+            long t, pr, h;
+            if (sscanf(p + 3, "%ld %ld %ld", &t, &pr, &h) != 3) {
+                fprintf(stderr, "%s:%u: expected adc <T> <P> <H>\n", path, lineno);
+                fclose(f);
+                return -1;
+            }
+            if (dump->count < MOCK_DUMP_MAX) {
+                dump->adc[dump->count][0] = (int32_t)t;
+                dump->adc[dump->count][1] = (int32_t)pr;
+                dump->adc[dump->count][2] = (int32_t)h;
+                dump->count++;
+            }
+        } else {
+            fprintf(stderr, "%s:%u: unknown line\n", path, lineno);
+            fclose(f);
+            return -1;
+        }
+    }
+    fclose(f);
+    if (!have_calib || dump->count == 0) {
+        fprintf(stderr, "%s: needs a calib line and at least one adc line\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static void mock_load_burst(mock_bus_t *m) {
+    const int32_t *a = m->dump->adc[m->next];
+    m->next = (m->next + 1) % m->dump->count;
+    uint32_t t = (uint32_t)a[0], p = (uint32_t)a[1], h = (uint32_t)a[2];
+    m->regs[BME280_REG_PRESS_MSB]  = (uint8_t)(p >> 12);
+    m->regs[BME280_REG_PRESS_LSB]  = (uint8_t)(p >> 4);
+    m->regs[BME280_REG_PRESS_XLSB] = (uint8_t)((p & 0x0F) << 4);
+    m->regs[BME280_REG_TEMP_MSB]   = (uint8_t)(t >> 12);
+    m->regs[BME280_REG_TEMP_LSB]   = (uint8_t)(t >> 4);
+    m->regs[BME280_REG_TEMP_XLSB]  = (uint8_t)((t & 0x0F) << 4);
+    m->regs[BME280_REG_HUM_MSB]    = (uint8_t)(h >> 8);
+    m->regs[BME280_REG_HUM_LSB]    = (uint8_t)h;
+}
+
+static uint64_t mock_rand(mock_bus_t *m) {
+    m->rng ^= m->rng << 13;
+    m->rng ^= m->rng >> 7;
+    m->rng ^= m->rng << 17;
+    return m->rng;
+}
+
+/* Busy-wait the simulated transfer time: sleeping would add scheduler latency
+ * far above a few tens of microseconds. Returns -1 for an injected error. */
+static int mock_transaction(mock_bus_t *m) {
+    uint64_t ns = m->latency_ns;
+    if (m->jitter_ns) ns += mock_rand(m) % (m->jitter_ns + 1u);
+    if (m->spike_ppm && mock_rand(m) % 1000000u < m->spike_ppm) {
+        ns += m->spike_ns;
+        m->spikes++;
+    }
+    if (ns) {
+        uint64_t end = mock_now_ns() + ns;
+        while (mock_now_ns() < end) {}
+    }
+    if (m->err_ppm && mock_rand(m) % 1000000u < m->err_ppm) {
+        m->errors++;
+        return -1;
+    }
+    return 0;
+}
+
+static int mock_read(void *user, uint8_t reg, uint8_t *buf, size_t len) {
+    mock_bus_t *m = (mock_bus_t *)user;
+    if (mock_transaction(m) != 0) return -1;
+    m->reads++;
+    if ((size_t)reg + len > sizeof(m->regs)) return -1;
+    if (reg == BME280_REG_PRESS_MSB) mock_load_burst(m);
+    memcpy(buf, &m->regs[reg], len);
+    return 0;
+}
+
+/* Register/value pairs after the first value, as on the real part */
+static int mock_write(void *user, uint8_t reg, const uint8_t *buf, size_t len) {
+    mock_bus_t *m = (mock_bus_t *)user;
+    if (mock_transaction(m) != 0) return -1;
+    m->writes++;
+    for (size_t i = 0; i < len; i += 2) {
+        uint8_t r = i ? buf[i - 1] : reg;
+        if (r == BME280_REG_RESET) continue;      /* reset: NVM copy is instant, STATUS stays 0 */
+        m->regs[r] = buf[i];
+    }
+    return 0;
+}
+
+static void mock_delay_ms(void *user, uint32_t ms) {
+    mock_bus_t *m = (mock_bus_t *)user;
+    m->delays++;
+    m->delay_ms_total += ms;
+    if (m->sleep_delays && ms) {
+        struct timespec ts = { (time_t)(ms / 1000u), (long)(ms % 1000u) * 1000000L };
+        nanosleep(&ts, NULL);
+    }
+}
+
+void mock_bus_init(mock_bus_t *m, const mock_dump_t *dump, uint32_t latency_ns, uint32_t jitter_ns) {
+    memset(m, 0, sizeof(*m));
+    m->dump = dump;
+    m->latency_ns = latency_ns;
+    m->jitter_ns = jitter_ns;
+    m->rng = 0x9E3779B97F4A7C15ull;
+    m->regs[BME280_REG_ID] = BME280_CHIP_ID;
+    memcpy(&m->regs[BME280_CALIB00_START], dump->calib_raw, BME280_CALIB00_LEN);
+    memcpy(&m->regs[BME280_CALIB26_START], dump->calib_raw + BME280_CALIB00_LEN, BME280_CALIB26_LEN);
+}
+
+void mock_bus_bind(mock_bus_t *m, bme280_bus_t *bus) {
+    bus->read = mock_read;
+    bus->write = mock_write;
+    bus->delay_ms = mock_delay_ms;
+    bus->user = m;
+}
+
+#if defined(__linux__)
+int mock_i2c_transfer(void *user, struct i2c_msg *msgs, size_t nmsgs) {
+    mock_i2c_t *a = (mock_i2c_t *)user;
+    __atomic_fetch_add(&a->transfers, 1, __ATOMIC_RELAXED);   /* probes share the adapter with its worker */
+    int multi = 0;
+    for (size_t i = 0; i < nmsgs; ++i) {
+        struct i2c_msg *msg = &msgs[i];
+        mock_bus_t *m = msg->addr < 128 && !(msg->flags & I2C_M_TEN) ? a->dev[msg->addr] : NULL;
+        if (!m) { errno = ENXIO; return -1; }
+        if (msg->addr != msgs[0].addr) multi = 1;
+        int rc = 0;
+        if (msg->flags & I2C_M_RD) {
+            rc = mock_read(m, m->ptr, msg->buf, msg->len);
+        } else if (msg->len == 1) {
+            m->ptr = msg->buf[0];   /* address phase of a register read */
+        } else if (msg->len > 1) {
+            rc = mock_write(m, msg->buf[0], msg->buf + 1, msg->len - 1u);
+        }
+        if (rc != 0) { errno = EIO; return -1; }
+    }
+    if (multi) __atomic_fetch_add(&a->multi, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+#endif
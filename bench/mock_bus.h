@@ -0,0 +1,94 @@
+#ifndef MOCK_BUS_H
+#define MOCK_BUS_H
+
+/*
+ * Simulated BME280 behind a bme280_bus_t, for benchmarks without hardware.
+ *
+ * The mock keeps a register file: chip ID, the NVM calibration from a dump,
+ * the control registers the driver writes and the 8-byte measurement burst.
+ * Every burst read starting at BME280_REG_PRESS_MSB serves the next raw ADC
+ * tuple of the dump (wrapping around), so the driver decodes real values.
+ * Each bus transaction busy-waits latency_ns plus a uniform 0..jitter_ns, like
+ * a 400 kHz I2C or an SPI transfer would; delay_ms() calls are counted and only
+ * slept through when sleep_delays is set. For soak runs, a transaction can
+ * also fail (err_ppm per million, the callback returns -1 as a NAKed I2C
+ * transfer would) or stall for spike_ns (spike_ppm per million).
+ *
+ * On Linux, mocks can also sit behind a simulated I2C adapter (mock_i2c_t):
+ * mock_i2c_transfer() serves I2C_RDWR message lists for I2CDevice's transfer
+ * hook (i2c_device_open_transfer), one mock per address, so combined
+ * transactions addressing several sensors (bme280_i2c_batch_*) run against
+ * the mocks too. A message to an empty address NAKs the whole transaction.
+ *
+ * Dump format (text, '#' starts a comment):
+ *     calib <33 hex bytes: CALIB00..CALIB25 then CALIB26..CALIB32>
+ *     adc <adc_T> <adc_P> <adc_H>        one line per measurement
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "BME280.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef MOCK_DUMP_MAX
+#define MOCK_DUMP_MAX 4096
+#endif
+
+typedef struct {
+    uint8_t  calib_raw[BME280_CALIB_RAW_LEN];
+    int32_t  adc[MOCK_DUMP_MAX][3];  /* adc_T, adc_P, adc_H */
+    size_t   count;
+} mock_dump_t;
+
+typedef struct {
+    uint8_t            regs[256];
+    const mock_dump_t *dump;
+    size_t             next;         /* next ADC tuple served */
+    uint32_t           latency_ns;   /* per transaction */
+    uint32_t           jitter_ns;    /* extra uniform 0..jitter_ns */
+    int                sleep_delays; /* honour delay_ms() instead of only counting it */
+    uint32_t           err_ppm;      /* transactions failing, per million */
+    uint32_t           spike_ppm;    /* transactions stalling spike_ns, per million */
+    uint32_t           spike_ns;
+    uint8_t            ptr;          /* register pointer set by a bare address write (mock_i2c_t) */
+    uint64_t           rng;
+    unsigned long      reads, writes, delays;
+    unsigned long      errors, spikes;
+    uint64_t           delay_ms_total;
+} mock_bus_t;
+
+/* Load a dump file. Returns 0, or -1 with a message on stderr. */
+int mock_dump_load(mock_dump_t *dump, const char *path);
+
+/* Reset the register file to power-on values with dump's calibration. */
+void mock_bus_init(mock_bus_t *m, const mock_dump_t *dump, uint32_t latency_ns, uint32_t jitter_ns);
+
+/* Fill bus with callbacks backed by m. */
+void mock_bus_bind(mock_bus_t *m, bme280_bus_t *bus);
+
+/* CLOCK_MONOTONIC in nanoseconds */
+uint64_t mock_now_ns(void);
+
+#if defined(__linux__)
+#include <linux/i2c.h>
+
+typedef struct {
+    mock_bus_t    *dev[128];    /* mock answering at each 7-bit address, NULL: NAK */
+    unsigned long  transfers;   /* transactions submitted */
+    unsigned long  multi;       /* transactions addressing more than one mock (batched rounds) */
+} mock_i2c_t;
+
+/* i2c_device_transfer_f over a mock_i2c_t (user). Every message costs a mock
+ * transaction; the first failure ends the transaction with -1 (errno EIO, or
+ * ENXIO for an empty address). */
+int mock_i2c_transfer(void *user, struct i2c_msg *msgs, size_t nmsgs);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MOCK_BUS_H */
@@ -0,0 +1,558 @@
+/*
+ * Soak / load harness: months of sensor and UI traffic in minutes.
+ *
+ * Builds the real dashboard (main.c's ui_create) on an in-memory LVGL display
+ * and runs the real sensor registry against N simulated BME280s (mock_bus.h,
+ * replaying a dump) on a virtual clock: sensor_registry_set_bus_factory()
+ * hands the mocks to discovery and probing, sensor_registry_set_clock() puts
+ * every worker wait and conversion sleep on virtual time. Each bus group is a
+ * simulated I2C adapter (mock_i2c_t) with one mock per address, so due
+ * sensors are sampled in batched rounds (bme280_i2c_batch_*) as on a real
+ * adapter node; --unbatched hands out bare buses instead. Workers, batching,
+ * burst retry and filter pipeline (sample_filter.h), adaptive levels
+ * (sample_sched.h), derived metrics, the calibration cache and re-attach with
+ * backoff after bus errors are the production code; every sample goes through
+ * main.c's publish path (history, telemetry, sample log). Once all sampling
+ * threads are blocked, the main loop plays the GUI thread: once per
+ * UI_UPDATE_INTERVAL_MS of virtual time with new data it runs
+ * update_display_timer_cb() and renders with lv_refr_now(); then it moves the
+ * clock to the next deadline.
+ *
+ *   make bench && ./bench/soak [--days=D] [--sensors=N] [--period=SEC] [--fixed]
+ *                              [--latency-us=U] [--jitter-us=J] [--err-ppm=P]
+ *                              [--spike-ppm=P --spike-us=U] [--speed=X]
+ *                              [--report-s=SEC] [--report=FILE] [--json]
+ *                              [--max-rss-growth-kb=K] [--telemetry=DEST]
+ *                              [--sample-log=PATH] [--dump=FILE] [--unbatched]
+ *
+ *   --days        virtual run time (default 30)
+ *   --sensors     simulated sensors (default 8, up to SENSOR_REGISTRY_MAX),
+ *                 spread over SOAK_BUSES bus groups (one worker each); the
+ *                 first on a bus is probed (answers at 0x76), the others
+ *                 have fixed addresses
+ *   --period      base sampling interval (default SENSOR_REFRESH_SEC); --fixed
+ *                 samples every period instead of at the adaptive levels
+ *   --err-ppm     bus transactions failing, per million
+ *   --spike-ppm   bus transactions stalling --spike-us (default 20000 us)
+ *   --speed       virtual seconds per real second (default 0: as fast as possible)
+ *
+ * One report row per --report-s of virtual time (default 6 h), CSV or JSON
+ * lines, to stdout or --report: virtual and wall time, sample and frame
+ * throughput, reads ok / failed, filter bursts and rejects (the registry's
+ * perf_stats counters), per-sample bus time p50 / p99 and frame latency
+ * p50 / p99 (wall time; conversion waits are virtual) with the maximum so far,
+ * process RSS, LVGL heap use and CPU use. The registry's log lines go to
+ * stderr. A summary follows (with the number of bus transactions that served
+ * several sensors at once); with --max-rss-growth-kb the exit status is 1
+ * when RSS grew more than that between the first and the last row.
+ */
+
+#define main weather_app_main
+int weather_app_main(int argc, char **argv);
+#include "../main.c"
+#undef main
+
+#include <sys/resource.h>
+
+#include "mock_bus.h"
+
+#ifndef SOAK_BUSES
+#define SOAK_BUSES SENSOR_WORKERS_MAX
+#endif
+#ifndef SOAK_EPOCH_S
+#define SOAK_EPOCH_S 1767225600u     /* virtual wall clock at start: 2026-01-01 00:00 UTC */
+#endif
+#define SOAK_SLOTS (2 * SENSOR_WORKERS_MAX + SENSOR_REGISTRY_MAX)
+
+/*
+ * Virtual clock (sensor_clock_t). A sampling thread that would sleep parks in
+ * a slot with its deadline; when every sampling thread is parked, time only
+ * moves under the main loop's control, which releases the slots that are due.
+ * Slots 0..SENSOR_WORKERS_MAX-1 are the workers' idle waits, the rest serve
+ * conversion sleeps. A released thread counts as running at once, so the main
+ * loop never steps past work it has started.
+ */
+typedef struct {
+    uint64_t due;
+    int      parked;
+    int      used;   // sleep slots: owned until the released thread has left
+} soak_slot_t;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  step;    // sampling threads: a slot was released
+    pthread_cond_t  idle;    // main loop: every sampling thread is parked
+    uint64_t        now_ns;  // written under lock, read atomically
+    int             threads, parked;
+    int             kick[SENSOR_WORKERS_MAX];
+    soak_slot_t     slot[SOAK_SLOTS];
+} soak_clock_t;
+
+typedef struct {
+    uint64_t frames;
+    perf_hist_t frame;
+} soak_window_t;
+
+static soak_clock_t g_vclock = { .lock = PTHREAD_MUTEX_INITIALIZER, .step = PTHREAD_COND_INITIALIZER,
+                                 .idle = PTHREAD_COND_INITIALIZER };
+static mock_bus_t g_mock[SENSOR_REGISTRY_MAX];
+static mock_i2c_t g_i2c[SOAK_BUSES];
+static int g_published;  // a sample was published since the last frame (atomic)
+static soak_window_t g_win;
+static perf_snapshot_t g_perf_prev;  // registry counters at the start of the window
+
+static void soak_park(soak_clock_t *c, soak_slot_t *s, uint64_t due)
+{
+    s->due = due;
+    s->parked = 1;
+    if (++c->parked == c->threads) pthread_cond_signal(&c->idle);
+    while (s->parked) pthread_cond_wait(&c->step, &c->lock);
+}
+
+static void soak_release(soak_clock_t *c, soak_slot_t *s)
+{
+    s->parked = 0;
+    c->parked--;
+}
+
+static uint64_t soak_clock_now_ns(void *user)
+{
+    return __atomic_load_n(&((soak_clock_t *)user)->now_ns, __ATOMIC_ACQUIRE);
+}
+
+static uint32_t soak_clock_time_s(void *user)
+{
+    return SOAK_EPOCH_S + (uint32_t)(soak_clock_now_ns(user) / 1000000000ull);
+}
+
+static void soak_clock_sleep_until(void *user, uint64_t deadline_ns)
+{
+    soak_clock_t *c = (soak_clock_t *)user;
+    pthread_mutex_lock(&c->lock);
+    if (deadline_ns > c->now_ns) {
+        unsigned i = SENSOR_WORKERS_MAX;
+        while (c->slot[i].used) ++i; // at most one slot per sampling thread
+        c->slot[i].used = 1;
+        soak_park(c, &c->slot[i], deadline_ns);
+        c->slot[i].used = 0;
+    }
+    pthread_mutex_unlock(&c->lock);
+}
+
+static void soak_clock_wait(void *user, unsigned worker, uint64_t deadline_ns)
+{
+    soak_clock_t *c = (soak_clock_t *)user;
+    pthread_mutex_lock(&c->lock);
+    if (!c->kick[worker] && deadline_ns > c->now_ns) soak_park(c, &c->slot[worker], deadline_ns);
+    c->kick[worker] = 0;
+    pthread_mutex_unlock(&c->lock);
+}
+
+static void soak_clock_wake(void *user, unsigned worker)
+{
+    soak_clock_t *c = (soak_clock_t *)user;
+    pthread_mutex_lock(&c->lock);
+    c->kick[worker] = 1;
+    if (c->slot[worker].parked) {
+        soak_release(c, &c->slot[worker]);
+        pthread_cond_broadcast(&c->step);
+    }
+    pthread_mutex_unlock(&c->lock);
+}
+
+static void soak_clock_thread(void *user, int delta)
+{
+    soak_clock_t *c = (soak_clock_t *)user;
+    pthread_mutex_lock(&c->lock);
+    c->threads += delta;
+    if (c->parked == c->threads) pthread_cond_signal(&c->idle);
+    pthread_mutex_unlock(&c->lock);
+}
+
+/* Main loop: wait until every sampling thread is parked; returns the earliest
+ * deadline (UINT64_MAX: none) */
+static uint64_t soak_clock_idle(soak_clock_t *c)
+{
+    pthread_mutex_lock(&c->lock);
+    while (c->parked < c->threads) pthread_cond_wait(&c->idle, &c->lock);
+    uint64_t due = UINT64_MAX;
+    for (unsigned i = 0; i < SOAK_SLOTS; ++i) {
+        if (c->slot[i].parked && c->slot[i].due < due) due = c->slot[i].due;
+    }
+    pthread_mutex_unlock(&c->lock);
+    return due;
+}
+
+static void soak_clock_advance(soak_clock_t *c, uint64_t now_ns)
+{
+    pthread_mutex_lock(&c->lock);
+    __atomic_store_n(&c->now_ns, now_ns, __ATOMIC_RELEASE);
+    for (unsigned i = 0; i < SOAK_SLOTS; ++i) {
+        if (c->slot[i].parked && c->slot[i].due <= now_ns) soak_release(c, &c->slot[i]);
+    }
+    pthread_cond_broadcast(&c->step);
+    pthread_mutex_unlock(&c->lock);
+}
+
+/* Sensor index is number index / SOAK_BUSES on bus index % SOAK_BUSES. The
+ * first answers at 0x76 behind a probing spec (discovery tries 0x77 first),
+ * the second at 0x77; the adapter is simulated, so the rest take 0x08 + n. */
+static uint8_t soak_addr(unsigned index)
+{
+    unsigned n = index / SOAK_BUSES;
+    return n == 0 ? BME280_I2C_ADDR_SDO_LOW : n == 1 ? BME280_I2C_ADDR_SDO_HIGH : (uint8_t)(0x08u + n);
+}
+
+/* Bus factory: the mocks behind the bus group's adapter, or bare buses */
+static int soak_bus_open(void *user, unsigned index, const sensor_config_t *cfg, uint8_t addr, bme280_bus_t *bus)
+{
+    (void)user;
+    (void)cfg;
+    if (addr != soak_addr(index)) return -1;
+    mock_bus_bind(&g_mock[index], bus);
+    return 0;
+}
+
+static int soak_i2c_open(void *user, unsigned index, const sensor_config_t *cfg, uint8_t addr, I2CDevice *i2c)
+{
+    (void)user;
+    if (addr != soak_addr(index)) return -1;
+    mock_i2c_t *a = &g_i2c[index % SOAK_BUSES];
+    a->dev[addr] = &g_mock[index];
+    return i2c_device_open_transfer(i2c, cfg->path, addr, mock_i2c_transfer, a);
+}
+
+static void soak_bus_close(void *user, unsigned index)
+{
+    (void)user;
+    g_i2c[index % SOAK_BUSES].dev[soak_addr(index)] = NULL;
+}
+
+static void soak_published(unsigned index, const sensor_sample_t *sample, void *user)
+{
+    sensor_sample_published(index, sample, user);
+    __atomic_store_n(&g_published, 1, __ATOMIC_RELEASE);
+}
+
+static void soak_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    (void)area;
+    (void)color_p;
+    lv_disp_flush_ready(drv);
+}
+
+/* perf_stats' log2 buckets, so perf_hist_percentile_ns() applies */
+static void soak_hist_record(perf_hist_t *h, uint64_t ns)
+{
+    uint64_t us = ns / 1000u;
+    unsigned b = us ? 64u - (unsigned)__builtin_clzll(us) : 0;
+    h->buckets[b < PERF_HIST_BUCKETS ? b : PERF_HIST_BUCKETS - 1]++;
+    h->count++;
+    h->sum_ns += ns;
+    if (ns > h->max_ns) h->max_ns = ns;
+}
+
+/* This window of a cumulative perf_stats histogram; the maximum stays the
+ * run's */
+static void soak_hist_delta(perf_hist_t *out, const perf_hist_t *cur, const perf_hist_t *prev)
+{
+    out->count = cur->count - prev->count;
+    out->sum_ns = cur->sum_ns - prev->sum_ns;
+    out->max_ns = cur->max_ns;
+    for (unsigned b = 0; b < PERF_HIST_BUCKETS; ++b) out->buckets[b] = cur->buckets[b] - prev->buckets[b];
+}
+
+static uint64_t soak_cpu_ns(void)
+{
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return ((uint64_t)ru.ru_utime.tv_sec + (uint64_t)ru.ru_stime.tv_sec) * 1000000000ull +
+           ((uint64_t)ru.ru_utime.tv_usec + (uint64_t)ru.ru_stime.tv_usec) * 1000ull;
+}
+
+static unsigned long soak_rss_kb(void)
+{
+    unsigned long size = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (fscanf(f, "%lu %lu", &size, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * ((unsigned long)sysconf(_SC_PAGESIZE) / 1024ul);
+}
+
+typedef struct {
+    FILE    *out;
+    int      json;
+    uint64_t wall0, wall_prev, cpu_prev;
+    unsigned long rss_first, rss_last, rss_peak;
+    uint32_t lvgl_first, lvgl_last;
+    unsigned rows;
+    unsigned long long samples, frames;
+} soak_report_t;
+
+static void soak_report_row(soak_report_t *r, uint64_t now_ms)
+{
+    uint64_t wall = perf_now_ns(), cpu = soak_cpu_ns();
+    double wall_s = (double)(wall - r->wall_prev) / 1e9;
+    double cpu_pct = wall > r->wall_prev ? 100.0 * (double)(cpu - r->cpu_prev) / (double)(wall - r->wall_prev) : 0.0;
+    unsigned long rss = soak_rss_kb();
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    uint32_t lvgl_used = mon.total_size - mon.free_size;
+    if (r->rows == 0) {
+        r->rss_first = rss;
+        r->lvgl_first = lvgl_used;
+    }
+    r->rss_last = rss;
+    r->lvgl_last = lvgl_used;
+    if (rss > r->rss_peak) r->rss_peak = rss;
+
+    static perf_snapshot_t cur;
+    perf_stats_snapshot(&cur);
+    const uint64_t *c = cur.counters, *p = g_perf_prev.counters;
+    unsigned long long ok = c[PERF_CNT_SENSOR_OK] - p[PERF_CNT_SENSOR_OK];
+    unsigned long long err = c[PERF_CNT_SENSOR_ERR] - p[PERF_CNT_SENSOR_ERR];
+    unsigned long long bursts = c[PERF_CNT_FILTER_BURSTS] - p[PERF_CNT_FILTER_BURSTS];
+    unsigned long long rejects = c[PERF_CNT_FILTER_REJECTS] - p[PERF_CNT_FILTER_REJECTS];
+    unsigned long long samples = ok + err;
+    perf_hist_t bus;
+    soak_hist_delta(&bus, &cur.hist[PERF_HIST_SENSOR_BUS], &g_perf_prev.hist[PERF_HIST_SENSOR_BUS]);
+
+    const soak_window_t *w = &g_win;
+    double virt_h = (double)now_ms / 3.6e6;
+    double sps = wall_s > 0 ? (double)samples / wall_s : 0.0;
+    double fps = wall_s > 0 ? (double)w->frames / wall_s : 0.0;
+    unsigned long long b50 = perf_hist_percentile_ns(&bus, 50) / 1000u, b99 = perf_hist_percentile_ns(&bus, 99) / 1000u;
+    unsigned long long f50 = perf_hist_percentile_ns(&w->frame, 50) / 1000u, f99 = perf_hist_percentile_ns(&w->frame, 99) / 1000u;
+    if (r->json) {
+        fprintf(r->out, "{\"soak\":\"window\",\"virtual_h\":%.2f,\"wall_s\":%.2f,\"samples\":%llu,\"samples_per_s\":%.0f,"
+                "\"frames\":%llu,\"frames_per_s\":%.1f,\"ok\":%llu,\"err\":%llu,\"bursts\":%llu,\"rejects\":%llu,"
+                "\"bus_p50_us\":%llu,\"bus_p99_us\":%llu,\"bus_max_us\":%llu,"
+                "\"frame_p50_us\":%llu,\"frame_p99_us\":%llu,\"frame_max_us\":%llu,"
+                "\"rss_kb\":%lu,\"lvgl_used\":%lu,\"cpu_pct\":%.1f}\n",
+                virt_h, (double)(wall - r->wall0) / 1e9, samples, sps,
+                (unsigned long long)w->frames, fps, ok, err, bursts, rejects,
+                b50, b99, (unsigned long long)(bus.max_ns / 1000u), f50, f99, (unsigned long long)(w->frame.max_ns / 1000u),
+                rss, (unsigned long)lvgl_used, cpu_pct);
+    } else {
+        if (r->rows == 0) {
+            fprintf(r->out, "virtual_h,wall_s,samples,samples_per_s,frames,frames_per_s,ok,err,bursts,rejects,"
+                    "bus_p50_us,bus_p99_us,bus_max_us,frame_p50_us,frame_p99_us,frame_max_us,rss_kb,lvgl_used,cpu_pct\n");
+        }
+        fprintf(r->out, "%.2f,%.2f,%llu,%.0f,%llu,%.1f,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%lu,%lu,%.1f\n",
+                virt_h, (double)(wall - r->wall0) / 1e9, samples, sps,
+                (unsigned long long)w->frames, fps, ok, err, bursts, rejects,
+                b50, b99, (unsigned long long)(bus.max_ns / 1000u), f50, f99, (unsigned long long)(w->frame.max_ns / 1000u),
+                rss, (unsigned long)lvgl_used, cpu_pct);
+    }
+    fflush(r->out);
+    r->rows++;
+    r->wall_prev = wall;
+    r->cpu_prev = cpu;
+    r->samples += samples;
+    r->frames += w->frames;
+    g_perf_prev = cur;
+    memset(&g_win, 0, sizeof(g_win));
+}
+
+int main(int argc, char **argv)
+{
+    double days = 30.0, speed = 0.0;
+    unsigned sensors = 8, period_s = SENSOR_REFRESH_SEC, report_s = 6 * 3600;
+    unsigned latency_us = 0, jitter_us = 0, err_ppm = 0, spike_ppm = 0, spike_us = 20000;
+    long max_rss_growth_kb = -1;
+    const char *dump_path = "bench/data/bme280_sample.dump";
+    const char *report_path = NULL, *telemetry = NULL, *log_path = NULL;
+    int json = 0, adaptive = 1, batched = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--days=", 7) == 0) days = strtod(argv[i] + 7, NULL);
+        else if (strncmp(argv[i], "--sensors=", 10) == 0) sensors = (unsigned)strtoul(argv[i] + 10, NULL, 10);
+        else if (strncmp(argv[i], "--period=", 9) == 0) period_s = (unsigned)strtoul(argv[i] + 9, NULL, 10);
+        else if (strcmp(argv[i], "--fixed") == 0) adaptive = 0;
+        else if (strncmp(argv[i], "--latency-us=", 13) == 0) latency_us = (unsigned)strtoul(argv[i] + 13, NULL, 10);
+        else if (strncmp(argv[i], "--jitter-us=", 12) == 0) jitter_us = (unsigned)strtoul(argv[i] + 12, NULL, 10);
+        else if (strncmp(argv[i], "--err-ppm=", 10) == 0) err_ppm = (unsigned)strtoul(argv[i] + 10, NULL, 10);
+        else if (strncmp(argv[i], "--spike-ppm=", 12) == 0) spike_ppm = (unsigned)strtoul(argv[i] + 12, NULL, 10);
+        else if (strncmp(argv[i], "--spike-us=", 11) == 0) spike_us = (unsigned)strtoul(argv[i] + 11, NULL, 10);
+        else if (strncmp(argv[i], "--speed=", 8) == 0) speed = strtod(argv[i] + 8, NULL);
+        else if (strncmp(argv[i], "--report-s=", 11) == 0) report_s = (unsigned)strtoul(argv[i] + 11, NULL, 10);
+        else if (strncmp(argv[i], "--report=", 9) == 0) report_path = argv[i] + 9;
+        else if (strcmp(argv[i], "--json") == 0) json = 1;
+        else if (strncmp(argv[i], "--max-rss-growth-kb=", 20) == 0) max_rss_growth_kb = strtol(argv[i] + 20, NULL, 10);
+        else if (strncmp(argv[i], "--telemetry=", 12) == 0) telemetry = argv[i] + 12;
+        else if (strncmp(argv[i], "--sample-log=", 13) == 0) log_path = argv[i] + 13;
+        else if (strncmp(argv[i], "--dump=", 7) == 0) dump_path = argv[i] + 7;
+        else if (strcmp(argv[i], "--derived") == 0) g_derived = 1;
+        else if (strcmp(argv[i], "--unbatched") == 0) batched = 0;
+        else {
+            fprintf(stderr, "usage: %s [--days=D] [--sensors=N] [--period=SEC] [--fixed] [--latency-us=U] [--jitter-us=J]\n"
+                            "       [--err-ppm=P] [--spike-ppm=P --spike-us=U] [--speed=X] [--report-s=SEC] [--report=FILE]\n"
+                            "       [--json] [--max-rss-growth-kb=K] [--telemetry=DEST] [--sample-log=PATH] [--derived] [--dump=FILE]\n"
+                            "       [--unbatched]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+    if (sensors == 0) sensors = 1;
+    if (sensors > SENSOR_REGISTRY_MAX) sensors = SENSOR_REGISTRY_MAX;
+    if (period_s == 0) period_s = 1;
+    if (report_s == 0) report_s = 3600;
+    if (err_ppm > 1000000u) err_ppm = 1000000u;
+    if (spike_ppm > 1000000u) spike_ppm = 1000000u;
+    uint64_t end_ns = (uint64_t)(days * 86400.0 * 1e9);
+    uint64_t report_ns = (uint64_t)report_s * 1000000000ull, frame_ns = (uint64_t)UI_UPDATE_INTERVAL_MS * 1000000ull;
+
+    soak_report_t rep = { .out = stdout, .json = json };
+    if (report_path && !(rep.out = fopen(report_path, "w"))) {
+        perror(report_path);
+        return 1;
+    }
+    // The registry logs attaches and level switches on stdout; keep stdout for the report
+    if (!report_path) {
+        int fd = dup(STDOUT_FILENO);
+        if (fd < 0 || !(rep.out = fdopen(fd, "w"))) {
+            perror("stdout");
+            return 1;
+        }
+    }
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+    if (telemetry && telemetry_start(telemetry) != 0) {
+        fprintf(stderr, "Telemetry: cannot start %s: %s\n", telemetry, strerror(errno));
+        return 1;
+    }
+    if (log_path && sample_log_open(log_path, SAMPLE_LOG_SYNC_SEC) != 0) {
+        fprintf(stderr, "Sample log: cannot open %s: %s\n", log_path, strerror(errno));
+        return 1;
+    }
+
+    static mock_dump_t dump;
+    if (mock_dump_load(&dump, dump_path) != 0) return 1;
+
+    // A private calibration cache, so re-attaches after bus errors take the fast path
+    char cache_path[64] = "";
+    if (!getenv("BME280_CALIB_CACHE")) {
+        snprintf(cache_path, sizeof(cache_path), "/tmp/soak_bme280.calib.%ld", (long)getpid());
+        setenv("BME280_CALIB_CACHE", cache_path, 1);
+    }
+
+    for (unsigned i = 0; i < sensors; ++i) {
+        char spec[48];
+        if (i < SOAK_BUSES) snprintf(spec, sizeof(spec), "i2c:/dev/soak-i2c-%u::Soak %u", i % SOAK_BUSES, i);
+        else snprintf(spec, sizeof(spec), "i2c:/dev/soak-i2c-%u:0x%02x:Soak %u", i % SOAK_BUSES, soak_addr(i), i);
+        sensor_registry_add_spec(spec);
+        mock_bus_t *m = &g_mock[i];
+        mock_bus_init(m, &dump, latency_us * 1000u, jitter_us * 1000u);
+        m->next = (i * 17u) % dump.count; // sensors out of phase
+        m->rng = 0x9E3779B97F4A7C15ull * (i + 1u);
+        m->err_ppm = err_ppm;
+        m->spike_ppm = spike_ppm;
+        m->spike_ns = spike_us * 1000u;
+    }
+    const sensor_clock_t clock = {
+        soak_clock_now_ns, soak_clock_time_s, soak_clock_sleep_until, soak_clock_wait, soak_clock_wake,
+        soak_clock_thread, &g_vclock,
+    };
+    const sensor_bus_factory_t factory = { soak_bus_open, soak_bus_close, batched ? soak_i2c_open : NULL, NULL };
+    sensor_registry_set_clock(&clock);
+    sensor_registry_set_bus_factory(&factory);
+    sensor_registry_set_adaptive(adaptive);
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[DISP_HOR_RES * DISP_VER_RES / 10];
+    lv_disp_draw_buf_init(&draw_buf, buf, NULL, sizeof(buf) / sizeof(buf[0]));
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = DISP_HOR_RES;
+    disp_drv.ver_res = DISP_VER_RES;
+    disp_drv.draw_buf = &draw_buf;
+    disp_drv.flush_cb = soak_flush_cb;
+    lv_disp_drv_register(&disp_drv);
+
+    history_init(&g_history);
+    ui_create(0);
+    lv_refr_now(NULL);
+
+    fprintf(stderr, "soak: %.1f virtual days, %u sensors on %u buses, %s sampling every %u s, err %u ppm, spikes %u ppm x %u us\n",
+            days, sensors, sensors < SOAK_BUSES ? sensors : SOAK_BUSES, adaptive ? "adaptive" : "fixed", period_s,
+            err_ppm, spike_ppm, spike_us);
+    memset(&g_win, 0, sizeof(g_win));
+    perf_stats_snapshot(&g_perf_prev);
+    rep.wall0 = rep.wall_prev = perf_now_ns();
+    rep.cpu_prev = soak_cpu_ns();
+    if (sensor_registry_start(period_s, soak_published, NULL) <= 0) {
+        fprintf(stderr, "soak: cannot start the sensor registry\n");
+        return 1;
+    }
+
+    uint64_t now_ns = 0, next_frame_ns = frame_ns, next_report_ns = report_ns;
+    for (;;) {
+        uint64_t due = soak_clock_idle(&g_vclock);
+        int published = __atomic_load_n(&g_published, __ATOMIC_ACQUIRE);
+        if (now_ns >= next_frame_ns) {
+            // update_display_timer_cb()'s cadence: only when something was published
+            if (published) {
+                __atomic_store_n(&g_published, 0, __ATOMIC_RELEASE);
+                published = 0;
+                uint64_t t0 = perf_now_ns();
+                update_display_timer_cb(NULL);
+                lv_refr_now(NULL);
+                soak_hist_record(&g_win.frame, perf_now_ns() - t0);
+                g_win.frames++;
+            }
+            next_frame_ns = (now_ns / frame_ns + 1) * frame_ns;
+        }
+        if (now_ns >= next_report_ns || now_ns >= end_ns) {
+            soak_report_row(&rep, now_ns / 1000000u);
+            next_report_ns += report_ns;
+        }
+        if (now_ns >= end_ns) break;
+
+        // Next event: the earliest sampling deadline, a GUI refresh or a report
+        uint64_t next = next_report_ns < end_ns ? next_report_ns : end_ns;
+        if (published && next_frame_ns < next) next = next_frame_ns;
+        if (due < next) next = due;
+        if (speed > 0) {
+            uint64_t wall_due = rep.wall0 + (uint64_t)((double)next / speed);
+            uint64_t t = perf_now_ns();
+            if (wall_due > t) {
+                struct timespec ts = { (time_t)((wall_due - t) / 1000000000ull), (long)((wall_due - t) % 1000000000ull) };
+                nanosleep(&ts, NULL);
+            }
+        }
+        now_ns = next;
+        soak_clock_advance(&g_vclock, now_ns);
+    }
+
+    // Every sampling thread is parked: the mocks' counters are stable
+    double wall_s = (double)(perf_now_ns() - rep.wall0) / 1e9;
+    long rss_growth = (long)rep.rss_last - (long)rep.rss_first;
+    long lvgl_growth = (long)rep.lvgl_last - (long)rep.lvgl_first;
+    unsigned long bus_errors = 0, spikes = 0, multi = 0;
+    for (unsigned i = 0; i < sensors; ++i) {
+        bus_errors += g_mock[i].errors;
+        spikes += g_mock[i].spikes;
+    }
+    for (unsigned b = 0; b < SOAK_BUSES; ++b) multi += g_i2c[b].multi;
+    if (rep.json) {
+        fprintf(rep.out, "{\"soak\":\"summary\",\"virtual_days\":%.2f,\"wall_s\":%.2f,\"sensors\":%u,\"samples\":%llu,"
+                "\"frames\":%llu,\"bus_errors\":%lu,\"bus_spikes\":%lu,\"batched_transfers\":%lu,\"rss_first_kb\":%lu,\"rss_last_kb\":%lu,"
+                "\"rss_peak_kb\":%lu,\"rss_growth_kb\":%ld,\"lvgl_growth\":%ld}\n",
+                (double)now_ns / 8.64e13, wall_s, sensors, rep.samples, rep.frames, bus_errors, spikes, multi,
+                rep.rss_first, rep.rss_last, rep.rss_peak, rss_growth, lvgl_growth);
+    } else {
+        fprintf(stderr, "soak: %.2f virtual days in %.1f s (x%.0f), %llu samples, %llu frames, %lu bus errors, %lu spikes, "
+                "%lu batched transfers\n",
+                (double)now_ns / 8.64e13, wall_s, wall_s > 0 ? (double)now_ns / 1e9 / wall_s : 0.0,
+                rep.samples, rep.frames, bus_errors, spikes, multi);
+        fprintf(stderr, "soak: RSS %lu -> %lu KiB (peak %lu, growth %ld), LVGL heap growth %ld bytes\n",
+                rep.rss_first, rep.rss_last, rep.rss_peak, rss_growth, lvgl_growth);
+    }
+    fclose(rep.out);
+    if (cache_path[0]) unlink(cache_path);
+    if (max_rss_growth_kb >= 0 && rss_growth > max_rss_growth_kb) {
+        fprintf(stderr, "soak: RSS grew %ld KiB, more than the allowed %ld KiB\n", rss_growth, max_rss_growth_kb);
+        return 1;
+    }
+    return 0;
+}
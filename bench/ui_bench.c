@@ -0,0 +1,165 @@
+/*
+ * End-to-end headless UI benchmark.
+ *
+ * Builds the real dashboard (main.c's ui_create) on an in-memory LVGL display
+ * with N sensors, then per frame reads every sensor through the BME280 driver
+ * on the mock bus (replaying a dump), publishes the samples with
+ * update_display_data() and renders with lv_refr_now(). Nothing is drawn to a
+ * screen; the flush callback only counts.
+ *
+ *   make bench && ./bench/ui_bench [--frames=N] [--sensors=N] [--dump=FILE] [--layout=fixed|flex] [--derived] [--json]
+ *
+ * Reports frames per second, flushed areas and bytes per frame, the cost of
+ * update_display_data() per call and CPU time per sample (driver read +
+ * compensation + filter pipeline + derived metrics + display update + its
+ * share of the render).
+ */
+
+#define main weather_app_main
+int weather_app_main(int argc, char **argv);
+#include "../main.c"
+#undef main
+
+#include "mock_bus.h"
+#include "../sample_filter.h"
+
+typedef struct {
+    uint64_t frames;
+    uint64_t areas;
+    uint64_t bytes;
+} ui_bench_flush_t;
+
+static ui_bench_flush_t g_flush;
+
+static void ui_bench_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    (void)color_p;
+    g_flush.areas++;
+    g_flush.bytes += (uint64_t)lv_area_get_size(area) * sizeof(lv_color_t);
+    if (lv_disp_flush_is_last(drv)) g_flush.frames++;
+    lv_disp_flush_ready(drv);
+}
+
+static uint64_t ui_bench_cpu_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned frames = 600, sensors = 8;
+    const char *dump_path = "bench/data/bme280_sample.dump";
+    int json = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (strncmp(argv[i], "--frames=", 9) == 0) frames = (unsigned)strtoul(argv[i] + 9, NULL, 10);
+        else if (strncmp(argv[i], "--sensors=", 10) == 0) sensors = (unsigned)strtoul(argv[i] + 10, NULL, 10);
+        else if (strncmp(argv[i], "--dump=", 7) == 0) dump_path = argv[i] + 7;
+        else if (strncmp(argv[i], "--layout=", 9) == 0) g_layout_fixed = strcmp(argv[i] + 9, "flex") != 0;
+        else if (strcmp(argv[i], "--derived") == 0) g_derived = 1;
+        else if (strcmp(argv[i], "--json") == 0) json = 1;
+        else {
+            fprintf(stderr, "usage: %s [--frames=N] [--sensors=N] [--dump=FILE] [--layout=fixed|flex] [--derived] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (frames == 0) frames = 1;
+    if (sensors == 0) sensors = 1;
+    if (sensors > SENSOR_REGISTRY_MAX) sensors = SENSOR_REGISTRY_MAX;
+
+    static mock_dump_t dump;
+    if (mock_dump_load(&dump, dump_path) != 0) return 1;
+
+    // One simulated BME280 per card; the registry only supplies names and the card count
+    static mock_bus_t bus[SENSOR_REGISTRY_MAX];
+    static bme280_t dev[SENSOR_REGISTRY_MAX];
+    static derived_t derived[SENSOR_REGISTRY_MAX];
+    static sample_filter_t filter[SENSOR_REGISTRY_MAX];
+    static sample_filter_config_t filter_cfg;
+    sample_filter_parse(SAMPLE_FILTER_DEFAULT, &filter_cfg);
+    const bme280_settings_t forced = {
+        .osr_t = BME280_OSRS_X1, .osr_p = BME280_OSRS_X1, .osr_h = BME280_OSRS_X1,
+        .filter = BME280_FILTER_OFF, .standby = BME280_STANDBY_1000_MS, .mode = BME280_FORCED_MODE,
+    };
+    for (unsigned i = 0; i < sensors; ++i) {
+        char spec[32];
+        snprintf(spec, sizeof(spec), "i2c:/dev/null:0x76:Bench %u", i);
+        sensor_registry_add_spec(spec);
+        mock_bus_init(&bus[i], &dump, 0, 0);
+        bus[i].next = (i * 17u) % dump.count; // sensors out of phase
+        bme280_bus_t b;
+        mock_bus_bind(&bus[i], &b);
+        if (bme280_init(&dev[i], &b, BME280_I2C_ADDR_SDO_LOW) != BME280_OK) {
+            fprintf(stderr, "bme280_init on the mock bus failed\n");
+            return 1;
+        }
+        bme280_apply_settings(&dev[i], &forced);
+        derived_init(&derived[i], 250.0f);
+        sample_filter_init(&filter[i], &filter_cfg);
+    }
+
+    lv_init();
+    static lv_disp_draw_buf_t draw_buf;
+    static lv_color_t buf[DISP_HOR_RES * DISP_VER_RES / 10];
+    lv_disp_draw_buf_init(&draw_buf, buf, NULL, sizeof(buf) / sizeof(buf[0]));
+    static lv_disp_drv_t disp_drv;
+    lv_disp_drv_init(&disp_drv);
+    disp_drv.hor_res = DISP_HOR_RES;
+    disp_drv.ver_res = DISP_VER_RES;
+    disp_drv.draw_buf = &draw_buf;
+    disp_drv.flush_cb = ui_bench_flush_cb;
+    lv_disp_drv_register(&disp_drv);
+
+    history_init(&g_history);
+    ui_create(0);
+    lv_refr_now(NULL); // first full frame is not counted
+    memset(&g_flush, 0, sizeof(g_flush));
+
+    uint64_t update_ns = 0, samples = 0;
+    uint64_t wall0 = perf_now_ns(), cpu0 = ui_bench_cpu_ns();
+    for (unsigned f = 0; f < frames; ++f) {
+        for (unsigned i = 0; i < sensors; ++i) {
+            bme280_reading_t r;
+            sensor_sample_t s = { .temperature = NAN, .pressure = NAN, .humidity = NAN };
+            if (bme280_read_measurement(&dev[i], &r) == BME280_OK) {
+                float v[3] = { r.temperature_c, r.pressure_pa / 100.0f, r.humidity_rh };
+                s.valid = s.online = 1;
+                s.rejected = (uint8_t)sample_filter_apply(&filter[i], f, v, BME280_FILTER_OFF, 0);
+                s.temperature = v[0];
+                s.pressure = v[1];
+                s.humidity = v[2];
+            }
+            s.time_s = (uint32_t)time(NULL);
+            derived_update(&derived[i], s.time_s, s.temperature, s.pressure, s.humidity, &s.derived);
+            uint64_t t0 = perf_now_ns();
+            update_display_data(i, &s);
+            update_ns += perf_now_ns() - t0;
+            samples++;
+        }
+        lv_refr_now(NULL);
+    }
+    double wall_s = (double)(perf_now_ns() - wall0) / 1e9;
+    double cpu_us = (double)(ui_bench_cpu_ns() - cpu0) / 1e3;
+
+    double fps = (double)frames / wall_s;
+    double bytes_per_frame = (double)g_flush.bytes / (double)frames;
+    double areas_per_frame = (double)g_flush.areas / (double)frames;
+    double update_ns_per_call = (double)update_ns / (double)samples;
+    double cpu_us_per_sample = cpu_us / (double)samples;
+    if (json) {
+        printf("{\"bench\":\"ui_end_to_end\",\"frames\":%u,\"sensors\":%u,\"layout\":\"%s\",\"fps\":%.1f,"
+               "\"flush_areas_per_frame\":%.2f,\"flush_bytes_per_frame\":%.0f,"
+               "\"update_display_ns\":%.0f,\"cpu_us_per_sample\":%.2f}\n",
+               frames, sensors, g_layout_fixed ? "fixed" : "flex", fps, areas_per_frame, bytes_per_frame, update_ns_per_call, cpu_us_per_sample);
+    } else {
+        printf("ui_end_to_end: %u frames, %u sensors, %dx%d, %s layout\n", frames, sensors,
+               DISP_HOR_RES, DISP_VER_RES, g_layout_fixed ? "fixed" : "flex");
+        printf("  frames per second        %10.1f\n", fps);
+        printf("  flush areas per frame    %10.2f\n", areas_per_frame);
+        printf("  flush bytes per frame    %10.0f\n", bytes_per_frame);
+        printf("  update_display_data      %10.0f ns/call\n", update_ns_per_call);
+        printf("  CPU per sample           %10.2f us\n", cpu_us_per_sample);
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "derived.h"
+
+#include <math.h>
+#include <string.h>
+
+#define DERIVED_MAGNUS_B 17.62f
+#define DERIVED_MAGNUS_C 243.12f
+
+float derived_logf(float x) {
+    union { float f; uint32_t u; } v = { x };
+    int e = (int)((v.u >> 23) & 0xFFu) - 127;
+    v.u = (v.u & 0x007FFFFFu) | 0x3F800000u;   /* mantissa in [1, 2) */
+    float m = v.f;
+    if (m > 1.41421356f) { m *= 0.5f; e++; }    /* [sqrt(1/2), sqrt(2)): |s| <= 0.172 */
+    /* log(m) = 2 atanh(s) = 2 (s + s^3/3 + s^5/5 + s^7/7 + ...), s = (m - 1) / (m + 1) */
+    float s = (m - 1.0f) / (m + 1.0f), s2 = s * s;
+    float poly = s * (2.0f + s2 * (0.666666667f + s2 * (0.4f + s2 * 0.285714286f)));
+    return (float)e * 0.693147181f + poly;
+}
+
+float derived_dew_point(float t, float h) {
+    if (isnan(t) || isnan(h) || h <= 0.0f) return NAN;
+    if (h > 100.0f) h = 100.0f;
+    float g = derived_logf(h * 0.01f) + DERIVED_MAGNUS_B * t / (DERIVED_MAGNUS_C + t);
+    return DERIVED_MAGNUS_C * g / (DERIVED_MAGNUS_B - g);
+}
+
+float derived_heat_index(float t, float h) {
+    if (isnan(t) || isnan(h)) return NAN;
+    float f = t * 1.8f + 32.0f;
+    float hi = 0.5f * (f + 61.0f + (f - 68.0f) * 1.2f + h * 0.094f);
+    if ((hi + f) * 0.5f >= 80.0f) {
+        hi = -42.379f + 2.04901523f * f + 10.14333127f * h - 0.22475541f * f * h
+           - 6.83783e-3f * f * f - 5.481717e-2f * h * h + 1.22874e-3f * f * f * h
+           + 8.5282e-4f * f * h * h - 1.99e-6f * f * f * h * h;
+        if (h < 13.0f && f >= 80.0f && f <= 112.0f) {
+            hi -= (13.0f - h) * 0.25f * sqrtf((17.0f - fabsf(f - 95.0f)) / 17.0f);
+        } else if (h > 85.0f && f >= 80.0f && f <= 87.0f) {
+            hi += (h - 85.0f) * 0.1f * (87.0f - f) * 0.2f;
+        }
+    }
+    return (hi - 32.0f) / 1.8f;
+}
+
+void derived_init(derived_t *d, float altitude_m) {
+    memset(d, 0, sizeof(*d));
+    d->slp_factor = isnan(altitude_m) || altitude_m >= 44330.0f ? NAN
+                  : 1.0f / powf(1.0f - altitude_m / 44330.0f, 5.255f);
+}
+
+void derived_update(derived_t *d, uint32_t time_s, float t, float p, float h, derived_values_t *out) {
+    out->dew_point = derived_dew_point(t, h);
+    out->heat_index = derived_heat_index(t, h);
+    out->sea_level = p * d->slp_factor;      /* NaN propagates */
+    out->tendency_3h = NAN;
+    if (isnan(p)) return;
+
+    uint32_t id = time_s / DERIVED_TENDENCY_BUCKET_S + 1u;
+    unsigned slot = id % DERIVED_TENDENCY_BUCKETS;
+    if (d->id[slot] != id) {
+        d->id[slot] = id;
+        d->sum[slot] = 0.0f;
+        d->count[slot] = 0;
+    }
+    if (d->count[slot] < UINT16_MAX) {
+        d->sum[slot] += p;
+        d->count[slot]++;
+    }
+
+    /* The bucket DERIVED_TENDENCY_S earlier is the ring's next slot */
+    uint32_t then = id - (DERIVED_TENDENCY_BUCKETS - 1u);
+    unsigned old = then % DERIVED_TENDENCY_BUCKETS;
+    if (id > DERIVED_TENDENCY_BUCKETS && d->id[old] == then && d->count[old]) {
+        out->tendency_3h = d->sum[slot] / (float)d->count[slot] - d->sum[old] / (float)d->count[old];
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef DERIVED_H
+#define DERIVED_H
+
+/*
+ * Derived metrics, computed on the sampling thread from each valid sample
+ * before it is published:
+ *   dew point       Magnus formula over water (b = 17.62, c = 243.12 °C)
+ *   heat index      NOAA/Rothfusz regression with its low-humidity and
+ *                   high-humidity adjustments; the Steadman average below
+ *                   80 °F (so it equals roughly the air temperature when cool)
+ *   sea level       station pressure reduced with the barometric formula,
+ *                   p / (1 - h / 44330 m)^5.255, for the configured altitude
+ *                   (NaN while no altitude is set); the factor is computed
+ *                   once, so a sample costs one multiply
+ *   tendency 3 h    pressure now minus pressure three hours ago, hPa; both are
+ *                   DERIVED_TENDENCY_BUCKET_S means from a ring of buckets, so
+ *                   noise averages out and each sample is one add
+ *
+ * Every sample costs O(1): the tendency ring is updated in place and read at
+ * one fixed slot, and the dew point's logarithm is derived_logf (exponent
+ * split plus a short atanh series, absolute error below 1e-6, no libm call).
+ *
+ * Pure state, no I/O; one derived_t per device, owned by its sampling thread.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DERIVED_TENDENCY_S
+#define DERIVED_TENDENCY_S 10800       /* WMO pressure tendency: 3 h */
+#endif
+#ifndef DERIVED_TENDENCY_BUCKET_S
+#define DERIVED_TENDENCY_BUCKET_S 600  /* averaging bucket at either end */
+#endif
+
+#define DERIVED_TENDENCY_BUCKETS (DERIVED_TENDENCY_S / DERIVED_TENDENCY_BUCKET_S + 1)
+
+typedef struct {
+    float dew_point;      /* Celsius */
+    float heat_index;     /* Celsius */
+    float sea_level;      /* hPa */
+    float tendency_3h;    /* hPa over DERIVED_TENDENCY_S */
+} derived_values_t;
+
+typedef struct {
+    uint32_t id[DERIVED_TENDENCY_BUCKETS];   /* time_s / BUCKET_S + 1; 0 = empty */
+    float    sum[DERIVED_TENDENCY_BUCKETS];
+    uint16_t count[DERIVED_TENDENCY_BUCKETS];
+    float    slp_factor;  /* 1 / (1 - h / 44330)^5.255; NaN: no altitude */
+} derived_t;
+
+/* Reset the tendency window; altitude_m is the station height above sea
+ * level (NaN: unknown, no sea-level pressure). */
+void derived_init(derived_t *d, float altitude_m);
+
+/* Fold one valid sample (Celsius, hPa, %RH; NaN channels allowed) in at
+ * time_s (seconds since the epoch) and compute every metric; metrics whose
+ * inputs are missing are NaN. */
+void derived_update(derived_t *d, uint32_t time_s, float t, float p, float h, derived_values_t *out);
+
+/* Stand-alone metrics, with the same approximations */
+float derived_dew_point(float t, float h);
+float derived_heat_index(float t, float h);
+
+/* Fast natural logarithm of a positive, normal x */
+float derived_logf(float x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DERIVED_H */
@@ -0,0 +1,237 @@
+#include "disp_pipeline.h"
+#include "fb_blit.h"
+#include "perf_stats.h"
+#include "thread_policy.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <linux/fb.h>
+
+static lv_disp_draw_buf_t g_draw_buf;
+static lv_color_t g_buf[DISP_BUF_COUNT][DISP_BUF_SIZE];
+static lv_disp_drv_t g_disp_drv;
+static disp_flush_cb_t g_backend_flush = NULL;
+
+static uint32_t disp_area_pixels(const lv_area_t *area)
+{
+    return (uint32_t)(area->x2 - area->x1 + 1) * (uint32_t)(area->y2 - area->y1 + 1);
+}
+
+/* Backend flush with timing; runs on whichever thread performs the flush.
+ * lv_disp_flush_is_last must be read before the backend signals flush_ready. */
+static void disp_timed_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    bool last = lv_disp_flush_is_last(drv);
+    uint64_t t0 = perf_now_ns();
+    g_backend_flush(drv, area, color_p);
+    perf_hist_record(PERF_HIST_FLUSH, perf_now_ns() - t0);
+    perf_count_add(PERF_CNT_FLUSH_AREAS, 1);
+    perf_count_add(PERF_CNT_PIXELS_FLUSHED, disp_area_pixels(area));
+    if (last) perf_count_add(PERF_CNT_FRAMES, 1);
+}
+
+/* ===== Flush worker =====
+ * LVGL keeps at most one flush in flight (it waits for draw_buf->flushing before
+ * handing over the next buffer), so a single job slot is enough. The GUI thread
+ * posts the job and immediately goes back to rendering into the other buffer;
+ * wait_cb blocks on the condition variable instead of spinning when LVGL needs
+ * the buffer back. */
+#if DISP_FLUSH_ASYNC
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    lv_disp_drv_t  *drv;
+    lv_area_t       area;     /* copied: LVGL reuses its area struct after flush_cb returns */
+    lv_color_t     *color_p;
+    bool            pending;  /* job posted, worker not done yet */
+} disp_flush_worker_t;
+
+static disp_flush_worker_t g_worker = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static void *disp_flush_worker_thread(void *arg)
+{
+    disp_flush_worker_t *w = (disp_flush_worker_t *)arg;
+    thread_policy_apply(THREAD_ROLE_FLUSH);
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (!w->pending) pthread_cond_wait(&w->cond, &w->lock);
+        lv_disp_drv_t *drv = w->drv;
+        lv_area_t area = w->area;
+        lv_color_t *color_p = w->color_p;
+        pthread_mutex_unlock(&w->lock);
+
+        disp_timed_flush(drv, &area, color_p); /* backend calls lv_disp_flush_ready() */
+
+        pthread_mutex_lock(&w->lock);
+        w->pending = false;
+        pthread_cond_broadcast(&w->cond);
+    }
+    return NULL;
+}
+
+static void disp_async_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    disp_flush_worker_t *w = &g_worker;
+    pthread_mutex_lock(&w->lock);
+    while (w->pending) pthread_cond_wait(&w->cond, &w->lock);
+    w->drv = drv;
+    w->area = *area;
+    w->color_p = color_p;
+    w->pending = true;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+}
+
+static void disp_async_wait_cb(lv_disp_drv_t *drv)
+{
+    (void)drv;
+    disp_flush_worker_t *w = &g_worker;
+    pthread_mutex_lock(&w->lock);
+    while (w->pending) pthread_cond_wait(&w->cond, &w->lock);
+    pthread_mutex_unlock(&w->lock);
+}
+#endif /* DISP_FLUSH_ASYNC */
+
+lv_disp_t *disp_pipeline_init(disp_flush_cb_t backend_flush, lv_coord_t hor_res, lv_coord_t ver_res)
+{
+    lv_disp_draw_buf_init(&g_draw_buf, g_buf[0], DISP_BUF_COUNT == 2 ? g_buf[DISP_BUF_COUNT - 1] : NULL, DISP_BUF_SIZE);
+
+    lv_disp_drv_init(&g_disp_drv);
+    g_disp_drv.draw_buf = &g_draw_buf;
+    g_disp_drv.hor_res = hor_res;
+    g_disp_drv.ver_res = ver_res;
+    g_backend_flush = backend_flush;
+    g_disp_drv.flush_cb = disp_timed_flush;
+
+#if DISP_FLUSH_ASYNC
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, disp_flush_worker_thread, &g_worker) == 0) {
+        pthread_detach(tid);
+        g_disp_drv.flush_cb = disp_async_flush_cb;
+        g_disp_drv.wait_cb = disp_async_wait_cb;
+    } else {
+        fprintf(stderr, "Display: flush worker unavailable; flushing synchronously\n");
+    }
+#endif
+    return lv_disp_drv_register(&g_disp_drv);
+}
+
+/* ===== Page-flipped framebuffer ===== */
+
+typedef struct {
+    int                      fd;
+    uint8_t                 *mem;
+    size_t                   mem_len;
+    size_t                   page_len;
+    struct fb_var_screeninfo vinfo;
+} disp_flip_fb_t;
+
+static disp_flip_fb_t g_flip = { .fd = -1 };
+static lv_disp_draw_buf_t g_flip_draw_buf;
+
+static void disp_flip_flush_cb(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    /* full_refresh: every flush is a complete frame in one of the two pages */
+    uint64_t t0 = perf_now_ns();
+    bool last = lv_disp_flush_is_last(drv);
+    if (last) {
+        g_flip.vinfo.yoffset = ((uint8_t *)color_p == g_flip.mem) ? 0 : g_flip.vinfo.yres;
+        g_flip.vinfo.xoffset = 0;
+        if (ioctl(g_flip.fd, FBIOPAN_DISPLAY, &g_flip.vinfo) == 0) {
+#ifdef FBIO_WAITFORVSYNC
+            uint32_t crtc = 0;
+            (void)ioctl(g_flip.fd, FBIO_WAITFORVSYNC, &crtc); /* best effort; not all drivers support it */
+#endif
+        }
+    }
+    perf_hist_record(PERF_HIST_FLUSH, perf_now_ns() - t0);
+    perf_count_add(PERF_CNT_FLUSH_AREAS, 1);
+    perf_count_add(PERF_CNT_PIXELS_FLUSHED, disp_area_pixels(area));
+    if (last) perf_count_add(PERF_CNT_FRAMES, 1);
+    lv_disp_flush_ready(drv);
+}
+
+static void disp_flip_close(void)
+{
+    if (g_flip.mem) munmap(g_flip.mem, g_flip.mem_len);
+    if (g_flip.fd >= 0) close(g_flip.fd);
+    g_flip.mem = NULL;
+    g_flip.fd = -1;
+}
+
+lv_disp_t *disp_pipeline_init_flip(const char *fb_path, lv_coord_t hor_res, lv_coord_t ver_res)
+{
+    if (!fb_path) return NULL;
+    g_flip.fd = open(fb_path, O_RDWR | O_CLOEXEC);
+    if (g_flip.fd < 0) {
+        fprintf(stderr, "Display: cannot open %s for page flipping: %s\n", fb_path, strerror(errno));
+        return NULL;
+    }
+
+    struct fb_fix_screeninfo finfo;
+    if (ioctl(g_flip.fd, FBIOGET_VSCREENINFO, &g_flip.vinfo) != 0 ||
+        ioctl(g_flip.fd, FBIOGET_FSCREENINFO, &finfo) != 0) {
+        disp_flip_close();
+        return NULL;
+    }
+
+    /* LVGL renders with stride == hor_res, so the framebuffer must match exactly */
+    if (g_flip.vinfo.xres != (uint32_t)hor_res || g_flip.vinfo.yres != (uint32_t)ver_res ||
+        fb_blit_classify(&g_flip.vinfo) != FB_BLIT_NATIVE ||
+        finfo.line_length != (uint32_t)hor_res * (LV_COLOR_DEPTH / 8)) {
+        fprintf(stderr, "Display: %s is %ux%u@%ubpp (stride %u); page flipping needs %dx%d@%d\n",
+                fb_path, g_flip.vinfo.xres, g_flip.vinfo.yres, g_flip.vinfo.bits_per_pixel,
+                finfo.line_length, (int)hor_res, (int)ver_res, LV_COLOR_DEPTH);
+        disp_flip_close();
+        return NULL;
+    }
+
+    if (g_flip.vinfo.yres_virtual < 2 * g_flip.vinfo.yres) {
+        g_flip.vinfo.yres_virtual = 2 * g_flip.vinfo.yres;
+        if (ioctl(g_flip.fd, FBIOPUT_VSCREENINFO, &g_flip.vinfo) != 0 ||
+            ioctl(g_flip.fd, FBIOGET_VSCREENINFO, &g_flip.vinfo) != 0 ||
+            g_flip.vinfo.yres_virtual < 2 * g_flip.vinfo.yres) {
+            fprintf(stderr, "Display: %s has no double-height virtual mode\n", fb_path);
+            disp_flip_close();
+            return NULL;
+        }
+        if (ioctl(g_flip.fd, FBIOGET_FSCREENINFO, &finfo) != 0) {
+            disp_flip_close();
+            return NULL;
+        }
+    }
+
+    g_flip.page_len = (size_t)finfo.line_length * g_flip.vinfo.yres;
+    g_flip.mem_len = g_flip.page_len * 2;
+    if (finfo.smem_len < g_flip.mem_len) {
+        disp_flip_close();
+        return NULL;
+    }
+    g_flip.mem = (uint8_t *)mmap(NULL, g_flip.mem_len, PROT_READ | PROT_WRITE, MAP_SHARED, g_flip.fd, 0);
+    if (g_flip.mem == MAP_FAILED) {
+        g_flip.mem = NULL;
+        disp_flip_close();
+        return NULL;
+    }
+
+    uint32_t px = (uint32_t)hor_res * (uint32_t)ver_res;
+    lv_disp_draw_buf_init(&g_flip_draw_buf, g_flip.mem, g_flip.mem + g_flip.page_len, px);
+
+    lv_disp_drv_init(&g_disp_drv);
+    g_disp_drv.draw_buf = &g_flip_draw_buf;
+    g_disp_drv.hor_res = hor_res;
+    g_disp_drv.ver_res = ver_res;
+    g_disp_drv.full_refresh = 1;
+    g_disp_drv.flush_cb = disp_flip_flush_cb;
+    return lv_disp_drv_register(&g_disp_drv);
+}
@@ -0,0 +1,75 @@
+#ifndef DISP_PIPELINE_H
+#define DISP_PIPELINE_H
+
+/*
+ * Display pipeline: draw buffers, flush worker and fbdev page flipping.
+ *
+ * Build-time configuration (override with CFLAGS+="-D..."):
+ *   DISP_HOR_RES / DISP_VER_RES  Display resolution (default 480x320)
+ *   DISP_BUF_SIZE                Pixels per draw buffer (default: half a screen)
+ *   DISP_BUF_COUNT               1 or 2 draw buffers (default 2)
+ *   DISP_FLUSH_ASYNC             1: a worker thread runs the backend flush so
+ *                                LVGL renders into the second buffer meanwhile
+ *                                (default 1 with two buffers)
+ *   DISP_RENDER_MODE             DISP_RENDER_PARTIAL (default) or
+ *                                DISP_RENDER_FLIP: full-refresh rendering straight
+ *                                into a double-height mmap'ed framebuffer, shown
+ *                                with FBIOPAN_DISPLAY (fbdev backend only; falls
+ *                                back to PARTIAL if the framebuffer can't do it)
+ */
+
+#include "lvgl/lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef DISP_HOR_RES
+#define DISP_HOR_RES 480            /* Default horizontal resolution for display driver */
+#endif
+
+#ifndef DISP_VER_RES
+#define DISP_VER_RES 320            /* Default vertical resolution for display driver */
+#endif
+
+#ifndef DISP_BUF_SIZE
+#define DISP_BUF_SIZE (DISP_HOR_RES * (DISP_VER_RES / 2))  /* Rendering buffer in pixels; may be smaller than the display resolution */
+#endif
+
+#ifndef DISP_BUF_COUNT
+#define DISP_BUF_COUNT 2
+#endif
+#if DISP_BUF_COUNT != 1 && DISP_BUF_COUNT != 2
+#error "DISP_BUF_COUNT must be 1 or 2"
+#endif
+
+#ifndef DISP_FLUSH_ASYNC
+#define DISP_FLUSH_ASYNC (DISP_BUF_COUNT == 2)
+#endif
+
+#define DISP_RENDER_PARTIAL 0
+#define DISP_RENDER_FLIP    1
+#ifndef DISP_RENDER_MODE
+#define DISP_RENDER_MODE DISP_RENDER_PARTIAL
+#endif
+
+/* Backend flush callback; must call lv_disp_flush_ready() when done (fbdev_flush and
+ * monitor_flush do). With DISP_FLUSH_ASYNC it runs on the flush worker thread. */
+typedef void (*disp_flush_cb_t)(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+
+/* Register a partial-refresh display using the static draw buffers and backend flush.
+ * If the DISP_FLUSH_ASYNC worker cannot start, this logs it and flushes synchronously
+ * on the calling thread instead. Returns lv_disp_drv_register()'s display. */
+lv_disp_t *disp_pipeline_init(disp_flush_cb_t backend_flush, lv_coord_t hor_res, lv_coord_t ver_res);
+
+/* Register a full-refresh, page-flipped display that renders directly into the
+ * framebuffer at fb_path. Returns NULL (nothing registered) if the device does not
+ * support a double-height virtual resolution matching LV_COLOR_DEPTH; the caller
+ * then falls back to disp_pipeline_init(). */
+lv_disp_t *disp_pipeline_init_flip(const char *fb_path, lv_coord_t hor_res, lv_coord_t ver_res);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DISP_PIPELINE_H */
@@ -0,0 +1,122 @@
+#include "event_loop.h"
+
+#include "lvgl/lvgl.h"
+#include "perf_stats.h"
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+typedef struct {
+    int                fd;
+    event_loop_fd_cb_t cb;
+    void              *user;
+} event_loop_slot_t;
+
+static int g_epfd = -1;
+static int g_notify_fd = -1;
+static event_loop_notify_cb_t g_on_notify = NULL;
+static void *g_notify_user = NULL;
+static event_loop_slot_t g_slots[EVENT_LOOP_MAX_FDS];
+static size_t g_slot_count = 0;
+
+uint32_t event_loop_tick_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u);
+}
+
+static void event_loop_drain_notify(int fd, void *user)
+{
+    (void)user;
+    uint64_t cnt;
+    /* Non-blocking eventfd: one read clears all pending notifications */
+    while (read(fd, &cnt, sizeof(cnt)) < 0 && errno == EINTR) { }
+    if (g_on_notify) g_on_notify(g_notify_user);
+}
+
+int event_loop_add_fd(int fd, event_loop_fd_cb_t cb, void *user)
+{
+    if (g_epfd < 0 || fd < 0 || !cb) { errno = EINVAL; return -1; }
+    if (g_slot_count >= EVENT_LOOP_MAX_FDS) { errno = ENOSPC; return -1; }
+
+    event_loop_slot_t *slot = &g_slots[g_slot_count];
+    slot->fd = fd;
+    slot->cb = cb;
+    slot->user = user;
+
+    struct epoll_event ev = { .events = EPOLLIN };
+    ev.data.ptr = slot;
+    if (epoll_ctl(g_epfd, EPOLL_CTL_ADD, fd, &ev) != 0) return -1;
+    g_slot_count++;
+    return 0;
+}
+
+int event_loop_init(event_loop_notify_cb_t on_notify, void *user)
+{
+    if (g_epfd >= 0) return 0;
+    g_epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (g_epfd < 0) return -1;
+
+    int nfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (nfd < 0) {
+        int saved = errno;
+        close(g_epfd);
+        g_epfd = -1;
+        errno = saved;
+        return -1;
+    }
+    g_on_notify = on_notify;
+    g_notify_user = user;
+    if (event_loop_add_fd(nfd, event_loop_drain_notify, NULL) != 0) {
+        int saved = errno;
+        close(nfd);
+        close(g_epfd);
+        g_epfd = -1;
+        errno = saved;
+        return -1;
+    }
+    /* Publish last: event_loop_notify() may already be called from other threads */
+    __atomic_store_n(&g_notify_fd, nfd, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void event_loop_notify(void)
+{
+    int fd = __atomic_load_n(&g_notify_fd, __ATOMIC_ACQUIRE);
+    if (fd < 0) return;
+    uint64_t one = 1;
+    ssize_t rc;
+    do {
+        rc = write(fd, &one, sizeof(one));
+    } while (rc < 0 && errno == EINTR);
+}
+
+void event_loop_run(void)
+{
+    struct epoll_event evs[EVENT_LOOP_MAX_FDS];
+    for (;;) {
+        uint64_t t0 = perf_now_ns();
+        uint32_t delay = lv_timer_handler();
+        perf_hist_record(PERF_HIST_TIMER_HANDLER, perf_now_ns() - t0);
+        /* LV_NO_TIMER_READY: nothing scheduled, sleep until an fd wakes us */
+        int timeout = (delay == LV_NO_TIMER_READY || delay > (uint32_t)INT32_MAX) ? -1 : (int)delay;
+
+        int n = epoll_wait(g_epfd, evs, EVENT_LOOP_MAX_FDS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            /* Unexpected epoll failure: degrade to plain polling rather than spin */
+            usleep(5000);
+            continue;
+        }
+        for (int i = 0; i < n; ++i) {
+            event_loop_slot_t *slot = (event_loop_slot_t *)evs[i].data.ptr;
+            slot->cb(slot->fd, slot->user);
+        }
+    }
+}
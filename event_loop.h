@@ -0,0 +1,53 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+/*
+ * Tickless GUI main loop (Linux epoll).
+ *
+ * The GUI thread runs lv_timer_handler() and then sleeps in epoll_wait() for
+ * exactly the delay LVGL reports until its next timer, or until one of the
+ * registered file descriptors (input device, data-update channel) becomes
+ * readable. Together with LV_TICK_CUSTOM (see lv_conf.h) this removes the
+ * 1 ms tick thread and the fixed 5 ms polling sleep.
+ *
+ * This header is also pulled in by LVGL through LV_TICK_CUSTOM_INCLUDE, so it
+ * must not include lvgl.h.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef EVENT_LOOP_MAX_FDS
+#define EVENT_LOOP_MAX_FDS 8
+#endif
+
+typedef void (*event_loop_fd_cb_t)(int fd, void *user);
+typedef void (*event_loop_notify_cb_t)(void *user);
+
+/* Milliseconds from CLOCK_MONOTONIC; used as LV_TICK_CUSTOM_SYS_TIME_EXPR. */
+uint32_t event_loop_tick_ms(void);
+
+/* Create the epoll set and the cross-thread notification channel (eventfd).
+ * on_notify runs on the GUI thread after any thread called event_loop_notify().
+ * Returns 0 on success, -1 on error with errno set. */
+int event_loop_init(event_loop_notify_cb_t on_notify, void *user);
+
+/* Watch fd for readability; cb runs on the GUI thread. Returns 0 or -1. */
+int event_loop_add_fd(int fd, event_loop_fd_cb_t cb, void *user);
+
+/* Wake the GUI thread (async-signal-safe, callable from any thread).
+ * No-op until event_loop_init() succeeded. */
+void event_loop_notify(void);
+
+/* Run lv_timer_handler() and sleep until the next LVGL deadline or fd event.
+ * Never returns. */
+void event_loop_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EVENT_LOOP_H */
@@ -44,10 +44,11 @@ int main(int argc, char **argv) {
     }
 
     // Configure: oversampling x1, filter off, standby 1000ms, normal mode
-    bme280_set_oversampling(&bme, BME280_OSRS_X1, BME280_OSRS_X1, BME280_OSRS_X1);
-    bme280_set_filter(&bme, BME280_FILTER_OFF);
-    bme280_set_standby(&bme, BME280_STANDBY_1000_MS);
-    bme280_set_mode(&bme, BME280_NORMAL_MODE);
+    const bme280_settings_t settings = {
+        .osr_t = BME280_OSRS_X1, .osr_p = BME280_OSRS_X1, .osr_h = BME280_OSRS_X1,
+        .filter = BME280_FILTER_OFF, .standby = BME280_STANDBY_1000_MS, .mode = BME280_NORMAL_MODE,
+    };
+    bme280_apply_settings(&bme, &settings); // one paired register write
 
     // Build Sensor.h interfaces
     bme280_sensor_wrapper_t temp_ctx, pres_ctx, hum_ctx;
@@ -0,0 +1,238 @@
+#include "fb_blit.h"
+#include "perf_stats.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+typedef struct {
+    int                      fd;
+    uint8_t                 *mem;
+    size_t                   mem_len;
+    uint32_t                 line_length;
+    uint32_t                 bytes_pp;
+    fb_blit_format_t         format;
+    struct fb_var_screeninfo vinfo;
+} fb_blit_t;
+
+static fb_blit_t g_fb = { .fd = -1 };
+
+static const char *const g_format_names[] = { "native", "565", "8888", "generic", "unsupported" };
+
+/* vinfo is bpp bits per pixel with red/green/blue at the given offset:length */
+static int fb_is_layout(const struct fb_var_screeninfo *v, uint32_t bpp, uint32_t ro, uint32_t rl,
+                        uint32_t go, uint32_t gl, uint32_t bo, uint32_t bl)
+{
+    return v->bits_per_pixel == bpp && !v->nonstd && v->grayscale == 0 &&
+           v->red.offset == ro && v->red.length == rl && v->green.offset == go && v->green.length == gl &&
+           v->blue.offset == bo && v->blue.length == bl &&
+           !v->red.msb_right && !v->green.msb_right && !v->blue.msb_right;
+}
+
+fb_blit_format_t fb_blit_classify(const struct fb_var_screeninfo *vinfo)
+{
+    int xrgb8888 = fb_is_layout(vinfo, 32, 16, 8, 8, 8, 0, 8);
+    int rgb565 = fb_is_layout(vinfo, 16, 11, 5, 5, 6, 0, 5);
+    (void)xrgb8888;
+#if LV_COLOR_DEPTH == 32
+    if (xrgb8888) return FB_BLIT_NATIVE;
+    if (rgb565) return FB_BLIT_565;
+#elif LV_COLOR_DEPTH == 16
+    if (rgb565) return FB_BLIT_NATIVE;
+#if !LV_COLOR_16_SWAP
+    if (xrgb8888) return FB_BLIT_8888;
+#endif
+#endif
+    if (vinfo->nonstd || vinfo->grayscale != 0) return FB_BLIT_UNSUPPORTED;
+    if (vinfo->bits_per_pixel != 16 && vinfo->bits_per_pixel != 24 && vinfo->bits_per_pixel != 32) {
+        return FB_BLIT_UNSUPPORTED;
+    }
+    if (vinfo->red.length > 8 || vinfo->green.length > 8 || vinfo->blue.length > 8) return FB_BLIT_UNSUPPORTED;
+    return FB_BLIT_GENERIC;
+}
+
+/* ===== Row kernels ===== */
+
+#if LV_COLOR_DEPTH == 32
+#if defined(__SSE2__)
+/* Four XRGB8888 pixels to RGB565 in the low half of each lane, biased by
+ * -0x8000 so the signed saturating pack keeps all 16 bits */
+static inline __m128i fb_565x4(__m128i p)
+{
+    __m128i r = _mm_and_si128(_mm_srli_epi32(p, 8), _mm_set1_epi32(0xF800));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x07E0));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(p, 3), _mm_set1_epi32(0x001F));
+    return _mm_sub_epi32(_mm_or_si128(_mm_or_si128(r, g), b), _mm_set1_epi32(0x8000));
+}
+#endif
+
+/* XRGB8888 -> RGB565 (truncating, like lv_color_to16) */
+static void fb_row_565(uint16_t *dst, const uint32_t *src, uint32_t n)
+{
+    uint32_t i = 0;
+#if defined(__SSE2__)
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    for (; i + 8 <= n; i += 8) {
+        __m128i lo = fb_565x4(_mm_loadu_si128((const __m128i *)(src + i)));
+        __m128i hi = fb_565x4(_mm_loadu_si128((const __m128i *)(src + i + 4)));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_add_epi16(_mm_packs_epi32(lo, hi), bias));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 8 <= n; i += 8) {
+        uint8x8x4_t px = vld4_u8((const uint8_t *)(src + i)); /* B, G, R, X planes */
+        uint16x8_t out = vshll_n_u8(px.val[2], 8);
+        out = vsriq_n_u16(out, vshll_n_u8(px.val[1], 8), 5);
+        out = vsriq_n_u16(out, vshll_n_u8(px.val[0], 8), 11);
+        vst1q_u16(dst + i, out);
+    }
+#endif
+    for (; i < n; ++i) {
+        uint32_t p = src[i];
+        dst[i] = (uint16_t)(((p >> 8) & 0xF800u) | ((p >> 5) & 0x07E0u) | ((p >> 3) & 0x001Fu));
+    }
+}
+#endif /* LV_COLOR_DEPTH == 32 */
+
+#if LV_COLOR_DEPTH == 16 && !LV_COLOR_16_SWAP
+/* RGB565 -> XRGB8888, low bits replicated so white stays 0xFFFFFF */
+static void fb_row_8888(uint32_t *dst, const uint16_t *src, uint32_t n)
+{
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t p = src[i];
+        uint32_t r = (p >> 11) & 0x1Fu, g = (p >> 5) & 0x3Fu, b = p & 0x1Fu;
+        dst[i] = 0xFF000000u | ((r << 3 | r >> 2) << 16) | ((g << 2 | g >> 4) << 8) | (b << 3 | b >> 2);
+    }
+}
+#endif
+
+/* Any truecolor layout with channels of at most 8 bits, little-endian */
+static void fb_row_generic(uint8_t *dst, const lv_color_t *src, uint32_t n)
+{
+    const struct fb_var_screeninfo *v = &g_fb.vinfo;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t c = lv_color_to32(src[i]);
+        uint32_t p = ((((c >> 16) & 0xFFu) >> (8 - v->red.length)) << v->red.offset) |
+                     ((((c >> 8) & 0xFFu) >> (8 - v->green.length)) << v->green.offset) |
+                     (((c & 0xFFu) >> (8 - v->blue.length)) << v->blue.offset);
+        for (uint32_t b = 0; b < g_fb.bytes_pp; ++b) *dst++ = (uint8_t)(p >> (8 * b));
+    }
+}
+
+/* ===== Backend ===== */
+
+void fb_blit_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    if (!g_fb.mem) {
+        lv_disp_flush_ready(drv);
+        return;
+    }
+    /* Clip to the visible screen; the source stride stays the area width */
+    int32_t x1 = area->x1 < 0 ? 0 : area->x1;
+    int32_t y1 = area->y1 < 0 ? 0 : area->y1;
+    int32_t x2 = area->x2 >= (int32_t)g_fb.vinfo.xres ? (int32_t)g_fb.vinfo.xres - 1 : area->x2;
+    int32_t y2 = area->y2 >= (int32_t)g_fb.vinfo.yres ? (int32_t)g_fb.vinfo.yres - 1 : area->y2;
+    if (x1 > x2 || y1 > y2) {
+        lv_disp_flush_ready(drv);
+        return;
+    }
+
+    uint32_t src_w = (uint32_t)(area->x2 - area->x1 + 1);
+    uint32_t n = (uint32_t)(x2 - x1 + 1), rows = (uint32_t)(y2 - y1 + 1);
+    const lv_color_t *src = color_p + (size_t)(y1 - area->y1) * src_w + (size_t)(x1 - area->x1);
+    uint8_t *dst = g_fb.mem + (size_t)((uint32_t)y1 + g_fb.vinfo.yoffset) * g_fb.line_length +
+                   (size_t)((uint32_t)x1 + g_fb.vinfo.xoffset) * g_fb.bytes_pp;
+    size_t row_bytes = (size_t)n * g_fb.bytes_pp;
+
+    if (g_fb.format == FB_BLIT_NATIVE && src_w == n && row_bytes == g_fb.line_length) {
+        memcpy(dst, src, row_bytes * rows);
+    } else {
+        for (uint32_t y = 0; y < rows; ++y, src += src_w, dst += g_fb.line_length) {
+            switch (g_fb.format) {
+            case FB_BLIT_NATIVE:
+                memcpy(dst, src, row_bytes);
+                break;
+#if LV_COLOR_DEPTH == 32
+            case FB_BLIT_565:
+                fb_row_565((uint16_t *)(void *)dst, (const uint32_t *)(const void *)src, n);
+                break;
+#endif
+#if LV_COLOR_DEPTH == 16 && !LV_COLOR_16_SWAP
+            case FB_BLIT_8888:
+                fb_row_8888((uint32_t *)(void *)dst, (const uint16_t *)(const void *)src, n);
+                break;
+#endif
+            default:
+                fb_row_generic(dst, src, n);
+                break;
+            }
+        }
+    }
+    perf_count_add(PERF_CNT_FB_BYTES, row_bytes * rows);
+    lv_disp_flush_ready(drv);
+}
+
+static void fb_blit_close(void)
+{
+    if (g_fb.mem) munmap(g_fb.mem, g_fb.mem_len);
+    if (g_fb.fd >= 0) close(g_fb.fd);
+    g_fb.mem = NULL;
+    g_fb.fd = -1;
+}
+
+int fb_blit_init(const char *fb_path)
+{
+    struct fb_fix_screeninfo finfo;
+    g_fb.fd = open(fb_path, O_RDWR | O_CLOEXEC);
+    if (g_fb.fd < 0) return -1;
+    if (ioctl(g_fb.fd, FBIOGET_VSCREENINFO, &g_fb.vinfo) != 0 ||
+        ioctl(g_fb.fd, FBIOGET_FSCREENINFO, &finfo) != 0) {
+        int err = errno;
+        fb_blit_close();
+        errno = err;
+        return -1;
+    }
+
+    g_fb.format = fb_blit_classify(&g_fb.vinfo);
+    if (finfo.type != FB_TYPE_PACKED_PIXELS ||
+        (finfo.visual != FB_VISUAL_TRUECOLOR && finfo.visual != FB_VISUAL_DIRECTCOLOR)) {
+        g_fb.format = FB_BLIT_UNSUPPORTED;
+    }
+    if (g_fb.format == FB_BLIT_UNSUPPORTED) {
+        fprintf(stderr, "Display: %s is %u bpp (type %u, visual %u); no blit for it\n",
+                fb_path, g_fb.vinfo.bits_per_pixel, finfo.type, finfo.visual);
+        fb_blit_close();
+        errno = ENOTSUP;
+        return -1;
+    }
+
+    g_fb.bytes_pp = (g_fb.vinfo.bits_per_pixel + 7) / 8;
+    g_fb.line_length = finfo.line_length;
+    g_fb.mem_len = finfo.smem_len;
+    g_fb.mem = (uint8_t *)mmap(NULL, g_fb.mem_len, PROT_READ | PROT_WRITE, MAP_SHARED, g_fb.fd, 0);
+    if (g_fb.mem == MAP_FAILED) {
+        int err = errno;
+        g_fb.mem = NULL;
+        fb_blit_close();
+        errno = err;
+        return -1;
+    }
+
+    fprintf(stderr, "Display: %s %ux%u, %u bpp (r%u:%u g%u:%u b%u:%u), LV_COLOR_DEPTH %d: %s blit\n",
+            fb_path, g_fb.vinfo.xres, g_fb.vinfo.yres, g_fb.vinfo.bits_per_pixel,
+            g_fb.vinfo.red.offset, g_fb.vinfo.red.length, g_fb.vinfo.green.offset, g_fb.vinfo.green.length,
+            g_fb.vinfo.blue.offset, g_fb.vinfo.blue.length, LV_COLOR_DEPTH, g_format_names[g_fb.format]);
+    if (g_fb.format == FB_BLIT_565) {
+        fprintf(stderr, "Display: build with make COLOR_DEPTH=16 to render in the panel's format\n");
+    }
+    return 0;
+}
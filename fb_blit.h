@@ -0,0 +1,58 @@
+#ifndef FB_BLIT_H
+#define FB_BLIT_H
+
+/*
+ * Linux framebuffer output: pixel format detection and blit.
+ *
+ * fb_blit_init() maps the framebuffer and compares its format (bits per
+ * pixel, channel offsets and lengths) with LVGL's lv_color_t; fb_blit_flush()
+ * is the disp_pipeline backend that writes flushed areas into it:
+ *   native   the framebuffer has lv_color_t's layout (XRGB8888 with
+ *            LV_COLOR_DEPTH 32, RGB565 with LV_COLOR_DEPTH 16): rows are
+ *            memcpy'ed, one memcpy per area when it spans the full stride
+ *   565      LV_COLOR_DEPTH 32 on an RGB565 panel: 8888 -> 565 packing, SSE2
+ *            on x86-64 and NEON on ARM, 8 pixels per step
+ *   8888     LV_COLOR_DEPTH 16 (no swap) on an XRGB8888 framebuffer
+ *   generic  anything else with 16, 24 or 32 bpp truecolor (BGR orders,
+ *            swapped RGB565 on a 32 bpp screen, ...): per pixel from the
+ *            framebuffer's channel offsets
+ * Rendering at the framebuffer's own format (make COLOR_DEPTH=16 for RGB565
+ * panels) halves the draw buffers and bytes per flush and makes every flush a
+ * copy; the conversions only cover builds that do not match their screen.
+ *
+ * LV_COLOR_16_SWAP (make COLOR_16_SWAP=1) renders RGB565 byte-swapped, the
+ * order SPI panels take on the wire. It counts as native on a 16 bpp
+ * framebuffer whose driver sends the memory to the panel as is; on a 32 bpp
+ * framebuffer the generic path swaps back.
+ */
+
+#include <linux/fb.h>
+#include "lvgl/lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    FB_BLIT_NATIVE = 0,
+    FB_BLIT_565,
+    FB_BLIT_8888,
+    FB_BLIT_GENERIC,
+    FB_BLIT_UNSUPPORTED,
+} fb_blit_format_t;
+
+/* How lv_color_t pixels have to be written to a framebuffer of vinfo's format. */
+fb_blit_format_t fb_blit_classify(const struct fb_var_screeninfo *vinfo);
+
+/* Open and map fb_path and pick the blit for its format. Returns 0, or -1
+ * with errno set (ENOTSUP: not a 16/24/32 bpp truecolor framebuffer). */
+int fb_blit_init(const char *fb_path);
+
+/* disp_pipeline backend flush (any thread); calls lv_disp_flush_ready(). */
+void fb_blit_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FB_BLIT_H */
@@ -0,0 +1,413 @@
+#include "headless.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "perf_stats.h"
+
+/* QOI worst case: 4 bytes per RGB pixel + header and end marker */
+#define QOI_HEADER_SIZE 14
+#define QOI_END_SIZE    8
+#define QOI_MAX_SIZE(w, h) ((size_t)(w) * (size_t)(h) * 4u + QOI_HEADER_SIZE + QOI_END_SIZE)
+
+typedef struct {
+    int      fd;           /* -1: free slot */
+    int      subscribed;
+    uint32_t last_gen;     /* framebuffer generation this client has seen */
+} headless_client_t;
+
+typedef struct {
+    pthread_mutex_t   lock;         /* fb, tile_gen, gen */
+    lv_color_t       *fb;
+    lv_coord_t        w, h;
+    uint32_t         *tile_gen;     /* generation of the last flush touching each tile */
+    unsigned          tiles_x, tiles_y;
+    uint32_t          gen;
+    /* Service thread only */
+    lv_color_t       *shadow;       /* dirty tiles copied out of fb for encoding */
+    uint32_t         *dirty;        /* tile indices of the update being built */
+    uint8_t          *out;
+    size_t            out_cap;
+    int               listen_fd;
+    unsigned          interval_ms;
+    headless_client_t clients[HEADLESS_CLIENTS_MAX];
+} headless_t;
+
+static headless_t g_hl = { .lock = PTHREAD_MUTEX_INITIALIZER, .listen_fd = -1 };
+
+/* ===== Framebuffer ===== */
+
+int headless_init(lv_coord_t hor_res, lv_coord_t ver_res)
+{
+    if (hor_res <= 0 || ver_res <= 0) { errno = EINVAL; return -1; }
+    size_t px = (size_t)hor_res * (size_t)ver_res;
+    g_hl.w = hor_res;
+    g_hl.h = ver_res;
+    g_hl.tiles_x = ((unsigned)hor_res + HEADLESS_TILE - 1) / HEADLESS_TILE;
+    g_hl.tiles_y = ((unsigned)ver_res + HEADLESS_TILE - 1) / HEADLESS_TILE;
+    size_t tiles = (size_t)g_hl.tiles_x * g_hl.tiles_y;
+    g_hl.out_cap = HEADLESS_HEADER_SIZE + tiles * (HEADLESS_TILE_HEADER + QOI_MAX_SIZE(HEADLESS_TILE, HEADLESS_TILE));
+
+    g_hl.fb = calloc(px, sizeof(lv_color_t));
+    g_hl.shadow = calloc(px, sizeof(lv_color_t));
+    g_hl.tile_gen = malloc(tiles * sizeof(uint32_t));
+    g_hl.dirty = malloc(tiles * sizeof(uint32_t));
+    g_hl.out = malloc(g_hl.out_cap);
+    if (!g_hl.fb || !g_hl.shadow || !g_hl.tile_gen || !g_hl.dirty || !g_hl.out) {
+        free(g_hl.fb); free(g_hl.shadow); free(g_hl.tile_gen); free(g_hl.dirty); free(g_hl.out);
+        g_hl.fb = g_hl.shadow = NULL;
+        g_hl.tile_gen = g_hl.dirty = NULL;
+        g_hl.out = NULL;
+        errno = ENOMEM;
+        return -1;
+    }
+    /* Every tile starts at generation 1, so a new client's first update is a full frame */
+    g_hl.gen = 1;
+    for (size_t i = 0; i < tiles; ++i) g_hl.tile_gen[i] = 1;
+    for (int i = 0; i < HEADLESS_CLIENTS_MAX; ++i) g_hl.clients[i].fd = -1;
+    return 0;
+}
+
+void headless_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p)
+{
+    lv_coord_t w = (lv_coord_t)(area->x2 - area->x1 + 1);
+    if (g_hl.fb && area->x1 >= 0 && area->y1 >= 0 && area->x2 < g_hl.w && area->y2 < g_hl.h) {
+        pthread_mutex_lock(&g_hl.lock);
+        uint32_t gen = ++g_hl.gen;
+        for (lv_coord_t y = area->y1; y <= area->y2; ++y) {
+            memcpy(&g_hl.fb[(size_t)y * (size_t)g_hl.w + (size_t)area->x1],
+                   color_p + (size_t)(y - area->y1) * (size_t)w, (size_t)w * sizeof(lv_color_t));
+        }
+        for (unsigned ty = (unsigned)area->y1 / HEADLESS_TILE; ty <= (unsigned)area->y2 / HEADLESS_TILE; ++ty) {
+            for (unsigned tx = (unsigned)area->x1 / HEADLESS_TILE; tx <= (unsigned)area->x2 / HEADLESS_TILE; ++tx) {
+                g_hl.tile_gen[ty * g_hl.tiles_x + tx] = gen;
+            }
+        }
+        pthread_mutex_unlock(&g_hl.lock);
+    }
+    lv_disp_flush_ready(drv);
+}
+
+/* ===== QOI encoder (RGB, one tile of the shadow buffer) ===== */
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF  0x40
+#define QOI_OP_LUMA  0x80
+#define QOI_OP_RUN   0xC0
+#define QOI_OP_RGB   0xFE
+
+static uint8_t *put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24); p[1] = (uint8_t)(v >> 16); p[2] = (uint8_t)(v >> 8); p[3] = (uint8_t)v;
+    return p + 4;
+}
+
+static size_t qoi_encode_tile(const lv_color_t *img, size_t stride, unsigned w, unsigned h, uint8_t *out)
+{
+    uint8_t *p = out;
+    memcpy(p, "qoif", 4);
+    p = put_be32(p + 4, w);
+    p = put_be32(p, h);
+    *p++ = 3;   /* RGB */
+    *p++ = 0;   /* sRGB with linear alpha */
+
+    uint32_t index[64];
+    memset(index, 0, sizeof(index));
+    uint32_t prev = 0xFF000000u;    /* a=255, r=g=b=0 as 0xAARRGGBB */
+    unsigned run = 0;
+    for (unsigned y = 0; y < h; ++y) {
+        const lv_color_t *row = img + (size_t)y * stride;
+        for (unsigned x = 0; x < w; ++x) {
+            uint32_t px = lv_color_to32(row[x]) | 0xFF000000u;
+            if (px == prev) {
+                if (++run == 62) { *p++ = (uint8_t)(QOI_OP_RUN | (run - 1)); run = 0; }
+                continue;
+            }
+            if (run) { *p++ = (uint8_t)(QOI_OP_RUN | (run - 1)); run = 0; }
+
+            uint8_t r = (uint8_t)(px >> 16), g = (uint8_t)(px >> 8), b = (uint8_t)px;
+            unsigned slot = (r * 3u + g * 5u + b * 7u + 255u * 11u) % 64u;
+            if (index[slot] == px) {
+                *p++ = (uint8_t)(QOI_OP_INDEX | slot);
+            } else {
+                index[slot] = px;
+                int8_t vr = (int8_t)(r - (uint8_t)(prev >> 16));
+                int8_t vg = (int8_t)(g - (uint8_t)(prev >> 8));
+                int8_t vb = (int8_t)(b - (uint8_t)prev);
+                int8_t vg_r = (int8_t)(vr - vg), vg_b = (int8_t)(vb - vg);
+                if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                    *p++ = (uint8_t)(QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+                } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                    *p++ = (uint8_t)(QOI_OP_LUMA | (vg + 32));
+                    *p++ = (uint8_t)((vg_r + 8) << 4 | (vg_b + 8));
+                } else {
+                    *p++ = QOI_OP_RGB;
+                    *p++ = r; *p++ = g; *p++ = b;
+                }
+            }
+            prev = px;
+        }
+    }
+    if (run) *p++ = (uint8_t)(QOI_OP_RUN | (run - 1));
+    static const uint8_t end[QOI_END_SIZE] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    memcpy(p, end, sizeof(end));
+    return (size_t)(p + sizeof(end) - out);
+}
+
+/* ===== Service ===== */
+
+static uint8_t *put_le16(uint8_t *p, uint32_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); return p + 2; }
+static uint8_t *put_le32(uint8_t *p, uint32_t v) { p = put_le16(p, v & 0xFFFFu); return put_le16(p, v >> 16); }
+
+static uint64_t headless_now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static int send_all(int fd, const uint8_t *buf, size_t len)
+{
+    while (len) {
+        ssize_t n = send(fd, buf, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/* Copy the tiles newer than the client's generation out of the framebuffer
+ * under the lock, then encode and send them without it. A push with nothing
+ * changed sends nothing; an explicit request always gets a frame. */
+static int headless_send_update(headless_client_t *c, int keyframe, int push)
+{
+    uint32_t since = keyframe ? 0 : c->last_gen;
+    unsigned n = 0, tiles = g_hl.tiles_x * g_hl.tiles_y;
+
+    pthread_mutex_lock(&g_hl.lock);
+    uint32_t gen = g_hl.gen;
+    for (unsigned i = 0; i < tiles; ++i) {
+        if (g_hl.tile_gen[i] <= since) continue;
+        unsigned x = (i % g_hl.tiles_x) * HEADLESS_TILE, y = (i / g_hl.tiles_x) * HEADLESS_TILE;
+        unsigned w = (unsigned)g_hl.w - x < HEADLESS_TILE ? (unsigned)g_hl.w - x : HEADLESS_TILE;
+        unsigned h = (unsigned)g_hl.h - y < HEADLESS_TILE ? (unsigned)g_hl.h - y : HEADLESS_TILE;
+        for (unsigned r = 0; r < h; ++r) {
+            size_t off = (size_t)(y + r) * (size_t)g_hl.w + x;
+            memcpy(&g_hl.shadow[off], &g_hl.fb[off], w * sizeof(lv_color_t));
+        }
+        g_hl.dirty[n++] = i;
+    }
+    pthread_mutex_unlock(&g_hl.lock);
+    if (push && n == 0) return 0;
+
+    uint8_t *p = g_hl.out + HEADLESS_HEADER_SIZE;
+    for (unsigned k = 0; k < n; ++k) {
+        unsigned i = g_hl.dirty[k];
+        unsigned x = (i % g_hl.tiles_x) * HEADLESS_TILE, y = (i / g_hl.tiles_x) * HEADLESS_TILE;
+        unsigned w = (unsigned)g_hl.w - x < HEADLESS_TILE ? (unsigned)g_hl.w - x : HEADLESS_TILE;
+        unsigned h = (unsigned)g_hl.h - y < HEADLESS_TILE ? (unsigned)g_hl.h - y : HEADLESS_TILE;
+        size_t len = qoi_encode_tile(&g_hl.shadow[(size_t)y * (size_t)g_hl.w + x], (size_t)g_hl.w, w, h,
+                                     p + HEADLESS_TILE_HEADER);
+        p = put_le16(p, x);
+        p = put_le16(p, y);
+        p = put_le16(p, w);
+        p = put_le16(p, h);
+        p = put_le32(p, (uint32_t)len);
+        p += len;
+    }
+    size_t total = (size_t)(p - g_hl.out);
+
+    uint8_t *hdr = put_le32(g_hl.out, HEADLESS_MAGIC);
+    hdr = put_le16(hdr, HEADLESS_VERSION);
+    hdr = put_le16(hdr, (uint32_t)g_hl.w);
+    hdr = put_le16(hdr, (uint32_t)g_hl.h);
+    hdr = put_le16(hdr, n);
+    hdr = put_le32(hdr, gen);
+    put_le32(hdr, (uint32_t)(total - HEADLESS_HEADER_SIZE));
+
+    if (send_all(c->fd, g_hl.out, total) != 0) return -1;
+    c->last_gen = gen;
+    perf_count_add(PERF_CNT_HEADLESS_TILES, n);
+    perf_count_add(PERF_CNT_HEADLESS_BYTES, total);
+    return 0;
+}
+
+static void headless_drop(headless_client_t *c)
+{
+    close(c->fd);
+    c->fd = -1;
+}
+
+static void headless_accept(void)
+{
+    int fd = accept4(g_hl.listen_fd, NULL, NULL, SOCK_CLOEXEC);
+    if (fd < 0) return;
+    for (int i = 0; i < HEADLESS_CLIENTS_MAX; ++i) {
+        headless_client_t *c = &g_hl.clients[i];
+        if (c->fd >= 0) continue;
+        /* A viewer that stops reading must not stall the other clients for long */
+        struct timeval tv = { 2, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        c->fd = fd;
+        c->subscribed = 0;
+        c->last_gen = 0;
+        return;
+    }
+    close(fd); /* full */
+}
+
+static void headless_client_input(headless_client_t *c)
+{
+    uint8_t cmd[16];
+    ssize_t n = recv(c->fd, cmd, sizeof(cmd), MSG_DONTWAIT);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        headless_drop(c);
+        return;
+    }
+    for (ssize_t i = 0; i < n && c->fd >= 0; ++i) {
+        int rc = 0;
+        switch (cmd[i]) {
+        case 'u': rc = headless_send_update(c, 0, 0); break;
+        case 'k': rc = headless_send_update(c, 1, 0); break;
+        case 's': c->subscribed = 1; break;
+        case 'p': c->subscribed = 0; break;
+        default: break;
+        }
+        if (rc != 0) headless_drop(c);
+    }
+}
+
+static void *headless_thread(void *arg)
+{
+    (void)arg;
+    struct pollfd pfds[1 + HEADLESS_CLIENTS_MAX];
+    headless_client_t *owner[1 + HEADLESS_CLIENTS_MAX];
+    uint64_t next_push = headless_now_ms() + g_hl.interval_ms;
+    for (;;) {
+        nfds_t n = 0;
+        int subscribers = 0;
+        pfds[n].fd = g_hl.listen_fd;
+        pfds[n].events = POLLIN;
+        owner[n++] = NULL;
+        for (int i = 0; i < HEADLESS_CLIENTS_MAX; ++i) {
+            if (g_hl.clients[i].fd < 0) continue;
+            subscribers += g_hl.clients[i].subscribed;
+            pfds[n].fd = g_hl.clients[i].fd;
+            pfds[n].events = POLLIN;
+            owner[n++] = &g_hl.clients[i];
+        }
+        uint64_t now = headless_now_ms();
+        int timeout = -1;
+        if (subscribers) timeout = next_push > now ? (int)(next_push - now) : 0;
+
+        if (poll(pfds, n, timeout) < 0 && errno != EINTR) return NULL;
+        for (nfds_t i = 0; i < n; ++i) {
+            if (!pfds[i].revents) continue;
+            if (!owner[i]) headless_accept();
+            else if (owner[i]->fd >= 0) headless_client_input(owner[i]);
+        }
+
+        now = headless_now_ms();
+        if (now >= next_push) {
+            for (int i = 0; i < HEADLESS_CLIENTS_MAX; ++i) {
+                headless_client_t *c = &g_hl.clients[i];
+                if (c->fd >= 0 && c->subscribed && headless_send_update(c, 0, 1) != 0) headless_drop(c);
+            }
+            next_push += g_hl.interval_ms;
+            if (next_push <= now) next_push = now + g_hl.interval_ms; /* slept through: no catch-up burst */
+        }
+    }
+    return NULL;
+}
+
+static int headless_listen_unix(const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (!path[0] || strlen(path) >= sizeof(addr.sun_path)) { errno = ENAMETOOLONG; return -1; }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    unlink(path); /* stale socket from a previous run */
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+static int headless_listen_tcp(const char *spec)
+{
+    char host[64] = "", port[16];
+    const char *colon = strrchr(spec, ':');
+    const char *p = colon ? colon + 1 : spec;
+    if (!p[0] || strlen(p) >= sizeof(port)) { errno = EINVAL; return -1; }
+    strcpy(port, p);
+    if (colon) {
+        size_t hlen = (size_t)(colon - spec);
+        if (spec[0] == '[' && hlen >= 2 && spec[hlen - 1] == ']') { spec++; hlen -= 2; }
+        if (hlen >= sizeof(host)) { errno = EINVAL; return -1; }
+        memcpy(host, spec, hlen);
+        host[hlen] = '\0';
+    }
+
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    if (getaddrinfo(host[0] ? host : NULL, port, &hints, &res) != 0 || !res) { errno = EADDRNOTAVAIL; return -1; }
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) continue;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, ai->ai_addr, ai->ai_addrlen) != 0 || listen(fd, 4) != 0) {
+            int saved = errno;
+            close(fd);
+            errno = saved;
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+int headless_start(const char *listen_spec, unsigned interval_ms)
+{
+    if (!g_hl.fb || !listen_spec) { errno = EINVAL; return -1; }
+    if (strncmp(listen_spec, "unix:", 5) == 0) g_hl.listen_fd = headless_listen_unix(listen_spec + 5);
+    else if (strncmp(listen_spec, "tcp:", 4) == 0) g_hl.listen_fd = headless_listen_tcp(listen_spec + 4);
+    else { errno = EINVAL; return -1; }
+    if (g_hl.listen_fd < 0) return -1;
+    g_hl.interval_ms = interval_ms ? interval_ms : HEADLESS_INTERVAL_MS;
+
+    pthread_t tid;
+    int rc = pthread_create(&tid, NULL, headless_thread, NULL);
+    if (rc != 0) {
+        close(g_hl.listen_fd);
+        g_hl.listen_fd = -1;
+        errno = rc;
+        return -1;
+    }
+    pthread_detach(tid);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+/*
+ * Headless display backend: LVGL renders into a memory framebuffer whose
+ * changed regions are served as QOI-compressed tiles over a socket.
+ *
+ * Selected at run time (--headless=<listen>), no display or input device is
+ * needed, e.g. to measure rendering cost in CI or to feed a remote monitoring
+ * portal. The flush callback copies each area into the framebuffer and stamps
+ * the HEADLESS_TILE x HEADLESS_TILE tiles it covers with a new generation;
+ * LVGL only flushes what it invalidated, so this is the dirty-rectangle set.
+ * Each client remembers the generation it has seen and is sent only the tiles
+ * that changed since, so bandwidth follows on-screen change, not screen area.
+ * Encoding runs on the service thread from a private copy of the dirty tiles;
+ * the flush path only holds a mutex for its memcpy.
+ *
+ * Protocol: a client sends single-byte commands
+ *   'u'  update: tiles changed since this client's previous update (the
+ *        first update of a connection is a full frame)
+ *   'k'  keyframe: every tile
+ *   's'  subscribe: push an update every interval_ms while tiles changed
+ *   'p'  pause a subscription
+ * and receives frames (little-endian, v1):
+ *   frame header, 20 bytes
+ *     u32 magic    "WXS1"
+ *     u16 version  1
+ *     u16 width    screen size in pixels
+ *     u16 height
+ *     u16 count    tiles that follow (0: nothing changed)
+ *     u32 seq      generation of the framebuffer the tiles were taken from
+ *     u32 bytes    payload size after the header
+ *   tile, 12 bytes + image
+ *     u16 x, y     top-left pixel
+ *     u16 w, h     size (edge tiles are smaller)
+ *     u32 len      QOI image size
+ *     u8  qoi[len] a complete QOI image (RGB, https://qoiformat.org)
+ */
+
+#include <stdint.h>
+#include "lvgl/lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HEADLESS_MAGIC        0x31535857u /* "WXS1" */
+#define HEADLESS_VERSION      1u
+#define HEADLESS_HEADER_SIZE  20
+#define HEADLESS_TILE_HEADER  12
+
+#ifndef HEADLESS_TILE
+#define HEADLESS_TILE 32              /* tile edge in pixels */
+#endif
+#ifndef HEADLESS_CLIENTS_MAX
+#define HEADLESS_CLIENTS_MAX 4
+#endif
+#ifndef HEADLESS_INTERVAL_MS
+#define HEADLESS_INTERVAL_MS 1000     /* push cadence for subscribed clients */
+#endif
+
+/* Allocate the framebuffer and tile map for a hor_res x ver_res screen.
+ * Returns 0, or -1 with errno set. */
+int headless_init(lv_coord_t hor_res, lv_coord_t ver_res);
+
+/* disp_pipeline backend flush (any thread). */
+void headless_flush(lv_disp_drv_t *drv, const lv_area_t *area, lv_color_t *color_p);
+
+/* Serve the framebuffer on listen:
+ *   unix:<path>              Unix stream socket (a stale socket file is replaced)
+ *   tcp:[<host>:]<port>      TCP, all interfaces without host
+ * interval_ms is the push cadence of subscribed clients (0: HEADLESS_INTERVAL_MS).
+ * Returns 0, or -1 with errno set. */
+int headless_start(const char *listen, unsigned interval_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HEADLESS_H */
@@ -0,0 +1,136 @@
+#include "history.h"
+
+#include <math.h>
+#include <string.h>
+
+static void ring_bind(history_ring_t *r, uint32_t width_s, uint32_t len,
+                      uint32_t *seq, uint32_t *start_s, uint16_t *count,
+                      float *min, float *max, float *sum)
+{
+    r->width_s = width_s;
+    r->len = len;
+    r->closed = 0;
+    r->open_start = 0;
+    r->seq = seq;
+    r->start_s = start_s;
+    for (int c = 0; c < HISTORY_CH_COUNT; ++c) {
+        r->count[c] = count + (size_t)c * len;
+        r->min[c] = min + (size_t)c * len;
+        r->max[c] = max + (size_t)c * len;
+        r->sum[c] = sum + (size_t)c * len;
+    }
+}
+
+#define HISTORY_BIND(h, t, s, w, n) \
+    ring_bind(&(h)->tier[t], (w), (n), (h)->s.seq, (h)->s.start_s, &(h)->s.count[0][0], \
+              &(h)->s.min[0][0], &(h)->s.max[0][0], &(h)->s.sum[0][0])
+
+void history_init(history_t *h)
+{
+    memset(h, 0, sizeof(*h));
+    HISTORY_BIND(h, HISTORY_TIER_1MIN,  s1min,  60,   HISTORY_1MIN_LEN);
+    HISTORY_BIND(h, HISTORY_TIER_15MIN, s15min, 900,  HISTORY_15MIN_LEN);
+    HISTORY_BIND(h, HISTORY_TIER_1H,    s1h,    3600, HISTORY_1H_LEN);
+}
+
+/* Start an empty bucket in the slot after the last closed one. The odd seq
+ * store is fenced ahead of the slot's new contents (and of the last close), so
+ * a reader that sees any of them also sees the slot being rewritten. */
+static void ring_open(history_ring_t *r, uint32_t start_s)
+{
+    uint32_t slot = r->closed % r->len;
+    __atomic_store_n(&r->seq[slot], r->seq[slot] + 1u, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    r->start_s[slot] = start_s;
+    for (int c = 0; c < HISTORY_CH_COUNT; ++c) {
+        r->count[c][slot] = 0;
+        r->min[c][slot] = NAN;
+        r->max[c][slot] = NAN;
+        r->sum[c][slot] = 0.0f;
+    }
+    r->open_start = start_s;
+}
+
+/* Publish the open bucket: its contents are complete before the release stores */
+static void ring_close(history_ring_t *r)
+{
+    uint32_t slot = r->closed % r->len;
+    __atomic_store_n(&r->seq[slot], r->seq[slot] + 1u, __ATOMIC_RELEASE);
+    __atomic_store_n(&r->closed, r->closed + 1, __ATOMIC_RELEASE);
+}
+
+static void ring_insert(history_ring_t *r, uint32_t t_s, const float v[HISTORY_CH_COUNT])
+{
+    uint32_t start = t_s - t_s % r->width_s;
+    if (r->open_start == 0) {
+        ring_open(r, start);
+    } else if (start > r->open_start) {
+        // Close the current bucket, emit empty buckets for any gap, open the new one
+        uint32_t gaps = (start - r->open_start) / r->width_s - 1;
+        if (gaps > r->len) gaps = r->len;
+        ring_close(r);
+        for (uint32_t i = gaps; i > 0; --i) {
+            ring_open(r, start - i * r->width_s);
+            ring_close(r);
+        }
+        ring_open(r, start);
+    }
+    // Samples older than the open bucket (clock stepped back) are folded into it
+
+    uint32_t slot = r->closed % r->len;
+    for (int c = 0; c < HISTORY_CH_COUNT; ++c) {
+        float x = v[c];
+        if (isnan(x)) continue;
+        if (isnan(r->min[c][slot]) || x < r->min[c][slot]) r->min[c][slot] = x;
+        if (isnan(r->max[c][slot]) || x > r->max[c][slot]) r->max[c][slot] = x;
+        if (r->count[c][slot] < UINT16_MAX) {
+            r->sum[c][slot] += x;
+            r->count[c][slot]++;
+        }
+    }
+}
+
+void history_insert(history_t *h, uint32_t t_s, const float v[HISTORY_CH_COUNT])
+{
+    for (int t = 0; t < HISTORY_TIER_COUNT; ++t) ring_insert(&h->tier[t], t_s, v);
+}
+
+uint32_t history_tier_width_s(const history_t *h, history_tier_t tier)
+{
+    return h->tier[tier].width_s;
+}
+
+uint32_t history_tier_len(const history_t *h, history_tier_t tier)
+{
+    return h->tier[tier].len;
+}
+
+uint32_t history_closed(const history_t *h, history_tier_t tier)
+{
+    return __atomic_load_n(&h->tier[tier].closed, __ATOMIC_ACQUIRE);
+}
+
+int history_get_bucket(const history_t *h, history_tier_t tier, uint32_t index,
+                       history_channel_t ch, history_bucket_t *out)
+{
+    const history_ring_t *r = &h->tier[tier];
+    uint32_t closed = history_closed(h, tier);
+    if (index >= closed || closed - index >= r->len) return -1;
+
+    uint32_t slot = index % r->len;
+    uint32_t seq = __atomic_load_n(&r->seq[slot], __ATOMIC_ACQUIRE);
+    if (seq & 1u) return -1; /* already reopened for a newer bucket */
+    history_bucket_t b;
+    b.start_s = r->start_s[slot];
+    b.count = r->count[ch][slot];
+    b.min = r->min[ch][slot];
+    b.max = r->max[ch][slot];
+    b.mean = b.count ? r->sum[ch][slot] / (float)b.count : NAN;
+
+    // The slot is reused once closed - index reaches len; recheck after copying
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&r->seq[slot], __ATOMIC_RELAXED) != seq) return -1;
+    if (history_closed(h, tier) - index >= r->len) return -1;
+    *out = b;
+    return 0;
+}
@@ -0,0 +1,114 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+/*
+ * Fixed-memory sensor history with multi-resolution aggregates.
+ *
+ * Every sample is folded into three downsampled tiers (1 min, 15 min, 1 h).
+ * Each tier is a ring of buckets holding min/max/sum/count per channel
+ * (a channel that is NaN in some samples, e.g. skipped humidity, averages
+ * only the samples that have it), stored as struct-of-arrays so that a chart reading one channel of one
+ * tier walks contiguous memory. Inserting is O(1) per tier (the open bucket
+ * is updated in place); nothing is ever recomputed from raw samples.
+ *
+ * Threading: one writer (history_insert) and any number of readers. A
+ * bucket is immutable once closed; readers observe the closed count with
+ * acquire ordering. Each slot also has a sequence count (a seqlock: odd while
+ * the writer is reusing the slot), and history_get_bucket() rejects buckets
+ * that were recycled while being copied, so no lock is needed.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    HISTORY_CH_TEMPERATURE = 0,  /* Celsius */
+    HISTORY_CH_PRESSURE,         /* hPa */
+    HISTORY_CH_HUMIDITY,         /* %RH */
+    HISTORY_CH_COUNT
+} history_channel_t;
+
+typedef enum {
+    HISTORY_TIER_1MIN = 0,
+    HISTORY_TIER_15MIN,
+    HISTORY_TIER_1H,
+    HISTORY_TIER_COUNT
+} history_tier_t;
+
+/* Buckets kept per tier: 24 h of 1 min, 7 d of 15 min, 30 d of 1 h */
+#ifndef HISTORY_1MIN_LEN
+#define HISTORY_1MIN_LEN  1440
+#endif
+#ifndef HISTORY_15MIN_LEN
+#define HISTORY_15MIN_LEN 672
+#endif
+#ifndef HISTORY_1H_LEN
+#define HISTORY_1H_LEN    720
+#endif
+
+typedef struct {
+    uint32_t start_s;   /* bucket start, seconds since the epoch */
+    uint16_t count;     /* samples folded into this channel (0 = gap or channel NaN throughout) */
+    float min;
+    float max;
+    float mean;
+} history_bucket_t;
+
+typedef struct {
+    uint32_t width_s;
+    uint32_t len;
+    uint32_t closed;     /* buckets closed so far; shared with readers */
+    uint32_t open_start; /* start of the bucket being filled (writer only) */
+    uint32_t *seq;       /* per slot: odd while open, bumped again on close */
+    uint32_t *start_s;
+    uint16_t *count[HISTORY_CH_COUNT];
+    float *min[HISTORY_CH_COUNT];
+    float *max[HISTORY_CH_COUNT];
+    float *sum[HISTORY_CH_COUNT];
+} history_ring_t;
+
+#define HISTORY_TIER_STORAGE(n)                    \
+    struct {                                       \
+        uint32_t seq[n];                           \
+        uint32_t start_s[n];                       \
+        uint16_t count[HISTORY_CH_COUNT][n];       \
+        float min[HISTORY_CH_COUNT][n];            \
+        float max[HISTORY_CH_COUNT][n];            \
+        float sum[HISTORY_CH_COUNT][n];            \
+    }
+
+typedef struct {
+    history_ring_t tier[HISTORY_TIER_COUNT];
+    HISTORY_TIER_STORAGE(HISTORY_1MIN_LEN)  s1min;
+    HISTORY_TIER_STORAGE(HISTORY_15MIN_LEN) s15min;
+    HISTORY_TIER_STORAGE(HISTORY_1H_LEN)    s1h;
+} history_t;
+
+/* Reset all tiers; must run before the writer starts. */
+void history_init(history_t *h);
+
+/* Fold one sample taken at t_s (seconds since the epoch) into every tier.
+ * NaN channels are skipped. Writer thread only. */
+void history_insert(history_t *h, uint32_t t_s, const float v[HISTORY_CH_COUNT]);
+
+/* Width in seconds and ring length of a tier. */
+uint32_t history_tier_width_s(const history_t *h, history_tier_t tier);
+uint32_t history_tier_len(const history_t *h, history_tier_t tier);
+
+/* Number of buckets closed so far in a tier. Only closed buckets are
+ * readable; indices count up forever, the ring keeps the last len - 1. */
+uint32_t history_closed(const history_t *h, history_tier_t tier);
+
+/* Copy closed bucket `index` of one channel. Returns 0, or -1 if the index is
+ * not closed yet or its slot has been recycled. */
+int history_get_bucket(const history_t *h, history_tier_t tier, uint32_t index,
+                       history_channel_t ch, history_bucket_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HISTORY_H */
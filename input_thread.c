@@ -0,0 +1,235 @@
+#include "input_thread.h"
+#include "event_loop.h"
+#include "lv_drv_conf.h"
+#include "perf_stats.h"
+#include "thread_policy.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+
+#if (INPUT_QUEUE_LEN & (INPUT_QUEUE_LEN - 1)) != 0
+#error "INPUT_QUEUE_LEN must be a power of two"
+#endif
+
+typedef struct {
+    int16_t  x, y;
+    uint8_t  pressed;
+    uint64_t t_ns;      /* CLOCK_MONOTONIC of the event */
+} input_point_t;
+
+/* SPSC ring: head is written by the input thread only, tail by the render
+ * thread only; each publishes its index with release ordering */
+typedef struct {
+    input_point_t slot[INPUT_QUEUE_LEN];
+    uint32_t      head __attribute__((aligned(64)));
+    uint32_t      tail __attribute__((aligned(64)));
+} input_queue_t;
+
+static input_queue_t g_queue;
+static uint64_t g_latest;             /* newest state, packed (input_pack); overflow fallback */
+static int g_fd = -1;
+static int g_wake_fd = -1;
+static int g_kernel_clock = 0;        /* event times are CLOCK_MONOTONIC (EVIOCSCLOCKID) */
+static lv_coord_t g_hor_res, g_ver_res;
+
+/* Render thread only */
+static input_point_t g_last;
+static uint32_t g_last_active_ms = 0;
+static int g_watched = 0;
+
+static uint64_t input_pack(const input_point_t *p)
+{
+    return (uint64_t)(uint16_t)p->x | (uint64_t)(uint16_t)p->y << 16 | (uint64_t)p->pressed << 32;
+}
+
+static int input_queue_push(const input_point_t *p)
+{
+    uint32_t head = g_queue.head;
+    if (head - __atomic_load_n(&g_queue.tail, __ATOMIC_ACQUIRE) == INPUT_QUEUE_LEN) return -1;
+    g_queue.slot[head & (INPUT_QUEUE_LEN - 1)] = *p;
+    __atomic_store_n(&g_queue.head, head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/* Pop the oldest transition; *more is set while others follow it */
+static int input_queue_pop(input_point_t *p, int *more)
+{
+    uint32_t tail = g_queue.tail;
+    uint32_t head = __atomic_load_n(&g_queue.head, __ATOMIC_ACQUIRE);
+    if (tail == head) return -1;
+    *p = g_queue.slot[tail & (INPUT_QUEUE_LEN - 1)];
+    __atomic_store_n(&g_queue.tail, tail + 1, __ATOMIC_RELEASE);
+    *more = head != tail + 1;
+    return 0;
+}
+
+static lv_coord_t input_clamp(int v, lv_coord_t res)
+{
+    return (lv_coord_t)(v < 0 ? 0 : v >= res ? res - 1 : v);
+}
+
+/* One EV_SYN report: screen coordinates as evdev_read computes them */
+static void input_commit(int raw_x, int raw_y, int pressed, uint64_t t_ns, input_point_t *prev)
+{
+#if defined(EVDEV_CALIBRATE) && EVDEV_CALIBRATE
+    raw_x = (raw_x - EVDEV_HOR_MIN) * g_hor_res / (EVDEV_HOR_MAX - EVDEV_HOR_MIN);
+    raw_y = (raw_y - EVDEV_VER_MIN) * g_ver_res / (EVDEV_VER_MAX - EVDEV_VER_MIN);
+#endif
+    input_point_t p = { input_clamp(raw_x, g_hor_res), input_clamp(raw_y, g_ver_res), (uint8_t)(pressed != 0), t_ns };
+    if (p.x == prev->x && p.y == prev->y && p.pressed == prev->pressed) return;
+    *prev = p;
+
+    perf_count_add(PERF_CNT_INPUT_EVENTS, 1);
+    __atomic_store_n(&g_latest, input_pack(&p), __ATOMIC_RELEASE);
+    if (input_queue_push(&p) != 0) perf_count_add(PERF_CNT_INPUT_DROPPED, 1);
+    uint64_t one = 1;
+    while (write(g_wake_fd, &one, sizeof(one)) < 0 && errno == EINTR) { }
+}
+
+static void *input_thread_main(void *arg)
+{
+    (void)arg;
+    thread_policy_apply(THREAD_ROLE_INPUT);
+    struct input_event evs[32];
+    int x = 0, y = 0, pressed = 0, dropping = 0;
+    input_point_t prev = { -1, -1, 0, 0 };
+    for (;;) {
+        ssize_t n = read(g_fd, evs, sizeof(evs));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "Input: read failed: %s; input thread stops\n", strerror(errno));
+            break;
+        }
+        uint64_t now = perf_now_ns();
+        for (size_t i = 0; i < (size_t)n / sizeof(evs[0]); ++i) {
+            const struct input_event *ev = &evs[i];
+            if (ev->type == EV_SYN) {
+                if (ev->code == SYN_DROPPED) {
+                    dropping = 1;   /* the kernel lost events: skip to the next report */
+                } else if (ev->code == SYN_REPORT) {
+                    uint64_t t = g_kernel_clock ? (uint64_t)ev->input_event_sec * 1000000000ull +
+                                                  (uint64_t)ev->input_event_usec * 1000ull : now;
+                    if (!dropping) input_commit(x, y, pressed, t, &prev);
+                    dropping = 0;
+                }
+                continue;
+            }
+            switch (ev->type) {
+            case EV_REL:
+                if (ev->code == REL_X) x += ev->value;
+                else if (ev->code == REL_Y) y += ev->value;
+                x = input_clamp(x, g_hor_res);
+                y = input_clamp(y, g_ver_res);
+                break;
+            case EV_ABS:
+#if defined(EVDEV_SWAP_AXES) && EVDEV_SWAP_AXES
+                if (ev->code == ABS_X || ev->code == ABS_MT_POSITION_X) y = ev->value;
+                else if (ev->code == ABS_Y || ev->code == ABS_MT_POSITION_Y) x = ev->value;
+#else
+                if (ev->code == ABS_X || ev->code == ABS_MT_POSITION_X) x = ev->value;
+                else if (ev->code == ABS_Y || ev->code == ABS_MT_POSITION_Y) y = ev->value;
+#endif
+                else if (ev->code == ABS_MT_TRACKING_ID) pressed = ev->value != -1;
+                break;
+            case EV_KEY:
+                if (ev->code == BTN_MOUSE || ev->code == BTN_TOUCH) pressed = ev->value != 0;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    close(g_fd);
+    g_fd = -1;
+    return NULL;
+}
+
+int input_thread_start(const char *path, lv_coord_t hor_res, lv_coord_t ver_res)
+{
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    int clk = CLOCK_MONOTONIC;
+    g_kernel_clock = ioctl(fd, EVIOCSCLOCKID, &clk) == 0;
+    int wfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wfd < 0) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    g_fd = fd;
+    g_wake_fd = wfd;
+    g_hor_res = hor_res;
+    g_ver_res = ver_res;
+
+    pthread_t tid;
+    int rc = pthread_create(&tid, NULL, input_thread_main, NULL);
+    if (rc != 0) {
+        close(fd);
+        close(wfd);
+        g_fd = g_wake_fd = -1;
+        errno = rc;
+        return -1;
+    }
+    pthread_detach(tid);
+    return 0;
+}
+
+static void input_thread_ready_cb(int fd, void *user)
+{
+    lv_indev_t *indev = (lv_indev_t *)user;
+    uint64_t cnt;
+    while (read(fd, &cnt, sizeof(cnt)) < 0 && errno == EINTR) { }
+    if (indev && indev->driver->read_timer) {
+        g_last_active_ms = lv_tick_get();
+        lv_timer_resume(indev->driver->read_timer);
+        lv_timer_ready(indev->driver->read_timer);
+    }
+}
+
+int input_thread_watch(lv_indev_t *indev)
+{
+    if (g_wake_fd < 0 || !indev) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (event_loop_add_fd(g_wake_fd, input_thread_ready_cb, indev) != 0) return -1;
+    g_last_active_ms = lv_tick_get();
+    g_watched = 1;
+    return 0;
+}
+
+void input_thread_read(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    input_point_t p;
+    int more = 0;
+    if (input_queue_pop(&p, &more) == 0) {
+        uint64_t now = perf_now_ns();
+        if (p.t_ns && p.t_ns <= now) perf_hist_record(PERF_HIST_INPUT_DISPATCH, now - p.t_ns);
+        g_last = p;
+    } else {
+        /* Empty, or transitions were dropped on overflow: report the newest state */
+        uint64_t latest = __atomic_load_n(&g_latest, __ATOMIC_ACQUIRE);
+        g_last.x = (int16_t)(uint16_t)latest;
+        g_last.y = (int16_t)(uint16_t)(latest >> 16);
+        g_last.pressed = (uint8_t)(latest >> 32);
+    }
+    data->point.x = g_last.x;
+    data->point.y = g_last.y;
+    data->state = g_last.pressed ? LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+    data->continue_reading = more;
+
+    if (g_last.pressed || more) {
+        g_last_active_ms = lv_tick_get();
+    } else if (g_watched && lv_tick_elaps(g_last_active_ms) > INPUT_THREAD_IDLE_MS && drv->read_timer) {
+        lv_timer_pause(drv->read_timer);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef INPUT_THREAD_H
+#define INPUT_THREAD_H
+
+/*
+ * Pointer input on its own thread (threaded mode, fbdev/evdev backend).
+ *
+ * The input thread blocks in read() on the evdev node, assembles each
+ * EV_SYN report into a pointer transition (position, pressed/released, the
+ * kernel's CLOCK_MONOTONIC event time) as lv_drivers' evdev_read does,
+ * including EVDEV_SWAP_AXES / EVDEV_CALIBRATE, and pushes it into a
+ * single-producer single-consumer ring of INPUT_QUEUE_LEN entries. It never
+ * touches LVGL. An eventfd wakes the render thread, whose event loop readies
+ * LVGL's pointer read timer at once.
+ *
+ * input_thread_read() is the pointer's read_cb on the render thread. It returns
+ * the queued transitions in order, one per call with continue_reading set
+ * while more are queued. LVGL's input timer runs before the display refresh
+ * in a timer pass, so an event is applied in the first pass after it arrives
+ * and reaches the screen with the frame that pass renders. The delay is at
+ * most the frame already in progress, not LVGL's 30 ms input poll. Taps and
+ * releases during a long redraw are queued, not overwritten. If the ring
+ * overflows, the newest state still wins (counted as input_dropped).
+ * Event-to-dispatch time is recorded in the input_dispatch histogram.
+ *
+ * While the pointer is released for INPUT_THREAD_IDLE_MS the read timer is
+ * paused, so an idle screen costs no input wakeups.
+ */
+
+#include "lvgl/lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef INPUT_QUEUE_LEN
+#define INPUT_QUEUE_LEN 64          /* power of two */
+#endif
+#ifndef INPUT_THREAD_IDLE_MS
+#define INPUT_THREAD_IDLE_MS 500    /* keep polling this long after release (gestures, click events) */
+#endif
+
+/* Open path and start the input thread for a hor_res x ver_res screen.
+ * Returns 0, or -1 with errno set (nothing started). */
+int input_thread_start(const char *path, lv_coord_t hor_res, lv_coord_t ver_res);
+
+/* Add the wake fd to the event loop (event_loop.h, render thread; after
+ * event_loop_init()) so that new transitions ready indev's read timer. The
+ * read timer is only paused while watched. Returns 0 or -1 with errno set. */
+int input_thread_watch(lv_indev_t *indev);
+
+/* LVGL pointer read_cb (render thread). */
+void input_thread_read(lv_indev_drv_t *drv, lv_indev_data_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INPUT_THREAD_H */
@@ -11,8 +11,15 @@
 #define LV_VER_RES_MAX          (320)
 
 /* Color settings */
+/* make COLOR_DEPTH=16 renders RGB565 (half the draw buffer memory and flush
+ * bytes; native on 16 bpp panels), make COLOR_16_SWAP=1 byte-swaps it for SPI
+ * panels. See fb_blit.h. */
+#ifndef LV_COLOR_DEPTH
 #define LV_COLOR_DEPTH          32
+#endif
+#ifndef LV_COLOR_16_SWAP
 #define LV_COLOR_16_SWAP        0
+#endif
 
 /* Enable anti-aliasing (1: Enable, 0: Disable) */
 #define LV_ANTIALIAS            1
@@ -20,7 +27,32 @@
 /* Tick configuration
  * If LV_TICK_CUSTOM is 0 (default) you must call lv_tick_inc(ms) periodically from your system tick.
  * If you set LV_TICK_CUSTOM to 1 you must provide a function: uint32_t lv_tick_get(void) that returns ms. */
+#ifdef USE_TICKLESS
+/* Tickless builds (make TICKLESS=1): LVGL reads CLOCK_MONOTONIC, no tick thread */
+#define LV_TICK_CUSTOM          1
+#define LV_TICK_CUSTOM_INCLUDE  "event_loop.h"
+#define LV_TICK_CUSTOM_SYS_TIME_EXPR (event_loop_tick_ms())
+#else
 #define LV_TICK_CUSTOM          0
+#endif
+
+/*====================
+   Memory
+ *====================*/
+
+/* LVGL's built-in allocator (TLSF) over one static arena, not a custom hook:
+ * every LVGL object, style and label text, cards and their labels included,
+ * comes from here and never from malloc, so memory is bounded at build time.
+ * The mem_pool.h pools are not wired in: they only hold fixed-size blocks,
+ * and a hook would still need a general allocator behind them. Usage, peak
+ * and fragmentation are in the stats dump ("mem", see mem_pool.h); raise
+ * LV_MEM_SIZE if the peak gets close to it (many sensor cards). */
+#define LV_MEM_CUSTOM           0
+#ifndef LV_MEM_SIZE
+#define LV_MEM_SIZE             (128U * 1024U)
+#endif
+#define LV_MEM_ADR              0     /* 0: a static array inside LVGL */
+#define LV_MEM_BUF_MAX_NUM      16    /* draw-time scratch buffers */
 
 /*====================
    Feature usage
@@ -5,16 +5,17 @@
  * Overview
  * --------
  * A minimal weather dashboard built with LVGL running on the Linux framebuffer
- * (fbdev) with evdev input. It renders four widgets (temperature, pressure,
- * humidity, time) and periodically refreshes their data using a background
- * thread that simulates weather API calls.
+ * (fbdev) with evdev input. It renders four cards (temperature, pressure,
+ * humidity, time) for the primary sensor, one compact card per additional
+ * sensor, and refreshes them from BME280 devices sampled in the background.
  *
  * Key Components
  * --------------
  * - LVGL core (lv_init, lv_timer_handler, lv_tick_inc)
  * - Linux framebuffer display driver (fbdev)
  * - Linux input driver (evdev) for mouse/touch
- * - POSIX threads: one for LVGL ticks, one for data refresh
+ * - Sensor registry (sensor_registry.c): BME280 devices over I2C or SPI
+ * - POSIX threads: one for LVGL ticks, a small pool for sensor sampling
  *
  * Threading Model
  * ---------------
@@ -22,7 +23,24 @@
  *   in a simple loop.
  * - Tick thread: calls lv_tick_inc(1) every 1 ms. LVGL uses this for time-based
  *   tasks, animations, and timers.
- * - API update thread: fetches data every 30 seconds and requests UI updates.
+ * - Tickless builds (make TICKLESS=1) drop the tick thread and the polling loop:
+ *   LVGL reads CLOCK_MONOTONIC directly and the main thread sleeps in epoll
+ *   until the next LVGL deadline, new sensor data, or input (event_loop.c).
+ * - Sensor discovery: every configured device is probed concurrently at start
+ *   and sampled as soon as it attaches; missing devices are re-probed with
+ *   backoff, so a sensor plugged in later shows up without a restart.
+ * - Threaded mode (--threaded, fbdev/evdev or headless): after setup main()
+ *   hands LVGL to a dedicated render thread and only joins it; an input thread
+ *   blocks on the evdev fd and queues pointer events lock-free (input_thread.h),
+ *   so touch handling no longer waits for LVGL's input poll. --affinity and
+ *   --priority pin the render, input, flush, sensor and telemetry threads
+ *   (thread_policy.h). See threaded_run() for the ownership contract.
+ * - Sensor workers: sample every device at its adaptive rate (SENSOR_REFRESH_SEC
+ *   while conditions change slowly, slower when stable, faster during weather
+ *   events; sample_sched.h), one worker per bus (up to SENSOR_WORKERS_MAX), and publish each device through its own
+ *   wait-free triple-buffered snapshot (snapshot.h). The GUI timer re-renders a
+ *   card only when its device published, and labels are only set when their
+ *   text changed. No lock is shared between the workers and the GUI thread.
  *
  * IMPORTANT: LVGL API calls are not thread-safe. All LVGL object access and
  * updates should occur from the same thread that runs lv_timer_handler (the
@@ -34,10 +52,12 @@
  *
  * Display Buffering
  * -----------------
- * DISP_BUF_SIZE is set to 320x240. LVGL supports rendering in smaller chunks
- * than the full display resolution, so the buffer can be smaller than the
- * window/screen size (e.g., 480x320). Increase buffer size or use double
- * buffering for better performance on larger displays.
+ * DISP_BUF_SIZE defaults to half a screen. LVGL supports rendering in smaller
+ * chunks than the full display resolution, so the buffer can be smaller than
+ * the window/screen size (e.g., 480x320). By default two buffers are used and a
+ * flush worker copies one to the display while LVGL renders into the other;
+ * DISP_RENDER_MODE=DISP_RENDER_FLIP renders straight into a page-flipped
+ * framebuffer instead. See disp_pipeline.h for the build options.
  *
  * Placeholders and Extensibility
  * ------------------------------
@@ -76,6 +96,27 @@
 #include <fcntl.h>
 #include <linux/i2c-dev.h>
 #endif
+#include <errno.h>
+#if defined(USE_TICKLESS) && !defined(USE_SDL_BACKEND)
+#include <linux/input.h>
+#endif
+#include "event_loop.h"
+#include "thread_policy.h"
+#ifndef USE_SDL_BACKEND
+#include "input_thread.h"
+#endif
+#include "disp_pipeline.h"
+#include "fb_blit.h"
+#include "mem_pool.h"
+#include "perf_stats.h"
+#include "snapshot.h"
+#include "history.h"
+#include "sensor_registry.h"
+#include "sample_filter.h"
+#include "telemetry.h"
+#include "sample_log.h"
+#include "num_label.h"
+#include "headless.h"
 
 #if defined(__linux__) && !defined(DISABLE_BME280)
 #define BME_FEATURE 1
@@ -83,8 +124,6 @@
 #define BME_FEATURE 0
 #endif
 
-#define DISP_BUF_SIZE (320 * 240)  /* Rendering buffer in pixels; may be smaller than the display resolution */
-
 #ifndef UI_UPDATE_INTERVAL_MS
 #define UI_UPDATE_INTERVAL_MS 1000  /* UI refresh timer interval in milliseconds */
 #endif
@@ -105,106 +144,341 @@
 #endif
 #endif
 
-#ifndef DISP_HOR_RES
-#define DISP_HOR_RES 480            /* Default horizontal resolution for display driver */
-#endif
-
-#ifndef DISP_VER_RES
-#define DISP_VER_RES 320            /* Default vertical resolution for display driver */
-#endif
-
-/* Default Linux I2C device path for BME280 (ensure visible before use) */
+/* Default Linux I2C device path for BME280 when no sensor is configured */
 #ifndef BME280_I2C_DEV
 #define BME280_I2C_DEV "/dev/i2c-1"
 #endif
 
-#if BME_FEATURE
-#include "BME280.h"
-#include "I2CDevice.h"
-#endif
-
 /* Color constants (use hex to avoid palette dependency) */
 #define COLOR_TEMP     lv_color_hex(0xF44336)  /* Red 500 */
 #define COLOR_PRESSURE lv_color_hex(0x2196F3)  /* Blue 500 */
 #define COLOR_HUMIDITY lv_color_hex(0x4CAF50)  /* Green 500 */
 #define COLOR_TIME     lv_color_hex(0x9C27B0)  /* Purple 500 */
-
-// UI widget handles created during UI construction; used to update label text.
-static lv_obj_t *temp_label;
-static lv_obj_t *pressure_label;
-static lv_obj_t *humidity_label;
-static lv_obj_t *time_label;
-static lv_obj_t *g_source_label_ref = NULL; // track source of data
-
-#if BME_FEATURE
-static unsigned long g_bme_ok = 0;
-static unsigned long g_bme_err = 0;
-#endif
+#define COLOR_SENSOR   lv_color_hex(0x607D8B)  /* Blue Grey 500 */
 
 /**
- * weather_data_t
- * In-memory representation of the current weather snapshot shown on screen.
+ * Card factory
+ * Every dashboard card is built from a card_template_t: a tinted container
+ * with a title, a row of fixed-width numeric fields (num_label.h: integer
+ * formatting, pre-rasterized glyphs, only changed digits redrawn) and/or one
+ * text label. The text label points at the card's own buffer
+ * (lv_label_set_text_static), so refreshing any number of cards copies into
+ * fixed storage and never allocates.
  *
- * Fields use SI units:
- * - temperature: Celsius
- * - pressure: hectopascals (hPa)
- * - humidity: percentage [0..100]
- * - time_str: formatted as HH:MM (24h)
+ * Cards share their styles: g_style_card (radius, padding) plus one tint
+ * style per colour/opacity and one text style per value font, instead of a
+ * set of local style properties on every object.
  *
- * Note: This demo uses NaN (math.h) to represent "unknown" values when
- * formatting output. In production, consider explicit validity flags for
- * clarity and portability.
+ * Layout (--layout, env WEATHER_LAYOUT):
+ *   fixed  (default) every card, field row and text label gets its position
+ *          and size once in ui_create from the display resolution and the
+ *          sensor count; text labels are fixed-width LV_LABEL_LONG_CLIP. No
+ *          object is content-sized, so a value update never resizes anything,
+ *          never runs a layout pass and only invalidates the glyph box it
+ *          redraws (the changed digit cells, or the text label's own line)
+ *   flex   the cards flow in ROW_WRAP/COLUMN flex containers and stretch with
+ *          flex_grow; adapts to any resolution, but a text change that alters
+ *          a label's width re-runs the flex layout of its card
  */
+#define CARD_FIELDS_MAX 3
+#define CARD_PAD        6         /* card padding */
+#define CARD_FIELD_GAP  8         /* between the numeric fields of a card */
+#define UI_STYLE_TINTS  8         /* distinct card colour/opacity pairs */
+#define UI_STYLE_FONTS  4         /* distinct value text fonts */
+
 typedef struct {
-    float temperature;
-    float pressure;
-    float humidity;
-    char time_str[32];
-} weather_data_t;
+    uint8_t int_digits;       /* including the cell a minus sign needs */
+    uint8_t frac_digits;
+    const char *unit;
+} card_field_t;
 
-static weather_data_t current_data = { .temperature = NAN, .pressure = NAN, .humidity = NAN, .time_str = "" };
-static pthread_mutex_t current_data_mutex = PTHREAD_MUTEX_INITIALIZER;  // Protects access to current_data
-static int g_last_source_is_bme = 0;  // 1 if last update used BME, else 0 (no sensor data)
+typedef struct {
+    const char *title;        /* NULL: set per instance (sensor name) */
+    const char *placeholder;  /* text label content before the first sample; NULL: fields only */
+    lv_color_t color;
+    const lv_font_t *font;
+    const card_field_t *fields;
+    unsigned field_count;     /* 0: text card */
+} card_template_t;
+
+typedef struct {
+    lv_obj_t *obj;
+    lv_obj_t *title;
+    lv_obj_t *value;          /* text label, NULL on fields-only cards */
+    lv_obj_t *row;            /* container of the numeric fields */
+    num_label_t *field[CARD_FIELDS_MAX];
+    unsigned field_count;
+    char text[48];
+} card_t;
+
+enum { CARD_TEMPERATURE, CARD_PRESSURE, CARD_HUMIDITY, CARD_TIME, CARD_PRIMARY_COUNT };
+enum { CARD_DEW_POINT, CARD_HEAT_INDEX, CARD_SEA_LEVEL, CARD_TENDENCY, CARD_DERIVED_COUNT };
+
+// UI widget handles created during UI construction; used to update label text.
+static card_t g_cards[CARD_PRIMARY_COUNT];            // primary sensor (registry index 0) + clock
+static card_t g_sensor_cards[SENSOR_REGISTRY_MAX];    // compact cards, only with 2+ sensors
+static card_t g_derived_cards[CARD_DERIVED_COUNT];    // primary sensor's derived metrics (--derived)
+static int g_derived = 0;
+static unsigned g_sensor_card_count = 0;
+static lv_obj_t *g_source_label_ref = NULL; // track source of data
+static lv_indev_t *g_pointer_indev = NULL;  // pointer input (fbdev/evdev backend)
+static const char *g_headless_listen = NULL; // --headless: memory framebuffer served on this socket
+static int g_layout_fixed = 1;               // --layout=fixed (default) or flex
+static int g_threaded = 0;                   // --threaded: render thread + input thread (threaded_run)
+
+// Shared card styles (GUI thread, created on first use)
+static lv_style_t g_style_card;
+static int g_style_card_ready = 0;
+static struct { lv_style_t style; lv_color_t color; lv_opa_t opa; } g_style_tint[UI_STYLE_TINTS];
+static unsigned g_style_tint_count = 0;
+static struct { lv_style_t style; const lv_font_t *font; } g_style_text[UI_STYLE_FONTS];
+static unsigned g_style_text_count = 0;
+
+// Downsampled history of the primary sensor (writer: its sampling worker,
+// reader: trend chart on the GUI thread)
+static history_t g_history;
 // Function prototypes
 void hal_init(void);
-void update_display_data(void);
-void *api_update_thread(void *arg);
+static void card_create(card_t *card, lv_obj_t *parent, const card_template_t *tpl,
+                        const char *title, lv_coord_t w, lv_coord_t h);
+static void card_style_apply(lv_obj_t *obj, lv_color_t color, lv_opa_t opa);
+static void text_style_apply(lv_obj_t *obj, const lv_font_t *font);
+static void card_set_value(card_t *card, const char *text);
+static void card_set_fields(card_t *card, const float *v);
+static void ui_create(int stats_overlay);
+void update_display_data(unsigned index, const sensor_sample_t *sample);
+static void sensor_sample_published(unsigned index, const sensor_sample_t *sample, void *user);
+static void clock_timer_cb(lv_timer_t *timer);
 void get_current_time(char *time_str, size_t size);
 void *lvgl_tick_thread(void *arg);
 void update_display_timer_cb(lv_timer_t *timer);
-#ifdef __linux__
-static int bme280_init_linux(const char *i2c_path);
-static int bme280_read_raw(float *temp_c, float *press_hpa, float *humid_rh);
-static int bme_is_inited(void);
-static uint8_t bme_get_addr(void);
+static void label_set_text_if_changed(lv_obj_t *label, const char *text);
+static void stats_overlay_create(void);
+static lv_obj_t *trend_chart_create(lv_obj_t *parent, lv_coord_t w, lv_coord_t h);
+static void trend_chart_refresh(void);
+static void loop_data_notify_cb(void *user);
+static int threaded_run(void);
+#ifdef USE_TICKLESS
+static int tickless_start(void);
+#ifndef USE_SDL_BACKEND
+static void tickless_evdev_read(lv_indev_drv_t *drv, lv_indev_data_t *data);
+#endif
 #endif
 #if BME_FEATURE
-static const char *g_cli_i2c_path = NULL; // optional CLI override
+static int g_sensor_cli_count = 0;           // sensors added by --sensor/--sensors/--i2c
 #endif
 
 int main(int argc, char **argv)
 {
-#if BME_FEATURE
-    // Parse command-line for --i2c <path> or --i2c=<path>
+    // Parse command-line options
+    //   --sensor=<spec> | --sensor <spec>  add a BME280 (i2c:<dev>[:<addr>[:<name>]]
+    //                                      or spi:<dev>[:<hz>[:<name>]]); repeatable
+    //   --sensors=<file>              add every spec in a config file
+    //   --i2c <path> | --i2c=<path>   shorthand for --sensor=i2c:<path>
+    //   --stats-overlay               show pipeline statistics on screen
+    //   --stats-file=<path>           SIGUSR1 writes a JSON stats dump here (default: stdout)
+    //   --stats-socket=<path>         Unix socket serving one JSON dump per connection
+    //   --telemetry=<dest>            stream samples to udp:<host>:<port> or unix:<path>
+    //   --sample-log=<path>           keep raw samples in a persistent log, replayed at start
+    //   --sample-log-sync=<sec>       msync cadence of the sample log (0 = every sample)
+    //   --sampling=adaptive|fixed     follow signal dynamics (default) or sample every SENSOR_REFRESH_SEC
+    //   --headless=<listen>           no display/input: render to memory, serve changed tiles on
+    //                                 unix:<path> or tcp:[<host>:]<port> (headless.h)
+    //   --headless-interval=<ms>      push cadence for subscribed headless clients
+    //   --layout=fixed|flex           precomputed card geometry (default) or flex layout
+    //   --derived                     dew point, heat index, sea level and 3 h tendency cards
+    //                                 and telemetry records (derived.h)
+    //   --altitude=<m>                station altitude for the sea-level pressure
+    //   --filter=<spec>|none          sample filter pipeline, e.g. median:5,hampel:7:3,ema:120
+    //                                 (sample_filter.h)
+    //   --threaded                    LVGL on a dedicated render thread, evdev on an input thread
+    //   --affinity=<spec>             CPUs per thread role, e.g. render:1,input:1,sensors:2-3
+    //   --priority=<spec>             SCHED_FIFO priority per role, e.g. input:60,render:50
+    //                                 (thread_policy.h)
+    int stats_overlay = 0;
+    const char *stats_file = getenv("WEATHER_STATS_FILE");
+    const char *stats_socket = getenv("WEATHER_STATS_SOCKET");
+    const char *telemetry_dest = getenv("WEATHER_TELEMETRY");
+    const char *sample_log_path = getenv("WEATHER_SAMPLE_LOG");
+    unsigned sample_log_sync = SAMPLE_LOG_SYNC_SEC;
+    const char *sampling = getenv("WEATHER_SAMPLING");
+    unsigned headless_interval = 0;
+    g_headless_listen = getenv("WEATHER_HEADLESS");
+    const char *layout = getenv("WEATHER_LAYOUT");
+    const char *derived = getenv("WEATHER_DERIVED");
+    const char *altitude = getenv("WEATHER_ALTITUDE");
+    const char *filter = getenv("WEATHER_FILTER");
+    const char *threaded = getenv("WEATHER_THREADED");
+    const char *affinity = getenv("WEATHER_AFFINITY");
+    const char *priority = getenv("WEATHER_PRIORITY");
+    g_threaded = threaded && threaded[0] && strcmp(threaded, "0") != 0;
+    g_derived = derived && derived[0] && strcmp(derived, "0") != 0;
     for (int i = 1; i < argc; ++i) {
-        if (strncmp(argv[i], "--i2c=", 7) == 0) {
-            g_cli_i2c_path = argv[i] + 7;
+#if BME_FEATURE
+        const char *spec = NULL;
+        char i2c_spec[SENSOR_PATH_MAX + 8];
+        if (strncmp(argv[i], "--sensor=", 9) == 0) {
+            spec = argv[i] + 9;
+        } else if (strcmp(argv[i], "--sensor") == 0 && i + 1 < argc) {
+            spec = argv[++i];
+        } else if (strncmp(argv[i], "--i2c=", 6) == 0) {
+            snprintf(i2c_spec, sizeof(i2c_spec), "i2c:%s", argv[i] + 6);
+            spec = i2c_spec;
         } else if (strcmp(argv[i], "--i2c") == 0 && i + 1 < argc) {
-            g_cli_i2c_path = argv[i + 1];
-            ++i;
+            snprintf(i2c_spec, sizeof(i2c_spec), "i2c:%s", argv[++i]);
+            spec = i2c_spec;
+        } else if (strncmp(argv[i], "--sensors=", 10) == 0) {
+            int n = sensor_registry_load_file(argv[i] + 10);
+            if (n < 0) fprintf(stderr, "Sensors: cannot read %s: %s\n", argv[i] + 10, strerror(errno));
+            else g_sensor_cli_count += n;
+            continue;
         }
+        if (spec) {
+            if (sensor_registry_add_spec(spec) < 0) fprintf(stderr, "Sensors: ignoring '%s'\n", spec);
+            else g_sensor_cli_count++;
+            continue;
+        }
+#endif
+        if (strcmp(argv[i], "--stats-overlay") == 0) {
+            stats_overlay = 1;
+        } else if (strncmp(argv[i], "--stats-file=", 13) == 0) {
+            stats_file = argv[i] + 13;
+        } else if (strncmp(argv[i], "--stats-socket=", 15) == 0) {
+            stats_socket = argv[i] + 15;
+        } else if (strncmp(argv[i], "--telemetry=", 12) == 0) {
+            telemetry_dest = argv[i] + 12;
+        } else if (strncmp(argv[i], "--sample-log=", 13) == 0) {
+            sample_log_path = argv[i] + 13;
+        } else if (strncmp(argv[i], "--sample-log-sync=", 18) == 0) {
+            sample_log_sync = (unsigned)strtoul(argv[i] + 18, NULL, 10);
+        } else if (strncmp(argv[i], "--sampling=", 11) == 0) {
+            sampling = argv[i] + 11;
+        } else if (strncmp(argv[i], "--headless=", 11) == 0) {
+            g_headless_listen = argv[i] + 11;
+        } else if (strncmp(argv[i], "--headless-interval=", 20) == 0) {
+            headless_interval = (unsigned)strtoul(argv[i] + 20, NULL, 10);
+        } else if (strncmp(argv[i], "--layout=", 9) == 0) {
+            layout = argv[i] + 9;
+        } else if (strcmp(argv[i], "--derived") == 0) {
+            g_derived = 1;
+        } else if (strncmp(argv[i], "--altitude=", 11) == 0) {
+            altitude = argv[i] + 11;
+        } else if (strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else if (strcmp(argv[i], "--threaded") == 0) {
+            g_threaded = 1;
+        } else if (strncmp(argv[i], "--affinity=", 11) == 0) {
+            affinity = argv[i] + 11;
+        } else if (strncmp(argv[i], "--priority=", 11) == 0) {
+            priority = argv[i] + 11;
+        }
+    }
+    // Before any thread is created: every role applies its policy at start
+    if (affinity && affinity[0] && thread_policy_set_affinity(affinity) != 0) {
+        fprintf(stderr, "Threads: ignoring affinity '%s'\n", affinity);
+    }
+    if (priority && priority[0] && thread_policy_set_priority(priority) != 0) {
+        fprintf(stderr, "Threads: ignoring priority '%s'\n", priority);
+    }
+    if (filter && sensor_registry_set_filter(filter) != 0) {
+        fprintf(stderr, "Sensors: ignoring filter '%s'; using %s\n", filter, SAMPLE_FILTER_DEFAULT);
+    }
+    if (altitude && altitude[0]) sensor_registry_set_altitude(strtof(altitude, NULL));
+    if (layout && strcmp(layout, "flex") == 0) g_layout_fixed = 0;
+    if (sampling && strcmp(sampling, "fixed") == 0) sensor_registry_set_adaptive(0);
+
+    // Start the stats dump service first: it blocks SIGUSR1, and every thread
+    // created afterwards inherits that mask.
+    if (perf_stats_start_service(stats_file, stats_socket) != 0) {
+        fprintf(stderr, "Stats: dump service unavailable: %s\n", strerror(errno));
+    }
+
+#if BME_FEATURE
+    // Nothing configured: one BME280 on the default adapter (env BME280_I2C_DEV overrides)
+    if (g_sensor_cli_count == 0) {
+        const char *env_path = getenv("BME280_I2C_DEV");
+        char spec[SENSOR_PATH_MAX + 8];
+        snprintf(spec, sizeof(spec), "i2c:%s", env_path && env_path[0] ? env_path : BME280_I2C_DEV);
+        sensor_registry_add_spec(spec);
     }
 #endif
+
+    if (telemetry_dest && telemetry_dest[0] && telemetry_start(telemetry_dest) != 0) {
+        fprintf(stderr, "Telemetry: cannot export to %s: %s\n", telemetry_dest, strerror(errno));
+    }
+    if (sample_log_path && sample_log_path[0] && sample_log_open(sample_log_path, sample_log_sync) != 0) {
+        fprintf(stderr, "Sample log: cannot open %s: %s\n", sample_log_path, strerror(errno));
+    }
+
     // Initialize LVGL core
     lv_init();
 
     // Initialize hardware abstraction layer (display + input drivers)
+    if (g_headless_listen && !g_headless_listen[0]) g_headless_listen = NULL;
     hal_init();
+    if (g_headless_listen && headless_start(g_headless_listen, headless_interval) != 0) {
+        fprintf(stderr, "Headless: cannot listen on %s: %s\n", g_headless_listen, strerror(errno));
+        return 1;
+    }
 
-    // Start LVGL tick thread (1 ms tick)
+#ifndef USE_TICKLESS
+    // Start LVGL tick thread (1 ms tick). Tickless builds read CLOCK_MONOTONIC
+    // through LV_TICK_CUSTOM instead (see lv_conf.h).
     pthread_t tick_thread;
     pthread_create(&tick_thread, NULL, lvgl_tick_thread, NULL);
+#endif
+
+    // Restore the primary sensor's history from the sample log (no-op without one);
+    // must finish before the sampling workers start writing
+    history_init(&g_history);
+    unsigned replayed = sample_log_replay(0, &g_history);
+    if (replayed) printf("Sample log: replayed %u samples into history\n", replayed);
+
+    ui_create(stats_overlay);
+
+    // Start the sensor workers (periodic data refresh); none without sensors
+    if (sensor_registry_start(SENSOR_REFRESH_SEC, sensor_sample_published, NULL) < 0) {
+        fprintf(stderr, "Sensors: no sampling worker could be started\n");
+    }
+
+    if (g_threaded) {
+        threaded_run(); // returns only if the render thread could not be started
+        fprintf(stderr, "Threaded mode unavailable (%s); running single-threaded\n", strerror(errno));
+    }
+
+#ifdef USE_TICKLESS
+    // Tickless: sleep until LVGL's next deadline, new sensor data or input.
+    // The sensor workers wake us through event_loop_notify(); no polling timer.
+    if (tickless_start() == 0) {
+        event_loop_run(); // never returns
+    }
+    fprintf(stderr, "Tickless loop unavailable (%s); falling back to polling\n", strerror(errno));
+#endif
+
+    // Create a GUI-thread timer to periodically update labels from the published snapshots
+    // This ensures LVGL API calls occur on the GUI thread.
+    lv_timer_create(update_display_timer_cb, UI_UPDATE_INTERVAL_MS, NULL); // update every 1s
 
+    // Main loop: process LVGL timers and let the CPU rest briefly
+    while(1) {
+        uint64_t t0 = perf_now_ns();
+        lv_timer_handler();
+        perf_hist_record(PERF_HIST_TIMER_HANDLER, perf_now_ns() - t0);
+        usleep(5000);
+    }
+
+    return 0;
+}
+
+/**
+ * ui_create
+ * Build the dashboard on the default display: window, primary cards, one
+ * compact card per sensor when there are several, source label, trend chart,
+ * optional stats overlay and the clock timer. GUI thread only; the sensor
+ * registry must be populated (card count) and history initialized.
+ */
+static void ui_create(int stats_overlay)
+{
     // Create main window (LVGL v8 API)
     lv_disp_t *disp = lv_disp_get_default();
     lv_coord_t disp_w = lv_disp_get_hor_res(disp);
@@ -219,150 +493,164 @@ int main(int argc, char **argv)
     lv_obj_t *win_content = lv_win_get_content(win);
     lv_obj_set_style_pad_all(win_content, 20, LV_PART_MAIN);
 
-    // Use flex layout for responsive positioning
-    lv_obj_set_flex_flow(win_content, LV_FLEX_FLOW_ROW_WRAP);
-    const int gap = 12;             // inter-item spacing used by flex
+    const int gap = 12;             // inter-item spacing
     const int content_pad = 20;     // must match pad_all above
-    lv_obj_set_style_pad_row(win_content, gap, LV_PART_MAIN);
-    lv_obj_set_style_pad_column(win_content, gap, LV_PART_MAIN);
-    lv_obj_set_style_pad_hor(win_content, 20, LV_PART_MAIN);
-    lv_obj_set_style_pad_ver(win_content, 20, LV_PART_MAIN);
+    const lv_coord_t avail_w = disp_w - 2*content_pad;
+    if (!g_layout_fixed) {
+        // Use flex layout for responsive positioning
+        lv_obj_set_flex_flow(win_content, LV_FLEX_FLOW_ROW_WRAP);
+        lv_obj_set_style_pad_row(win_content, gap, LV_PART_MAIN);
+        lv_obj_set_style_pad_column(win_content, gap, LV_PART_MAIN);
+    }
 
     // Compute a reasonable base card size from the display resolution
-    int base_card_w = (int)((disp_w - 2*content_pad - gap) / 2); // target 2 columns
+    int base_card_w = (int)((avail_w - gap) / 2);                // target 2 columns
     if (base_card_w < 140) base_card_w = 140;                    // enforce a minimum width
     int base_card_h = disp_h / 6;                                // proportional height
     if (base_card_h < 60) base_card_h = 60;                      // enforce a minimum height
 
-    // Create temperature widget
-    lv_obj_t *temp_container = lv_obj_create(win_content);
-    lv_obj_set_size(temp_container, base_card_w, base_card_h);
-    lv_obj_set_style_bg_color(temp_container, COLOR_TEMP, LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(temp_container, LV_OPA_20, LV_PART_MAIN);
-    lv_obj_set_style_radius(temp_container, 10, LV_PART_MAIN);
-    lv_obj_set_flex_flow(temp_container, LV_FLEX_FLOW_COLUMN);
-    lv_obj_set_style_pad_all(temp_container, 6, LV_PART_MAIN);
-    lv_obj_set_flex_grow(temp_container, 1);
-
-    lv_obj_t *temp_title = lv_label_create(temp_container);
-    lv_label_set_text(temp_title, "Temperature");
-    lv_obj_align(temp_title, LV_ALIGN_TOP_MID, 0, 0);
-
-    temp_label = lv_label_create(temp_container);
-    lv_label_set_text(temp_label, "-- °C");
-    lv_obj_set_style_text_font(temp_label, &lv_font_montserrat_18, LV_PART_MAIN);
-    lv_obj_align(temp_label, LV_ALIGN_BOTTOM_MID, 0, 0);
-
-    // Create pressure widget
-    lv_obj_t *pressure_container = lv_obj_create(win_content);
-    lv_obj_set_size(pressure_container, base_card_w, base_card_h);
-    lv_obj_set_style_bg_color(pressure_container, COLOR_PRESSURE, LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(pressure_container, LV_OPA_20, LV_PART_MAIN);
-    lv_obj_set_style_radius(pressure_container, 10, LV_PART_MAIN);
-    lv_obj_set_flex_flow(pressure_container, LV_FLEX_FLOW_COLUMN);
-    lv_obj_set_style_pad_all(pressure_container, 6, LV_PART_MAIN);
-    lv_obj_set_flex_grow(pressure_container, 1);
-
-    lv_obj_t *pressure_title = lv_label_create(pressure_container);
-    lv_label_set_text(pressure_title, "Pressure");
-    lv_obj_align(pressure_title, LV_ALIGN_TOP_MID, 0, 0);
-
-    pressure_label = lv_label_create(pressure_container);
-    lv_label_set_text(pressure_label, "-- hPa");
-    lv_obj_set_style_text_font(pressure_label, &lv_font_montserrat_18, LV_PART_MAIN);
-    lv_obj_align(pressure_label, LV_ALIGN_BOTTOM_MID, 0, 0);
-
-    // Create humidity widget
-    lv_obj_t *humidity_container = lv_obj_create(win_content);
-    lv_obj_set_size(humidity_container, base_card_w, base_card_h);
-    lv_obj_set_style_bg_color(humidity_container, COLOR_HUMIDITY, LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(humidity_container, LV_OPA_20, LV_PART_MAIN);
-    lv_obj_set_style_radius(humidity_container, 10, LV_PART_MAIN);
-    lv_obj_set_flex_flow(humidity_container, LV_FLEX_FLOW_COLUMN);
-    lv_obj_set_style_pad_all(humidity_container, 6, LV_PART_MAIN);
-    lv_obj_set_flex_grow(humidity_container, 1);
-
-    lv_obj_t *humidity_title = lv_label_create(humidity_container);
-    lv_label_set_text(humidity_title, "Humidity");
-    lv_obj_align(humidity_title, LV_ALIGN_TOP_MID, 0, 0);
-
-    humidity_label = lv_label_create(humidity_container);
-    lv_label_set_text(humidity_label, "-- %");
-    lv_obj_set_style_text_font(humidity_label, &lv_font_montserrat_18, LV_PART_MAIN);
-    lv_obj_align(humidity_label, LV_ALIGN_BOTTOM_MID, 0, 0);
-
-    // Create time widget
-    lv_obj_t *time_container = lv_obj_create(win_content);
-    lv_obj_set_size(time_container, base_card_w, base_card_h);
-    lv_obj_set_style_bg_color(time_container, COLOR_TIME, LV_PART_MAIN);
-    lv_obj_set_style_bg_opa(time_container, LV_OPA_20, LV_PART_MAIN);
-    lv_obj_set_style_radius(time_container, 10, LV_PART_MAIN);
-    lv_obj_set_flex_flow(time_container, LV_FLEX_FLOW_COLUMN);
-    lv_obj_set_style_pad_all(time_container, 6, LV_PART_MAIN);
-    lv_obj_set_flex_grow(time_container, 1);
-
-    lv_obj_t *time_title = lv_label_create(time_container);
-    lv_label_set_text(time_title, "Time");
-    lv_obj_align(time_title, LV_ALIGN_TOP_MID, 0, 0);
-
-    time_label = lv_label_create(time_container);
-    lv_label_set_text(time_label, "-- : --");
-    lv_obj_set_style_text_font(time_label, &lv_font_montserrat_18, LV_PART_MAIN);
-    lv_obj_align(time_label, LV_ALIGN_BOTTOM_MID, 0, 0);
+    // Value fields: "-40.0 °C", "1013 hPa" and "100.0 %" fit
+    static const card_field_t f_temp = { 3, 1, "°C" }, f_press = { 4, 0, "hPa" }, f_hum = { 3, 1, "%" };
+    static const card_field_t f_all[CARD_FIELDS_MAX] = { { 3, 1, "°C" }, { 4, 0, "hPa" }, { 3, 0, "%" } };
+    const card_template_t primary[CARD_PRIMARY_COUNT] = {
+        [CARD_TEMPERATURE] = { "Temperature", NULL,      COLOR_TEMP    , &lv_font_montserrat_18, &f_temp,  1 },
+        [CARD_PRESSURE]    = { "Pressure",    NULL,      COLOR_PRESSURE, &lv_font_montserrat_18, &f_press, 1 },
+        [CARD_HUMIDITY]    = { "Humidity",    NULL,      COLOR_HUMIDITY, &lv_font_montserrat_18, &f_hum,   1 },
+        [CARD_TIME]        = { "Time",        "-- : --", COLOR_TIME    , &lv_font_montserrat_18, NULL,     0 },
+    };
+    // Fixed layout: a grid of up to 2 columns, as many as fit at the minimum width
+    unsigned cols = 2;
+    while (cols > 1 && (lv_coord_t)(cols * 140 + (cols - 1) * gap) > avail_w) cols--;
+    lv_coord_t cell_w = g_layout_fixed ? (lv_coord_t)((avail_w - (lv_coord_t)(cols - 1) * gap) / cols)
+                                       : base_card_w;
+    lv_coord_t y = 0;
+    for (int c = 0; c < CARD_PRIMARY_COUNT; ++c) {
+        card_create(&g_cards[c], win_content, &primary[c], NULL, cell_w, base_card_h);
+        if (g_layout_fixed) {
+            lv_obj_set_pos(g_cards[c].obj, (lv_coord_t)((c % cols) * (cell_w + gap)),
+                           (lv_coord_t)(y + (c / cols) * (base_card_h + gap)));
+        }
+    }
+    y += (lv_coord_t)(((CARD_PRIMARY_COUNT + cols - 1) / cols) * (base_card_h + gap));
+
+    // Derived metrics of the primary sensor (--derived): one row of four
+    if (g_derived) {
+        static const card_field_t f_dp = { 3, 1, "°C" }, f_slp = { 4, 1, "hPa" }, f_tend = { 3, 1, "hPa" };
+        const card_template_t derived[CARD_DERIVED_COUNT] = {
+            [CARD_DEW_POINT]  = { "Dew point",  NULL, COLOR_HUMIDITY, &lv_font_montserrat_14, &f_dp,   1 },
+            [CARD_HEAT_INDEX] = { "Feels like", NULL, COLOR_TEMP    , &lv_font_montserrat_14, &f_dp,   1 },
+            [CARD_SEA_LEVEL]  = { "Sea level",  NULL, COLOR_PRESSURE, &lv_font_montserrat_14, &f_slp,  1 },
+            [CARD_TENDENCY]   = { "3 h trend",  NULL, COLOR_PRESSURE, &lv_font_montserrat_14, &f_tend, 1 },
+        };
+        unsigned dcols = CARD_DERIVED_COUNT;
+        while (dcols > 1 && (lv_coord_t)(dcols * 100 + (dcols - 1) * gap) > avail_w) dcols--;
+        int derived_w = g_layout_fixed ? (int)((avail_w - (lv_coord_t)(dcols - 1) * gap) / dcols)
+                                       : (int)((avail_w - 3*gap) / 4);
+        if (derived_w < 100) derived_w = 100;
+        for (unsigned c = 0; c < CARD_DERIVED_COUNT; ++c) {
+            card_create(&g_derived_cards[c], win_content, &derived[c], NULL, derived_w, base_card_h);
+            if (g_layout_fixed) {
+                lv_obj_set_pos(g_derived_cards[c].obj, (lv_coord_t)((c % dcols) * (derived_w + gap)),
+                               (lv_coord_t)(y + (c / dcols) * (base_card_h + gap)));
+            }
+        }
+        y += (lv_coord_t)(((CARD_DERIVED_COUNT + dcols - 1) / dcols) * (base_card_h + gap));
+    }
+
+    // One compact card per sensor once there is more than one (four per row;
+    // the fixed layout spreads fewer sensors over the full width)
+    if (sensor_registry_count() > 1) {
+        const card_template_t compact = { NULL, "offline", COLOR_SENSOR, &lv_font_montserrat_14,
+                                          f_all, CARD_FIELDS_MAX };
+        g_sensor_card_count = sensor_registry_count();
+        unsigned small_cols = g_sensor_card_count < 4 ? g_sensor_card_count : 4;
+        while (small_cols > 1 && (lv_coord_t)(small_cols * 100 + (small_cols - 1) * gap) > avail_w) small_cols--;
+        int small_w = g_layout_fixed ? (int)((avail_w - (lv_coord_t)(small_cols - 1) * gap) / small_cols)
+                                     : (int)((avail_w - 3*gap) / 4);
+        if (small_w < 100) small_w = 100;
+        for (unsigned i = 0; i < g_sensor_card_count; ++i) {
+            card_create(&g_sensor_cards[i], win_content, &compact, sensor_registry_config(i)->name,
+                        small_w, base_card_h);
+            if (g_layout_fixed) {
+                lv_obj_set_pos(g_sensor_cards[i].obj, (lv_coord_t)((i % small_cols) * (small_w + gap)),
+                               (lv_coord_t)(y + (i / small_cols) * (base_card_h + gap)));
+            }
+        }
+        y += (lv_coord_t)(((g_sensor_card_count + small_cols - 1) / small_cols) * (base_card_h + gap));
+    }
 
     // Add a source/status label at bottom of the window
     lv_obj_t *src_label = lv_label_create(win_content);
     lv_label_set_text(src_label, "Source: --");
     lv_obj_set_style_text_font(src_label, &lv_font_montserrat_14, LV_PART_MAIN);
     lv_obj_set_style_text_color(src_label, lv_color_hex(0x607D8B), LV_PART_MAIN); // blue-grey
-    lv_obj_align(src_label, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+    if (g_layout_fixed) {
+        lv_label_set_long_mode(src_label, LV_LABEL_LONG_CLIP);
+        lv_obj_set_size(src_label, avail_w, lv_font_get_line_height(&lv_font_montserrat_14));
+        lv_obj_set_pos(src_label, 0, y);
+        y += lv_font_get_line_height(&lv_font_montserrat_14) + gap;
+    } else {
+        lv_obj_align(src_label, LV_ALIGN_BOTTOM_LEFT, 0, 0);
+    }
     // Keep a handle for updates
     g_source_label_ref = src_label;
 
-    // Start API update thread (periodic data refresh)
-    pthread_t api_thread;
-    pthread_create(&api_thread, NULL, api_update_thread, NULL);
+    // Pressure trend chart (full width, below the cards)
+    lv_obj_t *trend = trend_chart_create(win_content, avail_w, disp_h / 3);
+    if (g_layout_fixed) lv_obj_set_pos(trend, 0, y);
 
-    // Create a GUI-thread timer to periodically update labels from current_data
-    // This ensures LVGL API calls occur on the GUI thread.
-    lv_timer_create(update_display_timer_cb, UI_UPDATE_INTERVAL_MS, NULL); // update every 1s
+    if (stats_overlay) stats_overlay_create();
 
-    // Main loop: process LVGL timers and let the CPU rest briefly
-    while(1) {
-        lv_timer_handler();
-        usleep(5000);
-    }
+    // Clock card: its own timer, realigned to each minute boundary
+    clock_timer_cb(lv_timer_create(clock_timer_cb, 60 * 1000, NULL));
+}
 
-    return 0;
+#ifndef USE_SDL_BACKEND
+/* Register the display: DISP_BUF_COUNT draw buffers, fb_blit flush (on the
+ * flush worker when DISP_FLUSH_ASYNC); lv_drivers' fbdev if fb_blit has no
+ * path for the framebuffer */
+static void fb_display_init(void)
+{
+    if (fb_blit_init(FBDEV_PATH) == 0) {
+        disp_pipeline_init(fb_blit_flush, DISP_HOR_RES, DISP_VER_RES);
+        return;
+    }
+    fprintf(stderr, "Display: %s: %s; using the fbdev driver\n", FBDEV_PATH, strerror(errno));
+    fbdev_init();
+    disp_pipeline_init(fbdev_flush, DISP_HOR_RES, DISP_VER_RES);
 }
+#endif
 
 /**
  * hal_init
  * Initialize the LVGL hardware abstraction layer:
- * - fbdev display driver with a single color buffer of size DISP_BUF_SIZE
+ * - Linux framebuffer through disp_pipeline (DISP_BUF_COUNT buffers of
+ *   DISP_BUF_SIZE pixels written by fb_blit in the framebuffer's detected
+ *   format, or a page-flipped framebuffer)
  * - evdev input driver configured as a pointer device (mouse/touch)
+ * - with --headless neither: disp_pipeline flushes into headless.c's memory
+ *   framebuffer and there is no input device (any backend build)
  *
  * Call this once from the main thread before creating LVGL objects.
  */
 void hal_init(void)
 {
+    if (g_headless_listen) {
+        if (headless_init(DISP_HOR_RES, DISP_VER_RES) != 0) {
+            fprintf(stderr, "Headless: no framebuffer: %s\n", strerror(errno));
+            exit(EXIT_FAILURE);
+        }
+        disp_pipeline_init(headless_flush, DISP_HOR_RES, DISP_VER_RES);
+        return;
+    }
 #ifdef USE_SDL_BACKEND
     /* Initialize SDL-based display (monitor) */
     monitor_init();
 
-    /* Create a display draw buffer (LVGL v8 API) */
-    static lv_disp_draw_buf_t draw_buf;
-    static lv_color_t buf1[DISP_BUF_SIZE];
-    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, DISP_BUF_SIZE);
-
-    /* Create and register display driver */
-    lv_disp_drv_t disp_drv;
-    lv_disp_drv_init(&disp_drv);
-    disp_drv.flush_cb = monitor_flush;   /* SDL/monitor flush */
-    disp_drv.draw_buf = &draw_buf;
-    disp_drv.hor_res = DISP_HOR_RES;     /* or rely on MONITOR_* from lv_drv_conf.h */
-    disp_drv.vert_res = DISP_VER_RES;
-    lv_disp_drv_register(&disp_drv);
+    /* Register the display: DISP_BUF_COUNT draw buffers, SDL/monitor flush
+     * (on the flush worker when DISP_FLUSH_ASYNC). Resolution: DISP_* or rely on
+     * MONITOR_* from lv_drv_conf.h */
+    disp_pipeline_init(monitor_flush, DISP_HOR_RES, DISP_VER_RES);
 
     /* Initialize SDL-based input devices */
     mouse_init();
@@ -374,7 +662,7 @@ void hal_init(void)
     lv_indev_drv_init(&indev_drv);
     indev_drv.type = LV_INDEV_TYPE_POINTER;
     indev_drv.read_cb = mouse_read;
-    lv_indev_drv_register(&indev_drv);
+    g_pointer_indev = lv_indev_drv_register(&indev_drv);
 
     /* Register keyboard as a keypad device (optional) */
     lv_indev_drv_init(&indev_drv);
@@ -389,29 +677,164 @@ void hal_init(void)
     lv_indev_drv_register(&indev_drv);
 #else
     // Initialize display driver (Linux framebuffer)
-    fbdev_init();
+#if DISP_RENDER_MODE == DISP_RENDER_FLIP
+    // Render straight into a double-height framebuffer and pan between pages
+    if (disp_pipeline_init_flip(FBDEV_PATH, DISP_HOR_RES, DISP_VER_RES) == NULL) {
+        fprintf(stderr, "Display: page flipping unavailable; using partial refresh\n");
+        fb_display_init();
+    }
+#else
+    fb_display_init();
+#endif
 
-    // Create a display draw buffer (LVGL v8 API)
-    static lv_disp_draw_buf_t draw_buf;
-    static lv_color_t buf1[DISP_BUF_SIZE];
-    lv_disp_draw_buf_init(&draw_buf, buf1, NULL, DISP_BUF_SIZE);
-
-    // Create and register display driver
-    lv_disp_drv_t disp_drv;
-    lv_disp_drv_init(&disp_drv);
-    disp_drv.flush_cb = fbdev_flush;
-    disp_drv.draw_buf = &draw_buf;
-    disp_drv.hor_res = DISP_HOR_RES;
-    disp_drv.vert_res = DISP_VER_RES;
-    lv_disp_drv_register(&disp_drv);
-
-    // Initialize input driver (mouse/touch via evdev)
-    evdev_init();
+    // Initialize input driver (mouse/touch via evdev; threaded mode: input thread)
     lv_indev_drv_t indev_drv;
     lv_indev_drv_init(&indev_drv);
     indev_drv.type = LV_INDEV_TYPE_POINTER;
-    indev_drv.read_cb = evdev_read;
-    lv_indev_drv_register(&indev_drv);
+    if (g_threaded && input_thread_start(EVDEV_NAME, lv_disp_get_hor_res(NULL), lv_disp_get_ver_res(NULL)) == 0) {
+        indev_drv.read_cb = input_thread_read;
+    } else {
+        if (g_threaded) fprintf(stderr, "Input: no input thread on %s: %s; polling\n", EVDEV_NAME, strerror(errno));
+        evdev_init();
+#ifdef USE_TICKLESS
+        // The threaded loop has no evdev wake fd: keep LVGL's periodic poll there
+        indev_drv.read_cb = g_threaded ? evdev_read : tickless_evdev_read;
+#else
+        indev_drv.read_cb = evdev_read;
+#endif
+    }
+    g_pointer_indev = lv_indev_drv_register(&indev_drv);
+#endif
+}
+
+#ifdef USE_TICKLESS
+/**
+ * Tickless input handling (fbdev/evdev backend)
+ *
+ * LVGL polls input devices from a 30 ms timer, which would keep the loop awake
+ * forever. In tickless mode that timer is paused while the pointer is idle; a
+ * second, wake-only descriptor on EVDEV_NAME sits in the epoll set and resumes
+ * the read timer as soon as the kernel queues an event. Each open evdev fd gets
+ * its own copy of the event stream, so draining the wake fd does not steal
+ * events from lv_drivers' evdev_read.
+ */
+#ifndef TICKLESS_INPUT_IDLE_MS
+#define TICKLESS_INPUT_IDLE_MS 500  /* keep polling this long after release (gestures, click events) */
+#endif
+
+#ifndef USE_SDL_BACKEND
+static uint32_t g_input_last_active_ms = 0;
+
+static void tickless_evdev_read(lv_indev_drv_t *drv, lv_indev_data_t *data)
+{
+    evdev_read(drv, data);
+    if (data->state == LV_INDEV_STATE_PRESSED) {
+        g_input_last_active_ms = lv_tick_get();
+    } else if (lv_tick_elaps(g_input_last_active_ms) > TICKLESS_INPUT_IDLE_MS && drv->read_timer) {
+        lv_timer_pause(drv->read_timer);
+    }
+}
+
+static void tickless_input_ready_cb(int fd, void *user)
+{
+    (void)user;
+    struct input_event evs[16];
+    while (read(fd, evs, sizeof(evs)) > 0) { }  // drain; evdev_read gets its own copy
+
+    if (g_pointer_indev && g_pointer_indev->driver->read_timer) {
+        g_input_last_active_ms = lv_tick_get();
+        lv_timer_resume(g_pointer_indev->driver->read_timer);
+        lv_timer_ready(g_pointer_indev->driver->read_timer);
+    }
+}
+#endif
+
+/**
+ * tickless_start
+ * Set up the epoll loop: data-update channel plus (fbdev builds) the evdev wake fd.
+ * Returns 0 on success, -1 if the loop could not be created.
+ */
+static int tickless_start(void)
+{
+    if (event_loop_init(loop_data_notify_cb, NULL) != 0) return -1;
+    // Render whatever was published before the loop existed
+    update_display_timer_cb(NULL);
+#ifndef USE_SDL_BACKEND
+    if (g_headless_listen) return 0; // no input device
+    int wake_fd = open(EVDEV_NAME, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (wake_fd >= 0 && event_loop_add_fd(wake_fd, tickless_input_ready_cb, NULL) == 0) {
+        g_input_last_active_ms = lv_tick_get();
+    } else {
+        // Without a wake fd, keep LVGL's periodic input polling
+        if (wake_fd >= 0) close(wake_fd);
+        fprintf(stderr, "Tickless: cannot watch %s; input stays polled\n", EVDEV_NAME);
+    }
+#endif
+    return 0;
+}
+#endif /* USE_TICKLESS */
+
+// Event loop notification: a sensor worker published (tickless and threaded loops)
+static void loop_data_notify_cb(void *user)
+{
+    (void)user;
+    update_display_timer_cb(NULL);
+}
+
+/**
+ * Threaded mode (--threaded)
+ *
+ * Ownership contract: LVGL, every object, timer and driver callback included,
+ * belongs to exactly one thread at a time. main() builds everything, then
+ * creates the render thread; pthread_create() is the hand-over and main()
+ * touches nothing afterwards. From then on:
+ *   render thread   the only caller of lv_*: runs lv_timer_handler() in the
+ *                   epoll event loop (event_loop.h), the pointer read_cb and
+ *                   update_display_data(); sleeps until LVGL's next deadline,
+ *                   a sensor publish or queued input
+ *   input thread    blocks on the evdev fd and queues pointer transitions in a
+ *                   lock-free ring (input_thread.h); no LVGL
+ *   flush worker    copies finished draw buffers while the next one renders
+ *                   (disp_pipeline.h); only lv_disp_flush_ready()
+ *   sensor workers, telemetry sender, sample log
+ *                   publish through snapshots and history and wake the render
+ *                   thread with event_loop_notify(); no LVGL
+ * Each thread applies its role's --affinity / --priority (thread_policy.h) at
+ * start. In non-tickless builds the 1 ms tick thread keeps running.
+ *
+ * Returns only on failure, -1 with errno set; the caller keeps LVGL then.
+ */
+static void *render_thread(void *arg)
+{
+    (void)arg;
+    thread_policy_apply(THREAD_ROLE_RENDER);
+    event_loop_run(); // never returns
+    return NULL;
+}
+
+static int threaded_run(void)
+{
+#ifdef USE_SDL_BACKEND
+    // SDL's window and event pump stay on the thread that created them
+    errno = ENOTSUP;
+    return -1;
+#else
+    if (event_loop_init(loop_data_notify_cb, NULL) != 0) return -1;
+    // Render whatever was published before the loop existed
+    update_display_timer_cb(NULL);
+    if (g_pointer_indev && g_pointer_indev->driver->read_cb == input_thread_read &&
+        input_thread_watch(g_pointer_indev) != 0) {
+        fprintf(stderr, "Input: cannot watch the input queue (%s); input stays polled\n", strerror(errno));
+    }
+
+    pthread_t tid;
+    int rc = pthread_create(&tid, NULL, render_thread, NULL);
+    if (rc != 0) {
+        errno = rc;
+        return -1;
+    }
+    pthread_join(tid, NULL);
+    return 0;
 #endif
 }
 
@@ -432,283 +855,483 @@ void *lvgl_tick_thread(void *arg)
 }
 
 /**
- * api_update_thread
- * POSIX thread entry point that periodically fetches weather data and requests
- * a UI update.
- *
- * WARNING: LVGL is not thread-safe. This demo calls lv_label_set_text directly
- * from this thread via update_display_data for brevity. Prefer handing off data
- * to the GUI thread via lv_timer, lv_async_call, or a thread-safe queue.
- *
- * arg: unused
- * returns: NULL
+ * sensor_sample_published
+ * Registry callback, runs on the sampling worker after every publish. Feeds
+ * the primary sensor's history, appends the raw ADC values to the sample log,
+ * queues the sample for telemetry (one event per quantity, sensor_id =
+ * registry index) and wakes the tickless GUI loop; never touches LVGL objects.
  */
-void *api_update_thread(void *arg)
+static void sensor_sample_published(unsigned index, const sensor_sample_t *sample, void *user)
 {
-    // Allow override of I2C path via env or argv (argv not available here; we use env only)
-#if BME_FEATURE
-    const char *env_path = getenv("BME280_I2C_DEV");
-    const char *i2c_path = g_cli_i2c_path ? g_cli_i2c_path : (env_path && env_path[0] ? env_path : BME280_I2C_DEV);
-#endif
-    while(1) {
-#if BME_FEATURE
-        static int bme_tried = 0;
-        if (!bme_tried) {
-            if (bme280_init_linux(i2c_path) == 0) {
-                printf("BME280 initialized over I2C at %s (addr 0x%02X)\n", i2c_path, (unsigned)bme_get_addr());
-            } else {
-                printf("BME280 not found on %s; sensor data unavailable.\n", i2c_path);
+    (void)user;
+    if (sample->valid) {
+        sample_log_append(index, sample->time_s, sample->adc_T, sample->adc_P, sample->adc_H,
+                          sensor_registry_calib_raw(index));
+
+        sensors_event_t ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.version = sizeof(ev);
+        ev.sensor_id = (int32_t)index;
+        ev.timestamp = (uint64_t)sample->time_s * 1000u;
+        ev.type = SENSOR_TYPE_AMBIENT_TEMPERATURE;
+        ev.value.temperature = sample->temperature;
+        telemetry_push(&ev);
+        ev.type = SENSOR_TYPE_PRESSURE;
+        ev.value.pressure = sample->pressure;
+        telemetry_push(&ev);
+        ev.type = SENSOR_TYPE_RELATIVE_HUMIDITY;
+        ev.value.relative_humidity = sample->humidity;
+        telemetry_push(&ev);
+        if (g_derived) {
+            // Derived metrics as TELEMETRY_TYPE_* records; NaN ones are left out
+            const derived_values_t *d = &sample->derived;
+            const struct { int type; float value; } dv[] = {
+                { TELEMETRY_TYPE_DEW_POINT, d->dew_point }, { TELEMETRY_TYPE_HEAT_INDEX, d->heat_index },
+                { TELEMETRY_TYPE_SEA_LEVEL, d->sea_level }, { TELEMETRY_TYPE_TENDENCY_3H, d->tendency_3h },
+            };
+            for (unsigned k = 0; k < sizeof(dv) / sizeof(dv[0]); ++k) {
+                if (isnan(dv[k].value)) continue;
+                ev.type = dv[k].type;
+                ev.value.data[0] = dv[k].value;
+                telemetry_push(&ev);
             }
-            bme_tried = 1;
         }
-#endif
-        float t = NAN, p = NAN, h = NAN;
-        int inc_ok = 0, inc_err = 0;
-        int last_is_bme = 0;
-#if BME_FEATURE
-        if (bme_is_inited()) {
-            if (bme280_read_raw(&t, &p, &h) != 0) {
-                // if a read fails, keep values as NAN
-                t = NAN; p = NAN; h = NAN;
-                inc_err = 1;
-                last_is_bme = 0;
-             } else {
-                inc_ok = 1;
-                last_is_bme = 1;
-             }
-        } else {
-            last_is_bme = 0;
+    }
+    if (index == 0 && sample->valid) {
+        const float v[HISTORY_CH_COUNT] = { sample->temperature, sample->pressure, sample->humidity };
+        history_insert(&g_history, sample->time_s, v);
+    }
+    event_loop_notify(); // no-op outside tickless builds
+}
+
+/* Add the shared card style and the tint style of color/opa to obj (a local
+ * style once UI_STYLE_TINTS pairs are in use) */
+static void card_style_apply(lv_obj_t *obj, lv_color_t color, lv_opa_t opa)
+{
+    if (!g_style_card_ready) {
+        lv_style_init(&g_style_card);
+        lv_style_set_radius(&g_style_card, 10);
+        lv_style_set_pad_all(&g_style_card, CARD_PAD);
+        g_style_card_ready = 1;
+    }
+    lv_obj_add_style(obj, &g_style_card, LV_PART_MAIN);
+
+    for (unsigned i = 0; i < g_style_tint_count; ++i) {
+        if (lv_color_to32(g_style_tint[i].color) == lv_color_to32(color) && g_style_tint[i].opa == opa) {
+            lv_obj_add_style(obj, &g_style_tint[i].style, LV_PART_MAIN);
+            return;
         }
-#else
-        // No BME feature compiled in
-        last_is_bme = 0;
-#endif
-        char ts[sizeof current_data.time_str];
-        get_current_time(ts, sizeof(ts));
-
-        pthread_mutex_lock(&current_data_mutex);
-        current_data.temperature = t;
-        current_data.pressure = p;
-        current_data.humidity = h;
-        strncpy(current_data.time_str, ts, sizeof(current_data.time_str));
-        current_data.time_str[sizeof(current_data.time_str) - 1] = '\0';
-        g_last_source_is_bme = last_is_bme;
-#if BME_FEATURE
-        if (inc_ok) g_bme_ok++;
-        if (inc_err) g_bme_err++;
-#endif
-        pthread_mutex_unlock(&current_data_mutex);
+    }
+    if (g_style_tint_count == UI_STYLE_TINTS) {
+        lv_obj_set_style_bg_color(obj, color, LV_PART_MAIN);
+        lv_obj_set_style_bg_opa(obj, opa, LV_PART_MAIN);
+        return;
+    }
+    lv_style_t *style = &g_style_tint[g_style_tint_count].style;
+    g_style_tint[g_style_tint_count].color = color;
+    g_style_tint[g_style_tint_count].opa = opa;
+    g_style_tint_count++;
+    lv_style_init(style);
+    lv_style_set_bg_color(style, color);
+    lv_style_set_bg_opa(style, opa);
+    lv_obj_add_style(obj, style, LV_PART_MAIN);
+}
 
-        sleep(SENSOR_REFRESH_SEC);
+/* Add the shared value text style of font to obj (local past UI_STYLE_FONTS) */
+static void text_style_apply(lv_obj_t *obj, const lv_font_t *font)
+{
+    for (unsigned i = 0; i < g_style_text_count; ++i) {
+        if (g_style_text[i].font == font) {
+            lv_obj_add_style(obj, &g_style_text[i].style, LV_PART_MAIN);
+            return;
+        }
     }
-    return NULL;
+    if (g_style_text_count == UI_STYLE_FONTS) {
+        lv_obj_set_style_text_font(obj, font, LV_PART_MAIN);
+        lv_obj_set_style_text_align(obj, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN);
+        return;
+    }
+    lv_style_t *style = &g_style_text[g_style_text_count].style;
+    g_style_text[g_style_text_count].font = font;
+    g_style_text_count++;
+    lv_style_init(style);
+    lv_style_set_text_font(style, font);
+    lv_style_set_text_align(style, LV_TEXT_ALIGN_CENTER);
+    lv_obj_add_style(obj, style, LV_PART_MAIN);
+}
+
+/**
+ * card_create
+ * Build one card from a template. title overrides tpl->title when non-NULL.
+ * With the fixed layout the fields are placed left to right (wrapping when a
+ * row is full) into a row of exactly their size, and the text label is one
+ * clipped line of the card's inner width, so nothing is sized by content.
+ */
+static void card_create(card_t *card, lv_obj_t *parent, const card_template_t *tpl,
+                        const char *title, lv_coord_t w, lv_coord_t h)
+{
+    const lv_coord_t inner_w = w - 2 * CARD_PAD;
+    card->obj = lv_obj_create(parent);
+    lv_obj_set_size(card->obj, w, h);
+    card_style_apply(card->obj, tpl->color, LV_OPA_20);
+    if (g_layout_fixed) {
+        lv_obj_clear_flag(card->obj, LV_OBJ_FLAG_SCROLLABLE);
+    } else {
+        lv_obj_set_flex_flow(card->obj, LV_FLEX_FLOW_COLUMN);
+        lv_obj_set_flex_grow(card->obj, 1);
+    }
+
+    card->title = lv_label_create(card->obj);
+    lv_label_set_text(card->title, title ? title : tpl->title);
+    if (g_layout_fixed) {
+        lv_label_set_long_mode(card->title, LV_LABEL_LONG_CLIP);
+        lv_obj_set_width(card->title, inner_w);
+        lv_obj_set_style_text_align(card->title, LV_TEXT_ALIGN_CENTER, LV_PART_MAIN);
+    }
+    lv_obj_align(card->title, LV_ALIGN_TOP_MID, 0, 0);
+
+    if (tpl->field_count) {
+        card->row = lv_obj_create(card->obj);
+        lv_obj_remove_style_all(card->row);
+        if (!g_layout_fixed) {
+            lv_obj_set_size(card->row, LV_PCT(100), LV_SIZE_CONTENT);
+            lv_obj_set_flex_flow(card->row, LV_FLEX_FLOW_ROW_WRAP);
+            lv_obj_set_style_pad_column(card->row, CARD_FIELD_GAP, LV_PART_MAIN);
+        }
+        lv_coord_t x = 0, y = 0, line_h = 0, row_w = 0;
+        for (unsigned i = 0; i < tpl->field_count && i < CARD_FIELDS_MAX; ++i) {
+            const card_field_t *f = &tpl->fields[i];
+            num_label_t *nl = num_label_create(card->row, tpl->font, f->int_digits, f->frac_digits, f->unit);
+            if (!nl) continue;
+            card->field[card->field_count++] = nl;
+            if (!g_layout_fixed) continue;
+            lv_obj_t *o = num_label_obj(nl);
+            lv_coord_t fw = lv_obj_get_style_width(o, LV_PART_MAIN);
+            lv_coord_t fh = lv_obj_get_style_height(o, LV_PART_MAIN);
+            if (x > 0 && x + fw > inner_w) { y += line_h; x = 0; line_h = 0; }
+            lv_obj_set_pos(o, x, y);
+            if (x + fw > row_w) row_w = x + fw;
+            if (fh > line_h) line_h = fh;
+            x += fw + CARD_FIELD_GAP;
+        }
+        if (g_layout_fixed) {
+            lv_obj_set_size(card->row, row_w, y + line_h);
+            lv_obj_align(card->row, LV_ALIGN_BOTTOM_MID, 0, 0);
+        }
+    }
+    if (tpl->placeholder) {
+        card->value = lv_label_create(card->obj);
+        snprintf(card->text, sizeof(card->text), "%s", tpl->placeholder);
+        lv_label_set_text_static(card->value, card->text);
+        text_style_apply(card->value, tpl->font);
+        if (g_layout_fixed) {
+            lv_label_set_long_mode(card->value, LV_LABEL_LONG_CLIP);
+            lv_obj_set_size(card->value, inner_w, lv_font_get_line_height(tpl->font));
+        }
+        lv_obj_align(card->value, LV_ALIGN_BOTTOM_MID, 0, 0);
+        if (card->row) lv_obj_add_flag(card->row, LV_OBJ_FLAG_HIDDEN);
+    }
+}
+
+/* Show a text in the card's label (hiding its fields); only when it changed */
+static void card_set_value(card_t *card, const char *text)
+{
+    if (!card->value) return;
+    if (card->row && !lv_obj_has_flag(card->row, LV_OBJ_FLAG_HIDDEN)) {
+        lv_obj_add_flag(card->row, LV_OBJ_FLAG_HIDDEN);
+        lv_obj_clear_flag(card->value, LV_OBJ_FLAG_HIDDEN);
+    }
+    if (strcmp(card->text, text) == 0) return;
+    snprintf(card->text, sizeof(card->text), "%s", text);
+    lv_label_set_text_static(card->value, card->text);
+}
+
+/* Show one value per field (NaN: "--"), hiding the text label; fields only
+ * redraw the digits that changed */
+static void card_set_fields(card_t *card, const float *v)
+{
+    if (!card->row) return;
+    if (lv_obj_has_flag(card->row, LV_OBJ_FLAG_HIDDEN)) {
+        lv_obj_clear_flag(card->row, LV_OBJ_FLAG_HIDDEN);
+        if (card->value) lv_obj_add_flag(card->value, LV_OBJ_FLAG_HIDDEN);
+    }
+    for (unsigned i = 0; i < card->field_count; ++i) num_label_set_float(card->field[i], v[i]);
+}
+
+/**
+ * clock_timer_cb
+ * Refresh the time card and re-arm for the next minute boundary, so the
+ * clock neither lags by up to a minute nor wakes the GUI thread every second.
+ */
+static void clock_timer_cb(lv_timer_t *timer)
+{
+    char time_str[32];
+    get_current_time(time_str, sizeof(time_str));
+    card_set_value(&g_cards[CARD_TIME], time_str[0] ? time_str : "--:--");
+    mem_stats_sample_lvgl(); // LVGL heap statistics for the stats dump, once a minute
+
+    time_t now = time(NULL);
+    lv_timer_set_period(timer, (uint32_t)(60 - now % 60) * 1000u);
 }
 
 /**
  * update_display_data
- * Format the current_data fields and set the corresponding LVGL labels.
+ * Show one published sensor sample on its cards. Index 0 drives the primary
+ * cards and the source label; every sensor also has its compact card when
+ * more than one is configured.
  *
  * Formatting Rules
- * - If a value is NaN, show "--" for that metric. Consider using NaN to
- *   differentiate an actual zero-valued reading from "unknown".
+ * - If a value is NaN, show "--" for that metric, so an actual zero-valued
+ *   reading stays distinguishable from "unknown".
+ * - Numbers are fixed-point fields (num_label.h): no printf formatting and
+ *   only changed digit cells are redrawn.
  *
  * Thread-safety
- * - Should be called from the GUI thread in production. See the top-of-file
- *   notes for approaches to marshal updates safely.
+ * - GUI thread only (called from update_display_timer_cb).
  */
-void update_display_data(void)
+void update_display_data(unsigned index, const sensor_sample_t *sample)
 {
-    char temp_str[32];
-    char pressure_str[32];
-    char humidity_str[32];
-    char time_str[32];
-
-    // Take a thread-safe snapshot of the latest data
-    float t, p, h;
-    int last_is_bme_snapshot = 0;
-    unsigned long bme_ok_snapshot = 0;
-    unsigned long bme_err_snapshot = 0;
-    pthread_mutex_lock(&current_data_mutex);
-    t = current_data.temperature;
-    p = current_data.pressure;
-    h = current_data.humidity;
-    strncpy(time_str, current_data.time_str, sizeof(time_str));
-    time_str[sizeof(time_str) - 1] = '\0';
-    last_is_bme_snapshot = g_last_source_is_bme;
-#if BME_FEATURE
-    bme_ok_snapshot = g_bme_ok;
-    bme_err_snapshot = g_bme_err;
-#endif
-    pthread_mutex_unlock(&current_data_mutex);
-
-    // Format temperature
-    if (!isnan(t)) {
-        snprintf(temp_str, sizeof(temp_str), "%.1f °C", t);
-    } else {
-        strcpy(temp_str, "-- °C");
+    const float v[CARD_FIELDS_MAX] = { sample->temperature, sample->pressure, sample->humidity };
+
+    if (index == 0) {
+        card_set_fields(&g_cards[CARD_TEMPERATURE], &v[0]);
+        card_set_fields(&g_cards[CARD_PRESSURE], &v[1]);
+        card_set_fields(&g_cards[CARD_HUMIDITY], &v[2]);
+        if (g_derived) {
+            const derived_values_t *d = &sample->derived;
+            card_set_fields(&g_derived_cards[CARD_DEW_POINT], &d->dew_point);
+            card_set_fields(&g_derived_cards[CARD_HEAT_INDEX], &d->heat_index);
+            card_set_fields(&g_derived_cards[CARD_SEA_LEVEL], &d->sea_level);
+            card_set_fields(&g_derived_cards[CARD_TENDENCY], &d->tendency_3h);
+        }
     }
 
-    // Format pressure
-    if (!isnan(p)) {
-        snprintf(pressure_str, sizeof(pressure_str), "%.0f hPa", p);
-    } else {
-        strcpy(pressure_str, "-- hPa");
+    if (index < g_sensor_card_count) {
+        if (sample->valid) card_set_fields(&g_sensor_cards[index], v);
+        else card_set_value(&g_sensor_cards[index], sample->online ? "read error" : "offline");
     }
+}
 
-    // Format humidity
-    if (!isnan(h)) {
-        snprintf(humidity_str, sizeof(humidity_str), "%.1f %%", h);
+/* Source label: primary sensor status, or how many sensors are online */
+static void update_source_label(void)
+{
+    if (!g_source_label_ref) return;
+#if BME_FEATURE
+    char srcbuf[64];
+    unsigned n = sensor_registry_count();
+    const sensor_sample_t *p = sensor_registry_latest(0);
+    if (n == 0 || !p) {
+        snprintf(srcbuf, sizeof(srcbuf), "Source: no sensor configured");
+    } else if (n > 1) {
+        unsigned online = 0;
+        for (unsigned i = 0; i < n; ++i) online += sensor_registry_latest(i)->valid;
+        snprintf(srcbuf, sizeof(srcbuf), "Source: %u/%u BME280 online", online, n);
+    } else if (p->valid) {
+        snprintf(srcbuf, sizeof(srcbuf), "Source: BME280 (ok=%lu err=%lu)", p->ok, p->err);
+    } else if (p->online) {
+        snprintf(srcbuf, sizeof(srcbuf), "Source: BME280 (read error, err=%lu)", p->err);
     } else {
-        strcpy(humidity_str, "-- %");
+        snprintf(srcbuf, sizeof(srcbuf), "Source: BME280 unavailable");
     }
-
-    // Format time (if available)
-    const char *time_to_show = (time_str[0] != '\0') ? time_str : "--:--";
-
-    // Update labels. NOTE: LVGL APIs are not thread-safe; this is called on GUI thread via lv_timer.
-    lv_label_set_text(temp_label, temp_str);
-    lv_label_set_text(pressure_label, pressure_str);
-    lv_label_set_text(humidity_label, humidity_str);
-    lv_label_set_text(time_label, time_to_show);
-    
-    // Update source label
-    if (g_source_label_ref) {
-#if BME_FEATURE
-        if (bme_is_inited() && last_is_bme_snapshot) {
-            char srcbuf[64];
-            snprintf(srcbuf, sizeof(srcbuf), "Source: BME280 (ok=%lu err=%lu)", bme_ok_snapshot, bme_err_snapshot);
-            lv_label_set_text(g_source_label_ref, srcbuf);
-        } else if (bme_is_inited()) {
-            char srcbuf[64];
-            snprintf(srcbuf, sizeof(srcbuf), "Source: BME280 (read error, err=%lu)", bme_err_snapshot);
-            lv_label_set_text(g_source_label_ref, srcbuf);
-        } else {
-            lv_label_set_text(g_source_label_ref, "Source: BME280 unavailable");
-        }
+    label_set_text_if_changed(g_source_label_ref, srcbuf);
 #else
-        lv_label_set_text(g_source_label_ref, "Source: BME280 disabled at build time");
+    label_set_text_if_changed(g_source_label_ref, "Source: BME280 disabled at build time");
 #endif
-    }
 }
 
 /**
  * update_display_timer_cb
  * LVGL timer callback that runs on the GUI thread to refresh label text.
+ *
+ * Each device is one atomic load when it has not published since the last
+ * call; only cards of devices with a new sample are re-rendered. Picking up a
+ * snapshot never waits for a sampling worker.
  */
 void update_display_timer_cb(lv_timer_t *timer)
 {
     (void)timer;
-    update_display_data();
+    trend_chart_refresh();
+    int changed = 0;
+    for (unsigned i = 0, n = sensor_registry_count(); i < n; ++i) {
+        const sensor_sample_t *sample = sensor_registry_poll(i);
+        if (!sample) continue;
+        update_display_data(i, sample);
+        changed = 1;
+    }
+    static int first = 1;
+    if (changed || first) update_source_label();
+    first = 0;
 }
 
-// Dummy API functions removed: data now only comes from BME280 (if available) and system clock
-
 /**
- * get_current_time
- * Format the current local time as HH:MM (24-hour clock).
- *
- * time_str: destination buffer where the formatted time is written
- * size:     size of the destination buffer
- *
- * Note: localtime() is not thread-safe. For multi-threaded usage prefer
- * localtime_r() where available.
+ * Statistics overlay (--stats-overlay)
+ * A small label on the top layer refreshed once per second from perf_stats.
+ * Off by default: its timer would otherwise keep waking the GUI thread.
  */
-void get_current_time(char *time_str, size_t size)
+#ifndef STATS_OVERLAY_PERIOD_MS
+#define STATS_OVERLAY_PERIOD_MS 1000
+#endif
+
+static void stats_overlay_timer_cb(lv_timer_t *timer)
 {
-    time_t rawtime;
-    struct tm timeinfo;
+    char buf[256];
+    perf_stats_format_overlay(buf, sizeof(buf));
+    label_set_text_if_changed((lv_obj_t *)timer->user_data, buf);
+    mem_stats_sample_lvgl();
+}
 
-    time(&rawtime);
-    localtime_r(&rawtime, &timeinfo);
-    strftime(time_str, size, "%H:%M", &timeinfo);
+static void stats_overlay_create(void)
+{
+    lv_obj_t *label = lv_label_create(lv_layer_top());
+    lv_obj_set_style_bg_color(label, lv_color_black(), LV_PART_MAIN);
+    lv_obj_set_style_bg_opa(label, LV_OPA_70, LV_PART_MAIN);
+    lv_obj_set_style_text_color(label, lv_color_white(), LV_PART_MAIN);
+    lv_obj_set_style_pad_all(label, 4, LV_PART_MAIN);
+    lv_obj_align(label, LV_ALIGN_TOP_RIGHT, -4, 4);
+    lv_label_set_text(label, "stats: --");
+    lv_timer_create(stats_overlay_timer_cb, STATS_OVERLAY_PERIOD_MS, label);
 }
 
-/* Minimal BME280 state and helpers (Linux I2C). Falls back to dummy API if unavailable. */
-#ifdef __linux__
-#if BME_FEATURE
-static I2CDevice g_i2c_dev = { .fd = -1 };
-static bme280_t g_bme_dev;
-static int bme_inited = 0;
-static uint8_t bme_addr = 0;
-/* g_bme_ok/g_bme_err are defined at the top-level (one definition only) */
-
-static int bme_bus_read(void *user, uint8_t reg, uint8_t *buf, size_t len) {
-    I2CDevice *dev = (I2CDevice *)user;
-    return i2c_device_read_reg(dev, reg, buf, len, 1) == 0 ? 0 : BME280_E_COMM;
+/**
+ * Pressure trend chart
+ * Plots the mean of closed history buckets for the selected range; tapping the
+ * card cycles 3 h / 24 h / 7 d. The series is shifted in place with
+ * lv_chart_set_next_value, so a refresh only appends buckets closed since the
+ * last one. The series is refilled only when the range changes.
+ */
+typedef struct {
+    const char *title;
+    history_tier_t tier;
+    uint16_t points;
+} trend_range_t;
+
+static const trend_range_t g_trend_ranges[] = {
+    { "Pressure, 3 h (tap to change)",  HISTORY_TIER_1MIN,  180 },
+    { "Pressure, 24 h (tap to change)", HISTORY_TIER_15MIN, 96 },
+    { "Pressure, 7 d (tap to change)",  HISTORY_TIER_1H,    168 },
+};
+
+static lv_obj_t *g_trend_chart = NULL;
+static lv_obj_t *g_trend_title = NULL;
+static lv_chart_series_t *g_trend_series = NULL;
+static unsigned g_trend_range = 0;
+static uint32_t g_trend_next = 0;            // next bucket index to append
+static lv_coord_t g_trend_min = 0, g_trend_max = 0;
+
+static void trend_chart_select(unsigned range)
+{
+    const trend_range_t *r = &g_trend_ranges[range];
+    g_trend_range = range;
+    lv_label_set_text(g_trend_title, r->title);
+    lv_chart_set_point_count(g_trend_chart, r->points);
+    lv_chart_set_all_value(g_trend_chart, g_trend_series, LV_CHART_POINT_NONE);
+    uint32_t closed = history_closed(&g_history, r->tier);
+    g_trend_next = closed > r->points ? closed - r->points : 0;
+    trend_chart_refresh();
 }
 
-static int bme_bus_write(void *user, uint8_t reg, const uint8_t *buf, size_t len) {
-    I2CDevice *dev = (I2CDevice *)user;
-    return i2c_device_write_reg(dev, reg, buf, len, 1) == 0 ? 0 : BME280_E_COMM;
+static void trend_chart_clicked_cb(lv_event_t *e)
+{
+    (void)e;
+    trend_chart_select((g_trend_range + 1) % (sizeof(g_trend_ranges) / sizeof(g_trend_ranges[0])));
 }
 
-static void bme_bus_delay(void *user, uint32_t ms) {
-    (void)user;
-    usleep(ms * 1000);
+static lv_obj_t *trend_chart_create(lv_obj_t *parent, lv_coord_t w, lv_coord_t h)
+{
+    lv_obj_t *card = lv_obj_create(parent);
+    lv_obj_set_size(card, w, h);
+    card_style_apply(card, COLOR_PRESSURE, LV_OPA_10);
+    lv_obj_set_flex_flow(card, LV_FLEX_FLOW_COLUMN);
+    lv_obj_add_event_cb(card, trend_chart_clicked_cb, LV_EVENT_CLICKED, NULL);
+
+    g_trend_title = lv_label_create(card);
+
+    g_trend_chart = lv_chart_create(card);
+    lv_obj_set_width(g_trend_chart, lv_pct(100));
+    lv_obj_set_flex_grow(g_trend_chart, 1);
+    lv_obj_clear_flag(g_trend_chart, LV_OBJ_FLAG_CLICKABLE); // let taps reach the card
+    lv_chart_set_type(g_trend_chart, LV_CHART_TYPE_LINE);
+    lv_chart_set_update_mode(g_trend_chart, LV_CHART_UPDATE_MODE_SHIFT);
+    lv_chart_set_div_line_count(g_trend_chart, 3, 0);
+    lv_obj_set_style_size(g_trend_chart, 0, LV_PART_INDICATOR); // no point markers
+    g_trend_series = lv_chart_add_series(g_trend_chart, COLOR_PRESSURE, LV_CHART_AXIS_PRIMARY_Y);
+
+    trend_chart_select(0);
+    return card;
 }
 
-static int bme280_init_try_addr(const char *i2c_path, uint8_t addr) {
-    if (i2c_device_open(&g_i2c_dev, i2c_path, addr) != 0) return -1;
-    bme280_bus_t bus = {
-        .read = bme_bus_read,
-        .write = bme_bus_write,
-        .delay_ms = bme_bus_delay,
-        .user = &g_i2c_dev
-    };
-    int rc = bme280_init(&g_bme_dev, &bus, addr);
-    if (rc != BME280_OK) {
-        i2c_device_close(&g_i2c_dev);
-        return -1;
+/* Recompute the Y range from the visible points (only after an append) */
+static void trend_chart_update_range(void)
+{
+    const lv_coord_t *y = lv_chart_get_y_array(g_trend_chart, g_trend_series);
+    uint16_t n = lv_chart_get_point_count(g_trend_chart);
+    lv_coord_t lo = LV_CHART_POINT_NONE, hi = LV_CHART_POINT_NONE;
+    for (uint16_t i = 0; i < n; ++i) {
+        if (y[i] == LV_CHART_POINT_NONE) continue;
+        if (lo == LV_CHART_POINT_NONE || y[i] < lo) lo = y[i];
+        if (hi == LV_CHART_POINT_NONE || y[i] > hi) hi = y[i];
     }
-    /* Configure a simple continuous measurement */
-    bme280_set_oversampling(&g_bme_dev, BME280_OSRS_X1, BME280_OSRS_X1, BME280_OSRS_X1);
-    bme280_set_filter(&g_bme_dev, BME280_FILTER_OFF);
-    bme280_set_standby(&g_bme_dev, BME280_STANDBY_1000_MS);
-    bme280_set_mode(&g_bme_dev, BME280_NORMAL_MODE);
-    pthread_mutex_lock(&current_data_mutex);
-    bme_addr = addr;
-    bme_inited = 1;
-    pthread_mutex_unlock(&current_data_mutex);
-    return 0;
+    if (lo == LV_CHART_POINT_NONE) return;
+    lo -= 5; hi += 5;  // +-0.5 hPa margin (values are hPa * 10)
+    if (lo == g_trend_min && hi == g_trend_max) return;
+    g_trend_min = lo;
+    g_trend_max = hi;
+    lv_chart_set_range(g_trend_chart, LV_CHART_AXIS_PRIMARY_Y, lo, hi);
 }
 
-static int bme280_init_linux(const char *i2c_path) {
-    if (bme_is_inited()) return 0;
-    const uint8_t addrs[] = { BME280_I2C_ADDR_SDO_HIGH, BME280_I2C_ADDR_SDO_LOW };
-    for (size_t i = 0; i < sizeof(addrs)/sizeof(addrs[0]); ++i) {
-        if (bme280_init_try_addr(i2c_path, addrs[i]) == 0) return 0;
+static void trend_chart_refresh(void)
+{
+    if (!g_trend_chart) return;
+    const trend_range_t *r = &g_trend_ranges[g_trend_range];
+    uint32_t closed = history_closed(&g_history, r->tier);
+    if (closed == g_trend_next) return;
+    if (closed - g_trend_next > r->points) g_trend_next = closed - r->points;
+
+    for (; g_trend_next != closed; ++g_trend_next) {
+        history_bucket_t b;
+        lv_coord_t v = LV_CHART_POINT_NONE;
+        if (history_get_bucket(&g_history, r->tier, g_trend_next, HISTORY_CH_PRESSURE, &b) == 0 && b.count)
+            v = (lv_coord_t)lrintf(b.mean * 10.0f);
+        lv_chart_set_next_value(g_trend_chart, g_trend_series, v);
     }
-    return -1;
+    trend_chart_update_range();
 }
 
-static int bme280_read_raw(float *temp_c, float *press_hpa, float *humid_rh) {
-    if (!bme_is_inited()) return -1;
-    bme280_reading_t r;
-    int rc = bme280_read_measurement(&g_bme_dev, &r);
-    if (rc != BME280_OK) return -1;
-    if (temp_c) *temp_c = r.temperature_c;
-    if (press_hpa) *press_hpa = r.pressure_pa / 100.0f; /* Pa -> hPa */
-    if (humid_rh) *humid_rh = r.humidity_rh;
-    return 0;
+/**
+ * label_set_text_if_changed
+ * Set a label's text only when it differs from what is shown. lv_label_set_text
+ * always reallocates the text and invalidates the label, so skipping identical
+ * strings avoids redraws that would produce the same pixels.
+ */
+static void label_set_text_if_changed(lv_obj_t *label, const char *text)
+{
+    if (!label || !text) return;
+    const char *cur = lv_label_get_text(label);
+    if (cur && strcmp(cur, text) == 0) return;
+    lv_label_set_text(label, text);
 }
 
-static int bme_is_inited(void) {
-    int v;
-    pthread_mutex_lock(&current_data_mutex);
-    v = bme_inited;
-    pthread_mutex_unlock(&current_data_mutex);
-    return v;
-}
-static uint8_t bme_get_addr(void) {
-    uint8_t a;
-    pthread_mutex_lock(&current_data_mutex);
-    a = bme_addr;
-    pthread_mutex_unlock(&current_data_mutex);
-    return a;
-}
-#endif /* BME_FEATURE */
-#endif /* __linux__ */
+// Dummy API functions removed: data now only comes from BME280 (if available) and system clock
+
+/**
+ * get_current_time
+ * Format the current local time as HH:MM (24-hour clock).
+ *
+ * time_str: destination buffer where the formatted time is written
+ * size:     size of the destination buffer
+ *
+ * Note: localtime() is not thread-safe. For multi-threaded usage prefer
+ * localtime_r() where available.
+ */
+void get_current_time(char *time_str, size_t size)
+{
+    time_t rawtime;
+    struct tm timeinfo;
 
+    time(&rawtime);
+    localtime_r(&rawtime, &timeinfo);
+    strftime(time_str, size, "%H:%M", &timeinfo);
+}
 
 /* Remove legacy BME280 low-level implementation and duplicate defines */
 // (Old ad-hoc I2C helpers and BME280_REG_* definitions replaced by BME280 driver)
@@ -0,0 +1,99 @@
+#include "mem_pool.h"
+
+#include <errno.h>
+#include <string.h>
+#include "lvgl/lvgl.h"
+
+static pthread_mutex_t g_pools_lock = PTHREAD_MUTEX_INITIALIZER;
+static mem_pool_t *g_pools = NULL;
+
+static pthread_mutex_t g_lvgl_lock = PTHREAD_MUTEX_INITIALIZER;
+static lv_mem_monitor_t g_lvgl_mon;
+static int g_lvgl_sampled = 0;
+
+/* Pools join the dump list on first use, so defining one costs nothing else */
+static void mem_pool_register(mem_pool_t *pool)
+{
+    pthread_mutex_lock(&g_pools_lock);
+    pool->next = g_pools;
+    g_pools = pool;
+    pthread_mutex_unlock(&g_pools_lock);
+}
+
+void *mem_pool_alloc(mem_pool_t *pool)
+{
+    void *block = NULL;
+    int first = 0;
+    pthread_mutex_lock(&pool->lock);
+    if (!pool->registered) {
+        pool->registered = 1;
+        first = 1;
+    }
+    if (pool->free_list) {
+        block = pool->free_list;
+        pool->free_list = *(void **)block;
+    } else if (pool->fresh < pool->capacity) {
+        block = pool->blocks + (size_t)pool->fresh++ * pool->block_size;
+    }
+    if (block) {
+        if (++pool->used > pool->peak) pool->peak = pool->used;
+    } else {
+        pool->failed++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    if (first) mem_pool_register(pool);
+    if (!block) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    memset(block, 0, pool->block_size);
+    return block;
+}
+
+void mem_pool_free(mem_pool_t *pool, void *block)
+{
+    if (!block) return;
+    pthread_mutex_lock(&pool->lock);
+    *(void **)block = pool->free_list;
+    pool->free_list = block;
+    pool->used--;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void mem_stats_sample_lvgl(void)
+{
+    lv_mem_monitor_t mon;
+    lv_mem_monitor(&mon);
+    pthread_mutex_lock(&g_lvgl_lock);
+    g_lvgl_mon = mon;
+    g_lvgl_sampled = 1;
+    pthread_mutex_unlock(&g_lvgl_lock);
+}
+
+void mem_stats_dump_json(FILE *f)
+{
+    lv_mem_monitor_t mon;
+    pthread_mutex_lock(&g_lvgl_lock);
+    mon = g_lvgl_mon;
+    int sampled = g_lvgl_sampled;
+    pthread_mutex_unlock(&g_lvgl_lock);
+
+    fputs("\"mem\":{", f);
+    if (sampled) {
+        fprintf(f, "\"lvgl\":{\"total\":%lu,\"used\":%lu,\"peak\":%lu,\"free_biggest\":%lu,\"frag_pct\":%u},",
+                (unsigned long)mon.total_size, (unsigned long)(mon.total_size - mon.free_size),
+                (unsigned long)mon.max_used, (unsigned long)mon.free_biggest_size, (unsigned)mon.frag_pct);
+    }
+    fputs("\"pools\":{", f);
+    pthread_mutex_lock(&g_pools_lock);
+    for (mem_pool_t *p = g_pools; p; p = p->next) {
+        pthread_mutex_lock(&p->lock);
+        fprintf(f, "%s\"%s\":{\"block\":%lu,\"capacity\":%u,\"used\":%u,\"peak\":%u,\"failed\":%llu}",
+                p == g_pools ? "" : ",", p->name, (unsigned long)p->block_size, p->capacity,
+                p->used, p->peak, (unsigned long long)p->failed);
+        pthread_mutex_unlock(&p->lock);
+    }
+    pthread_mutex_unlock(&g_pools_lock);
+    fputs("}}", f);
+}
@@ -0,0 +1,75 @@
+#ifndef MEM_POOL_H
+#define MEM_POOL_H
+
+/*
+ * Fixed-block pools and memory statistics.
+ *
+ * A pool is a static array of count blocks of one type, defined with
+ * MEM_POOL_DEFINE next to its only user. Allocation takes a block from the
+ * free list (or the next never-used one), freeing pushes it back: O(1), no
+ * libc allocator, no fragmentation, and a hard bound set at build time. A full
+ * pool returns NULL and counts the failure. Pools are thread-safe (one mutex
+ * each; the critical section is a pointer swap).
+ *
+ * The only pool is num_label's widget state (num_label.c); the lv_obj_t it
+ * draws into, like every other LVGL object, style and text, comes from LVGL's
+ * own fixed arena (lv_conf.h: built-in TLSF allocator over LV_MEM_SIZE bytes,
+ * LV_MEM_CUSTOM 0), not from a pool. mem_stats_sample_lvgl()
+ * copies lv_mem_monitor() (used bytes, peak, fragmentation, biggest free
+ * block) for the stats dump; it has to run on the GUI thread.
+ *
+ * mem_stats_dump_json() writes both as the "mem" member of the perf_stats
+ * JSON dump:
+ *   "mem":{"lvgl":{"total":..,"used":..,"peak":..,"free_biggest":..,"frag_pct":..},
+ *          "pools":{"<name>":{"block":..,"capacity":..,"used":..,"peak":..,"failed":..},..}}
+ */
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mem_pool {
+    const char      *name;
+    uint8_t         *blocks;
+    size_t           block_size;
+    unsigned         capacity;
+    pthread_mutex_t  lock;
+    void            *free_list;  /* freed blocks, linked through their first word */
+    unsigned         fresh;      /* blocks [fresh, capacity) were never handed out */
+    unsigned         used, peak;
+    uint64_t         failed;
+    struct mem_pool *next;       /* registered pools, for the stats dump */
+    int              registered;
+} mem_pool_t;
+
+/* static mem_pool_t var holding count blocks of type */
+#define MEM_POOL_DEFINE(var, type, count)                                          \
+    static union { type obj; void *link; max_align_t align; } var##_blocks[count]; \
+    static mem_pool_t var = {                                                      \
+        .name = #var, .blocks = (uint8_t *)var##_blocks,                           \
+        .block_size = sizeof(var##_blocks[0]), .capacity = (count),                \
+        .lock = PTHREAD_MUTEX_INITIALIZER,                                         \
+    }
+
+/* A zeroed block, or NULL (errno ENOMEM) when the pool is exhausted. */
+void *mem_pool_alloc(mem_pool_t *pool);
+
+/* Return a block from mem_pool_alloc(); NULL is ignored. */
+void mem_pool_free(mem_pool_t *pool, void *block);
+
+/* Snapshot LVGL's heap statistics (GUI thread). */
+void mem_stats_sample_lvgl(void);
+
+/* Write "\"mem\":{...}" (no surrounding braces) to f. */
+void mem_stats_dump_json(FILE *f);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEM_POOL_H */
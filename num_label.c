@@ -0,0 +1,344 @@
+#include "num_label.h"
+#include "mem_pool.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_UNIT_MAX 8             /* bytes of a unit string, UTF-8 */
+
+/* Atlas cells: digits first so a digit value is its own glyph index */
+enum {
+    NUM_GLYPH_MINUS = 10,
+    NUM_GLYPH_POINT,
+    NUM_GLYPH_COUNT,
+    NUM_GLYPH_NONE = 0xFF
+};
+
+typedef struct {
+    char          text[NUM_UNIT_MAX];
+    lv_img_dsc_t  img;
+} num_unit_t;
+
+typedef struct {
+    const lv_font_t *font;
+    lv_color_t    color;
+    lv_coord_t    cell_w;          /* widest digit: every digit/minus cell */
+    lv_coord_t    point_w;
+    lv_coord_t    h;               /* font line height */
+    lv_img_dsc_t  glyph[NUM_GLYPH_COUNT];
+    num_unit_t    unit[NUM_ATLAS_UNITS];
+    unsigned      unit_count;
+} num_atlas_t;
+
+struct num_label {
+    lv_obj_t        *obj;
+    num_atlas_t     *atlas;
+    const num_unit_t *unit;        /* NULL: no unit */
+    uint8_t          int_digits;
+    uint8_t          frac_digits;
+    uint8_t          known;        /* showing a value that fits: decimal point drawn */
+    int32_t          scale;        /* 10^frac_digits */
+    int32_t          value;
+    uint8_t          cell[NUM_LABEL_MAX_CELLS]; /* glyph per digit cell, NUM_GLYPH_NONE = blank */
+};
+
+static num_atlas_t g_atlas[NUM_ATLAS_MAX];
+static unsigned g_atlas_count = 0;
+
+/* Widget state comes and goes with sensor cards: fixed blocks, not malloc.
+ * The widget's lv_obj_t is LVGL's (its arena, lv_conf.h). */
+MEM_POOL_DEFINE(num_label_pool, struct num_label, NUM_LABEL_POOL);
+
+// ===== Atlas =====
+
+/* Next code point of a UTF-8 string; advances *s */
+static uint32_t num_utf8_next(const char **s) {
+    const uint8_t *p = (const uint8_t *)*s;
+    uint32_t c = *p++;
+    int extra = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : c >= 0xC0 ? 1 : 0;
+    if (extra) c &= 0x3Fu >> extra;
+    while (extra-- && (*p & 0xC0) == 0x80) c = (c << 6) | (*p++ & 0x3Fu);
+    *s = (const char *)p;
+    return c;
+}
+
+static void num_put_px(uint8_t *px, lv_color_t color, lv_opa_t opa) {
+#if LV_COLOR_DEPTH == 32
+    color.ch.alpha = opa;
+    memcpy(px, &color, sizeof(color));
+#else
+    memcpy(px, &color, LV_COLOR_SIZE / 8);
+    px[LV_COLOR_SIZE / 8] = opa;
+#endif
+}
+
+/* Rasterize one glyph into a TRUE_COLOR_ALPHA buffer of w x h pixels with its
+ * pen at x; overlapping coverage (kerned pairs) keeps the stronger pixel.
+ * Returns the advance width. */
+static lv_coord_t num_render_glyph(const num_atlas_t *a, uint8_t *buf, lv_coord_t w, lv_coord_t x,
+                                   uint32_t letter, uint32_t next) {
+    lv_font_glyph_dsc_t g;
+    if (!lv_font_get_glyph_dsc(a->font, &g, letter, next)) return 0;
+    const uint8_t *bmp = lv_font_get_glyph_bitmap(a->font, letter);
+    if (!bmp || g.bpp == 0) return (lv_coord_t)g.adv_w;
+
+    uint32_t bpp = g.bpp == 3 ? 4 : g.bpp; /* as lv_draw_sw_letter: 3 bpp bitmaps are unpacked to 4 */
+    uint32_t max = (1u << bpp) - 1u;
+    lv_coord_t x0 = x + g.ofs_x;
+    lv_coord_t y0 = (lv_coord_t)(a->font->line_height - a->font->base_line) - (lv_coord_t)g.box_h - g.ofs_y;
+    uint32_t bit = 0;
+    for (lv_coord_t row = 0; row < (lv_coord_t)g.box_h; ++row) {
+        for (lv_coord_t col = 0; col < (lv_coord_t)g.box_w; ++col, bit += bpp) {
+            lv_coord_t px = x0 + col, py = y0 + row;
+            if (px < 0 || px >= w || py < 0 || py >= a->h) continue;
+            uint32_t v = (bmp[bit >> 3] >> (8u - bpp - (bit & 7u))) & max; /* rows are packed back to back */
+            lv_opa_t opa = (lv_opa_t)(v * 255u / max);
+            uint8_t *p = buf + ((size_t)py * w + px) * LV_IMG_PX_SIZE_ALPHA_BYTE;
+            if (opa > p[LV_IMG_PX_SIZE_ALPHA_BYTE - 1]) num_put_px(p, a->color, opa);
+        }
+    }
+    return (lv_coord_t)g.adv_w;
+}
+
+static int num_img_alloc(lv_img_dsc_t *img, lv_coord_t w, lv_coord_t h) {
+    size_t size = (size_t)w * h * LV_IMG_PX_SIZE_ALPHA_BYTE;
+    uint8_t *data = calloc(1, size ? size : 1);
+    if (!data) return -1;
+    memset(img, 0, sizeof(*img));
+    img->header.cf = LV_IMG_CF_TRUE_COLOR_ALPHA;
+    img->header.w = (uint32_t)w;
+    img->header.h = (uint32_t)h;
+    img->data_size = (uint32_t)size;
+    img->data = data;
+    return 0;
+}
+
+/* Atlas for a font/colour pair, built on first use and kept for the process
+ * lifetime. Pixel data lives outside LVGL's heap (LV_MEM_SIZE is small). */
+static num_atlas_t *num_atlas_get(const lv_font_t *font, lv_color_t color) {
+    for (unsigned i = 0; i < g_atlas_count; ++i) {
+        if (g_atlas[i].font == font && g_atlas[i].color.full == color.full) return &g_atlas[i];
+    }
+    if (g_atlas_count == NUM_ATLAS_MAX) return NULL;
+
+    num_atlas_t *a = &g_atlas[g_atlas_count];
+    memset(a, 0, sizeof(*a));
+    a->font = font;
+    a->color = color;
+    a->h = lv_font_get_line_height(font);
+    for (uint32_t d = 0; d < 10; ++d) {
+        lv_coord_t adv = lv_font_get_glyph_width(font, '0' + d, 0);
+        if (adv > a->cell_w) a->cell_w = adv;
+    }
+    a->point_w = lv_font_get_glyph_width(font, '.', 0);
+
+    static const char glyphs[NUM_GLYPH_COUNT] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '-', '.' };
+    for (unsigned i = 0; i < NUM_GLYPH_COUNT; ++i) {
+        lv_coord_t w = i == NUM_GLYPH_POINT ? a->point_w : a->cell_w;
+        if (num_img_alloc(&a->glyph[i], w, a->h) != 0) {
+            while (i--) free((void *)a->glyph[i].data);
+            return NULL;
+        }
+        /* Centre each glyph in its cell so every digit cell has the same width */
+        lv_coord_t adv = lv_font_get_glyph_width(font, (uint8_t)glyphs[i], 0);
+        num_render_glyph(a, (uint8_t *)a->glyph[i].data, w, (w - adv) / 2, (uint8_t)glyphs[i], 0);
+    }
+    g_atlas_count++;
+    return a;
+}
+
+/* Rasterized unit string, kerned as one run of text */
+static const num_unit_t *num_atlas_unit(num_atlas_t *a, const char *text) {
+    if (!text || !text[0]) return NULL;
+    for (unsigned i = 0; i < a->unit_count; ++i) {
+        if (strcmp(a->unit[i].text, text) == 0) return &a->unit[i];
+    }
+    if (a->unit_count == NUM_ATLAS_UNITS || strlen(text) >= NUM_UNIT_MAX) return NULL;
+
+    num_unit_t *u = &a->unit[a->unit_count];
+    strcpy(u->text, text);
+    lv_coord_t w = 0;
+    for (const char *s = text; *s;) {
+        uint32_t c = num_utf8_next(&s);
+        const char *peek = s;
+        w += lv_font_get_glyph_width(a->font, c, *peek ? num_utf8_next(&peek) : 0);
+    }
+    if (num_img_alloc(&u->img, w, a->h) != 0) return NULL;
+    lv_coord_t x = 0;
+    for (const char *s = text; *s;) {
+        uint32_t c = num_utf8_next(&s);
+        const char *peek = s;
+        x += num_render_glyph(a, (uint8_t *)u->img.data, w, x, c, *peek ? num_utf8_next(&peek) : 0);
+    }
+    a->unit_count++;
+    return u;
+}
+
+// ===== Widget =====
+
+/* Area of digit cell i, or of the decimal point (i == NUM_LABEL_MAX_CELLS),
+ * or of the unit (i == NUM_LABEL_MAX_CELLS + 1), in screen coordinates */
+static void num_label_area(const num_label_t *nl, unsigned i, lv_area_t *out) {
+    const num_atlas_t *a = nl->atlas;
+    lv_area_t c;
+    lv_obj_get_coords(nl->obj, &c);
+    lv_coord_t frac_x = (lv_coord_t)(nl->int_digits * a->cell_w + (nl->frac_digits ? a->point_w : 0));
+    lv_coord_t x, w;
+    if (i < nl->int_digits) {
+        x = (lv_coord_t)(i * a->cell_w);
+        w = a->cell_w;
+    } else if (i < NUM_LABEL_MAX_CELLS) {
+        x = (lv_coord_t)(frac_x + (i - nl->int_digits) * a->cell_w);
+        w = a->cell_w;
+    } else if (i == NUM_LABEL_MAX_CELLS) {
+        x = (lv_coord_t)(nl->int_digits * a->cell_w);
+        w = a->point_w;
+    } else {
+        x = (lv_coord_t)(frac_x + nl->frac_digits * a->cell_w + a->cell_w / 4);
+        w = nl->unit ? (lv_coord_t)nl->unit->img.header.w : 0;
+    }
+    out->x1 = c.x1 + x;
+    out->y1 = c.y1;
+    out->x2 = out->x1 + w - 1;
+    out->y2 = c.y1 + a->h - 1;
+}
+
+static void num_label_draw_img(lv_draw_ctx_t *draw_ctx, const lv_draw_img_dsc_t *dsc,
+                               const lv_area_t *area, const lv_img_dsc_t *img) {
+    lv_area_t clip;
+    if (_lv_area_intersect(&clip, area, draw_ctx->clip_area)) lv_draw_img(draw_ctx, dsc, area, img);
+}
+
+static void num_label_event_cb(lv_event_t *e) {
+    num_label_t *nl = (num_label_t *)lv_event_get_user_data(e);
+    lv_event_code_t code = lv_event_get_code(e);
+    if (code == LV_EVENT_DELETE) {
+        mem_pool_free(&num_label_pool, nl);
+        return;
+    }
+    if (code != LV_EVENT_DRAW_MAIN) return;
+
+    /* Only cells inside the area being redrawn are blended */
+    lv_draw_ctx_t *draw_ctx = lv_event_get_draw_ctx(e);
+    lv_draw_img_dsc_t dsc;
+    lv_draw_img_dsc_init(&dsc);
+    lv_area_t area;
+    for (unsigned i = 0; i < (unsigned)nl->int_digits + nl->frac_digits; ++i) {
+        if (nl->cell[i] == NUM_GLYPH_NONE) continue;
+        num_label_area(nl, i, &area);
+        num_label_draw_img(draw_ctx, &dsc, &area, &nl->atlas->glyph[nl->cell[i]]);
+    }
+    if (nl->known && nl->frac_digits) {
+        num_label_area(nl, NUM_LABEL_MAX_CELLS, &area);
+        num_label_draw_img(draw_ctx, &dsc, &area, &nl->atlas->glyph[NUM_GLYPH_POINT]);
+    }
+    if (nl->unit) {
+        num_label_area(nl, NUM_LABEL_MAX_CELLS + 1, &area);
+        num_label_draw_img(draw_ctx, &dsc, &area, &nl->unit->img);
+    }
+}
+
+/* Swap in new cell glyphs, invalidating only what changed */
+static void num_label_apply(num_label_t *nl, const uint8_t *cell, uint8_t known) {
+    lv_area_t area;
+    for (unsigned i = 0; i < (unsigned)nl->int_digits + nl->frac_digits; ++i) {
+        if (nl->cell[i] == cell[i]) continue;
+        nl->cell[i] = cell[i];
+        num_label_area(nl, i, &area);
+        lv_obj_invalidate_area(nl->obj, &area);
+    }
+    if (nl->known != known) {
+        nl->known = known;
+        if (nl->frac_digits) {
+            num_label_area(nl, NUM_LABEL_MAX_CELLS, &area);
+            lv_obj_invalidate_area(nl->obj, &area);
+        }
+    }
+}
+
+num_label_t *num_label_create(lv_obj_t *parent, const lv_font_t *font,
+                              uint8_t int_digits, uint8_t frac_digits, const char *unit) {
+    if (!font || int_digits == 0 || frac_digits > 9 || int_digits + frac_digits > NUM_LABEL_MAX_CELLS) return NULL;
+    num_label_t *nl = mem_pool_alloc(&num_label_pool);
+    if (!nl) return NULL;
+
+    nl->obj = lv_obj_create(parent);
+    lv_obj_remove_style_all(nl->obj);
+    lv_obj_clear_flag(nl->obj, LV_OBJ_FLAG_CLICKABLE | LV_OBJ_FLAG_SCROLLABLE);
+    nl->atlas = num_atlas_get(font, lv_obj_get_style_text_color(nl->obj, LV_PART_MAIN));
+    if (!nl->atlas) {
+        lv_obj_del(nl->obj);
+        mem_pool_free(&num_label_pool, nl);
+        return NULL;
+    }
+    nl->unit = num_atlas_unit(nl->atlas, unit);
+    nl->int_digits = int_digits;
+    nl->frac_digits = frac_digits;
+    nl->scale = 1;
+    for (uint8_t i = 0; i < frac_digits; ++i) nl->scale *= 10;
+    memset(nl->cell, NUM_GLYPH_NONE, sizeof(nl->cell));
+
+    const num_atlas_t *a = nl->atlas;
+    lv_coord_t w = (lv_coord_t)(int_digits * a->cell_w);
+    if (frac_digits) w = (lv_coord_t)(w + a->point_w + frac_digits * a->cell_w);
+    if (nl->unit) w = (lv_coord_t)(w + a->cell_w / 4 + (lv_coord_t)nl->unit->img.header.w);
+    lv_obj_set_size(nl->obj, w, a->h);
+    lv_obj_add_event_cb(nl->obj, num_label_event_cb, LV_EVENT_ALL, nl);
+    num_label_set_unknown(nl);
+    return nl;
+}
+
+lv_obj_t *num_label_obj(const num_label_t *nl) {
+    return nl ? nl->obj : NULL;
+}
+
+void num_label_set_unknown(num_label_t *nl) {
+    if (!nl) return;
+    uint8_t cell[NUM_LABEL_MAX_CELLS];
+    memset(cell, NUM_GLYPH_NONE, sizeof(cell));
+    cell[nl->int_digits - 1] = NUM_GLYPH_MINUS;
+    if (nl->int_digits > 1) cell[nl->int_digits - 2] = NUM_GLYPH_MINUS;
+    num_label_apply(nl, cell, 0);
+}
+
+void num_label_set_fixed(num_label_t *nl, int32_t value) {
+    if (!nl) return;
+    if (nl->known && nl->value == value) return;
+    nl->value = value;
+
+    uint8_t cell[NUM_LABEL_MAX_CELLS];
+    memset(cell, NUM_GLYPH_NONE, sizeof(cell));
+    uint32_t mag = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    for (unsigned i = nl->int_digits + nl->frac_digits; i-- > nl->int_digits;) {
+        cell[i] = (uint8_t)(mag % 10u);
+        mag /= 10u;
+    }
+    int i = nl->int_digits - 1;
+    do {
+        cell[i--] = (uint8_t)(mag % 10u);
+        mag /= 10u;
+    } while (mag && i >= 0);
+    if (value < 0) {
+        if (i >= 0) cell[i] = NUM_GLYPH_MINUS;
+        else mag = 1;
+    }
+    if (mag) {
+        /* Does not fit: dashes in every integer cell, no decimals */
+        memset(cell, NUM_GLYPH_MINUS, nl->int_digits);
+        memset(cell + nl->int_digits, NUM_GLYPH_NONE, nl->frac_digits);
+    }
+    num_label_apply(nl, cell, mag == 0);
+}
+
+void num_label_set_float(num_label_t *nl, float v) {
+    if (!nl) return;
+    if (isnan(v)) {
+        num_label_set_unknown(nl);
+        return;
+    }
+    float scaled = v * (float)nl->scale;
+    if (scaled > 2e9f) scaled = 2e9f;        /* shows dashes: far beyond any cell count */
+    else if (scaled < -2e9f) scaled = -2e9f;
+    num_label_set_fixed(nl, (int32_t)lrintf(scaled));
+}
@@ -0,0 +1,63 @@
+#ifndef NUM_LABEL_H
+#define NUM_LABEL_H
+
+/*
+ * Fixed-width numeric value widget (LVGL v8).
+ *
+ * A value is formatted with integer math into fixed cells: int_digits digit
+ * cells (a minus sign takes the cell before the first digit), a decimal point
+ * and frac_digits digit cells when frac_digits > 0, then the unit. Glyphs come
+ * from an atlas shared by every widget with the same font and text colour: the
+ * digits, '-', '.' and each unit string are rasterized once into
+ * LV_IMG_CF_TRUE_COLOR_ALPHA cells, so drawing is a plain image blend and no
+ * text is shaped or allocated after creation. Setting a value invalidates only
+ * the cells whose glyph changed.
+ *
+ * GUI thread only, like every LVGL object.
+ */
+
+#include <stdint.h>
+#include "lvgl/lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef NUM_LABEL_MAX_CELLS
+#define NUM_LABEL_MAX_CELLS 8      /* int_digits + frac_digits */
+#endif
+#ifndef NUM_ATLAS_MAX
+#define NUM_ATLAS_MAX 4            /* distinct font/colour pairs */
+#endif
+#ifndef NUM_ATLAS_UNITS
+#define NUM_ATLAS_UNITS 4          /* distinct unit strings per atlas */
+#endif
+#ifndef NUM_LABEL_POOL
+#define NUM_LABEL_POOL 64          /* widget states alive at once (mem_pool.h) */
+#endif
+
+typedef struct num_label num_label_t;
+
+/* Create a widget in parent. The text colour is inherited from parent's style
+ * at creation; unit may be NULL or "". Starts unknown ("--").
+ * Returns NULL on invalid geometry or allocation failure. */
+num_label_t *num_label_create(lv_obj_t *parent, const lv_font_t *font,
+                              uint8_t int_digits, uint8_t frac_digits, const char *unit);
+
+/* The widget's LVGL object, e.g. for alignment or flags. */
+lv_obj_t *num_label_obj(const num_label_t *nl);
+
+/* Show value / 10^frac_digits. Values that do not fit show dashes. */
+void num_label_set_fixed(num_label_t *nl, int32_t value);
+
+/* Round v to frac_digits decimals and show it; NaN shows "--". */
+void num_label_set_float(num_label_t *nl, float v);
+
+/* Show "--" */
+void num_label_set_unknown(num_label_t *nl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NUM_LABEL_H */
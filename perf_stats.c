@@ -0,0 +1,307 @@
+#include "perf_stats.h"
+#include "mem_pool.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* One shard per thread; aligned so two threads never share a cache line */
+typedef struct {
+    uint64_t    counters[PERF_CNT_COUNT];
+    perf_hist_t hist[PERF_HIST_COUNT];
+} __attribute__((aligned(64))) perf_shard_t;
+
+/* Shards 0..PERF_MAX_THREADS-2 belong to one live thread each and go back to
+ * the free list when it exits (their totals stay in them); the last one is
+ * shared by every thread that finds none left. */
+static perf_shard_t g_shards[PERF_MAX_THREADS];
+static unsigned g_shard_next = 0;
+static unsigned g_shard_free[PERF_MAX_THREADS];
+static unsigned g_shard_nfree = 0;
+static pthread_mutex_t g_shard_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t g_shard_key;
+static pthread_once_t g_shard_once = PTHREAD_ONCE_INIT;
+static __thread perf_shard_t *t_shard = NULL;
+
+static const char *const g_hist_names[PERF_HIST_COUNT] = {
+    "timer_handler", "flush_area", "sensor_bus", "sensor_wait", "sensor_total", "input_dispatch",
+};
+
+static const char *const g_counter_names[PERF_CNT_COUNT] = {
+    "frames", "flush_areas", "pixels_flushed", "i2c_ioctls", "spi_ioctls", "sensor_ok", "sensor_err",
+    "telemetry_records", "telemetry_dropped", "telemetry_sends", "sample_log_syncs",
+    "sample_sched_changes", "headless_tiles", "headless_bytes", "fb_bytes",
+    "filter_bursts", "filter_rejects", "input_events", "input_dropped",
+};
+
+uint64_t perf_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/* Thread exit (pthread key destructor) */
+static void perf_shard_release(void *arg)
+{
+    unsigned idx = (unsigned)((perf_shard_t *)arg - g_shards);
+    if (idx == PERF_MAX_THREADS - 1) return;
+    pthread_mutex_lock(&g_shard_lock);
+    g_shard_free[g_shard_nfree++] = idx;
+    pthread_mutex_unlock(&g_shard_lock);
+}
+
+static void perf_shard_key_init(void)
+{
+    pthread_key_create(&g_shard_key, perf_shard_release);
+}
+
+static perf_shard_t *perf_shard(void)
+{
+    if (!t_shard) {
+        pthread_once(&g_shard_once, perf_shard_key_init);
+        pthread_mutex_lock(&g_shard_lock);
+        unsigned idx = PERF_MAX_THREADS - 1;
+        if (g_shard_nfree) idx = g_shard_free[--g_shard_nfree];
+        else if (g_shard_next < PERF_MAX_THREADS - 1) idx = g_shard_next++;
+        pthread_mutex_unlock(&g_shard_lock);
+        t_shard = &g_shards[idx];
+        pthread_setspecific(g_shard_key, t_shard);
+    }
+    return t_shard;
+}
+
+static unsigned perf_bucket(uint64_t ns)
+{
+    uint64_t us = ns / 1000u;
+    if (us == 0) return 0;
+    unsigned b = 64u - (unsigned)__builtin_clzll(us); /* 1 -> 1, 2..3 -> 2, ... */
+    return b < PERF_HIST_BUCKETS ? b : PERF_HIST_BUCKETS - 1;
+}
+
+void perf_hist_record(perf_hist_id_t id, uint64_t ns)
+{
+    if ((unsigned)id >= PERF_HIST_COUNT) return;
+    perf_hist_t *h = &perf_shard()->hist[id];
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sum_ns, ns, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->buckets[perf_bucket(ns)], 1, __ATOMIC_RELAXED);
+    uint64_t cur = __atomic_load_n(&h->max_ns, __ATOMIC_RELAXED);
+    while (ns > cur && !__atomic_compare_exchange_n(&h->max_ns, &cur, ns, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { }
+}
+
+void perf_count_add(perf_counter_id_t id, uint64_t n)
+{
+    if ((unsigned)id >= PERF_CNT_COUNT) return;
+    __atomic_fetch_add(&perf_shard()->counters[id], n, __ATOMIC_RELAXED);
+}
+
+void perf_stats_snapshot(perf_snapshot_t *out)
+{
+    if (!out) return;
+    memset(out, 0, sizeof(*out));
+    for (unsigned s = 0; s < PERF_MAX_THREADS; ++s) {
+        const perf_shard_t *sh = &g_shards[s];
+        for (unsigned c = 0; c < PERF_CNT_COUNT; ++c) {
+            out->counters[c] += __atomic_load_n(&sh->counters[c], __ATOMIC_RELAXED);
+        }
+        for (unsigned h = 0; h < PERF_HIST_COUNT; ++h) {
+            const perf_hist_t *src = &sh->hist[h];
+            perf_hist_t *dst = &out->hist[h];
+            dst->count  += __atomic_load_n(&src->count, __ATOMIC_RELAXED);
+            dst->sum_ns += __atomic_load_n(&src->sum_ns, __ATOMIC_RELAXED);
+            uint64_t mx = __atomic_load_n(&src->max_ns, __ATOMIC_RELAXED);
+            if (mx > dst->max_ns) dst->max_ns = mx;
+            for (unsigned b = 0; b < PERF_HIST_BUCKETS; ++b) {
+                dst->buckets[b] += __atomic_load_n(&src->buckets[b], __ATOMIC_RELAXED);
+            }
+        }
+    }
+}
+
+uint64_t perf_hist_percentile_ns(const perf_hist_t *h, unsigned pct)
+{
+    if (!h || h->count == 0) return 0;
+    if (pct > 100) pct = 100;
+    uint64_t target = (h->count * pct + 99) / 100;
+    if (target == 0) target = 1;
+    uint64_t seen = 0;
+    for (unsigned b = 0; b < PERF_HIST_BUCKETS; ++b) {
+        seen += h->buckets[b];
+        if (seen >= target) {
+            uint64_t upper = (b == 0) ? 1000u : (1000ull << b);
+            return upper < h->max_ns ? upper : h->max_ns;
+        }
+    }
+    return h->max_ns;
+}
+
+const char *perf_hist_name(perf_hist_id_t id)
+{
+    return (unsigned)id < PERF_HIST_COUNT ? g_hist_names[id] : "?";
+}
+
+const char *perf_counter_name(perf_counter_id_t id)
+{
+    return (unsigned)id < PERF_CNT_COUNT ? g_counter_names[id] : "?";
+}
+
+int perf_stats_dump_json(FILE *f)
+{
+    if (!f) { errno = EINVAL; return -1; }
+    perf_snapshot_t snap;
+    perf_stats_snapshot(&snap);
+
+    fprintf(f, "{\"t_ns\":%llu,\"counters\":{", (unsigned long long)perf_now_ns());
+    for (unsigned c = 0; c < PERF_CNT_COUNT; ++c) {
+        fprintf(f, "%s\"%s\":%llu", c ? "," : "", g_counter_names[c], (unsigned long long)snap.counters[c]);
+    }
+    fputs("},\"hist\":{", f);
+    for (unsigned h = 0; h < PERF_HIST_COUNT; ++h) {
+        const perf_hist_t *hs = &snap.hist[h];
+        fprintf(f, "%s\"%s\":{\"count\":%llu,\"sum_ns\":%llu,\"max_ns\":%llu,\"p50_ns\":%llu,\"p99_ns\":%llu,\"buckets_us_log2\":[",
+                h ? "," : "", g_hist_names[h],
+                (unsigned long long)hs->count, (unsigned long long)hs->sum_ns, (unsigned long long)hs->max_ns,
+                (unsigned long long)perf_hist_percentile_ns(hs, 50), (unsigned long long)perf_hist_percentile_ns(hs, 99));
+        for (unsigned b = 0; b < PERF_HIST_BUCKETS; ++b) {
+            fprintf(f, "%s%llu", b ? "," : "", (unsigned long long)hs->buckets[b]);
+        }
+        fputs("]}", f);
+    }
+    fputs("},", f);
+    mem_stats_dump_json(f);
+    fputs("}\n", f);
+    return fflush(f) == 0 ? 0 : -1;
+}
+
+static unsigned long perf_us(uint64_t ns) { return (unsigned long)(ns / 1000u); }
+
+void perf_stats_format_overlay(char *buf, size_t len)
+{
+    if (!buf || len == 0) return;
+    perf_snapshot_t snap;
+    perf_stats_snapshot(&snap);
+    const perf_hist_t *th = &snap.hist[PERF_HIST_TIMER_HANDLER];
+    const perf_hist_t *fl = &snap.hist[PERF_HIST_FLUSH];
+    const perf_hist_t *sb = &snap.hist[PERF_HIST_SENSOR_BUS];
+    const perf_hist_t *sw = &snap.hist[PERF_HIST_SENSOR_WAIT];
+    snprintf(buf, len,
+             "timer p50/p99 %lu/%lu us\n"
+             "flush p50/p99 %lu/%lu us  frames %llu  px %llu\n"
+             "sensor bus/wait p99 %lu/%lu us  i2c %llu spi %llu",
+             perf_us(perf_hist_percentile_ns(th, 50)), perf_us(perf_hist_percentile_ns(th, 99)),
+             perf_us(perf_hist_percentile_ns(fl, 50)), perf_us(perf_hist_percentile_ns(fl, 99)),
+             (unsigned long long)snap.counters[PERF_CNT_FRAMES], (unsigned long long)snap.counters[PERF_CNT_PIXELS_FLUSHED],
+             perf_us(perf_hist_percentile_ns(sb, 99)), perf_us(perf_hist_percentile_ns(sw, 99)),
+             (unsigned long long)snap.counters[PERF_CNT_I2C_IOCTLS], (unsigned long long)snap.counters[PERF_CNT_SPI_IOCTLS]);
+}
+
+/* ===== Dump service (SIGUSR1 via signalfd + optional Unix socket) ===== */
+
+typedef struct {
+    int sig_fd;
+    int listen_fd;
+    const char *dump_path;
+} perf_service_t;
+
+static perf_service_t g_service = { .sig_fd = -1, .listen_fd = -1 };
+
+static void perf_dump_to_path(const char *path)
+{
+    if (!path) {
+        perf_stats_dump_json(stdout);
+        return;
+    }
+    FILE *f = fopen(path, "w");
+    if (!f) return;
+    perf_stats_dump_json(f);
+    fclose(f);
+}
+
+static void *perf_service_thread(void *arg)
+{
+    perf_service_t *svc = (perf_service_t *)arg;
+    struct pollfd pfds[2];
+    nfds_t n = 0;
+    if (svc->sig_fd >= 0) { pfds[n].fd = svc->sig_fd; pfds[n].events = POLLIN; n++; }
+    if (svc->listen_fd >= 0) { pfds[n].fd = svc->listen_fd; pfds[n].events = POLLIN; n++; }
+
+    for (;;) {
+        if (poll(pfds, n, -1) < 0) {
+            if (errno == EINTR) continue;
+            return NULL;
+        }
+        for (nfds_t i = 0; i < n; ++i) {
+            if (!(pfds[i].revents & POLLIN)) continue;
+            if (pfds[i].fd == svc->sig_fd) {
+                struct signalfd_siginfo si;
+                if (read(svc->sig_fd, &si, sizeof(si)) == (ssize_t)sizeof(si)) perf_dump_to_path(svc->dump_path);
+            } else {
+                int c = accept4(svc->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+                if (c < 0) continue;
+                FILE *f = fdopen(c, "w");
+                if (f) {
+                    perf_stats_dump_json(f);
+                    fclose(f);
+                } else {
+                    close(c);
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+static int perf_open_socket(const char *path)
+{
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) { errno = ENAMETOOLONG; return -1; }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    unlink(path); /* stale socket from a previous run */
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+int perf_stats_start_service(const char *dump_path, const char *socket_path)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGUSR1);
+    if (pthread_sigmask(SIG_BLOCK, &mask, NULL) != 0) return -1;
+
+    g_service.dump_path = dump_path;
+    g_service.sig_fd = signalfd(-1, &mask, SFD_CLOEXEC);
+    if (g_service.sig_fd < 0) return -1;
+
+    if (socket_path && socket_path[0]) {
+        g_service.listen_fd = perf_open_socket(socket_path);
+        if (g_service.listen_fd < 0) {
+            fprintf(stderr, "Stats: cannot listen on %s: %s\n", socket_path, strerror(errno));
+        }
+    }
+
+    pthread_t tid;
+    int rc = pthread_create(&tid, NULL, perf_service_thread, &g_service);
+    if (rc != 0) { errno = rc; return -1; }
+    pthread_detach(tid);
+    return 0;
+}
@@ -0,0 +1,113 @@
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+/*
+ * Hot-path instrumentation for the render/flush/sensor pipeline.
+ *
+ * Every thread records into its own shard of counters and log2 latency
+ * histograms (relaxed atomics, no locks, no shared cache lines on the hot path).
+ * A thread's shard is reused by later threads once it exits, so short-lived
+ * threads (sensor discovery) do not use shards up.
+ * Readers sum the shards on demand, so recording stays cheap enough to leave
+ * enabled in production builds.
+ *
+ * Output:
+ *   - perf_stats_format_overlay(): short multi-line text for an on-screen label
+ *   - perf_stats_dump_json(): one JSON object per dump (machine readable)
+ *   - perf_stats_start_service(): dumps on SIGUSR1 and/or to every client that
+ *     connects to a Unix stream socket
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PERF_HIST_TIMER_HANDLER = 0, /* lv_timer_handler() duration */
+    PERF_HIST_FLUSH,             /* backend flush time per area */
+    PERF_HIST_SENSOR_BUS,        /* time spent in bus transfers per sample */
+    PERF_HIST_SENSOR_WAIT,       /* time sleeping for the conversion per sample */
+    PERF_HIST_SENSOR_TOTAL,      /* full sample latency */
+    PERF_HIST_INPUT_DISPATCH,    /* threaded mode: pointer event to LVGL read_cb */
+    PERF_HIST_COUNT
+} perf_hist_id_t;
+
+typedef enum {
+    PERF_CNT_FRAMES = 0,         /* last-area flushes (completed frames) */
+    PERF_CNT_FLUSH_AREAS,
+    PERF_CNT_PIXELS_FLUSHED,
+    PERF_CNT_I2C_IOCTLS,         /* I2C transfers issued (ioctl/read/write syscalls) */
+    PERF_CNT_SPI_IOCTLS,         /* SPI_IOC_MESSAGE calls */
+    PERF_CNT_SENSOR_OK,
+    PERF_CNT_SENSOR_ERR,
+    PERF_CNT_TELEMETRY_RECORDS,  /* records handed to the telemetry socket */
+    PERF_CNT_TELEMETRY_DROPPED,  /* records lost: queue full or send failed */
+    PERF_CNT_TELEMETRY_SENDS,    /* sendmmsg/sendmsg calls */
+    PERF_CNT_SAMPLE_LOG_SYNCS,   /* sample log msync() flushes */
+    PERF_CNT_SAMPLE_SCHED_CHANGES, /* adaptive sampling level switches */
+    PERF_CNT_HEADLESS_TILES,     /* headless backend: tiles sent */
+    PERF_CNT_HEADLESS_BYTES,     /* headless backend: bytes sent */
+    PERF_CNT_FB_BYTES,           /* bytes written to the framebuffer by fb_blit */
+    PERF_CNT_FILTER_BURSTS,      /* sample filter: re-reads after a failed or suspicious read */
+    PERF_CNT_FILTER_REJECTS,     /* sample filter: samples with a channel replaced */
+    PERF_CNT_INPUT_EVENTS,       /* threaded mode: pointer transitions queued */
+    PERF_CNT_INPUT_DROPPED,      /* threaded mode: transitions lost to a full queue */
+    PERF_CNT_COUNT
+} perf_counter_id_t;
+
+/* Histogram buckets: bucket 0 is < 1 us, bucket i covers [2^(i-1), 2^i) us */
+#define PERF_HIST_BUCKETS 26
+
+#ifndef PERF_MAX_THREADS
+#define PERF_MAX_THREADS 16          /* live threads beyond PERF_MAX_THREADS - 1 share the last shard */
+#endif
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum_ns;
+    uint64_t max_ns;
+    uint64_t buckets[PERF_HIST_BUCKETS];
+} perf_hist_t;
+
+typedef struct {
+    uint64_t    counters[PERF_CNT_COUNT];
+    perf_hist_t hist[PERF_HIST_COUNT];
+} perf_snapshot_t;
+
+/* CLOCK_MONOTONIC in nanoseconds */
+uint64_t perf_now_ns(void);
+
+void perf_hist_record(perf_hist_id_t id, uint64_t ns);
+void perf_count_add(perf_counter_id_t id, uint64_t n);
+
+/* Sum all thread shards into out. */
+void perf_stats_snapshot(perf_snapshot_t *out);
+
+/* Approximate percentile (0..100) in nanoseconds: upper bound of the bucket. */
+uint64_t perf_hist_percentile_ns(const perf_hist_t *h, unsigned pct);
+
+const char *perf_hist_name(perf_hist_id_t id);
+const char *perf_counter_name(perf_counter_id_t id);
+
+/* Write one JSON object (single line, newline-terminated) to f. Returns 0 or -1. */
+int perf_stats_dump_json(FILE *f);
+
+/* Compact human-readable summary for an on-screen overlay. */
+void perf_stats_format_overlay(char *buf, size_t len);
+
+/* Start the dump service. Must be called before other threads are created so
+ * SIGUSR1 stays blocked everywhere and is only consumed through a signalfd.
+ *   dump_path:   file rewritten on every SIGUSR1 (NULL = stdout)
+ *   socket_path: Unix stream socket; each connection receives one dump (NULL = none)
+ * Returns 0 on success, -1 on error with errno set. */
+int perf_stats_start_service(const char *dump_path, const char *socket_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERF_STATS_H */
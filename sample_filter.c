@@ -0,0 +1,153 @@
+#include "sample_filter.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* BME280 operating range; a compensated value outside it is a bad read */
+static const float g_range_lo[3] = { -40.0f, 300.0f, 0.0f };
+static const float g_range_hi[3] = { 85.0f, 1100.0f, 100.0f };
+static const float g_floor[3] = { SAMPLE_FILTER_FLOOR_T, SAMPLE_FILTER_FLOOR_P, SAMPLE_FILTER_FLOOR_H };
+
+static const char *const g_kind_names[SAMPLE_FILTER_KINDS] = { "median", "hampel", "ema" };
+
+int sample_filter_parse(const char *spec, sample_filter_config_t *out) {
+    if (!spec || !out) return -1;
+    memset(out, 0, sizeof(*out));
+    if (strcmp(spec, "none") == 0 || !*spec) return 0;
+
+    char buf[96];
+    if (strlen(spec) >= sizeof(buf)) return -1;
+    strcpy(buf, spec);
+    unsigned seen = 0;
+    char *rest = buf, *tok;
+    while ((tok = strsep(&rest, ",")) != NULL) {
+        char *name = strsep(&tok, ":");
+        char *a1 = strsep(&tok, ":");
+        char *a2 = tok;
+        char *end = NULL;
+        sample_filter_stage_t st;
+        int k = 0;
+        while (k < SAMPLE_FILTER_KINDS && strcmp(name, g_kind_names[k]) != 0) ++k;
+        if (k == SAMPLE_FILTER_KINDS || (seen & (1u << k)) || out->count == SAMPLE_FILTER_STAGES_MAX) return -1;
+        seen |= 1u << k;
+        st.kind = (sample_filter_kind_t)k;
+
+        switch (st.kind) {
+        case SAMPLE_FILTER_MEDIAN:
+            st.n = a1 && *a1 ? (unsigned)strtoul(a1, &end, 10) : 5u;
+            st.arg = 0.0f;
+            if ((end && *end) || a2 || st.n < 3 || st.n > SAMPLE_FILTER_BURST_MAX || !(st.n & 1u)) return -1;
+            break;
+        case SAMPLE_FILTER_HAMPEL:
+            st.n = a1 && *a1 ? (unsigned)strtoul(a1, &end, 10) : 7u;
+            if ((end && *end) || st.n < 3 || st.n > SAMPLE_FILTER_WINDOW_MAX) return -1;
+            end = NULL;
+            st.arg = a2 && *a2 ? strtof(a2, &end) : 3.0f;
+            if ((end && *end) || !(st.arg > 0.0f)) return -1;
+            break;
+        default: /* SAMPLE_FILTER_EMA */
+            st.n = 0;
+            st.arg = a1 && *a1 ? strtof(a1, &end) : 60.0f;
+            if ((end && *end) || a2 || !(st.arg > 0.0f)) return -1;
+            break;
+        }
+        out->stage[out->count++] = st;
+    }
+    return 0;
+}
+
+static const sample_filter_stage_t *sample_filter_find(const sample_filter_t *f, sample_filter_kind_t kind) {
+    for (unsigned i = 0; i < f->cfg->count; ++i) {
+        if (f->cfg->stage[i].kind == kind) return &f->cfg->stage[i];
+    }
+    return NULL;
+}
+
+void sample_filter_init(sample_filter_t *f, const sample_filter_config_t *cfg) {
+    memset(f, 0, sizeof(*f));
+    f->cfg = cfg;
+    for (int c = 0; c < 3; ++c) f->ema[c] = NAN;
+}
+
+unsigned sample_filter_burst(const sample_filter_t *f) {
+    const sample_filter_stage_t *st = sample_filter_find(f, SAMPLE_FILTER_MEDIAN);
+    return st ? st->n : 1u;
+}
+
+/* Median of n <= SAMPLE_FILTER_WINDOW_MAX values; sorts v */
+static float sample_filter_median_of(float *v, unsigned n) {
+    for (unsigned i = 1; i < n; ++i) {
+        float x = v[i];
+        unsigned j = i;
+        for (; j > 0 && v[j - 1] > x; --j) v[j] = v[j - 1];
+        v[j] = x;
+    }
+    return n & 1u ? v[n / 2] : 0.5f * (v[n / 2 - 1] + v[n / 2]);
+}
+
+/* x deviates from the window of channel c by more than K scaled MADs;
+ * *med is the window median */
+static int sample_filter_outlier(const sample_filter_t *f, const sample_filter_stage_t *st, int c, float x, float *med) {
+    unsigned n = f->fill[c];
+    if (n < 3) return 0;
+    float w[SAMPLE_FILTER_WINDOW_MAX];
+    memcpy(w, f->window[c], n * sizeof(w[0]));
+    float m = sample_filter_median_of(w, n);
+    for (unsigned i = 0; i < n; ++i) w[i] = fabsf(w[i] - m);
+    float scale = 1.4826f * sample_filter_median_of(w, n);
+    if (scale < g_floor[c]) scale = g_floor[c];
+    *med = m;
+    return fabsf(x - m) > st->arg * scale;
+}
+
+int sample_filter_suspect(const sample_filter_t *f, const float v[3]) {
+    const sample_filter_stage_t *hampel = sample_filter_find(f, SAMPLE_FILTER_HAMPEL);
+    for (int c = 0; c < 3; ++c) {
+        float med;
+        if (isnan(v[c])) continue; /* channel skipped */
+        if (v[c] < g_range_lo[c] || v[c] > g_range_hi[c]) return 1;
+        if (hampel && sample_filter_outlier(f, hampel, c, v[c], &med)) return 1;
+    }
+    return 0;
+}
+
+void sample_filter_median(const float reads[][3], unsigned n, float out[3]) {
+    float v[SAMPLE_FILTER_BURST_MAX];
+    if (n > SAMPLE_FILTER_BURST_MAX) n = SAMPLE_FILTER_BURST_MAX;
+    for (int c = 0; c < 3; ++c) {
+        for (unsigned i = 0; i < n; ++i) v[i] = reads[i][c];
+        out[c] = n ? sample_filter_median_of(v, n) : NAN;
+    }
+}
+
+unsigned sample_filter_apply(sample_filter_t *f, uint32_t now_s, float v[3], bme280_filter_t chip_iir, int confirmed) {
+    unsigned replaced = 0;
+    for (unsigned i = 0; i < f->cfg->count; ++i) {
+        const sample_filter_stage_t *st = &f->cfg->stage[i];
+        if (st->kind == SAMPLE_FILTER_HAMPEL) {
+            for (int c = 0; c < 3; ++c) {
+                float raw = v[c], med;
+                if (isnan(raw)) continue; /* skipped channels never enter the window */
+                if (!confirmed && sample_filter_outlier(f, st, c, raw, &med)) {
+                    v[c] = med;
+                    replaced |= 1u << c;
+                }
+                f->window[c][f->head[c]] = raw;
+                f->head[c] = (f->head[c] + 1u) % st->n;
+                if (f->fill[c] < st->n) f->fill[c]++;
+            }
+        } else if (st->kind == SAMPLE_FILTER_EMA) {
+            float alpha = 1.0f - expf(-(float)(now_s - f->ema_time_s) / st->arg);
+            f->ema_time_s = now_s;
+            for (int c = 0; c < 3; ++c) {
+                if (isnan(v[c])) continue;
+                /* Chip IIR on: temperature and pressure are filtered already */
+                if (isnan(f->ema[c]) || (c < 2 && chip_iir != BME280_FILTER_OFF)) f->ema[c] = v[c];
+                else f->ema[c] += alpha * (v[c] - f->ema[c]);
+                v[c] = f->ema[c];
+            }
+        }
+    }
+    return replaced;
+}
@@ -0,0 +1,118 @@
+#ifndef SAMPLE_FILTER_H
+#define SAMPLE_FILTER_H
+
+/*
+ * Sample filter pipeline: cleans each device's stream before it is published,
+ * so one bad read does not reach the screen, without oversampling every
+ * sample.
+ *
+ * A pipeline is configured with a spec of comma-separated stages, each
+ * kind at most once, or "none":
+ *   median:N     a suspicious read (bus error, outside the BME280 operating
+ *                range, or a Hampel outlier) is followed at once by a burst
+ *                of N - 1 more forced conversions, and the sample becomes the
+ *                per-channel median of the reads (N odd, at most
+ *                SAMPLE_FILTER_BURST_MAX). A median of at least three
+ *                conversions that still stands out is a real change and is
+ *                kept. Stable samples cost one conversion as before.
+ *   hampel:W:K   a value further than K scaled MADs (1.4826 * the median
+ *                absolute deviation, at least the channel's noise floor) from
+ *                the median of the last W values is replaced by that median,
+ *                unless a burst confirmed it. The window keeps the raw
+ *                values, so a lasting step is accepted after W / 2 samples.
+ *   ema:TAU      exponential moving average with time constant TAU seconds;
+ *                the weight follows the actual interval, so the smoothing is
+ *                the same at every adaptive sampling rate
+ *
+ * The burst always happens at acquisition; hampel and ema run in spec order.
+ * The default is SAMPLE_FILTER_DEFAULT.
+ *
+ * The chip's IIR filter (bme280_set_filter, the EVENT level in
+ * sample_sched.h) already low-passes temperature and pressure. While it is on,
+ * the EMA passes those two channels through and follows them, so nothing is
+ * filtered twice and switching levels causes no jump. Humidity is not
+ * filtered by the chip and stays smoothed. In normal mode, which is when the
+ * IIR is used, repeated reads return the same conversion, so a burst is one
+ * re-read that only rules out a bus error.
+ *
+ * Fixed-size state, no allocation and no bus access. There is one
+ * sample_filter_t per device, owned by its sampling thread.
+ */
+
+#include <stdint.h>
+#include "BME280.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SAMPLE_FILTER_DEFAULT
+#define SAMPLE_FILTER_DEFAULT "median:5,hampel:7:3"
+#endif
+#ifndef SAMPLE_FILTER_FLOOR_T
+#define SAMPLE_FILTER_FLOOR_T 0.2f     /* Celsius: smallest Hampel deviation scale */
+#endif
+#ifndef SAMPLE_FILTER_FLOOR_P
+#define SAMPLE_FILTER_FLOOR_P 0.2f     /* hPa */
+#endif
+#ifndef SAMPLE_FILTER_FLOOR_H
+#define SAMPLE_FILTER_FLOOR_H 1.0f     /* %RH */
+#endif
+
+#define SAMPLE_FILTER_STAGES_MAX 3
+#define SAMPLE_FILTER_BURST_MAX  9
+#define SAMPLE_FILTER_WINDOW_MAX 15
+
+typedef enum {
+    SAMPLE_FILTER_MEDIAN = 0,
+    SAMPLE_FILTER_HAMPEL,
+    SAMPLE_FILTER_EMA,
+    SAMPLE_FILTER_KINDS
+} sample_filter_kind_t;
+
+typedef struct {
+    sample_filter_kind_t kind;
+    unsigned             n;    /* median: burst reads; hampel: window */
+    float                arg;  /* hampel: K; ema: TAU seconds */
+} sample_filter_stage_t;
+
+typedef struct {
+    sample_filter_stage_t stage[SAMPLE_FILTER_STAGES_MAX];
+    unsigned              count;
+} sample_filter_config_t;
+
+typedef struct {
+    const sample_filter_config_t *cfg;
+    float    window[3][SAMPLE_FILTER_WINDOW_MAX];  /* Hampel ring: temperature, pressure, humidity */
+    unsigned head[3], fill[3];
+    float    ema[3];                               /* NaN: not seeded */
+    uint32_t ema_time_s;
+} sample_filter_t;
+
+/* Parse a pipeline spec (see above). Returns 0 or -1 if malformed. */
+int sample_filter_parse(const char *spec, sample_filter_config_t *out);
+
+/* Empty windows and EMA; cfg must outlive f. */
+void sample_filter_init(sample_filter_t *f, const sample_filter_config_t *cfg);
+
+/* Reads in a burst, counting the suspicious one (1: no median stage). */
+unsigned sample_filter_burst(const sample_filter_t *f);
+
+/* A read (Celsius, hPa, %RH; NaN: channel skipped) that is out of range or
+ * a Hampel outlier. */
+int sample_filter_suspect(const sample_filter_t *f, const float v[3]);
+
+/* Per-channel median of n reads. */
+void sample_filter_median(const float reads[][3], unsigned n, float out[3]);
+
+/* Run the stream stages over one valid sample at now_s (monotonic seconds)
+ * in place. chip_iir is the device's current IIR setting; confirmed marks a
+ * median of independent conversions. Returns a bit mask (1 << channel) of
+ * the channels whose value was rejected and replaced. */
+unsigned sample_filter_apply(sample_filter_t *f, uint32_t now_s, float v[3], bme280_filter_t chip_iir, int confirmed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_FILTER_H */
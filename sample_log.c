@@ -0,0 +1,399 @@
+#include "sample_log.h"
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "perf_stats.h"
+
+#define SAMPLE_LOG_HEADER_SIZE 4096u
+#define SAMPLE_LOG_REPLAY_BATCH 32 /* records compensated per bme280_compensate_batch() call */
+
+typedef struct {
+    uint8_t  used;
+    uint8_t  sensor;
+    uint8_t  raw[BME280_CALIB_RAW_LEN];
+    uint8_t  reserved;
+    uint32_t seq;       /* order of registration; a sensor's newest entry is its current one */
+    uint32_t gen_from;  /* records in older segment generations belong to an evicted calibration */
+    uint32_t crc;       /* over everything above */
+} sample_log_calib_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t segments;
+    uint32_t segment_records;
+    uint32_t gen[SAMPLE_LOG_SEGMENTS];
+    sample_log_calib_t calib[SAMPLE_LOG_CALIBS];
+} sample_log_header_t;
+
+typedef struct {
+    uint32_t time_s;
+    uint32_t check;
+    uint64_t adc;
+} sample_log_record_t;
+
+_Static_assert(sizeof(sample_log_header_t) <= SAMPLE_LOG_HEADER_SIZE, "sample log header exceeds its page");
+_Static_assert(sizeof(sample_log_record_t) == 16, "sample log records must not straddle pages");
+_Static_assert(SAMPLE_LOG_CALIBS <= 256 && SAMPLE_LOG_SENSORS <= 256, "calibration ids and sensors are 8 bits");
+_Static_assert(SAMPLE_LOG_CALIBS > SAMPLE_LOG_SENSORS, "eviction needs an entry no sensor is using");
+
+#define SAMPLE_LOG_FILE_SIZE \
+    ((size_t)SAMPLE_LOG_HEADER_SIZE + (size_t)SAMPLE_LOG_SEGMENTS * SAMPLE_LOG_SEGMENT_RECORDS * sizeof(sample_log_record_t))
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint8_t *g_map = NULL;
+static unsigned g_sync_s = SAMPLE_LOG_SYNC_SEC;
+static unsigned g_active = 0;              /* segment being appended to */
+static uint32_t g_pos = 0;                 /* next record in g_active */
+static size_t   g_dirty_lo = 0, g_dirty_hi = 0; /* byte range written since the last msync */
+static int      g_header_dirty = 0;       /* calibration entry changed since the last msync */
+static int      g_calib_cur[SAMPLE_LOG_SENSORS]; /* current entry of each sensor, -1: none */
+static uint32_t g_calib_seq = 0;          /* highest seq in use */
+static time_t   g_last_sync = 0;
+
+static sample_log_header_t *sample_log_header(void) {
+    return (sample_log_header_t *)g_map;
+}
+
+static sample_log_record_t *sample_log_segment(unsigned seg) {
+    return (sample_log_record_t *)(g_map + SAMPLE_LOG_HEADER_SIZE) + (size_t)seg * SAMPLE_LOG_SEGMENT_RECORDS;
+}
+
+/* CRC-32 (IEEE 802.3, reflected), bitwise: only used for the small calibration slots */
+static uint32_t sample_log_crc32(const void *data, size_t len) {
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t crc = ~0u;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; ++k) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+/* Record check: a few multiply/xorshift rounds (murmur3 finalizer) over the
+ * record and the generation of its segment. Cheap enough to validate every
+ * record on replay; a different generation makes stale records fail. */
+static uint32_t sample_log_mix(uint32_t h) {
+    h ^= h >> 16; h *= 0x85EBCA6Bu;
+    h ^= h >> 13; h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+static uint32_t sample_log_check(uint32_t gen, uint32_t time_s, uint64_t adc) {
+    uint32_t h = sample_log_mix(gen * 0x9E3779B1u ^ time_s);
+    h = sample_log_mix(h ^ (uint32_t)adc);
+    return sample_log_mix(h ^ (uint32_t)(adc >> 32));
+}
+
+static uint32_t sample_log_calib_crc(const sample_log_calib_t *c) {
+    return sample_log_crc32(c, offsetof(sample_log_calib_t, crc));
+}
+
+static int sample_log_calib_valid(const sample_log_calib_t *c) {
+    return c->used && c->sensor < SAMPLE_LOG_SENSORS && c->crc == sample_log_calib_crc(c);
+}
+
+static int sample_log_record_valid(const sample_log_record_t *r, uint32_t gen) {
+    return r->time_s != 0 && r->check == sample_log_check(gen, r->time_s, r->adc);
+}
+
+static uint64_t sample_log_pack(unsigned calib, int32_t adc_T, int32_t adc_P, int32_t adc_H) {
+    return ((uint64_t)((uint32_t)adc_T & 0xFFFFFu)) |
+           ((uint64_t)((uint32_t)adc_P & 0xFFFFFu) << 20) |
+           ((uint64_t)((uint32_t)adc_H & 0xFFFFu) << 40) |
+           ((uint64_t)(calib & 0xFFu) << 56);
+}
+
+/* Number of valid records at the start of a segment */
+static uint32_t sample_log_segment_fill(unsigned seg) {
+    uint32_t gen = sample_log_header()->gen[seg];
+    if (gen == 0) return 0;
+    const sample_log_record_t *r = sample_log_segment(seg);
+    uint32_t n = 0;
+    while (n < SAMPLE_LOG_SEGMENT_RECORDS && sample_log_record_valid(&r[n], gen)) ++n;
+    return n;
+}
+
+static void sample_log_reset(void) {
+    sample_log_header_t *hdr = sample_log_header();
+    memset(hdr, 0, SAMPLE_LOG_HEADER_SIZE);
+    hdr->magic = SAMPLE_LOG_MAGIC;
+    hdr->version = SAMPLE_LOG_VERSION;
+    hdr->record_size = sizeof(sample_log_record_t);
+    hdr->segments = SAMPLE_LOG_SEGMENTS;
+    hdr->segment_records = SAMPLE_LOG_SEGMENT_RECORDS;
+    hdr->gen[0] = 1;
+    msync(g_map, SAMPLE_LOG_HEADER_SIZE, MS_SYNC);
+}
+
+/* Move to the next segment; the header must reach the disk before any record
+ * of the new generation, or those records would not validate after a crash. */
+static void sample_log_rotate(void) {
+    sample_log_header_t *hdr = sample_log_header();
+    unsigned next = (g_active + 1u) % SAMPLE_LOG_SEGMENTS;
+    hdr->gen[next] = hdr->gen[g_active] + 1u;
+    g_active = next;
+    g_pos = 0;
+    msync(g_map, SAMPLE_LOG_HEADER_SIZE, MS_SYNC);
+}
+
+int sample_log_open(const char *path, unsigned sync_s) {
+    if (!path || !path[0]) { errno = EINVAL; return -1; }
+    if (g_map) { errno = EBUSY; return -1; }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) return -1;
+
+    const size_t size = SAMPLE_LOG_FILE_SIZE;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int e = errno; close(fd); errno = e;
+        return -1;
+    }
+    int fresh = (size_t)st.st_size != size;
+    if (fresh) {
+        /* Reserve every block now: no fragmentation or ENOSPC (SIGBUS through
+         * the mapping) later. Filesystems without fallocate get a sparse file. */
+        if (ftruncate(fd, 0) != 0 || (posix_fallocate(fd, 0, (off_t)size) != 0 && ftruncate(fd, (off_t)size) != 0)) {
+            int e = errno; close(fd); errno = e;
+            return -1;
+        }
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int e = errno;
+    close(fd); /* the mapping keeps the file open */
+    if (map == MAP_FAILED) { errno = e; return -1; }
+
+    pthread_mutex_lock(&g_lock);
+    g_map = (uint8_t *)map;
+    g_sync_s = sync_s;
+    sample_log_header_t *hdr = sample_log_header();
+    if (fresh || hdr->magic != SAMPLE_LOG_MAGIC || hdr->version != SAMPLE_LOG_VERSION ||
+        hdr->record_size != sizeof(sample_log_record_t) || hdr->segments != SAMPLE_LOG_SEGMENTS ||
+        hdr->segment_records != SAMPLE_LOG_SEGMENT_RECORDS) {
+        /* New file, older layout or different build: old records are unreadable
+         * (a preallocated file already reads as zeros) */
+        if (!fresh) memset(g_map + SAMPLE_LOG_HEADER_SIZE, 0, size - SAMPLE_LOG_HEADER_SIZE);
+        sample_log_reset();
+    }
+
+    /* The newest generation is the active segment; append after its last valid record */
+    g_active = 0;
+    for (unsigned s = 1; s < SAMPLE_LOG_SEGMENTS; ++s) {
+        if (hdr->gen[s] > hdr->gen[g_active]) g_active = s;
+    }
+    if (hdr->gen[g_active] == 0) sample_log_reset();
+    g_pos = sample_log_segment_fill(g_active);
+    g_calib_seq = 0;
+    int reopen = 0;
+    for (unsigned s = 0; s < SAMPLE_LOG_SENSORS; ++s) g_calib_cur[s] = -1;
+    for (unsigned i = 0; i < SAMPLE_LOG_CALIBS; ++i) {
+        const sample_log_calib_t *c = &hdr->calib[i];
+        if (!sample_log_calib_valid(c)) continue;
+        if (c->seq > g_calib_seq) g_calib_seq = c->seq;
+        int cur = g_calib_cur[c->sensor];
+        if (cur < 0 || c->seq > hdr->calib[cur].seq) g_calib_cur[c->sensor] = (int)i;
+        if (c->gen_from > hdr->gen[g_active]) reopen = 1;
+    }
+    /* Crashed between rewriting an evicted entry and its rotation reaching
+     * the disk: open the segment its gen_from names */
+    if (reopen) sample_log_rotate();
+    g_dirty_lo = g_dirty_hi = 0;
+    g_header_dirty = 0;
+    g_last_sync = time(NULL);
+    pthread_mutex_unlock(&g_lock);
+    return 0;
+}
+
+/* Make calib_raw the sensor's current calibration: an entry it had before
+ * (swapped back), a free one, or the oldest one of all. Reusing an entry that
+ * older records still name opens a new segment, so gen_from tells them apart.
+ * The entry is rewritten before the rotation's header msync: records of the
+ * new generation never reach the disk ahead of the entry they name. Returns
+ * the entry. */
+static unsigned sample_log_calib_register(unsigned sensor, const uint8_t calib_raw[BME280_CALIB_RAW_LEN]) {
+    sample_log_header_t *hdr = sample_log_header();
+    int slot = -1, free_slot = -1, oldest = -1;
+    for (unsigned i = 0; i < SAMPLE_LOG_CALIBS && slot < 0; ++i) {
+        const sample_log_calib_t *c = &hdr->calib[i];
+        if (!sample_log_calib_valid(c)) {
+            if (free_slot < 0) free_slot = (int)i;
+        } else if (c->sensor == sensor && memcmp(c->raw, calib_raw, sizeof(c->raw)) == 0) {
+            slot = (int)i;
+        } else if (g_calib_cur[c->sensor] != (int)i && (oldest < 0 || c->seq < hdr->calib[oldest].seq)) {
+            oldest = (int)i;
+        }
+    }
+    sample_log_calib_t *c;
+    int evict = 0;
+    if (slot >= 0) {
+        c = &hdr->calib[slot];
+    } else if (free_slot >= 0) {
+        slot = free_slot;
+        c = &hdr->calib[slot];
+        memset(c, 0, sizeof(*c));
+        c->used = 1;
+        c->sensor = (uint8_t)sensor;
+        memcpy(c->raw, calib_raw, sizeof(c->raw));
+        c->gen_from = hdr->gen[g_active]; /* no record names a never used entry */
+    } else {
+        /* Current entries are never evicted, and there are more entries than sensors */
+        slot = oldest;
+        c = &hdr->calib[slot];
+        c->sensor = (uint8_t)sensor;
+        memcpy(c->raw, calib_raw, sizeof(c->raw));
+        c->gen_from = hdr->gen[g_active] + 1u; /* the segment sample_log_rotate() opens below */
+        evict = 1;
+    }
+    c->seq = ++g_calib_seq;
+    c->crc = sample_log_calib_crc(c);
+    g_calib_cur[sensor] = slot;
+    if (evict) sample_log_rotate(); /* syncs the header */
+    else g_header_dirty = 1;
+    return (unsigned)slot;
+}
+
+int sample_log_append(unsigned sensor, uint32_t time_s, int32_t adc_T, int32_t adc_P, int32_t adc_H,
+                      const uint8_t calib_raw[BME280_CALIB_RAW_LEN]) {
+    if (!g_map || sensor >= SAMPLE_LOG_SENSORS || time_s == 0) return -1;
+
+    pthread_mutex_lock(&g_lock);
+    sample_log_header_t *hdr = sample_log_header();
+    int cur = g_calib_cur[sensor];
+    if (calib_raw && (cur < 0 || memcmp(hdr->calib[cur].raw, calib_raw, BME280_CALIB_RAW_LEN) != 0)) {
+        cur = (int)sample_log_calib_register(sensor, calib_raw);
+    }
+    if (cur < 0) {
+        pthread_mutex_unlock(&g_lock);
+        return -1;
+    }
+    if (g_pos == SAMPLE_LOG_SEGMENT_RECORDS) sample_log_rotate();
+
+    sample_log_record_t *r = &sample_log_segment(g_active)[g_pos];
+    uint64_t adc = sample_log_pack((unsigned)cur, adc_T, adc_P, adc_H);
+    r->time_s = time_s;
+    r->adc = adc;
+    r->check = sample_log_check(hdr->gen[g_active], time_s, adc);
+    g_pos++;
+
+    size_t off = (size_t)((uint8_t *)r - g_map);
+    if (g_dirty_lo == g_dirty_hi) {
+        g_dirty_lo = off;
+        g_dirty_hi = off + sizeof(*r);
+    } else {
+        if (off < g_dirty_lo) g_dirty_lo = off;
+        if (off + sizeof(*r) > g_dirty_hi) g_dirty_hi = off + sizeof(*r);
+    }
+
+    time_t now = time(NULL);
+    size_t lo = 0, hi = 0;
+    if (now - g_last_sync >= (time_t)g_sync_s || now < g_last_sync) {
+        lo = g_header_dirty ? 0 : g_dirty_lo & ~(size_t)(SAMPLE_LOG_HEADER_SIZE - 1u); /* page aligned */
+        hi = g_dirty_hi;
+        g_dirty_lo = g_dirty_hi = 0;
+        g_header_dirty = 0;
+        g_last_sync = now;
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    /* Flush outside the lock so other sensors keep appending meanwhile */
+    if (hi > lo) {
+        msync(g_map + lo, hi - lo, MS_SYNC);
+        perf_count_add(PERF_CNT_SAMPLE_LOG_SYNCS, 1);
+    }
+    return 0;
+}
+
+typedef struct {
+    int32_t  adc_T[SAMPLE_LOG_REPLAY_BATCH];
+    int32_t  adc_P[SAMPLE_LOG_REPLAY_BATCH];
+    int32_t  adc_H[SAMPLE_LOG_REPLAY_BATCH];
+    uint32_t time_s[SAMPLE_LOG_REPLAY_BATCH];
+    unsigned n;
+} sample_log_batch_t;
+
+static void sample_log_replay_flush(const bme280_calib_t *calib, sample_log_batch_t *b, history_t *h) {
+    bme280_reading_t r[SAMPLE_LOG_REPLAY_BATCH];
+    bme280_compensate_batch(calib, b->adc_T, b->adc_P, b->adc_H, b->n, r);
+    for (unsigned j = 0; j < b->n; ++j) {
+        const float v[HISTORY_CH_COUNT] = { r[j].temperature_c, r[j].pressure_pa / 100.0f, r[j].humidity_rh };
+        history_insert(h, b->time_s[j], v);
+    }
+    b->n = 0;
+}
+
+unsigned sample_log_replay(unsigned sensor, history_t *h) {
+    if (!g_map || !h || sensor >= SAMPLE_LOG_SENSORS) return 0;
+
+    pthread_mutex_lock(&g_lock);
+    const sample_log_header_t *hdr = sample_log_header();
+    uint8_t mine[SAMPLE_LOG_CALIBS]; /* entries of this sensor */
+    for (unsigned i = 0; i < SAMPLE_LOG_CALIBS; ++i) {
+        mine[i] = sample_log_calib_valid(&hdr->calib[i]) && hdr->calib[i].sensor == sensor;
+    }
+
+    /* Records are read in place: unpack the ADC fields into struct-of-arrays
+     * batches and compensate each batch in one call, one calibration per batch */
+    bme280_calib_t calib;
+    unsigned calib_id = SAMPLE_LOG_CALIBS;
+    sample_log_batch_t b;
+    b.n = 0;
+    unsigned total = 0;
+    /* Oldest segment first: the one after the active segment, around the ring */
+    for (unsigned k = 1; k <= SAMPLE_LOG_SEGMENTS; ++k) {
+        unsigned seg = (g_active + k) % SAMPLE_LOG_SEGMENTS;
+        uint32_t fill = seg == g_active ? g_pos : sample_log_segment_fill(seg);
+        const sample_log_record_t *rec = sample_log_segment(seg);
+        for (uint32_t i = 0; i < fill; ++i) {
+            uint64_t adc = rec[i].adc;
+            unsigned id = (unsigned)(adc >> 56);
+            if (id >= SAMPLE_LOG_CALIBS || !mine[id] || hdr->gen[seg] < hdr->calib[id].gen_from) continue;
+            if (id != calib_id) {
+                if (b.n) sample_log_replay_flush(&calib, &b, h);
+                bme280_parse_calibration(hdr->calib[id].raw, &calib);
+                calib_id = id;
+            }
+            b.time_s[b.n] = rec[i].time_s;
+            b.adc_T[b.n] = (int32_t)(adc & 0xFFFFFu);
+            b.adc_P[b.n] = (int32_t)((adc >> 20) & 0xFFFFFu);
+            b.adc_H[b.n] = (int32_t)((adc >> 40) & 0xFFFFu);
+            total++;
+            if (++b.n == SAMPLE_LOG_REPLAY_BATCH) sample_log_replay_flush(&calib, &b, h);
+        }
+    }
+    if (b.n) sample_log_replay_flush(&calib, &b, h);
+    pthread_mutex_unlock(&g_lock);
+    return total;
+}
+
+#else /* !__linux__ */
+
+int sample_log_open(const char *path, unsigned sync_s) {
+    (void)path; (void)sync_s;
+    return -1;
+}
+
+int sample_log_append(unsigned sensor, uint32_t time_s, int32_t adc_T, int32_t adc_P, int32_t adc_H,
+                      const uint8_t calib_raw[BME280_CALIB_RAW_LEN]) {
+    (void)sensor; (void)time_s; (void)adc_T; (void)adc_P; (void)adc_H; (void)calib_raw;
+    return -1;
+}
+
+unsigned sample_log_replay(unsigned sensor, history_t *h) {
+    (void)sensor; (void)h;
+    return 0;
+}
+
+#endif /* __linux__ */
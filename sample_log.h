@@ -0,0 +1,89 @@
+#ifndef SAMPLE_LOG_H
+#define SAMPLE_LOG_H
+
+/*
+ * Persistent raw sample log (Linux).
+ *
+ * Each sample is stored as the raw BME280 ADC tuple plus its timestamp in a
+ * preallocated, mmap'ed file that is split into SAMPLE_LOG_SEGMENTS segments
+ * and used as a ring: when the active segment is full the oldest one is
+ * recycled. Appending is a 16-byte store into the mapping; dirty pages are
+ * flushed with one msync() every sync_s seconds instead of a write() per
+ * sample. Every calibration a sensor was read with gets its own entry in the
+ * file header and each record names its entry, so samples taken before a
+ * sensor was swapped are still compensated with the calibration they were
+ * read with.
+ *
+ * File layout (native endianness, v2):
+ *   header, 4096 bytes
+ *     u32 magic, u16 version, u16 record_size, u32 segments, u32 segment_records
+ *     u32 gen[SAMPLE_LOG_SEGMENTS]        segment generation, 0 = never used
+ *     calibration entry [SAMPLE_LOG_CALIBS]
+ *                  used flag, sensor index, NVM bytes, seq (newest of a sensor
+ *                  is its current one), gen_from, CRC-32
+ *   segments, SAMPLE_LOG_SEGMENT_RECORDS records of 16 bytes each
+ *     u32 time_s   seconds since the epoch
+ *     u32 check    hash of the record and its segment generation
+ *     u64 adc      adc_T bits 0..19, adc_P 20..39, adc_H 40..55, calibration
+ *                  entry 56..63
+ *
+ * With every entry in use, a new calibration takes the oldest entry and opens
+ * a new segment; its gen_from then excludes the older records that still name
+ * the entry, which drop out of replay. The entry is on disk before the new
+ * segment is, so no record is ever compensated with the evicted calibration.
+ *
+ * Crash recovery: a segment's records are valid up to the first one whose
+ * check does not match (never written, torn, or left over from an older lap
+ * of the ring), so no separate index has to be kept consistent. At most the
+ * samples since the last msync() are lost.
+ */
+
+#include <stdint.h>
+#include "BME280.h"
+#include "history.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SAMPLE_LOG_MAGIC   0x314C5857u /* "WXL1" */
+#define SAMPLE_LOG_VERSION 2u
+
+#ifndef SAMPLE_LOG_SEGMENTS
+#define SAMPLE_LOG_SEGMENTS 8
+#endif
+#ifndef SAMPLE_LOG_SEGMENT_RECORDS
+#define SAMPLE_LOG_SEGMENT_RECORDS 16384  /* 256 KiB per segment, 2 MiB file */
+#endif
+#ifndef SAMPLE_LOG_SENSORS
+#define SAMPLE_LOG_SENSORS 16             /* sensor indices */
+#endif
+#ifndef SAMPLE_LOG_CALIBS
+#define SAMPLE_LOG_CALIBS 64              /* calibration entries, all sensors (at most 256) */
+#endif
+#ifndef SAMPLE_LOG_SYNC_SEC
+#define SAMPLE_LOG_SYNC_SEC 300
+#endif
+
+/* Open (creating and preallocating as needed) the log at path and find the
+ * append position. A file with another layout is reset. sync_s is the msync
+ * cadence; 0 flushes after every sample. Returns 0, or -1 with errno set. */
+int sample_log_open(const char *path, unsigned sync_s);
+
+/* Append one sample from any thread. calib_raw is the NVM calibration the ADC
+ * values were read with (a new entry when it differs from the sensor's current
+ * one; NULL: the current one). Returns 0, or -1 if the log is not open, sensor
+ * is out of range or it has no calibration yet. */
+int sample_log_append(unsigned sensor, uint32_t time_s, int32_t adc_T, int32_t adc_P, int32_t adc_H,
+                      const uint8_t calib_raw[BME280_CALIB_RAW_LEN]);
+
+/* Compensate every stored sample of one sensor with the calibration it was
+ * read with, oldest first, and fold it into h. Call before the history writer
+ * starts. Returns the number of samples replayed (0 without a log). */
+unsigned sample_log_replay(unsigned sensor, history_t *h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_LOG_H */
@@ -0,0 +1,93 @@
+#include "sample_sched.h"
+
+#include <math.h>
+#include <string.h>
+
+static const bme280_settings_t g_level_settings[SAMPLE_SCHED_LEVELS] = {
+    [SAMPLE_SCHED_QUIET] = {
+        .osr_t = BME280_OSRS_X1, .osr_p = BME280_OSRS_X1, .osr_h = BME280_OSRS_X1,
+        .filter = BME280_FILTER_OFF, .standby = BME280_STANDBY_1000_MS, .mode = BME280_FORCED_MODE,
+    },
+    [SAMPLE_SCHED_NORMAL] = {
+        .osr_t = BME280_OSRS_X1, .osr_p = BME280_OSRS_X4, .osr_h = BME280_OSRS_X1,
+        .filter = BME280_FILTER_OFF, .standby = BME280_STANDBY_1000_MS, .mode = BME280_FORCED_MODE,
+    },
+    [SAMPLE_SCHED_EVENT] = {
+        .osr_t = BME280_OSRS_X2, .osr_p = BME280_OSRS_X16, .osr_h = BME280_OSRS_X2,
+        .filter = BME280_FILTER_4, .standby = BME280_STANDBY_1000_MS, .mode = BME280_NORMAL_MODE,
+    },
+};
+
+static const float g_threshold[3] = { SAMPLE_SCHED_DT_C, SAMPLE_SCHED_DP_HPA, SAMPLE_SCHED_DH_RH };
+
+void sample_sched_init(sample_sched_t *s, sample_sched_level_t level, uint32_t now_s) {
+    memset(s, 0, sizeof(*s));
+    s->level = level < SAMPLE_SCHED_LEVELS ? level : SAMPLE_SCHED_NORMAL;
+    s->hold_until_s = now_s + SAMPLE_SCHED_HOLD_S;
+}
+
+/* Largest channel spread over the window, in units of its threshold */
+static float sample_sched_score(const sample_sched_t *s, uint32_t id) {
+    float score = 0.0f;
+    for (int c = 0; c < 3; ++c) {
+        float lo = INFINITY, hi = -INFINITY;
+        for (unsigned i = 0; i < SAMPLE_SCHED_BUCKETS; ++i) {
+            const sample_sched_bucket_t *b = &s->bucket[i];
+            if (b->id == 0 || b->id + SAMPLE_SCHED_BUCKETS <= id) continue; /* empty or expired */
+            if (b->min[c] < lo) lo = b->min[c];
+            if (b->max[c] > hi) hi = b->max[c];
+        }
+        if (hi >= lo && (hi - lo) / g_threshold[c] > score) score = (hi - lo) / g_threshold[c];
+    }
+    return score;
+}
+
+sample_sched_level_t sample_sched_update(sample_sched_t *s, uint32_t now_s, float t, float p, float h) {
+    const float v[3] = { t, p, h };
+    uint32_t id = now_s / SAMPLE_SCHED_BUCKET_S + 1u;
+    sample_sched_bucket_t *b = &s->bucket[id % SAMPLE_SCHED_BUCKETS];
+    if (b->id != id) {
+        b->id = id;
+        for (int c = 0; c < 3; ++c) { b->min[c] = INFINITY; b->max[c] = -INFINITY; }
+    }
+    for (int c = 0; c < 3; ++c) {
+        if (isnan(v[c])) continue;
+        if (v[c] < b->min[c]) b->min[c] = v[c];
+        if (v[c] > b->max[c]) b->max[c] = v[c];
+    }
+
+    s->score = sample_sched_score(s, id);
+    sample_sched_level_t want = s->score >= 1.0f ? SAMPLE_SCHED_EVENT
+                              : s->score >= 0.5f ? SAMPLE_SCHED_NORMAL : SAMPLE_SCHED_QUIET;
+    if (want >= s->level) {
+        /* Escalate at once; activity at the current level renews its hold */
+        s->level = want;
+        s->hold_until_s = now_s + SAMPLE_SCHED_HOLD_S;
+    } else if ((int32_t)(now_s - s->hold_until_s) >= 0) {
+        s->level = (sample_sched_level_t)(s->level - 1);
+        s->hold_until_s = now_s + SAMPLE_SCHED_HOLD_S;
+    }
+    return s->level;
+}
+
+const bme280_settings_t *sample_sched_settings(sample_sched_level_t level) {
+    return &g_level_settings[level < SAMPLE_SCHED_LEVELS ? level : SAMPLE_SCHED_NORMAL];
+}
+
+uint64_t sample_sched_interval_ms(sample_sched_level_t level, uint64_t base_ms) {
+    switch (level) {
+    case SAMPLE_SCHED_QUIET:
+        return base_ms * SAMPLE_SCHED_QUIET_FACTOR;
+    case SAMPLE_SCHED_EVENT: {
+        uint64_t ms = base_ms / SAMPLE_SCHED_EVENT_DIVISOR;
+        return ms < 1000u ? (base_ms < 1000u ? base_ms : 1000u) : ms;
+    }
+    default:
+        return base_ms;
+    }
+}
+
+const char *sample_sched_level_name(sample_sched_level_t level) {
+    static const char *const names[SAMPLE_SCHED_LEVELS] = { "quiet", "normal", "event" };
+    return level < SAMPLE_SCHED_LEVELS ? names[level] : "?";
+}
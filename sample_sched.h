@@ -0,0 +1,99 @@
+#ifndef SAMPLE_SCHED_H
+#define SAMPLE_SCHED_H
+
+/*
+ * Adaptive sampling scheduler: picks a device's sampling rate, oversampling
+ * and filter from how fast the weather is changing.
+ *
+ * Three levels:
+ *   QUIET   forced mode, x1 oversampling, no filter, every base * QUIET_FACTOR;
+ *           the sensor sleeps between samples (no self-heating, fewest bus
+ *           transfers)
+ *   NORMAL  forced mode, pressure x4, every base interval
+ *   EVENT   normal mode (1 s standby), T x2 / P x16 / H x2, IIR filter 4, every
+ *           base / EVENT_DIVISOR (at least 1 s)
+ *
+ * Every valid sample is folded into a ring of 1 min min/max buckets covering
+ * SAMPLE_SCHED_WINDOW_S. The spread of each channel over the window, relative
+ * to its threshold (a pressure drop or rise of SAMPLE_SCHED_DP_HPA, a humidity
+ * swing of SAMPLE_SCHED_DH_RH, a temperature swing of SAMPLE_SCHED_DT_C), is
+ * the activity score: >= 1 jumps straight to EVENT, >= 1/2 raises to at least
+ * NORMAL. Levels only step down one at a time, after SAMPLE_SCHED_HOLD_S
+ * without activity that would justify the current level. The window is
+ * time-based, so the score does not depend on the rate being sampled at.
+ *
+ * Pure state machine, no bus access; one sample_sched_t per device, owned by
+ * its sampling thread.
+ */
+
+#include <stdint.h>
+#include "BME280.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SAMPLE_SCHED_WINDOW_S
+#define SAMPLE_SCHED_WINDOW_S 600      /* change-rate window */
+#endif
+#ifndef SAMPLE_SCHED_HOLD_S
+#define SAMPLE_SCHED_HOLD_S 600        /* minimum dwell before stepping down */
+#endif
+#ifndef SAMPLE_SCHED_DP_HPA
+#define SAMPLE_SCHED_DP_HPA 0.4f       /* per window: about 2.5 hPa/h, a fast front */
+#endif
+#ifndef SAMPLE_SCHED_DH_RH
+#define SAMPLE_SCHED_DH_RH 5.0f
+#endif
+#ifndef SAMPLE_SCHED_DT_C
+#define SAMPLE_SCHED_DT_C 1.0f
+#endif
+#ifndef SAMPLE_SCHED_QUIET_FACTOR
+#define SAMPLE_SCHED_QUIET_FACTOR 2    /* QUIET interval = base * this */
+#endif
+#ifndef SAMPLE_SCHED_EVENT_DIVISOR
+#define SAMPLE_SCHED_EVENT_DIVISOR 6   /* EVENT interval = base / this */
+#endif
+
+#define SAMPLE_SCHED_BUCKET_S 60
+#define SAMPLE_SCHED_BUCKETS  (SAMPLE_SCHED_WINDOW_S / SAMPLE_SCHED_BUCKET_S)
+
+typedef enum {
+    SAMPLE_SCHED_QUIET = 0,
+    SAMPLE_SCHED_NORMAL,
+    SAMPLE_SCHED_EVENT,
+    SAMPLE_SCHED_LEVELS
+} sample_sched_level_t;
+
+typedef struct {
+    uint32_t id;                 /* time_s / SAMPLE_SCHED_BUCKET_S + 1; 0 = empty */
+    float    min[3], max[3];     /* temperature, pressure, humidity */
+} sample_sched_bucket_t;
+
+typedef struct {
+    sample_sched_bucket_t bucket[SAMPLE_SCHED_BUCKETS];
+    sample_sched_level_t  level;
+    uint32_t              hold_until_s;
+    float                 score;  /* last activity score */
+} sample_sched_t;
+
+/* Start at level with an empty window; now_s is a monotonic seconds clock. */
+void sample_sched_init(sample_sched_t *s, sample_sched_level_t level, uint32_t now_s);
+
+/* Fold one valid sample (Celsius, hPa, %RH) in and return the level to sample
+ * at from now on. */
+sample_sched_level_t sample_sched_update(sample_sched_t *s, uint32_t now_s, float t, float p, float h);
+
+/* Sensor settings of a level. */
+const bme280_settings_t *sample_sched_settings(sample_sched_level_t level);
+
+/* Sampling interval of a level for a base interval (both in ms). */
+uint64_t sample_sched_interval_ms(sample_sched_level_t level, uint64_t base_ms);
+
+const char *sample_sched_level_name(sample_sched_level_t level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_SCHED_H */
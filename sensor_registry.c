@@ -0,0 +1,877 @@
+/* The spidev helper is header-only; this is its one implementation unit. The
+ * define must precede every include that pulls SPIDevice.h in. */
+#define SPIDEVICE_IMPLEMENTATION
+#include "SPIDevice.h"
+
+#include "sensor_registry.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "BME280.h"
+#include "BME280_I2CDevice.h"
+#include "BME280_SPIDevice.h"
+#include "BME280_CalibCache.h"
+#include "derived.h"
+#include "perf_stats.h"
+#include "sample_filter.h"
+#include "sample_sched.h"
+#include "snapshot.h"
+#include "thread_policy.h"
+#ifdef BME280_FIXED_BUS
+#include "BME280_Fixed.h"
+#endif
+
+#ifndef BME280_CALIB_CACHE_FILE
+#define BME280_CALIB_CACHE_FILE "/var/tmp/weather_bme280.calib"
+#endif
+
+#define SENSOR_SPI_DEFAULT_HZ 8000000u
+
+typedef struct {
+    sensor_config_t  cfg;
+    unsigned         group;     /* bus group: devices sharing path share a worker */
+    bme280_t         bme;
+    I2CDevice        i2c;
+    SPIDevice        spi;
+    SPIQueue         spiq;      /* SPI: whole measurement cycle in one ioctl */
+    bme280_bus_t     inner;     /* adapter callbacks (BME280_I2CDevice / BME280_SPIDevice) */
+#ifdef BME280_FIXED_BUS
+    bme280_fixed_t   fixed;     /* build-time specialized driver replaces bme/i2c/spi */
+#endif
+    int              injected;  /* bus from the bus factory (sensor_bus_factory_t) */
+    int              attached;  /* owner thread only (see owned) */
+    int              owned;     /* 0: discovery thread, 1: sampling worker (atomic) */
+    uint64_t         next_probe_ns;  /* CLOCK_MONOTONIC; re-probe deadline while detached */
+    uint64_t         next_sample_ns; /* CLOCK_MONOTONIC; next sample while attached */
+    uint64_t         interval_ns;    /* current sampling interval */
+    sample_sched_t   sched;          /* adaptive mode: level and change-rate window */
+    sample_filter_t  filter;         /* outlier rejection and smoothing; reset on attach */
+    derived_t        derived;        /* derived metrics; kept across re-attaches */
+    uint32_t         backoff_ms;     /* current re-probe delay, 0 after a successful attach */
+    uint8_t          addr;
+    unsigned long    ok, err;
+    sensor_sample_t  slots[3];
+    snapshot_t       snap;
+} sensor_dev_t;
+
+static sensor_dev_t g_devs[SENSOR_REGISTRY_MAX];
+static unsigned g_dev_count = 0;
+static unsigned g_group_count = 0;
+static unsigned g_workers = 0;  /* workers running; devices go to group % g_workers (atomic) */
+static uint64_t g_refresh_ns = 30ull * 1000000000ull;
+#ifdef BME280_FIXED_BUS
+static int g_adaptive = 0;      /* settings are fixed at build time */
+#else
+static int g_adaptive = 1;
+#endif
+static float g_altitude_m = NAN;
+static sample_filter_config_t g_filter_cfg;
+static int g_filter_set = 0;    /* else SAMPLE_FILTER_DEFAULT */
+static sensor_sample_cb_t g_cb = NULL;
+static void *g_cb_user = NULL;
+
+#ifndef BME280_FIXED_BUS
+static sensor_bus_factory_t g_factory;
+static int g_factory_set = 0;
+#endif
+
+/* Guards the shared calibration cache mapping (lookups and stores only) */
+static pthread_mutex_t g_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static bme280_calib_cache_t g_calib_cache = { .fd = -1, .map = NULL, .lock = &g_cache_lock };
+
+/* Fixed-rate mode: continuous measurement, x1 oversampling, no filter */
+static const bme280_settings_t g_settings = {
+    .osr_t = BME280_OSRS_X1, .osr_p = BME280_OSRS_X1, .osr_h = BME280_OSRS_X1,
+    .filter = BME280_FILTER_OFF, .standby = BME280_STANDBY_1000_MS, .mode = BME280_NORMAL_MODE,
+};
+
+/* ===== Clock (default: CLOCK_MONOTONIC, see sensor_clock_t) ===== */
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;   /* CLOCK_MONOTONIC */
+    int             kick;   /* a device was handed over */
+} sensor_worker_t;
+
+static sensor_worker_t g_worker[SENSOR_WORKERS_MAX];
+
+static uint64_t sensor_mono_now_ns(void *user) {
+    (void)user;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t sensor_mono_time_s(void *user) {
+    (void)user;
+    return (uint32_t)time(NULL);
+}
+
+static void sensor_mono_sleep_until(void *user, uint64_t deadline_ns) {
+    (void)user;
+    struct timespec ts = { (time_t)(deadline_ns / 1000000000ull), (long)(deadline_ns % 1000000000ull) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+}
+
+static void sensor_mono_wait(void *user, unsigned w, uint64_t deadline_ns) {
+    (void)user;
+    sensor_worker_t *wk = &g_worker[w];
+    struct timespec ts = { (time_t)(deadline_ns / 1000000000ull), (long)(deadline_ns % 1000000000ull) };
+    pthread_mutex_lock(&wk->lock);
+    while (!wk->kick && pthread_cond_timedwait(&wk->cond, &wk->lock, &ts) != ETIMEDOUT) {}
+    wk->kick = 0;
+    pthread_mutex_unlock(&wk->lock);
+}
+
+static void sensor_mono_wake(void *user, unsigned w) {
+    (void)user;
+    pthread_mutex_lock(&g_worker[w].lock);
+    g_worker[w].kick = 1;
+    pthread_cond_signal(&g_worker[w].cond);
+    pthread_mutex_unlock(&g_worker[w].lock);
+}
+
+static const sensor_clock_t g_mono_clock = {
+    sensor_mono_now_ns, sensor_mono_time_s, sensor_mono_sleep_until, sensor_mono_wait, sensor_mono_wake, NULL, NULL,
+};
+static sensor_clock_t g_clock = {
+    sensor_mono_now_ns, sensor_mono_time_s, sensor_mono_sleep_until, sensor_mono_wait, sensor_mono_wake, NULL, NULL,
+};
+
+static uint64_t sensor_now_ns(void) {
+    return g_clock.now_ns(g_clock.user);
+}
+
+static uint32_t sensor_now_s(void) {
+    return (uint32_t)(sensor_now_ns() / 1000000000ull);
+}
+
+static void sensor_sleep_us(uint32_t us) {
+    g_clock.sleep_until(g_clock.user, sensor_now_ns() + (uint64_t)us * 1000u);
+}
+
+static void sensor_thread(int delta) {
+    if (g_clock.thread) g_clock.thread(g_clock.user, delta);
+}
+
+int sensor_registry_set_clock(const sensor_clock_t *clock) {
+    if (g_workers) return -1;
+    g_clock = clock ? *clock : g_mono_clock;
+    return 0;
+}
+
+int sensor_registry_set_bus_factory(const sensor_bus_factory_t *factory) {
+#ifdef BME280_FIXED_BUS
+    (void)factory;
+    return -1;
+#else
+    if (g_workers) return -1;
+    if (factory) g_factory = *factory;
+    g_factory_set = factory != NULL;
+    return 0;
+#endif
+}
+
+/* ===== Config parsing ===== */
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) ++s;
+    char *e = s + strlen(s);
+    while (e > s && isspace((unsigned char)e[-1])) *--e = '\0';
+    return s;
+}
+
+int sensor_registry_parse_spec(const char *spec, sensor_config_t *out) {
+    if (!spec || !out) return -1;
+    char buf[SENSOR_PATH_MAX + SENSOR_NAME_MAX + 32];
+    if (strlen(spec) >= sizeof(buf)) return -1;
+    strcpy(buf, spec);
+
+    memset(out, 0, sizeof(*out));
+    /* strsep keeps empty fields, so "i2c:/dev/i2c-1::Name" probes both addresses */
+    char *rest = buf;
+    char *kind = strsep(&rest, ":");
+    char *path = strsep(&rest, ":");
+    char *arg  = strsep(&rest, ":");
+    char *name = rest;
+    if (!kind || !path || !*path || strlen(path) >= sizeof(out->path)) return -1;
+
+    if (strcmp(kind, "i2c") == 0) {
+        out->bus = SENSOR_BUS_I2C;
+        if (arg && *arg) {
+            char *end = NULL;
+            unsigned long a = strtoul(arg, &end, 0);
+            if (*end || a > 0x7F) return -1;
+            out->addr = (uint8_t)a;
+        }
+    } else if (strcmp(kind, "spi") == 0) {
+        out->bus = SENSOR_BUS_SPI;
+        out->spi_speed_hz = SENSOR_SPI_DEFAULT_HZ;
+        if (arg && *arg) {
+            char *end = NULL;
+            unsigned long hz = strtoul(arg, &end, 0);
+            if (*end || hz == 0) return -1;
+            out->spi_speed_hz = (uint32_t)hz;
+        }
+    } else {
+        return -1;
+    }
+    strcpy(out->path, path);
+    if (name && *name) {
+        snprintf(out->name, sizeof(out->name), "%s", name);
+    } else {
+        const char *base = strrchr(out->path, '/');
+        snprintf(out->name, sizeof(out->name), "%s", base ? base + 1 : out->path);
+    }
+    return 0;
+}
+
+int sensor_registry_add(const sensor_config_t *cfg) {
+    if (!cfg || g_dev_count >= SENSOR_REGISTRY_MAX || g_workers) return -1;
+#ifdef BME280_FIXED_BUS
+    /* The bus type is part of the build; the spec's I2C address is ignored */
+    if (cfg->bus != (BME280_FIXED_BUS == BME280_FIXED_BUS_SPI ? SENSOR_BUS_SPI : SENSOR_BUS_I2C)) return -1;
+#endif
+    sensor_dev_t *d = &g_devs[g_dev_count];
+    memset(d, 0, sizeof(*d));
+    d->cfg = *cfg;
+    d->i2c.fd = -1;
+    d->spi.fd = -1;
+#ifdef BME280_FIXED_BUS
+    d->fixed.fd = -1;
+#endif
+
+    d->group = g_group_count;
+    for (unsigned i = 0; i < g_dev_count; ++i) {
+        if (strcmp(g_devs[i].cfg.path, cfg->path) == 0) { d->group = g_devs[i].group; break; }
+    }
+    if (d->group == g_group_count) g_group_count++;
+
+    for (int s = 0; s < 3; ++s) {
+        d->slots[s] = (sensor_sample_t){ .temperature = NAN, .pressure = NAN, .humidity = NAN,
+                                         .derived = { NAN, NAN, NAN, NAN } };
+    }
+    snapshot_init(&d->snap, d->slots, sizeof(d->slots[0]));
+    return (int)g_dev_count++;
+}
+
+int sensor_registry_add_spec(const char *spec) {
+    sensor_config_t cfg;
+    if (sensor_registry_parse_spec(spec, &cfg) != 0) return -1;
+    return sensor_registry_add(&cfg);
+}
+
+int sensor_registry_load_file(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    char line[256];
+    int added = 0, lineno = 0;
+    while (fgets(line, sizeof(line), f)) {
+        ++lineno;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *spec = trim(line);
+        if (!*spec) continue;
+        if (sensor_registry_add_spec(spec) < 0) {
+            fprintf(stderr, "%s:%d: ignoring sensor spec '%s'\n", path, lineno, spec);
+            continue;
+        }
+        ++added;
+    }
+    fclose(f);
+    return added;
+}
+
+unsigned sensor_registry_count(void) {
+    return g_dev_count;
+}
+
+const sensor_config_t *sensor_registry_config(unsigned index) {
+    return index < g_dev_count ? &g_devs[index].cfg : NULL;
+}
+
+/* ===== Bus wrapper: time every transfer for perf_stats ===== */
+
+static __thread uint64_t t_bus_ns = 0;   /* per worker, reset per sample */
+static __thread uint64_t t_wait_ns = 0;
+
+static int sensor_bus_read(void *user, uint8_t reg, uint8_t *buf, size_t len) {
+    sensor_dev_t *d = (sensor_dev_t *)user;
+    uint64_t t0 = perf_now_ns();
+    int rc = d->inner.read(d->inner.user, reg, buf, len);
+    t_bus_ns += perf_now_ns() - t0;
+    perf_count_add(d->cfg.bus == SENSOR_BUS_SPI ? PERF_CNT_SPI_IOCTLS : PERF_CNT_I2C_IOCTLS, 1);
+    return rc;
+}
+
+static int sensor_bus_write(void *user, uint8_t reg, const uint8_t *buf, size_t len) {
+    sensor_dev_t *d = (sensor_dev_t *)user;
+    uint64_t t0 = perf_now_ns();
+    int rc = d->inner.write(d->inner.user, reg, buf, len);
+    t_bus_ns += perf_now_ns() - t0;
+    perf_count_add(d->cfg.bus == SENSOR_BUS_SPI ? PERF_CNT_SPI_IOCTLS : PERF_CNT_I2C_IOCTLS, 1);
+    return rc;
+}
+
+/* Conversion waits go through the registry clock, not the bus's delay_ms */
+static void sensor_bus_delay(void *user, uint32_t ms) {
+    (void)user;
+    uint64_t t0 = perf_now_ns();
+    sensor_sleep_us(ms * 1000u);
+    t_wait_ns += perf_now_ns() - t0;
+}
+
+/* ===== Attach / sample (owner thread) ===== */
+
+static const bme280_settings_t *sensor_settings(const sensor_dev_t *d) {
+    return g_adaptive ? sample_sched_settings(d->sched.level) : &g_settings;
+}
+
+static uint64_t sensor_interval_ns(const sensor_dev_t *d) {
+    if (!g_adaptive) return g_refresh_ns;
+    return sample_sched_interval_ms(d->sched.level, g_refresh_ns / 1000000ull) * 1000000ull;
+}
+
+static void sensor_close(sensor_dev_t *d) {
+#ifdef BME280_FIXED_BUS
+    bme280_fixed_close(&d->fixed);
+#else
+    if (d->injected) {
+        g_factory.close(g_factory.user, (unsigned)(d - g_devs));
+        i2c_device_clear(&d->i2c);
+    } else if (d->cfg.bus == SENSOR_BUS_SPI) spi_device_close(&d->spi);
+    else i2c_device_close(&d->i2c);
+#endif
+    d->attached = 0;
+    d->injected = 0;
+}
+
+/* Cached fast attach (or full init) on the already open bus handle, then the
+ * settings of the current sampling level. The cache lock is never held across
+ * bus I/O (bme280_init_cached), so a hung bus cannot stall other workers. */
+static int sensor_init_bme(sensor_dev_t *d, uint8_t addr) {
+    const bme280_bus_t bus = { sensor_bus_read, sensor_bus_write, sensor_bus_delay, d };
+    int rc = bme280_init_cached(&d->bme, &bus, addr, &g_calib_cache, d->cfg.path, NULL);
+    if (rc != BME280_OK) return rc;
+    return bme280_apply_settings(&d->bme, sensor_settings(d));
+}
+
+static int sensor_attach(sensor_dev_t *d) {
+    /* A fresh attach starts at NORMAL with an empty window */
+    sample_sched_init(&d->sched, SAMPLE_SCHED_NORMAL, sensor_now_s());
+    sample_filter_init(&d->filter, &g_filter_cfg);
+    d->interval_ns = sensor_interval_ns(d);
+#ifdef BME280_FIXED_BUS
+    if (bme280_fixed_open(&d->fixed, d->cfg.path) != BME280_OK) return -1;
+    d->addr = BME280_FIXED_BUS == BME280_FIXED_BUS_I2C ? BME280_FIXED_ADDR : 0;
+#else
+    if (g_factory_set) {
+        /* Same probe order as the adapter nodes below */
+        const uint8_t probe[] = { BME280_I2C_ADDR_SDO_HIGH, BME280_I2C_ADDR_SDO_LOW };
+        const uint8_t spi = 0;
+        const uint8_t *addrs = d->cfg.bus == SENSOR_BUS_SPI ? &spi : d->cfg.addr ? &d->cfg.addr : probe;
+        size_t naddrs = d->cfg.bus == SENSOR_BUS_SPI || d->cfg.addr ? 1 : sizeof(probe);
+        size_t i = 0;
+        for (; i < naddrs; ++i) {
+            if (d->cfg.bus == SENSOR_BUS_I2C && g_factory.open_i2c) {
+                if (g_factory.open_i2c(g_factory.user, (unsigned)(d - g_devs), &d->cfg, addrs[i], &d->i2c) != 0) continue;
+                bme280_bus_from_i2c_device(&d->inner, &d->i2c);
+            } else if (g_factory.open(g_factory.user, (unsigned)(d - g_devs), &d->cfg, addrs[i], &d->inner) != 0) {
+                continue;
+            }
+            d->injected = 1;
+            if (sensor_init_bme(d, addrs[i]) == BME280_OK) break;
+            sensor_close(d);
+        }
+        if (i == naddrs) return -1;
+        d->addr = addrs[i];
+    } else if (d->cfg.bus == SENSOR_BUS_SPI) {
+        if (spi_device_open(&d->spi, d->cfg.path, d->cfg.spi_speed_hz, d->cfg.spi_mode, 8) != 0) return -1;
+        bme280_bus_from_spi_device(&d->inner, &d->spi);
+        spi_queue_init(&d->spiq, &d->spi);
+        if (sensor_init_bme(d, 0) != BME280_OK) { sensor_close(d); return -1; }
+        d->addr = 0;
+    } else {
+        const uint8_t probe[] = { BME280_I2C_ADDR_SDO_HIGH, BME280_I2C_ADDR_SDO_LOW };
+        const uint8_t *addrs = d->cfg.addr ? &d->cfg.addr : probe;
+        size_t naddrs = d->cfg.addr ? 1 : sizeof(probe);
+        size_t i = 0;
+        for (; i < naddrs; ++i) {
+            if (i2c_device_open(&d->i2c, d->cfg.path, addrs[i]) != 0) continue;
+            bme280_bus_from_i2c_device(&d->inner, &d->i2c);
+            if (sensor_init_bme(d, addrs[i]) == BME280_OK) break;
+            i2c_device_close(&d->i2c);
+        }
+        if (i == naddrs) return -1;
+        d->addr = addrs[i];
+    }
+#endif
+    d->attached = 1;
+    printf("Sensor %s: BME280 on %s", d->cfg.name, d->cfg.path);
+    if (d->cfg.bus == SENSOR_BUS_I2C) printf(" (addr 0x%02X)", (unsigned)d->addr);
+    printf("\n");
+    return 0;
+}
+
+static void sensor_publish(unsigned index, const sensor_sample_t *s) {
+    sensor_dev_t *d = &g_devs[index];
+    sensor_sample_t *w = snapshot_write_begin(&d->snap);
+    *w = *s;
+    snapshot_publish(&d->snap);
+    if (g_cb) g_cb(index, s, g_cb_user);
+}
+
+static void sensor_publish_offline(unsigned index) {
+    sensor_dev_t *d = &g_devs[index];
+    sensor_sample_t s = { .temperature = NAN, .pressure = NAN, .humidity = NAN };
+    s.derived = (derived_values_t){ NAN, NAN, NAN, NAN };
+    s.time_s = g_clock.time_s(g_clock.user);
+    s.ok = d->ok;
+    s.err = d->err;
+    sensor_publish(index, &s);
+}
+
+/* Detached device: try again after the current backoff, doubling it up to
+ * SENSOR_PROBE_BACKOFF_MAX_MS */
+static void sensor_schedule_probe(sensor_dev_t *d) {
+    if (d->backoff_ms == 0) {
+        d->backoff_ms = SENSOR_PROBE_BACKOFF_MIN_MS;
+    } else {
+        d->backoff_ms = d->backoff_ms * 2u < SENSOR_PROBE_BACKOFF_MAX_MS ? d->backoff_ms * 2u : SENSOR_PROBE_BACKOFF_MAX_MS;
+    }
+    d->next_probe_ns = sensor_now_ns() + (uint64_t)d->backoff_ms * 1000000ull;
+}
+
+/* Adaptive mode: move the device to a new level with the single-field setters.
+ * Config writes only take effect in sleep mode, so the device is put to sleep
+ * first; switching to FORCED starts one stray conversion that ends in sleep. */
+static void sensor_set_level(sensor_dev_t *d, sample_sched_level_t level) {
+    const bme280_settings_t *st = sample_sched_settings(level);
+    int rc = bme280_set_mode(&d->bme, BME280_SLEEP_MODE);
+    if (rc == BME280_OK) rc = bme280_set_oversampling(&d->bme, st->osr_t, st->osr_p, st->osr_h);
+    if (rc == BME280_OK) rc = bme280_set_filter(&d->bme, st->filter);
+    if (rc == BME280_OK) rc = bme280_set_standby(&d->bme, st->standby);
+    if (rc == BME280_OK) rc = bme280_set_mode(&d->bme, st->mode);
+    if (rc != BME280_OK) {
+        /* The next read fails over to sensor_init_bme(), which applies the level */
+        fprintf(stderr, "Sensor %s: cannot switch to %s sampling: %d\n", d->cfg.name, sample_sched_level_name(level), rc);
+    }
+    d->interval_ns = sensor_interval_ns(d);
+    perf_count_add(PERF_CNT_SAMPLE_SCHED_CHANGES, 1);
+    printf("Sensor %s: %s sampling, every %.1f s (activity %.2f)\n", d->cfg.name, sample_sched_level_name(level),
+           (double)d->interval_ns / 1e9, (double)d->sched.score);
+}
+
+/* One measurement through the device's driver; bus and conversion time add
+ * to t_bus_ns / t_wait_ns */
+static int sensor_read(sensor_dev_t *d, bme280_reading_t *r) {
+    uint64_t t0 = perf_now_ns();
+    int rc;
+#ifdef BME280_FIXED_BUS
+    rc = bme280_fixed_read(&d->fixed, r);
+    perf_count_add(BME280_FIXED_BUS == BME280_FIXED_BUS_SPI ? PERF_CNT_SPI_IOCTLS : PERF_CNT_I2C_IOCTLS,
+                   BME280_FIXED_SPI_ONE_IOCTL || BME280_FIXED_MODE == BME280_FIXED_NORMAL ? 1 : 2);
+    t_bus_ns += perf_now_ns() - t0;
+#else
+    if (d->cfg.bus == SENSOR_BUS_SPI && !d->injected) {
+        /* Trigger, conversion wait and burst read are one SPI_IOC_MESSAGE */
+        uint32_t wait_us = 0;
+        rc = bme280_spi_read_measurement(&d->bme, &d->spiq, r, &wait_us);
+        perf_count_add(PERF_CNT_SPI_IOCTLS, 1);
+        uint64_t total = perf_now_ns() - t0;
+        uint64_t wait = (uint64_t)wait_us * 1000u < total ? (uint64_t)wait_us * 1000u : total;
+        t_wait_ns += wait;
+        t_bus_ns += total - wait;
+    } else {
+        rc = bme280_read_measurement(&d->bme, r);
+    }
+#endif
+    return rc;
+}
+
+static int sensor_forced(const sensor_dev_t *d) {
+#ifdef BME280_FIXED_BUS
+    (void)d;
+    return BME280_FIXED_MODE == BME280_FIXED_FORCED;
+#else
+    return d->bme.settings.mode == BME280_FORCED_MODE;
+#endif
+}
+
+static bme280_filter_t sensor_chip_iir(const sensor_dev_t *d) {
+#ifdef BME280_FIXED_BUS
+    (void)d;
+    return (bme280_filter_t)BME280_FIXED_FILTER;
+#else
+    return d->bme.settings.filter;
+#endif
+}
+
+/* A failed or suspicious read (have: v holds it): read again right away
+ * instead of one interval later. In forced mode every read is a fresh
+ * conversion and v becomes the median of up to the filter's burst size of
+ * them; three or more confirm a real change. In normal mode the registers
+ * hold one conversion per standby period, so one re-read only rules out a bus
+ * error. Returns the number of good reads. */
+static unsigned sensor_burst(sensor_dev_t *d, float v[3], int have, int *confirmed) {
+    float reads[SAMPLE_FILTER_BURST_MAX][3];
+    unsigned n = 0;
+    int forced = sensor_forced(d);
+    unsigned want = forced ? sample_filter_burst(&d->filter) : (unsigned)have + 1u;
+    if (have) {
+        memcpy(reads[n++], v, sizeof(reads[0]));
+    }
+    perf_count_add(PERF_CNT_FILTER_BURSTS, 1);
+    for (unsigned i = (unsigned)have; i < want; ++i) {
+        bme280_reading_t r;
+        if (sensor_read(d, &r) != BME280_OK) {
+            d->err++;
+            continue;
+        }
+        reads[n][0] = r.temperature_c;
+        reads[n][1] = r.pressure_pa / 100.0f; /* Pa -> hPa */
+        reads[n][2] = r.humidity_rh;
+        n++;
+    }
+    *confirmed = 0;
+    if (n == 0) return 0;
+    if (forced) {
+        sample_filter_median((const float (*)[3])reads, n, v);
+        *confirmed = n >= 3;
+    } else {
+        memcpy(v, reads[n - 1], sizeof(reads[0]));
+    }
+    return n;
+}
+
+/* Everything after the measurement: rc and r are its result, t0 its start.
+ * t_bus_ns / t_wait_ns hold its bus and conversion time. */
+static void sensor_sample_from(unsigned index, int rc, const bme280_reading_t *r, uint64_t t0) {
+    sensor_dev_t *d = &g_devs[index];
+    sensor_sample_t s = { .temperature = NAN, .pressure = NAN, .humidity = NAN };
+    s.derived = (derived_values_t){ NAN, NAN, NAN, NAN };
+    s.time_s = g_clock.time_s(g_clock.user);
+
+    int lost = 0;
+    float v[3] = { NAN, NAN, NAN };
+    if (rc == BME280_OK) {
+        v[0] = r->temperature_c;
+        v[1] = r->pressure_pa / 100.0f; /* Pa -> hPa */
+        v[2] = r->humidity_rh;
+    } else {
+        d->err++;
+        /* Fast re-attach from the calibration cache; a device that is gone is
+         * closed and re-probed with backoff */
+#ifdef BME280_FIXED_BUS
+        lost = 1; /* no fast path: the fixed driver always re-probes */
+#else
+        lost = sensor_init_bme(d, d->addr) != BME280_OK;
+#endif
+    }
+    int confirmed = 0;
+    if (!lost && (rc != BME280_OK || sample_filter_suspect(&d->filter, v))) {
+        if (sensor_burst(d, v, rc == BME280_OK, &confirmed) > 0) rc = BME280_OK;
+    }
+    perf_hist_record(PERF_HIST_SENSOR_TOTAL, perf_now_ns() - t0);
+    perf_hist_record(PERF_HIST_SENSOR_BUS, t_bus_ns);
+    perf_hist_record(PERF_HIST_SENSOR_WAIT, t_wait_ns);
+    perf_count_add(rc == BME280_OK ? PERF_CNT_SENSOR_OK : PERF_CNT_SENSOR_ERR, 1);
+
+    if (rc == BME280_OK) {
+        d->ok++;
+        s.valid = 1;
+        s.rejected = (uint8_t)sample_filter_apply(&d->filter, sensor_now_s(), v, sensor_chip_iir(d), confirmed);
+        if (s.rejected) perf_count_add(PERF_CNT_FILTER_REJECTS, 1);
+        s.temperature = v[0];
+        s.pressure = v[1];
+        s.humidity = v[2];
+#ifdef BME280_FIXED_BUS
+        s.adc_T = d->fixed.last_adc_T;
+        s.adc_P = d->fixed.last_adc_P;
+        s.adc_H = d->fixed.last_adc_H;
+#else
+        s.adc_T = d->bme.last_adc_T;
+        s.adc_P = d->bme.last_adc_P;
+        s.adc_H = d->bme.last_adc_H;
+#endif
+        derived_update(&d->derived, s.time_s, s.temperature, s.pressure, s.humidity, &s.derived);
+        if (g_adaptive) {
+            sample_sched_level_t was = d->sched.level;
+            sample_sched_level_t level = sample_sched_update(&d->sched, sensor_now_s(), s.temperature, s.pressure, s.humidity);
+            if (level != was) sensor_set_level(d, level);
+        }
+    } else if (lost) {
+        sensor_close(d);
+        d->backoff_ms = 0;
+        sensor_schedule_probe(d);
+        fprintf(stderr, "Sensor %s: lost on %s; re-probing\n", d->cfg.name, d->cfg.path);
+    }
+    s.online = (uint8_t)d->attached;
+    s.addr = d->addr;
+    s.ok = d->ok;
+    s.err = d->err;
+    sensor_publish(index, &s);
+}
+
+static void sensor_sample(unsigned index) {
+    bme280_reading_t r;
+    t_bus_ns = 0;
+    t_wait_ns = 0;
+    uint64_t t0 = perf_now_ns();
+    int rc = sensor_read(&g_devs[index], &r);
+    sensor_sample_from(index, rc, &r, t0);
+}
+
+#ifndef SENSOR_BATCH_WINDOW_MS
+#define SENSOR_BATCH_WINDOW_MS 250u /* I2C devices due this soon join a batch that is due now */
+#endif
+
+static void sensor_advance(sensor_dev_t *d, uint64_t now) {
+    d->next_sample_ns += d->interval_ns;
+    if (d->next_sample_ns <= now) d->next_sample_ns = now + d->interval_ns; /* overran: skip */
+}
+
+#ifndef BME280_FIXED_BUS
+/* I2C devices that are due in one worker round: one trigger per adapter, one
+ * wait for the longest conversion and one combined burst read per adapter
+ * (bme280_i2c_batch_*) instead of a full cycle per device, so the samples of
+ * a bus are taken together. A failed trigger falls back to one cycle per
+ * device, a failed read to one read per device inside the batch. Any device
+ * with I2C_RDWR transfers qualifies: an adapter node or a factory's
+ * open_i2c device, not a factory's bare bme280_bus_t. */
+static int sensor_batchable(const sensor_dev_t *d) {
+    return d->cfg.bus == SENSOR_BUS_I2C && i2c_device_is_open(&d->i2c);
+}
+
+static void sensor_sample_batch(bme280_i2c_batch_t *b, const unsigned *index) {
+    if (b->count < 2) {
+        if (b->count) sensor_sample(index[0]);
+        return;
+    }
+    uint64_t t0 = perf_now_ns();
+    int rc = bme280_i2c_batch_trigger(b);
+    uint32_t ioctls = b->ioctls;
+    if (rc != BME280_OK) {
+        perf_count_add(PERF_CNT_I2C_IOCTLS, ioctls);
+        for (size_t k = 0; k < b->count; ++k) sensor_sample(index[k]);
+        return;
+    }
+    uint64_t t1 = perf_now_ns();
+    sensor_sleep_us(b->wait_us);
+    uint64_t t2 = perf_now_ns();
+    bme280_i2c_batch_read(b);
+    uint64_t t3 = perf_now_ns();
+    perf_count_add(PERF_CNT_I2C_IOCTLS, ioctls + b->ioctls);
+
+    for (size_t k = 0; k < b->count; ++k) {
+        /* Each device is charged the shared cycle plus its own processing */
+        t_bus_ns = ((t1 - t0) + (t3 - t2)) / b->count;
+        t_wait_ns = t2 - t1;
+        sensor_sample_from(index[k], b->entries[k].status, &b->entries[k].reading, perf_now_ns() - (t3 - t0));
+    }
+}
+#endif
+
+/* Attach a detached device. On success the first sample is taken as soon as
+ * the first conversion is done, instead of one interval later. */
+static void sensor_probe(unsigned index) {
+    sensor_dev_t *d = &g_devs[index];
+    if (sensor_attach(d) != 0) {
+        if (d->backoff_ms == 0) {
+            fprintf(stderr, "Sensor %s: no BME280 on %s; retrying with backoff\n", d->cfg.name, d->cfg.path);
+        }
+        sensor_schedule_probe(d);
+        sensor_publish_offline(index);
+        return;
+    }
+    d->backoff_ms = 0;
+#ifdef BME280_FIXED_BUS
+    uint32_t us = BME280_FIXED_WAIT_US;
+#else
+    uint32_t us = bme280_measurement_time_us(&d->bme.settings);
+#endif
+    sensor_sleep_us(us);
+    sensor_sample(index);
+    d->next_sample_ns = sensor_now_ns() + d->interval_ns;
+}
+
+/* ===== Discovery and worker pool ===== */
+
+static void sensor_hand_over(unsigned index) {
+    sensor_dev_t *d = &g_devs[index];
+    __atomic_store_n(&d->owned, 1, __ATOMIC_RELEASE);
+    g_clock.wake(g_clock.user, d->group % __atomic_load_n(&g_workers, __ATOMIC_ACQUIRE));
+}
+
+/* One short-lived thread per device: every bus and device probes at once and
+ * samples as soon as it is attached, then hands the device to its worker. */
+static void *sensor_discover(void *arg) {
+    unsigned index = (unsigned)(uintptr_t)arg;
+    thread_policy_apply(THREAD_ROLE_SENSORS);
+    sensor_probe(index);
+    sensor_hand_over(index);
+    sensor_thread(-1);
+    return NULL;
+}
+
+static void *sensor_worker(void *arg) {
+    unsigned w = (unsigned)(uintptr_t)arg;
+    thread_policy_apply(THREAD_ROLE_SENSORS);
+    for (;;) {
+        uint64_t now = sensor_now_ns();
+        uint64_t next = now + g_refresh_ns;
+        unsigned workers = __atomic_load_n(&g_workers, __ATOMIC_ACQUIRE);
+#ifndef BME280_FIXED_BUS
+        int batch_due = 0;
+#endif
+        for (unsigned i = 0; i < g_dev_count; ++i) {
+            sensor_dev_t *d = &g_devs[i];
+            if (d->group % workers != w || !__atomic_load_n(&d->owned, __ATOMIC_ACQUIRE)) continue;
+            if (!d->attached) {
+                if (now >= d->next_probe_ns) sensor_probe(i);
+            } else if (now >= d->next_sample_ns) {
+#ifndef BME280_FIXED_BUS
+                if (sensor_batchable(d)) {
+                    batch_due = 1;
+                    continue;
+                }
+#endif
+                sensor_sample(i);
+                sensor_advance(d, now);
+            }
+        }
+#ifndef BME280_FIXED_BUS
+        if (batch_due) {
+            bme280_i2c_batch_t batch;
+            unsigned index[BME280_I2C_BATCH_MAX];
+            uint64_t horizon = now + SENSOR_BATCH_WINDOW_MS * 1000000ull;
+            bme280_i2c_batch_init(&batch);
+            for (unsigned i = 0; i < g_dev_count; ++i) {
+                sensor_dev_t *d = &g_devs[i];
+                if (d->group % workers != w || !__atomic_load_n(&d->owned, __ATOMIC_ACQUIRE)) continue;
+                if (!d->attached || !sensor_batchable(d) || d->next_sample_ns > horizon) continue;
+                if (batch.count == BME280_I2C_BATCH_MAX) {
+                    sensor_sample_batch(&batch, index);
+                    bme280_i2c_batch_init(&batch);
+                }
+                index[batch.count] = i;
+                if (bme280_i2c_batch_add(&batch, &d->bme, &d->i2c) < 0) sensor_sample(i);
+                if (d->next_sample_ns > now) d->next_sample_ns = now; /* pulled forward into this round */
+                sensor_advance(d, now);
+            }
+            sensor_sample_batch(&batch, index);
+        }
+#endif
+        for (unsigned i = 0; i < g_dev_count; ++i) {
+            sensor_dev_t *d = &g_devs[i];
+            if (d->group % workers != w || !__atomic_load_n(&d->owned, __ATOMIC_ACQUIRE)) continue;
+            uint64_t due = d->attached ? d->next_sample_ns : d->next_probe_ns;
+            if (due < next) next = due;
+        }
+        g_clock.wait(g_clock.user, w, next);
+    }
+    return NULL;
+}
+
+void sensor_registry_set_adaptive(int enable) {
+#ifndef BME280_FIXED_BUS
+    if (!g_workers) g_adaptive = enable != 0;
+#else
+    (void)enable;
+#endif
+}
+
+void sensor_registry_set_altitude(float altitude_m) {
+    if (!g_workers) g_altitude_m = altitude_m;
+}
+
+int sensor_registry_set_filter(const char *spec) {
+    sample_filter_config_t cfg;
+    if (g_workers || sample_filter_parse(spec, &cfg) != 0) return -1;
+    g_filter_cfg = cfg;
+    g_filter_set = 1;
+    return 0;
+}
+
+int sensor_registry_start(unsigned refresh_s, sensor_sample_cb_t cb, void *user) {
+    if (g_workers) return (int)g_workers;
+    if (g_dev_count == 0) return 0;
+    if (!g_filter_set) sample_filter_parse(SAMPLE_FILTER_DEFAULT, &g_filter_cfg);
+    for (unsigned i = 0; i < g_dev_count; ++i) derived_init(&g_devs[i].derived, g_altitude_m);
+    g_refresh_ns = (uint64_t)(refresh_s ? refresh_s : 1) * 1000000000ull;
+    g_cb = cb;
+    g_cb_user = user;
+
+    const char *env = getenv("BME280_CALIB_CACHE");
+    const char *cache_path = env ? env : BME280_CALIB_CACHE_FILE;
+    if (cache_path[0] && bme280_calib_cache_open(&g_calib_cache, cache_path) != 0) {
+        fprintf(stderr, "BME280: calibration cache %s unavailable: %s\n", cache_path, strerror(errno));
+    }
+
+    /* Workers are started in order and stop at the first failure, so groups
+     * are spread over workers 0..started-1 and none is left without one */
+    unsigned n = g_group_count < SENSOR_WORKERS_MAX ? g_group_count : SENSOR_WORKERS_MAX;
+    g_workers = n;
+    unsigned started = 0;
+    for (unsigned w = 0; w < n; ++w) {
+        pthread_condattr_t ca;
+        pthread_condattr_init(&ca);
+        pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+        pthread_mutex_init(&g_worker[w].lock, NULL);
+        pthread_cond_init(&g_worker[w].cond, &ca);
+        pthread_condattr_destroy(&ca);
+
+        pthread_t th;
+        sensor_thread(1);
+        int rc = pthread_create(&th, NULL, sensor_worker, (void *)(uintptr_t)w);
+        if (rc != 0) {
+            sensor_thread(-1);
+            fprintf(stderr, "Sensors: worker %u not started: %s; %u of %u running\n", w, strerror(rc), started, n);
+            break;
+        }
+        pthread_detach(th);
+        ++started;
+    }
+    __atomic_store_n(&g_workers, started, __ATOMIC_RELEASE);
+    if (!started) return -1;
+
+    /* Discovery: without a thread the device goes straight to its worker,
+     * which probes it on its first pass */
+    for (unsigned i = 0; i < g_dev_count; ++i) {
+        pthread_t th;
+        sensor_thread(1);
+        if (pthread_create(&th, NULL, sensor_discover, (void *)(uintptr_t)i) == 0) {
+            pthread_detach(th);
+        } else {
+            sensor_thread(-1);
+            sensor_hand_over(i);
+        }
+    }
+    return (int)started;
+}
+
+const uint8_t *sensor_registry_calib_raw(unsigned index) {
+    if (index >= g_dev_count || !g_devs[index].attached) return NULL;
+#ifdef BME280_FIXED_BUS
+    return g_devs[index].fixed.calib_raw;
+#else
+    return g_devs[index].bme.calib_raw;
+#endif
+}
+
+const sensor_sample_t *sensor_registry_poll(unsigned index) {
+    if (index >= g_dev_count) return NULL;
+    return (const sensor_sample_t *)snapshot_poll(&g_devs[index].snap);
+}
+
+const sensor_sample_t *sensor_registry_latest(unsigned index) {
+    if (index >= g_dev_count) return NULL;
+    return (const sensor_sample_t *)snapshot_current(&g_devs[index].snap, NULL);
+}
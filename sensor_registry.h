@@ -0,0 +1,198 @@
+#ifndef SENSOR_REGISTRY_H
+#define SENSOR_REGISTRY_H
+
+/*
+ * Sensor device registry and sampling worker pool (Linux, BME280 over I2C/SPI).
+ *
+ * Devices are described by short specs, from the command line or a config
+ * file (one spec per line, '#' starts a comment):
+ *
+ *     i2c:<adapter>[:<addr>[:<name>]]      e.g. i2c:/dev/i2c-1:0x76:Outdoor
+ *     spi:<spidev>[:<speed_hz>[:<name>]]   e.g. spi:/dev/spidev0.0:8000000:Indoor
+ *
+ * An I2C address of 0 (or omitted) probes 0x77 and then 0x76.
+ *
+ * The registry owns one bme280_t and one bus handle per device. At start every
+ * device is probed concurrently on its own short-lived discovery thread and
+ * takes its first sample as soon as it is attached. Sampling then runs on a
+ * small pool of worker threads; devices are assigned to workers by bus
+ * (adapter / spidev node), so a slow or hung bus only delays the sensors on
+ * that bus. A worker samples its due I2C devices (and those due within
+ * SENSOR_BATCH_WINDOW_MS) in one batched round: one conversion trigger, one
+ * wait for the longest conversion, one burst read (bme280_i2c_batch_*).
+ * Devices that are missing or get lost are re-probed with
+ * exponential backoff (SENSOR_PROBE_BACKOFF_MIN_MS .. _MAX_MS). Each device publishes its samples through its own wait-free
+ * snapshot (snapshot.h); the GUI thread polls them with
+ * sensor_registry_poll() without locks or allocation.
+ *
+ * By default each device's rate, oversampling and filter follow the weather
+ * (sample_sched.h): forced-mode samples at a low rate with the sensor asleep
+ * in between while conditions are stable, faster and with more oversampling
+ * while pressure, humidity or temperature change quickly.
+ *
+ * Reads pass through a filter pipeline (sample_filter.h) first: a failed or
+ * suspicious read is retried at once with a short burst of forced conversions,
+ * outliers are rejected, and smoothing takes the chip's IIR setting into
+ * account.
+ *
+ * Each valid sample carries its derived metrics (derived.h), computed on the
+ * sampling thread before the snapshot handoff.
+ *
+ * Time and buses can be injected (sensor_registry_set_clock(),
+ * sensor_registry_set_bus_factory()), so the real discovery, probe and worker
+ * paths run on a virtual clock against simulated sensors (bench/soak.c).
+ */
+
+#include <stdint.h>
+#include "BME280.h"
+#include "I2CDevice.h"
+#include "derived.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SENSOR_REGISTRY_MAX
+#define SENSOR_REGISTRY_MAX 16
+#endif
+#ifndef SENSOR_WORKERS_MAX
+#define SENSOR_WORKERS_MAX 4
+#endif
+#ifndef SENSOR_PROBE_BACKOFF_MIN_MS
+#define SENSOR_PROBE_BACKOFF_MIN_MS 1000
+#endif
+#ifndef SENSOR_PROBE_BACKOFF_MAX_MS
+#define SENSOR_PROBE_BACKOFF_MAX_MS 300000
+#endif
+#define SENSOR_PATH_MAX 48
+#define SENSOR_NAME_MAX 24
+
+typedef enum {
+    SENSOR_BUS_I2C = 0,
+    SENSOR_BUS_SPI
+} sensor_bus_type_t;
+
+typedef struct {
+    sensor_bus_type_t bus;
+    char     path[SENSOR_PATH_MAX];
+    uint8_t  addr;          /* I2C: 7-bit address, 0 = probe both BME280 addresses */
+    uint32_t spi_speed_hz;  /* SPI: clock, default 8 MHz */
+    uint8_t  spi_mode;      /* SPI: mode 0..3 */
+    char     name[SENSOR_NAME_MAX];
+} sensor_config_t;
+
+/* One published sample. Units: Celsius, hPa, %RH; NaN when not valid. */
+typedef struct {
+    float         temperature;
+    float         pressure;
+    float         humidity;
+    uint32_t      time_s;   /* wall clock of the read */
+    uint8_t       online;   /* device attached */
+    uint8_t       valid;    /* values come from a successful read */
+    uint8_t       addr;     /* I2C address in use (0 for SPI) */
+    unsigned long ok;       /* successful reads so far */
+    unsigned long err;      /* failed reads so far */
+    uint8_t       rejected; /* channels the filter replaced (1 << 0 temperature, 1 << 1 pressure, 1 << 2 humidity) */
+    int32_t       adc_T, adc_P, adc_H; /* raw ADC values of the last read behind a valid sample */
+    derived_values_t derived; /* dew point, heat index, sea level, 3 h tendency (derived.h) */
+} sensor_sample_t;
+
+/* Called on the sampling thread (discovery or worker) after each publish,
+ * e.g. history or wakeups. Calls for one device never overlap. */
+typedef void (*sensor_sample_cb_t)(unsigned index, const sensor_sample_t *sample, void *user);
+
+/* Time source of every sampling thread. The default is CLOCK_MONOTONIC for
+ * deadlines, time() for sample timestamps and real sleeps. An injected clock
+ * sees every point where a sampling thread blocks:
+ *   now_ns       monotonic time
+ *   time_s       wall clock for sensor_sample_t.time_s
+ *   sleep_until  conversion waits (probe, batched rounds and the driver's
+ *                bus delays, which then replace the bus's delay_ms)
+ *   wait         worker idle wait: returns at deadline_ns or after wake(worker)
+ *   wake         a device was handed over to worker
+ *   thread       +1 before a sampling thread is created, -1 when it exits or
+ *                was not created (may be NULL) */
+typedef struct {
+    uint64_t (*now_ns)(void *user);
+    uint32_t (*time_s)(void *user);
+    void     (*sleep_until)(void *user, uint64_t deadline_ns);
+    void     (*wait)(void *user, unsigned worker, uint64_t deadline_ns);
+    void     (*wake)(void *user, unsigned worker);
+    void     (*thread)(void *user, int delta);
+    void     *user;
+} sensor_clock_t;
+
+/* Bus of every device instead of its adapter node. open fills bus for device
+ * index at addr (the I2C address being probed, 0 for SPI) and returns 0, or -1
+ * if nothing answers there; close releases it. Such devices are sampled one by
+ * one, through bme280_read_measurement().
+ * open_i2c (may be NULL) replaces open for I2C devices: it sets up i2c,
+ * usually with i2c_device_open_transfer(), so the device has I2C_RDWR
+ * transfers and takes part in batched rounds like one on an adapter node
+ * (devices with the same i2c.path share its transactions). The registry
+ * clears i2c after close. */
+typedef struct {
+    int      (*open)(void *user, unsigned index, const sensor_config_t *cfg, uint8_t addr, bme280_bus_t *bus);
+    void     (*close)(void *user, unsigned index);
+    int      (*open_i2c)(void *user, unsigned index, const sensor_config_t *cfg, uint8_t addr, I2CDevice *i2c);
+    void     *user;
+} sensor_bus_factory_t;
+
+/* Install a clock (NULL: the default) or a bus factory (NULL: the devices'
+ * adapter nodes). The structs are copied. Return 0, or -1 once sampling has
+ * started; BME280_FIXED_BUS builds have no bus factory. */
+int sensor_registry_set_clock(const sensor_clock_t *clock);
+int sensor_registry_set_bus_factory(const sensor_bus_factory_t *factory);
+
+/* Parse a spec (see above). Returns 0 or -1 if malformed. */
+int sensor_registry_parse_spec(const char *spec, sensor_config_t *out);
+
+/* Register a device. Returns its index or -1 (registry full / bad spec).
+ * Only valid before sensor_registry_start(). */
+int sensor_registry_add(const sensor_config_t *cfg);
+int sensor_registry_add_spec(const char *spec);
+
+/* Register every spec in a config file. Returns the number added or -1. */
+int sensor_registry_load_file(const char *path);
+
+unsigned sensor_registry_count(void);
+const sensor_config_t *sensor_registry_config(unsigned index);
+
+/* Adaptive sampling (default on). Off: every device samples in normal mode at
+ * x1 oversampling once per refresh_s. Only valid before sensor_registry_start(). */
+void sensor_registry_set_adaptive(int enable);
+
+/* Station altitude in metres for the sea-level pressure of every device
+ * (default NaN: none). Only valid before sensor_registry_start(). */
+void sensor_registry_set_altitude(float altitude_m);
+
+/* Filter pipeline of every device (sample_filter.h, e.g. "median:5,hampel:7:3,ema:120"
+ * or "none"; default SAMPLE_FILTER_DEFAULT). Returns 0, or -1 if the spec is
+ * malformed or sampling has started. */
+int sensor_registry_set_filter(const char *spec);
+
+/* Start discovery and the worker pool; every attached device is sampled once
+ * per refresh_s, or at the interval of its adaptive level (refresh_s is the
+ * NORMAL level's). Returns immediately with the number of workers started
+ * (0 if no devices), or -1. If a worker cannot be created, the bus groups are
+ * spread over the ones that were. */
+int sensor_registry_start(unsigned refresh_s, sensor_sample_cb_t cb, void *user);
+
+/* NVM calibration a device's raw ADC values are compensated with (BME280.h,
+ * BME280_CALIB_RAW_LEN bytes), or NULL while detached. Only stable on the
+ * sampling thread, i.e. from inside the sample callback. */
+const uint8_t *sensor_registry_calib_raw(unsigned index);
+
+/* Consumer side (one thread, normally the GUI): newest sample of a device,
+ * or NULL if nothing new since the previous call for that index. */
+const sensor_sample_t *sensor_registry_poll(unsigned index);
+
+/* Consumer side: sample returned by the last poll (an offline placeholder
+ * before the first publish). */
+const sensor_sample_t *sensor_registry_latest(unsigned index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_REGISTRY_H */
@@ -0,0 +1,113 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+/*
+ * Wait-free single-producer/single-consumer snapshot (triple buffer).
+ *
+ * The producer fills a private back slot and publishes it with one atomic
+ * exchange; the consumer picks up the newest published slot with one atomic
+ * exchange. Neither side ever waits for the other or retries, so the GUI
+ * frame time is independent of how long the producer spends on the bus.
+ *
+ * Three slots of `size` bytes live in caller-provided storage:
+ *
+ *     static weather_data_t storage[3];
+ *     static snapshot_t snap = SNAPSHOT_INIT(storage);
+ *
+ * Producer (one thread):
+ *     weather_data_t *w = snapshot_write_begin(&snap);
+ *     ... fill *w ...
+ *     snapshot_publish(&snap);
+ *
+ * Consumer (one thread, e.g. the GUI):
+ *     const weather_data_t *r = snapshot_poll(&snap);   // NULL if nothing new
+ *
+ * Fan-in from several producers uses one snapshot_t per producer; the
+ * consumer polls each of them (snapshot_pending() is a single load) and a
+ * shared wakeup such as event_loop_notify() tells it when to look.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SNAPSHOT_FRESH 4u  /* set in `middle` while it holds an unread slot */
+
+typedef struct {
+    unsigned char *slots; /* 3 * size bytes */
+    size_t size;
+    unsigned back;        /* producer only: slot being written */
+    unsigned front;       /* consumer only: slot last returned */
+    unsigned middle;      /* shared: slot index | SNAPSHOT_FRESH */
+    uint32_t seq[3];      /* publish count stored with each slot */
+    uint32_t published;   /* producer only: last publish count */
+} snapshot_t;
+
+/* Static initializer over an array of exactly three payload objects. */
+#define SNAPSHOT_INIT(storage) \
+    { (unsigned char *)(storage), sizeof((storage)[0]), 0u, 1u, 2u, {0, 0, 0}, 0u }
+
+/* Runtime initializer; `storage` must hold 3 * size bytes. */
+static inline void snapshot_init(snapshot_t *s, void *storage, size_t size)
+{
+    s->slots = (unsigned char *)storage;
+    s->size = size;
+    s->back = 0;
+    s->front = 1;
+    s->middle = 2;
+    s->seq[0] = s->seq[1] = s->seq[2] = 0;
+    s->published = 0;
+}
+
+/* Producer: slot to fill for the next publish. Its previous contents are
+ * whatever was published two or more rounds ago (or the initial storage). */
+static inline void *snapshot_write_begin(snapshot_t *s)
+{
+    return s->slots + (size_t)s->back * s->size;
+}
+
+/* Producer: make the back slot visible and take over the old middle slot.
+ * Returns the publish count (starts at 1). */
+static inline uint32_t snapshot_publish(snapshot_t *s)
+{
+    uint32_t seq = ++s->published;
+    if (seq == 0) seq = s->published = 1; /* 0 means "never published" */
+    s->seq[s->back] = seq;
+    unsigned prev = __atomic_exchange_n(&s->middle, s->back | SNAPSHOT_FRESH, __ATOMIC_ACQ_REL);
+    s->back = prev & ~SNAPSHOT_FRESH;
+    return seq;
+}
+
+/* Consumer: nonzero if a publish happened since the last snapshot_poll(). */
+static inline int snapshot_pending(const snapshot_t *s)
+{
+    return (__atomic_load_n(&s->middle, __ATOMIC_ACQUIRE) & SNAPSHOT_FRESH) != 0;
+}
+
+/* Consumer: newest published payload, or NULL if nothing new since the last
+ * call. The pointer stays valid until the next snapshot_poll(). */
+static inline const void *snapshot_poll(snapshot_t *s)
+{
+    if (!snapshot_pending(s)) return NULL;
+    unsigned prev = __atomic_exchange_n(&s->middle, s->front, __ATOMIC_ACQ_REL);
+    s->front = prev & ~SNAPSHOT_FRESH;
+    return s->slots + (size_t)s->front * s->size;
+}
+
+/* Consumer: payload returned by the last successful snapshot_poll() (the
+ * initial storage contents before any publish), together with its publish
+ * count (0 = never published). */
+static inline const void *snapshot_current(const snapshot_t *s, uint32_t *seq)
+{
+    if (seq) *seq = s->seq[s->front];
+    return s->slots + (size_t)s->front * s->size;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SNAPSHOT_H */
@@ -0,0 +1,304 @@
+#include "telemetry.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+
+#include "perf_stats.h"
+#include "thread_policy.h"
+
+#if (TELEMETRY_QUEUE_LEN & (TELEMETRY_QUEUE_LEN - 1)) != 0
+#error "TELEMETRY_QUEUE_LEN must be a power of two"
+#endif
+
+#define TELEMETRY_FRAME_SIZE (TELEMETRY_HEADER_SIZE + TELEMETRY_FRAME_RECORDS * TELEMETRY_RECORD_SIZE)
+#define TELEMETRY_RECONNECT_MIN_MS 1000
+#define TELEMETRY_RECONNECT_MAX_MS 60000
+
+typedef struct {
+    uint64_t timestamp_ms;
+    float    value;
+    uint16_t sensor_id;
+    uint8_t  type;
+} telemetry_rec_t;
+
+/* Bounded multi-producer queue (Vyukov): a slot is free for position pos when
+ * its seq == pos and holds a record for the consumer when seq == pos + 1. */
+typedef struct {
+    uint32_t        seq;
+    telemetry_rec_t rec;
+} telemetry_slot_t;
+
+typedef struct {
+    telemetry_slot_t slots[TELEMETRY_QUEUE_LEN];
+    uint32_t head __attribute__((aligned(64)));  /* producers */
+    uint32_t tail __attribute__((aligned(64)));  /* exporter thread */
+} telemetry_queue_t;
+
+typedef enum { TELEMETRY_UDP, TELEMETRY_UNIX } telemetry_kind_t;
+
+typedef struct {
+    telemetry_kind_t kind;
+    char     host[64];
+    char     port[8];
+    char     path[108];
+    int      fd;
+    uint32_t backoff_ms;
+    uint64_t reconnect_ns;
+    uint32_t frame_seq;
+} telemetry_link_t;
+
+static telemetry_queue_t g_queue;
+static telemetry_link_t g_link = { .fd = -1 };
+static int g_running = 0;
+static uint32_t g_dropped = 0;
+
+/* ===== Queue ===== */
+
+int telemetry_push(const sensors_event_t *event)
+{
+    if (!event || !__atomic_load_n(&g_running, __ATOMIC_ACQUIRE)) return -1;
+
+    uint32_t pos = __atomic_load_n(&g_queue.head, __ATOMIC_RELAXED);
+    telemetry_slot_t *slot;
+    for (;;) {
+        slot = &g_queue.slots[pos & (TELEMETRY_QUEUE_LEN - 1)];
+        uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&g_queue.head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) break;
+        } else if (diff < 0) {
+            /* Full: the exporter is behind; never wait for it */
+            __atomic_fetch_add(&g_dropped, 1, __ATOMIC_RELAXED);
+            perf_count_add(PERF_CNT_TELEMETRY_DROPPED, 1);
+            return -1;
+        } else {
+            pos = __atomic_load_n(&g_queue.head, __ATOMIC_RELAXED);
+        }
+    }
+    slot->rec.timestamp_ms = event->timestamp;
+    slot->rec.value = event->value.data[0];
+    slot->rec.sensor_id = (uint16_t)event->sensor_id;
+    slot->rec.type = (uint8_t)event->type;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static int telemetry_pop(telemetry_rec_t *out)
+{
+    uint32_t pos = g_queue.tail;
+    telemetry_slot_t *slot = &g_queue.slots[pos & (TELEMETRY_QUEUE_LEN - 1)];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) return 0;
+    *out = slot->rec;
+    __atomic_store_n(&slot->seq, pos + TELEMETRY_QUEUE_LEN, __ATOMIC_RELEASE);
+    g_queue.tail = pos + 1;
+    return 1;
+}
+
+/* ===== Encoding ===== */
+
+static void put_le16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); }
+static void put_le32(uint8_t *p, uint32_t v) { put_le16(p, (uint16_t)v); put_le16(p + 2, (uint16_t)(v >> 16)); }
+static void put_le64(uint8_t *p, uint64_t v) { put_le32(p, (uint32_t)v); put_le32(p + 4, (uint32_t)(v >> 32)); }
+
+/* Fill one frame from the queue. Returns its size in bytes, 0 if the queue is empty. */
+static size_t telemetry_encode_frame(uint8_t *frame)
+{
+    telemetry_rec_t r;
+    uint16_t count = 0;
+    uint64_t base_ms = 0;
+    uint8_t *p = frame + TELEMETRY_HEADER_SIZE;
+    while (count < TELEMETRY_FRAME_RECORDS && telemetry_pop(&r)) {
+        if (count == 0) base_ms = r.timestamp_ms;
+        /* Producers race, so a record can be a little older than the base: clamp */
+        uint64_t dt = r.timestamp_ms >= base_ms ? r.timestamp_ms - base_ms : 0;
+        uint32_t bits;
+        memcpy(&bits, &r.value, sizeof(bits));
+        put_le16(p, r.sensor_id);
+        p[2] = r.type;
+        p[3] = 0;
+        put_le32(p + 4, dt > UINT32_MAX ? UINT32_MAX : (uint32_t)dt);
+        put_le32(p + 8, bits);
+        p += TELEMETRY_RECORD_SIZE;
+        count++;
+    }
+    if (count == 0) return 0;
+    put_le32(frame, TELEMETRY_MAGIC);
+    put_le16(frame + 4, TELEMETRY_VERSION);
+    put_le16(frame + 6, count);
+    put_le32(frame + 8, g_link.frame_seq++);
+    put_le32(frame + 12, __atomic_load_n(&g_dropped, __ATOMIC_RELAXED));
+    put_le64(frame + 16, base_ms);
+    return (size_t)(p - frame);
+}
+
+/* ===== Link ===== */
+
+static int telemetry_parse_dest(const char *dest, telemetry_link_t *link)
+{
+    if (strncmp(dest, "unix:", 5) == 0) {
+        if (strlen(dest + 5) >= sizeof(link->path) || !dest[5]) return -1;
+        link->kind = TELEMETRY_UNIX;
+        strcpy(link->path, dest + 5);
+        return 0;
+    }
+    if (strncmp(dest, "udp:", 4) != 0) return -1;
+    const char *host = dest + 4;
+    const char *colon = strrchr(host, ':');
+    if (!colon || colon == host || strlen(colon + 1) >= sizeof(link->port) || !colon[1]) return -1;
+    size_t hlen = (size_t)(colon - host);
+    if (host[0] == '[' && hlen >= 2 && host[hlen - 1] == ']') { host++; hlen -= 2; }
+    if (hlen >= sizeof(link->host)) return -1;
+    link->kind = TELEMETRY_UDP;
+    memcpy(link->host, host, hlen);
+    link->host[hlen] = '\0';
+    strcpy(link->port, colon + 1);
+    return 0;
+}
+
+static int telemetry_connect(telemetry_link_t *link)
+{
+    if (link->kind == TELEMETRY_UNIX) {
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, link->path);
+        int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return -1;
+        /* A collector that stops reading must not block the exporter forever */
+        struct timeval tv = { 1, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            int saved = errno;
+            close(fd);
+            errno = saved;
+            return -1;
+        }
+        return fd;
+    }
+
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(link->host, link->port, &hints, &res) != 0 || !res) { errno = EHOSTUNREACH; return -1; }
+    int fd = -1;
+    for (struct addrinfo *ai = res; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    return fd;
+}
+
+static void telemetry_disconnect(telemetry_link_t *link, uint64_t now_ns)
+{
+    if (link->fd >= 0) close(link->fd);
+    link->fd = -1;
+    link->backoff_ms = link->backoff_ms ? link->backoff_ms * 2u : TELEMETRY_RECONNECT_MIN_MS;
+    if (link->backoff_ms > TELEMETRY_RECONNECT_MAX_MS) link->backoff_ms = TELEMETRY_RECONNECT_MAX_MS;
+    link->reconnect_ns = now_ns + (uint64_t)link->backoff_ms * 1000000ull;
+}
+
+/* Send n encoded frames in one syscall. Returns 0 or -1. */
+static int telemetry_send(telemetry_link_t *link, struct iovec *iov, unsigned n)
+{
+    if (link->kind == TELEMETRY_UDP) {
+        struct mmsghdr msgs[TELEMETRY_FRAMES_PER_SEND];
+        memset(msgs, 0, sizeof(msgs[0]) * n);
+        for (unsigned i = 0; i < n; ++i) {
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int sent = sendmmsg(link->fd, msgs, n, 0);
+        /* ECONNREFUSED only reports an earlier unreachable datagram; keep the socket */
+        return (sent < 0 && errno != ECONNREFUSED) ? -1 : 0;
+    }
+
+    struct msghdr mh;
+    memset(&mh, 0, sizeof(mh));
+    mh.msg_iov = iov;
+    mh.msg_iovlen = n;
+    size_t total = 0;
+    for (unsigned i = 0; i < n; ++i) total += iov[i].iov_len;
+    ssize_t sent = sendmsg(link->fd, &mh, MSG_NOSIGNAL);
+    /* A short write would split a frame; the stream cannot resync, so reconnect */
+    return (sent < 0 || (size_t)sent != total) ? -1 : 0;
+}
+
+static void *telemetry_thread(void *arg)
+{
+    (void)arg;
+    thread_policy_apply(THREAD_ROLE_TELEMETRY);
+    static uint8_t frames[TELEMETRY_FRAMES_PER_SEND][TELEMETRY_FRAME_SIZE];
+    struct iovec iov[TELEMETRY_FRAMES_PER_SEND];
+    const struct timespec period = { TELEMETRY_FLUSH_MS / 1000, (long)(TELEMETRY_FLUSH_MS % 1000) * 1000000L };
+
+    for (;;) {
+        uint64_t now = perf_now_ns();
+        if (g_link.fd < 0 && now >= g_link.reconnect_ns) {
+            g_link.fd = telemetry_connect(&g_link);
+            if (g_link.fd >= 0) g_link.backoff_ms = 0;
+            else telemetry_disconnect(&g_link, now);
+        }
+        if (g_link.fd < 0) {
+            /* Records stay queued until the collector is back (bounded: newer ones are dropped) */
+            nanosleep(&period, NULL);
+            continue;
+        }
+
+        unsigned n = 0;
+        size_t records = 0;
+        while (n < TELEMETRY_FRAMES_PER_SEND) {
+            size_t len = telemetry_encode_frame(frames[n]);
+            if (len == 0) break;
+            iov[n].iov_base = frames[n];
+            iov[n].iov_len = len;
+            records += (len - TELEMETRY_HEADER_SIZE) / TELEMETRY_RECORD_SIZE;
+            n++;
+        }
+        if (n) {
+            perf_count_add(PERF_CNT_TELEMETRY_SENDS, 1);
+            if (telemetry_send(&g_link, iov, n) == 0) {
+                perf_count_add(PERF_CNT_TELEMETRY_RECORDS, records);
+            } else {
+                perf_count_add(PERF_CNT_TELEMETRY_DROPPED, records);
+                __atomic_fetch_add(&g_dropped, (uint32_t)records, __ATOMIC_RELAXED);
+                telemetry_disconnect(&g_link, perf_now_ns());
+            }
+        }
+        /* A full batch means more is waiting: send again right away */
+        if (n < TELEMETRY_FRAMES_PER_SEND) nanosleep(&period, NULL);
+    }
+    return NULL;
+}
+
+int telemetry_start(const char *dest)
+{
+    if (!dest || !dest[0]) { errno = EINVAL; return -1; }
+    if (__atomic_load_n(&g_running, __ATOMIC_RELAXED)) return 0;
+    if (telemetry_parse_dest(dest, &g_link) != 0) { errno = EINVAL; return -1; }
+
+    for (uint32_t i = 0; i < TELEMETRY_QUEUE_LEN; ++i) g_queue.slots[i].seq = i;
+    g_queue.head = 0;
+    g_queue.tail = 0;
+
+    pthread_t tid;
+    int rc = pthread_create(&tid, NULL, telemetry_thread, NULL);
+    if (rc != 0) { errno = rc; return -1; }
+    pthread_detach(tid);
+    __atomic_store_n(&g_running, 1, __ATOMIC_RELEASE);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/*
+ * Binary telemetry exporter.
+ *
+ * Sampling threads push sensors_event_t records (Sensor.h) into a bounded
+ * lock-free queue; telemetry_push() never blocks and drops the record when the
+ * queue is full. One exporter thread drains the queue every TELEMETRY_FLUSH_MS,
+ * packs the records into frames and sends many frames per syscall: sendmmsg()
+ * on UDP (one frame per datagram), one sendmsg() on a Unix stream socket
+ * (frames back to back, self-delimiting through their header).
+ *
+ * Wire format (little-endian, v1):
+ *   frame header, 24 bytes
+ *     u32 magic    "WXT1"
+ *     u16 version  1
+ *     u16 count    records that follow
+ *     u32 seq      frame sequence number (gaps = lost datagrams)
+ *     u32 dropped  records dropped at the queue so far
+ *     u64 base_ms  timestamp of the first record, ms since the epoch
+ *   record, 12 bytes each
+ *     u16 sensor_id  sensors_event_t.sensor_id
+ *     u8  type       sensors_event_t.type (sensors_type_t, or TELEMETRY_TYPE_*
+ *                    for derived metrics)
+ *     u8  reserved   0
+ *     u32 dt_ms      timestamp - base_ms
+ *     f32 value      sensors_event_t.value.data[0] (IEEE 754)
+ */
+
+#include <stdint.h>
+#include "Sensor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TELEMETRY_MAGIC        0x31545857u /* "WXT1" */
+#define TELEMETRY_VERSION      1u
+#define TELEMETRY_HEADER_SIZE  24
+#define TELEMETRY_RECORD_SIZE  12
+
+/* Record types of derived metrics (derived.h), outside sensors_type_t */
+#define TELEMETRY_TYPE_DEW_POINT    64  /* Celsius */
+#define TELEMETRY_TYPE_HEAT_INDEX   65  /* Celsius */
+#define TELEMETRY_TYPE_SEA_LEVEL    66  /* hPa */
+#define TELEMETRY_TYPE_TENDENCY_3H  67  /* hPa per 3 h */
+
+#ifndef TELEMETRY_QUEUE_LEN
+#define TELEMETRY_QUEUE_LEN 1024      /* power of two */
+#endif
+#ifndef TELEMETRY_FRAME_RECORDS
+#define TELEMETRY_FRAME_RECORDS 100   /* 1224-byte frames: one datagram below a 1500 MTU */
+#endif
+#ifndef TELEMETRY_FRAMES_PER_SEND
+#define TELEMETRY_FRAMES_PER_SEND 8
+#endif
+#ifndef TELEMETRY_FLUSH_MS
+#define TELEMETRY_FLUSH_MS 1000
+#endif
+
+/* Start the exporter thread for dest:
+ *   udp:<host>:<port>   e.g. udp:10.0.0.5:9750 or udp:[fd00::5]:9750
+ *   unix:<path>         Unix stream socket; reconnects with backoff
+ * Returns 0 on success, -1 on error with errno set. */
+int telemetry_start(const char *dest);
+
+/* Queue one event from any thread (lock-free, never blocks).
+ * Returns 0, or -1 if the exporter is not running or the queue is full. */
+int telemetry_push(const sensors_event_t *event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TELEMETRY_H */
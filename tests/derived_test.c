@@ -0,0 +1,70 @@
+/*
+ * derived.c unit test: dew point, heat index (every branch) and sea-level
+ * pressure against reference values, and the fast logarithm against libm.
+ *
+ *   make -C tests && ./tests/derived_test
+ *
+ * Reference values are the same formulas evaluated in double precision.
+ * Exits 0 when every check passes; each failure is printed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "derived.h"
+
+static int g_failed = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); g_failed = 1; } \
+    } while (0)
+
+static int near(float a, double b, double tol)
+{
+    return fabs((double)a - b) <= tol;
+}
+
+int main(void)
+{
+    /* derived_logf over many octaves */
+    for (float x = 1e-3f; x < 1e3f; x *= 1.37f) CHECK(fabsf(derived_logf(x) - logf(x)) < 2e-6f);
+
+    /* Magnus dew point; saturated air is at its dew point, above 100 %RH clamps */
+    CHECK(near(derived_dew_point(20.0f, 50.0f), 9.2552, 1e-3));
+    CHECK(near(derived_dew_point(30.0f, 80.0f), 26.1688, 1e-3));
+    CHECK(near(derived_dew_point(-5.0f, 70.0f), -9.6293, 1e-3));
+    CHECK(near(derived_dew_point(25.0f, 100.0f), 25.0, 1e-3));
+    CHECK(near(derived_dew_point(25.0f, 104.0f), 25.0, 1e-3));
+    CHECK(isnan(derived_dew_point(20.0f, 0.0f)) && isnan(derived_dew_point(NAN, 50.0f)));
+
+    /* Heat index: Steadman average when cool */
+    CHECK(near(derived_heat_index(20.0f, 50.0f), 19.3611, 1e-2));
+    /* Rothfusz regression; 90 degF at 50 % is 95 degF in the NWS table */
+    CHECK(near(derived_heat_index(32.0f, 50.0f), 34.3637, 1e-2));
+    CHECK(near(derived_heat_index((90.0f - 32.0f) / 1.8f, 50.0f) * 1.8f + 32.0f, 95.0, 0.5));
+    /* Low-humidity adjustment (plain regression: 35.0712) */
+    CHECK(near(derived_heat_index(38.0f, 10.0f), 34.7270, 1e-2));
+    /* ... not above 112 degF */
+    CHECK(near(derived_heat_index(45.0f, 10.0f), 42.1217, 1e-2));
+    /* High-humidity adjustment (plain regression: 37.0756) */
+    CHECK(near(derived_heat_index(29.0f, 90.0f), 37.2312, 1e-2));
+    CHECK(isnan(derived_heat_index(30.0f, NAN)));
+
+    /* Sea-level pressure at 500 m; unknown altitude gives NaN */
+    derived_t d;
+    derived_values_t v;
+    derived_init(&d, 500.0f);
+    derived_update(&d, 1767225600u, 20.0f, 950.0f, 50.0f, &v);
+    CHECK(near(v.sea_level, 1008.3495, 1e-2));
+    CHECK(near(v.dew_point, 9.2552, 1e-3) && near(v.heat_index, 19.3611, 1e-2));
+    CHECK(isnan(v.tendency_3h)); /* no sample three hours back */
+    derived_init(&d, 0.0f);
+    derived_update(&d, 1767225600u, 20.0f, 950.0f, 50.0f, &v);
+    CHECK(near(v.sea_level, 950.0, 1e-3));
+    derived_init(&d, NAN);
+    derived_update(&d, 1767225600u, 20.0f, 950.0f, 50.0f, &v);
+    CHECK(isnan(v.sea_level));
+
+    if (!g_failed) printf("derived_test: ok\n");
+    return g_failed;
+}
@@ -0,0 +1,119 @@
+/*
+ * history.c unit test: per-channel aggregates with NaN channels, and a
+ * reader racing the writer never getting a torn or recycled bucket.
+ *
+ *   make -C tests && ./tests/history_test
+ *
+ * Exits 0 when every check passes; each failure is printed.
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#include "history.h"
+
+static history_t g_h;
+static int g_failed = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); g_failed = 1; } \
+    } while (0)
+
+static int near(float a, float b)
+{
+    return fabsf(a - b) < 1e-4f;
+}
+
+/* Concurrent case: every sample of 1 min bucket k is k, so a bucket read
+ * whole has start t0 + 60 k and min = max = mean = k on every channel */
+#define RACE_MINUTES 100000u
+#define RACE_PER_MIN 6u
+static const uint32_t g_race_t0 = 1767225600u;
+static int g_race_done = 0;
+
+static void *race_writer(void *arg)
+{
+    history_t *h = arg;
+    for (uint32_t k = 0; k <= RACE_MINUTES; ++k) {
+        const float v[HISTORY_CH_COUNT] = { (float)k, (float)k, (float)k };
+        for (uint32_t j = 0; j < RACE_PER_MIN; ++j) history_insert(h, g_race_t0 + k * 60u + j * 10u, v);
+    }
+    __atomic_store_n(&g_race_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void race_check(void)
+{
+    history_init(&g_h);
+    pthread_t t;
+    if (pthread_create(&t, NULL, race_writer, &g_h) != 0) {
+        CHECK(!"pthread_create");
+        return;
+    }
+    const uint32_t len = history_tier_len(&g_h, HISTORY_TIER_1MIN);
+    unsigned reads = 0, torn = 0;
+    while (!__atomic_load_n(&g_race_done, __ATOMIC_ACQUIRE)) {
+        uint32_t closed = history_closed(&g_h, HISTORY_TIER_1MIN);
+        if (closed == 0) continue;
+        /* The oldest bucket is the next one to be recycled */
+        uint32_t index = closed > len - 1u ? closed - (len - 1u) : 0;
+        for (int ch = 0; ch < HISTORY_CH_COUNT; ++ch) {
+            history_bucket_t b;
+            if (history_get_bucket(&g_h, HISTORY_TIER_1MIN, index, (history_channel_t)ch, &b) != 0) continue;
+            ++reads;
+            if (b.start_s != g_race_t0 + index * 60u || b.count != RACE_PER_MIN ||
+                b.min != (float)index || b.max != (float)index || b.mean != (float)index) ++torn;
+        }
+    }
+    pthread_join(t, NULL);
+    CHECK(torn == 0);
+    CHECK(reads > 0);
+    CHECK(history_closed(&g_h, HISTORY_TIER_1MIN) == RACE_MINUTES);
+}
+
+int main(void)
+{
+    history_init(&g_h);
+    const uint32_t t0 = 1767225600u; /* minute aligned */
+
+    /* Bucket 0: humidity only in two of four samples, pressure in none */
+    const float s[4][HISTORY_CH_COUNT] = {
+        { 20.0f, NAN, 40.0f },
+        { 22.0f, NAN, NAN },
+        { 24.0f, NAN, 50.0f },
+        { 26.0f, NAN, NAN },
+    };
+    for (unsigned i = 0; i < 4; ++i) history_insert(&g_h, t0 + i * 10u, s[i]);
+    /* Bucket 1: only NaN samples */
+    const float none[HISTORY_CH_COUNT] = { NAN, NAN, NAN };
+    history_insert(&g_h, t0 + 60u, none);
+    /* Bucket 2 closes bucket 1 */
+    const float all[HISTORY_CH_COUNT] = { 21.0f, 1013.0f, 45.0f };
+    history_insert(&g_h, t0 + 120u, all);
+
+    CHECK(history_closed(&g_h, HISTORY_TIER_1MIN) == 2);
+
+    history_bucket_t b;
+    CHECK(history_get_bucket(&g_h, HISTORY_TIER_1MIN, 0, HISTORY_CH_TEMPERATURE, &b) == 0);
+    CHECK(b.start_s == t0 && b.count == 4 && near(b.mean, 23.0f) && near(b.min, 20.0f) && near(b.max, 26.0f));
+
+    CHECK(history_get_bucket(&g_h, HISTORY_TIER_1MIN, 0, HISTORY_CH_HUMIDITY, &b) == 0);
+    CHECK(b.count == 2 && near(b.mean, 45.0f) && near(b.min, 40.0f) && near(b.max, 50.0f));
+
+    CHECK(history_get_bucket(&g_h, HISTORY_TIER_1MIN, 0, HISTORY_CH_PRESSURE, &b) == 0);
+    CHECK(b.count == 0 && isnan(b.mean) && isnan(b.min) && isnan(b.max));
+
+    for (int ch = 0; ch < HISTORY_CH_COUNT; ++ch) {
+        CHECK(history_get_bucket(&g_h, HISTORY_TIER_1MIN, 1, (history_channel_t)ch, &b) == 0);
+        CHECK(b.count == 0 && isnan(b.mean));
+    }
+
+    /* The open 15 min and 1 h buckets are not readable yet */
+    CHECK(history_get_bucket(&g_h, HISTORY_TIER_15MIN, 0, HISTORY_CH_TEMPERATURE, &b) == -1);
+
+    race_check();
+
+    if (!g_failed) printf("history_test: ok\n");
+    return g_failed;
+}
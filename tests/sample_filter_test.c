@@ -0,0 +1,120 @@
+/*
+ * sample_filter.c unit test: a spike in a median burst is rejected, Hampel
+ * replaces outliers but follows a lasting step, and the EMA stays out of the
+ * chip IIR's way.
+ *
+ *   make -C tests && ./tests/sample_filter_test
+ *
+ * Exits 0 when every check passes; each failure is printed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "sample_filter.h"
+
+static int g_failed = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); g_failed = 1; } \
+    } while (0)
+
+static int near(float a, float b)
+{
+    return fabsf(a - b) < 1e-4f;
+}
+
+int main(void)
+{
+    sample_filter_config_t cfg;
+    sample_filter_t f;
+
+    /* Spec parsing */
+    CHECK(sample_filter_parse(SAMPLE_FILTER_DEFAULT, &cfg) == 0 && cfg.count == 2);
+    CHECK(sample_filter_parse("none", &cfg) == 0 && cfg.count == 0);
+    CHECK(sample_filter_parse("ema:30,hampel:5:2.5", &cfg) == 0 && cfg.count == 2 &&
+          cfg.stage[0].kind == SAMPLE_FILTER_EMA && near(cfg.stage[0].arg, 30.0f) &&
+          cfg.stage[1].kind == SAMPLE_FILTER_HAMPEL && cfg.stage[1].n == 5 && near(cfg.stage[1].arg, 2.5f));
+    CHECK(sample_filter_parse("median:4", &cfg) == -1);  /* even */
+    CHECK(sample_filter_parse("median:11", &cfg) == -1); /* over SAMPLE_FILTER_BURST_MAX */
+    CHECK(sample_filter_parse("hampel:7:0", &cfg) == -1);
+    CHECK(sample_filter_parse("ema:60,ema:30", &cfg) == -1);
+    CHECK(sample_filter_parse("mean:3", &cfg) == -1);
+
+    /* Median burst: an out-of-range read asks for a burst, and the median of
+     * the burst drops the spike on every channel */
+    CHECK(sample_filter_parse("median:5,hampel:7:3", &cfg) == 0);
+    sample_filter_init(&f, &cfg);
+    CHECK(sample_filter_burst(&f) == 5);
+    const float spike[3] = { 21.0f, 1013.0f, 250.0f };
+    CHECK(sample_filter_suspect(&f, spike));
+    const float burst[5][3] = {
+        { 21.00f, 1013.00f, 45.0f },
+        { 21.02f, 1013.02f, 45.2f },
+        { -140.0f, 1900.00f, 250.0f }, /* the spike */
+        { 20.98f, 1012.98f, 44.8f },
+        { 21.01f, 1013.01f, 45.1f },
+    };
+    float m[3];
+    sample_filter_median(burst, 5, m);
+    CHECK(near(m[0], 21.00f) && near(m[1], 1013.01f) && near(m[2], 45.1f));
+    CHECK(!sample_filter_suspect(&f, m));
+    sample_filter_init(&f, &(sample_filter_config_t){ .count = 0 });
+    CHECK(sample_filter_burst(&f) == 1); /* no median stage */
+
+    /* Hampel: a steady window, then one outlier on temperature */
+    CHECK(sample_filter_parse("hampel:7:3", &cfg) == 0);
+    sample_filter_init(&f, &cfg);
+    uint32_t t = 1000;
+    for (int i = 0; i < 7; ++i) {
+        float v[3] = { 20.0f + 0.01f * (float)(i % 3), 1000.0f, NAN };
+        CHECK(sample_filter_apply(&f, t++, v, BME280_FILTER_OFF, 0) == 0);
+    }
+    CHECK(f.fill[2] == 0); /* skipped channels never enter the window */
+    float out[3] = { 25.0f, 1000.0f, NAN };
+    CHECK(sample_filter_suspect(&f, out));
+    CHECK(sample_filter_apply(&f, t++, out, BME280_FILTER_OFF, 0) == 1u << 0);
+    CHECK(near(out[0], 20.01f) && near(out[1], 1000.0f) && isnan(out[2]));
+    /* Within K scaled MADs (the noise floor here): kept */
+    float ok[3] = { 20.5f, 1000.3f, NAN };
+    CHECK(!sample_filter_suspect(&f, ok));
+    CHECK(sample_filter_apply(&f, t++, ok, BME280_FILTER_OFF, 0) == 0 && near(ok[0], 20.5f));
+    /* A median of a burst that confirms the value is never replaced */
+    float confirmed[3] = { 25.0f, 1000.0f, NAN };
+    CHECK(sample_filter_apply(&f, t++, confirmed, BME280_FILTER_OFF, 1) == 0 && near(confirmed[0], 25.0f));
+    /* A lasting step: the raw values fill the window and it is accepted */
+    unsigned last = 1;
+    for (int i = 0; i < 7 && last; ++i) {
+        float v[3] = { 25.0f, 1000.0f, NAN };
+        last = sample_filter_apply(&f, t++, v, BME280_FILTER_OFF, 0);
+        if (!last) CHECK(near(v[0], 25.0f));
+    }
+    CHECK(last == 0);
+
+    /* EMA, chip IIR off: seeded by the first sample, then weighted by the
+     * actual interval */
+    CHECK(sample_filter_parse("ema:60", &cfg) == 0);
+    sample_filter_init(&f, &cfg);
+    float v[3] = { 20.0f, 1000.0f, 40.0f };
+    CHECK(sample_filter_apply(&f, 100, v, BME280_FILTER_OFF, 0) == 0);
+    CHECK(near(v[0], 20.0f) && near(v[1], 1000.0f) && near(v[2], 40.0f));
+    float a = 1.0f - expf(-30.0f / 60.0f);
+    v[0] = 22.0f; v[1] = 1002.0f; v[2] = 50.0f;
+    sample_filter_apply(&f, 130, v, BME280_FILTER_OFF, 0);
+    CHECK(near(v[0], 20.0f + 2.0f * a) && near(v[1], 1000.0f + 2.0f * a) && near(v[2], 40.0f + 10.0f * a));
+    float h = v[2];
+
+    /* Chip IIR on: temperature and pressure pass through, humidity is still
+     * smoothed */
+    v[0] = 24.0f; v[1] = 1004.0f; v[2] = 60.0f;
+    sample_filter_apply(&f, 190, v, BME280_FILTER_16, 0);
+    a = 1.0f - expf(-60.0f / 60.0f);
+    CHECK(near(v[0], 24.0f) && near(v[1], 1004.0f) && near(v[2], h + (60.0f - h) * a));
+    /* ... and the EMA followed them: switching the IIR off does not jump back */
+    v[0] = 24.0f; v[1] = 1004.0f; v[2] = 60.0f;
+    sample_filter_apply(&f, 250, v, BME280_FILTER_OFF, 0);
+    CHECK(near(v[0], 24.0f) && near(v[1], 1004.0f));
+
+    if (!g_failed) printf("sample_filter_test: ok\n");
+    return g_failed;
+}
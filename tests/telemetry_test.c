@@ -0,0 +1,142 @@
+/*
+ * telemetry.c unit test: the record queue reports full and empty correctly
+ * under concurrent producers, and frames decode back to the pushed records.
+ *
+ *   make -C tests && ./tests/telemetry_test
+ *
+ * The queue and the encoder are internal, so the test compiles telemetry.c
+ * in and never starts the exporter thread. Exits 0 when every check passes;
+ * each failure is printed.
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "../telemetry.c"
+
+/* Used by the exporter thread and the drop counter only */
+void perf_count_add(perf_counter_id_t id, uint64_t n) { (void)id; (void)n; }
+uint64_t perf_now_ns(void) { return 0; }
+void thread_policy_apply(thread_role_t role) { (void)role; }
+
+#define PRODUCERS 4
+#define PER_PRODUCER (TELEMETRY_QUEUE_LEN / PRODUCERS)
+
+static int g_failed = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); g_failed = 1; } \
+    } while (0)
+
+static uint16_t get_le16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+static uint32_t get_le32(const uint8_t *p) { return get_le16(p) | (uint32_t)get_le16(p + 2) << 16; }
+static uint64_t get_le64(const uint8_t *p) { return get_le32(p) | (uint64_t)get_le32(p + 4) << 32; }
+
+static sensors_event_t event(int32_t sensor_id, int32_t type, uint64_t timestamp_ms, float value)
+{
+    sensors_event_t ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.version = sizeof(ev);
+    ev.sensor_id = sensor_id;
+    ev.type = type;
+    ev.timestamp = timestamp_ms;
+    ev.value.data[0] = value;
+    return ev;
+}
+
+static void *producer(void *arg)
+{
+    int32_t id = (int32_t)(intptr_t)arg;
+    for (int i = 0; i < PER_PRODUCER; ++i) {
+        sensors_event_t ev = event(id, SENSOR_TYPE_AMBIENT_TEMPERATURE, 1000u + (uint64_t)i, (float)i);
+        CHECK(telemetry_push(&ev) == 0);
+    }
+    return NULL;
+}
+
+int main(void)
+{
+    telemetry_rec_t r;
+    sensors_event_t ev = event(1, SENSOR_TYPE_PRESSURE, 1, 1.0f);
+
+    /* Not running: push refuses; nothing to pop or encode */
+    CHECK(telemetry_push(&ev) == -1);
+    CHECK(telemetry_pop(&r) == 0);
+    for (uint32_t i = 0; i < TELEMETRY_QUEUE_LEN; ++i) g_queue.slots[i].seq = i; /* as telemetry_start() */
+    __atomic_store_n(&g_running, 1, __ATOMIC_RELEASE);
+    static uint8_t frame[TELEMETRY_FRAME_SIZE];
+    CHECK(telemetry_encode_frame(frame) == 0);
+
+    /* Concurrent producers fill the queue exactly; one more push is dropped */
+    pthread_t t[PRODUCERS];
+    for (intptr_t p = 0; p < PRODUCERS; ++p) {
+        if (pthread_create(&t[p], NULL, producer, (void *)p) != 0) {
+            fprintf(stderr, "telemetry_test: pthread_create failed\n");
+            return 1;
+        }
+    }
+    for (int p = 0; p < PRODUCERS; ++p) pthread_join(t[p], NULL);
+    CHECK(telemetry_push(&ev) == -1);
+    CHECK(g_dropped == 1);
+
+    /* Every record once, each producer's in order; then empty */
+    int next[PRODUCERS] = { 0 };
+    unsigned popped = 0;
+    while (telemetry_pop(&r)) {
+        ++popped;
+        CHECK(r.sensor_id < PRODUCERS);
+        if (r.sensor_id >= PRODUCERS) continue;
+        CHECK(r.value == (float)next[r.sensor_id] && r.timestamp_ms == 1000u + (uint64_t)next[r.sensor_id]);
+        next[r.sensor_id]++;
+    }
+    CHECK(popped == TELEMETRY_QUEUE_LEN);
+    CHECK(telemetry_pop(&r) == 0);
+    /* Slots are free again after the wrap */
+    CHECK(telemetry_push(&ev) == 0);
+    CHECK(telemetry_pop(&r) == 1 && r.sensor_id == 1);
+
+    /* Encode, then decode per the wire format in telemetry.h */
+    const struct { int32_t id, type; uint64_t ms; float v; } in[] = {
+        { 0, SENSOR_TYPE_AMBIENT_TEMPERATURE, 1767225600000ull, 21.5f },
+        { 0, SENSOR_TYPE_PRESSURE, 1767225600250ull, 1013.25f },
+        { 3, SENSOR_TYPE_RELATIVE_HUMIDITY, 1767225601000ull, 45.0f },
+        { 3, TELEMETRY_TYPE_DEW_POINT, 1767225600100ull, -3.75f },
+        { 65535, TELEMETRY_TYPE_TENDENCY_3H, 1767225600000ull - 5u, 0.5f }, /* older than the base */
+    };
+    const unsigned n = sizeof(in) / sizeof(in[0]);
+    for (unsigned i = 0; i < n; ++i) {
+        sensors_event_t e = event(in[i].id, in[i].type, in[i].ms, in[i].v);
+        CHECK(telemetry_push(&e) == 0);
+    }
+    uint32_t seq = g_link.frame_seq;
+    size_t len = telemetry_encode_frame(frame);
+    CHECK(len == TELEMETRY_HEADER_SIZE + n * TELEMETRY_RECORD_SIZE);
+    CHECK(get_le32(frame) == TELEMETRY_MAGIC);
+    CHECK(get_le16(frame + 4) == TELEMETRY_VERSION);
+    CHECK(get_le16(frame + 6) == n);
+    CHECK(get_le32(frame + 8) == seq);
+    CHECK(get_le32(frame + 12) == 1); /* the drop above */
+    uint64_t base = get_le64(frame + 16);
+    CHECK(base == in[0].ms);
+    for (unsigned i = 0; i < n; ++i) {
+        const uint8_t *p = frame + TELEMETRY_HEADER_SIZE + i * TELEMETRY_RECORD_SIZE;
+        uint32_t bits = get_le32(p + 8);
+        float v;
+        memcpy(&v, &bits, sizeof(v));
+        uint64_t want_dt = in[i].ms >= base ? in[i].ms - base : 0;
+        CHECK(get_le16(p) == (uint16_t)in[i].id);
+        CHECK(p[2] == (uint8_t)in[i].type && p[3] == 0);
+        CHECK(get_le32(p + 4) == want_dt);
+        CHECK(v == in[i].v);
+    }
+    CHECK(telemetry_encode_frame(frame) == 0);
+
+    /* A full queue spans frames of at most TELEMETRY_FRAME_RECORDS */
+    for (unsigned i = 0; i < TELEMETRY_FRAME_RECORDS + 1u; ++i) CHECK(telemetry_push(&ev) == 0);
+    CHECK(telemetry_encode_frame(frame) == TELEMETRY_FRAME_SIZE && get_le16(frame + 6) == TELEMETRY_FRAME_RECORDS);
+    CHECK(telemetry_encode_frame(frame) == TELEMETRY_HEADER_SIZE + TELEMETRY_RECORD_SIZE && get_le16(frame + 6) == 1);
+    CHECK(get_le32(frame + 8) == seq + 2u);
+
+    if (!g_failed) printf("telemetry_test: ok\n");
+    return g_failed;
+}
@@ -0,0 +1,134 @@
+#include "thread_policy.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    int       has_cpus;
+    cpu_set_t cpus;
+    int       has_prio;
+    int       prio;      /* 0: SCHED_OTHER, 1..99: SCHED_FIFO */
+    int       warned;
+} thread_policy_t;
+
+static thread_policy_t g_policy[THREAD_ROLE_COUNT];
+
+static const char *const g_role_names[THREAD_ROLE_COUNT] = { "render", "input", "flush", "sensors", "telemetry" };
+
+const char *thread_policy_role_name(thread_role_t role)
+{
+    return (unsigned)role < THREAD_ROLE_COUNT ? g_role_names[role] : "?";
+}
+
+/* "2", "2-3", "0+2-3" */
+static int thread_parse_cpus(const char *s, cpu_set_t *set)
+{
+    CPU_ZERO(set);
+    while (*s) {
+        char *end = NULL;
+        unsigned long lo = strtoul(s, &end, 10), hi = lo;
+        if (end == s) return -1;
+        if (*end == '-') {
+            s = end + 1;
+            hi = strtoul(s, &end, 10);
+            if (end == s) return -1;
+        }
+        if (lo > hi || hi >= CPU_SETSIZE) return -1;
+        for (unsigned long c = lo; c <= hi; ++c) CPU_SET(c, set);
+        if (*end == '+') ++end;
+        else if (*end) return -1;
+        s = end;
+    }
+    return CPU_COUNT(set) ? 0 : -1;
+}
+
+/* Walk "role:value,..." and hand each pair to fn; a bad pair fails the whole spec */
+static int thread_parse_spec(const char *spec, thread_policy_t *out, int (*fn)(const char *, thread_policy_t *))
+{
+    char buf[256];
+    if (!spec || strlen(spec) >= sizeof(buf)) return -1;
+    strcpy(buf, spec);
+    char *rest = buf, *tok;
+    while ((tok = strsep(&rest, ",")) != NULL) {
+        if (!*tok) continue;
+        char *value = strchr(tok, ':');
+        if (!value) return -1;
+        *value++ = '\0';
+        int r = 0;
+        while (r < THREAD_ROLE_COUNT && strcmp(tok, g_role_names[r]) != 0) ++r;
+        if (r == THREAD_ROLE_COUNT || fn(value, &out[r]) != 0) return -1;
+    }
+    return 0;
+}
+
+static int thread_parse_affinity(const char *value, thread_policy_t *p)
+{
+    if (thread_parse_cpus(value, &p->cpus) != 0) return -1;
+    p->has_cpus = 1;
+    return 0;
+}
+
+static int thread_parse_priority(const char *value, thread_policy_t *p)
+{
+    char *end = NULL;
+    long prio = strtol(value, &end, 10);
+    if (end == value || *end || prio < 0 || prio > 99) return -1;
+    p->prio = (int)prio;
+    p->has_prio = 1;
+    return 0;
+}
+
+int thread_policy_set_affinity(const char *spec)
+{
+    thread_policy_t tmp[THREAD_ROLE_COUNT];
+    memcpy(tmp, g_policy, sizeof(tmp));
+    if (thread_parse_spec(spec, tmp, thread_parse_affinity) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy(g_policy, tmp, sizeof(tmp));
+    return 0;
+}
+
+int thread_policy_set_priority(const char *spec)
+{
+    thread_policy_t tmp[THREAD_ROLE_COUNT];
+    memcpy(tmp, g_policy, sizeof(tmp));
+    if (thread_parse_spec(spec, tmp, thread_parse_priority) != 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    memcpy(g_policy, tmp, sizeof(tmp));
+    return 0;
+}
+
+void thread_policy_apply(thread_role_t role)
+{
+    if ((unsigned)role >= THREAD_ROLE_COUNT) return;
+    thread_policy_t *p = &g_policy[role];
+    char name[16];
+    snprintf(name, sizeof(name), "wx-%s", g_role_names[role]);
+    pthread_setname_np(pthread_self(), name);
+
+    int rc = 0;
+    const char *what = NULL;
+    if (p->has_cpus) {
+        rc = pthread_setaffinity_np(pthread_self(), sizeof(p->cpus), &p->cpus);
+        if (rc != 0) what = "CPU affinity";
+    }
+    if (p->has_prio) {
+        struct sched_param sp = { .sched_priority = p->prio };
+        int prc = pthread_setschedparam(pthread_self(), p->prio ? SCHED_FIFO : SCHED_OTHER, &sp);
+        if (prc != 0) {
+            rc = prc;
+            what = "priority";
+        }
+    }
+    if (what && !__atomic_exchange_n(&p->warned, 1, __ATOMIC_RELAXED)) {
+        fprintf(stderr, "Threads: cannot set %s of %s threads: %s\n", what, g_role_names[role], strerror(rc));
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef THREAD_POLICY_H
+#define THREAD_POLICY_H
+
+/*
+ * Per-role CPU affinity and scheduling priority (Linux).
+ *
+ * Every long-lived thread belongs to a role and calls thread_policy_apply()
+ * first thing, which names it ("wx-<role>", visible in top -H) and applies
+ * the role's CPU set and priority. Roles without a policy keep the inherited
+ * ones. Specs are comma-separated role:value pairs:
+ *
+ *     affinity   render:1,input:1,sensors:2-3,telemetry:3   (CPU lists: 2, 2-3, 0+2)
+ *     priority   input:60,render:50                          (1..99 SCHED_FIFO, 0 SCHED_OTHER)
+ *
+ * Roles: render (the LVGL thread), input (evdev reader), flush (display flush
+ * worker), sensors (sampling workers and discovery), telemetry (sender).
+ *
+ * Configure before any thread of a role is started; the tables are read-only
+ * afterwards. A policy the kernel refuses (no CAP_SYS_NICE for SCHED_FIFO, a
+ * CPU that is offline) is reported once per role and otherwise ignored.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    THREAD_ROLE_RENDER = 0,
+    THREAD_ROLE_INPUT,
+    THREAD_ROLE_FLUSH,
+    THREAD_ROLE_SENSORS,
+    THREAD_ROLE_TELEMETRY,
+    THREAD_ROLE_COUNT
+} thread_role_t;
+
+/* Parse an affinity spec (see above). Returns 0, or -1 with errno EINVAL;
+ * nothing is changed then. */
+int thread_policy_set_affinity(const char *spec);
+
+/* Parse a priority spec (see above). Returns 0, or -1 with errno EINVAL. */
+int thread_policy_set_priority(const char *spec);
+
+/* Name the calling thread and apply its role's policy. */
+void thread_policy_apply(thread_role_t role);
+
+const char *thread_policy_role_name(thread_role_t role);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* THREAD_POLICY_H */